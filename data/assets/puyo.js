@@ -168,9 +168,40 @@ function init() {
     document.getElementById('player-fields').appendChild(ojama1);
     document.getElementById('player-fields').appendChild(ojama2);
 
-    setInterval(function() {
-        loadData();
-    }, 10);
+    if (window.EventSource) {
+        subscribeData();
+    } else {
+        setInterval(function() {
+            loadData();
+        }, 10);
+    }
+}
+
+// Receives the changes of the game state from /stream.
+// A "snapshot" event has the whole state, and a "delta" event has only the changed members.
+function subscribeData() {
+    var state = null;
+    var source = new EventSource("/stream");
+
+    source.addEventListener("snapshot", function(e) {
+        state = JSON.parse(e.data);
+        displayGameState(state);
+    });
+
+    source.addEventListener("delta", function(e) {
+        // A delta before the first snapshot cannot be applied.
+        if (state === null)
+            return;
+        var delta = JSON.parse(e.data);
+        for (var key in delta)
+            state[key] = delta[key];
+        displayGameState(state);
+    });
+
+    // EventSource reconnects by itself, and the server sends a snapshot first.
+    source.onerror = function() {
+        state = null;
+    };
 }
 
 function loadData() {
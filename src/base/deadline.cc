@@ -0,0 +1,12 @@
+#include "base/deadline.h"
+
+#include <limits>
+
+using namespace std;
+
+double Deadline::remainingSeconds() const
+{
+    if (isInfinite())
+        return numeric_limits<double>::infinity();
+    return chrono::duration<double>(time_ - Clock::now()).count();
+}
@@ -0,0 +1,55 @@
+#ifndef BASE_DEADLINE_H_
+#define BASE_DEADLINE_H_
+
+#include <atomic>
+#include <chrono>
+
+// Deadline is the time when a search should finish. A search checks hasPassed()
+// cooperatively, stops there, and returns the best result it has found so far.
+// hasPassed() can be called from several threads at the same time.
+class Deadline {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // The default deadline never passes.
+    Deadline() : time_(Clock::time_point::max()) {}
+    explicit Deadline(Clock::time_point time) : time_(time) {}
+    Deadline(const Deadline& other) : time_(other.time_), hit_(other.hit_.load()) {}
+    Deadline& operator=(const Deadline& other)
+    {
+        time_ = other.time_;
+        hit_ = other.hit_.load();
+        return *this;
+    }
+
+    static Deadline never() { return Deadline(); }
+    static Deadline afterMillis(int millis) { return Deadline(Clock::now() + std::chrono::milliseconds(millis)); }
+
+    bool isInfinite() const { return time_ == Clock::time_point::max(); }
+    Clock::time_point time() const { return time_; }
+
+    bool hasPassed() const
+    {
+        if (hit_.load(std::memory_order_relaxed))
+            return true;
+        if (isInfinite() || Clock::now() < time_)
+            return false;
+        hit_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Makes the deadline pass now. This can be called from another thread to cancel a search.
+    void expire() { hit_.store(true, std::memory_order_relaxed); }
+
+    // True if hasPassed() has returned true, i.e. a search has been stopped by this deadline.
+    bool wasHit() const { return hit_.load(std::memory_order_relaxed); }
+
+    // Returns the remaining time [s]. Negative if the deadline has passed.
+    double remainingSeconds() const;
+
+private:
+    Clock::time_point time_;
+    mutable std::atomic<bool> hit_ { false };
+};
+
+#endif // BASE_DEADLINE_H_
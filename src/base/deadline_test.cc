@@ -0,0 +1,52 @@
+#include "base/deadline.h"
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+TEST(DeadlineTest, never)
+{
+    Deadline deadline;
+    EXPECT_TRUE(deadline.isInfinite());
+    EXPECT_FALSE(deadline.hasPassed());
+    EXPECT_FALSE(deadline.wasHit());
+    EXPECT_LT(1e9, deadline.remainingSeconds());
+}
+
+TEST(DeadlineTest, afterMillis)
+{
+    Deadline deadline = Deadline::afterMillis(10);
+    EXPECT_FALSE(deadline.isInfinite());
+    EXPECT_FALSE(deadline.hasPassed());
+    EXPECT_FALSE(deadline.wasHit());
+
+    this_thread::sleep_for(chrono::milliseconds(20));
+    EXPECT_FALSE(deadline.wasHit());
+    EXPECT_TRUE(deadline.hasPassed());
+    EXPECT_TRUE(deadline.wasHit());
+    EXPECT_GT(0, deadline.remainingSeconds());
+}
+
+TEST(DeadlineTest, copy)
+{
+    Deadline deadline = Deadline::afterMillis(0);
+    EXPECT_TRUE(deadline.hasPassed());
+
+    Deadline copied(deadline);
+    EXPECT_TRUE(copied.wasHit());
+    EXPECT_EQ(deadline.time(), copied.time());
+}
+
+TEST(DeadlineTest, expire)
+{
+    Deadline deadline;
+    EXPECT_FALSE(deadline.hasPassed());
+
+    thread th([&]() { deadline.expire(); });
+    th.join();
+
+    EXPECT_TRUE(deadline.hasPassed());
+    EXPECT_TRUE(deadline.wasHit());
+}
@@ -1,27 +1,62 @@
 #include "base/executor.h"
 
+#include <algorithm>
+#include <chrono>
+
+#ifdef OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
 DEFINE_int32(num_threads, 1, "The default number of threads");
+DEFINE_bool(pin_threads, false, "Pin the threads of the default executor to CPUs");
 
 using namespace std;
 
+namespace {
+
+struct CurrentWorker {
+    const Executor* executor;
+    int index;
+};
+
+thread_local CurrentWorker currentWorker { nullptr, -1 };
+
+std::int64_t durationInMicros(chrono::steady_clock::time_point begin, chrono::steady_clock::time_point end)
+{
+    return chrono::duration_cast<chrono::microseconds>(end - begin).count();
+}
+
+}
+
 // static
 unique_ptr<Executor> Executor::makeDefaultExecutor(bool automaticStart)
 {
-    Executor* executor = new Executor(FLAGS_num_threads);
+    Executor* executor = new Executor(FLAGS_num_threads, FLAGS_pin_threads);
     if (automaticStart)
         executor->start();
 
     return unique_ptr<Executor>(executor);
 }
 
-Executor::Executor(int numThread) :
+Executor::Executor(int numThread, bool pinsThreads) :
     threads_(numThread),
+    numPendingTasks_(0),
+    numSleepingWorkers_(0),
+    nextWorker_(0),
     shouldStop_(false),
-    hasStarted_(false)
+    hasStarted_(false),
+    pinsThreads_(pinsThreads)
 {
+    for (int i = 0; i < numThread; ++i) {
+        workers_.emplace_back(new Worker);
+        workers_.back()->tasksRun = 0;
+        workers_.back()->steals = 0;
+        workers_.back()->idleTimeInMicros = 0;
+    }
 }
 
 Executor::~Executor()
@@ -36,9 +71,22 @@ void Executor::start()
     hasStarted_ = true;
 
     for (size_t i = 0; i < threads_.size(); ++i) {
-        threads_[i] = thread([this]() {
-                runWorkerLoop();
+        threads_[i] = thread([this, i]() {
+            runWorkerLoop(static_cast<int>(i));
         });
+
+#ifdef OS_LINUX
+        if (pinsThreads_) {
+            int numCPUs = std::max(1U, thread::hardware_concurrency());
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(i % numCPUs, &cpuset);
+            if (pthread_setaffinity_np(threads_[i].native_handle(), sizeof(cpuset), &cpuset) != 0)
+                LOG(WARNING) << "failed to pin worker " << i;
+        }
+#else
+        LOG_IF(WARNING, pinsThreads_) << "pinning threads is not supported on this platform";
+#endif
     }
 }
 
@@ -46,8 +94,12 @@ void Executor::stop()
 {
     CHECK(hasStarted_);
 
-    shouldStop_ = true;
-    condVar_.notify_all();
+    {
+        lock_guard<mutex> lock(mu_);
+        shouldStop_ = true;
+        condVar_.notify_all();
+    }
+
     for (size_t i = 0; i < threads_.size(); ++i) {
         if (threads_[i].joinable()) {
             threads_[i].join();
@@ -58,35 +110,170 @@ void Executor::stop()
 void Executor::submit(Executor::Func f)
 {
     CHECK(f) << "function should be callable";
+    CHECK(!workers_.empty()) << "executor doesn't have any worker";
+
+    int index = currentWorkerIndex();
+    if (index < 0)
+        index = nextWorker_++ % workers_.size();
 
-    unique_lock<mutex> lock(mu_);
-    tasks_.push_back(std::move(f));
-    condVar_.notify_one();
+    {
+        Worker* worker = workers_[index].get();
+        lock_guard<mutex> lock(worker->mu);
+        worker->tasks.push_back(std::move(f));
+    }
+
+    // A worker increments numSleepingWorkers_ and checks numPendingTasks_ under mu_,
+    // so the worker won't miss this task.
+    numPendingTasks_++;
+    if (numSleepingWorkers_ > 0) {
+        lock_guard<mutex> lock(mu_);
+        condVar_.notify_one();
+    }
+}
+
+std::vector<Executor::WorkerStats> Executor::stats() const
+{
+    std::vector<WorkerStats> result(workers_.size());
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        result[i].tasksRun = workers_[i]->tasksRun;
+        result[i].steals = workers_[i]->steals;
+        result[i].idleTime = workers_[i]->idleTimeInMicros / 1000000.0;
+    }
+    return result;
 }
 
-void Executor::runWorkerLoop()
+void Executor::runWorkerLoop(int index)
 {
+    currentWorker.executor = this;
+    currentWorker.index = index;
+
+    Worker* worker = workers_[index].get();
     while (true) {
-        Func f = take();
-        if (!f)
+        Func f;
+        if (take(index, &f)) {
+            f();
+            worker->tasksRun++;
+            continue;
+        }
+
+        auto begin = chrono::steady_clock::now();
+        {
+            unique_lock<mutex> lock(mu_);
+            numSleepingWorkers_++;
+            while (numPendingTasks_ == 0 && !shouldStop_)
+                condVar_.wait(lock);
+            numSleepingWorkers_--;
+        }
+        worker->idleTimeInMicros += durationInMicros(begin, chrono::steady_clock::now());
+
+        if (shouldStop_ && numPendingTasks_ == 0)
             break;
+    }
+
+    currentWorker.executor = nullptr;
+    currentWorker.index = -1;
+}
+
+int Executor::currentWorkerIndex() const
+{
+    return currentWorker.executor == this ? currentWorker.index : -1;
+}
+
+bool Executor::take(int index, Func* f)
+{
+    if (numPendingTasks_ == 0)
+        return false;
+
+    if (index >= 0) {
+        Worker* worker = workers_[index].get();
+        lock_guard<mutex> lock(worker->mu);
+        if (!worker->tasks.empty()) {
+            *f = std::move(worker->tasks.back());
+            worker->tasks.pop_back();
+            numPendingTasks_--;
+            return true;
+        }
+    }
+
+    const int n = static_cast<int>(workers_.size());
+    const int start = index >= 0 ? index + 1 : 0;
+    for (int i = 0; i < n; ++i) {
+        int victimIndex = (start + i) % n;
+        if (victimIndex == index)
+            continue;
+
+        Worker* victim = workers_[victimIndex].get();
+        lock_guard<mutex> lock(victim->mu);
+        if (!victim->tasks.empty()) {
+            *f = std::move(victim->tasks.front());
+            victim->tasks.pop_front();
+            numPendingTasks_--;
+            if (index >= 0)
+                workers_[index]->steals++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Executor::runPendingTask()
+{
+    int index = currentWorkerIndex();
+
+    Func f;
+    if (!take(index, &f))
+        return false;
 
+    f();
+    if (index >= 0)
+        workers_[index]->tasksRun++;
+    return true;
+}
+
+// ----------------------------------------------------------------------
+
+TaskGroup::TaskGroup(Executor* executor) :
+    executor_(executor),
+    numRunning_(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    wait();
+}
+
+void TaskGroup::run(Executor::Func f)
+{
+    if (!executor_) {
         f();
+        return;
     }
+
+    numRunning_++;
+    executor_->submit([this, f]() {
+        f();
+
+        // Notify under the lock. Otherwise, wait() might return and this TaskGroup
+        // might be destructed before notifying.
+        lock_guard<mutex> lock(mu_);
+        if (--numRunning_ == 0)
+            condVar_.notify_all();
+    });
 }
 
-Executor::Func Executor::take()
+void TaskGroup::wait()
 {
-    unique_lock<mutex> lock(mu_);
-    while (true) {
-        if (!tasks_.empty())
-            break;
-        if (shouldStop_)
-            return Func();
-        condVar_.wait(lock);
+    while (numRunning_ > 0) {
+        // Help the workers instead of just sleeping.
+        if (executor_->runPendingTask())
+            continue;
+
+        unique_lock<mutex> lock(mu_);
+        condVar_.wait_for(lock, chrono::microseconds(100), [this]() { return numRunning_ == 0; });
     }
 
-    Func f = std::move(tasks_.front());
-    tasks_.pop_front();
-    return f;
+    // Make sure the last task has released mu_.
+    lock_guard<mutex> lock(mu_);
 }
@@ -3,41 +3,111 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 #include "base/noncopyable.h"
 
-// Executor is an implementation of thread pool.
-// This implementation might have certain overhead. It's not intended to be used for
-// a lot of micro tasks. Please submit coarse tasks.
+// Executor is an implementation of thread pool with work stealing.
+//
+// Each worker has its own deque. A task submitted from a worker thread is pushed to
+// the worker's deque, and the worker takes tasks from the back of its deque (LIFO).
+// When its deque is empty, a worker steals a task from the front of another worker's
+// deque (FIFO). A task submitted from a non-worker thread is distributed to workers
+// in round-robin.
+//
+// Use TaskGroup to wait for the submitted tasks.
 class Executor : noncopyable {
 public:
     typedef std::function<void (void)> Func;
 
+    struct WorkerStats {
+        std::int64_t tasksRun = 0;
+        std::int64_t steals = 0;
+        double idleTime = 0;  // [s]
+    };
+
     static std::unique_ptr<Executor> makeDefaultExecutor(bool automaticStart = true);
 
-    explicit Executor(int numThread);
+    // When |pinsThreads| is true, i-th worker is pinned to (i % #cpu)-th CPU.
+    // (Only supported on Linux.)
+    explicit Executor(int numThread, bool pinsThreads = false);
     ~Executor();
 
     void start();
+    // Stops the workers after all submitted tasks are run.
     void stop();
 
     void submit(Func);
 
+    int numThreads() const { return static_cast<int>(workers_.size()); }
+    std::vector<WorkerStats> stats() const;
+
 private:
-    void runWorkerLoop();
-    Func take();
+    friend class TaskGroup;
+
+    struct Worker {
+        std::mutex mu;
+        std::deque<Func> tasks;
+
+        std::atomic<std::int64_t> tasksRun;
+        std::atomic<std::int64_t> steals;
+        std::atomic<std::int64_t> idleTimeInMicros;
+    };
 
+    void runWorkerLoop(int index);
+
+    // Returns the index of the worker if the current thread is a worker of this executor.
+    // Otherwise, -1 is returned.
+    int currentWorkerIndex() const;
+    // Takes a task from the deque of |index|-th worker, or steals a task from the other
+    // workers. |index| can be -1. In that case, steals a task.
+    bool take(int index, Func*);
+    // Runs one pending task in the current thread. Returns false if there is no task.
+    bool runPendingTask();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
     std::vector<std::thread> threads_;
+
     std::mutex mu_;
     std::condition_variable condVar_;
+    std::atomic<int> numPendingTasks_;
+    std::atomic<int> numSleepingWorkers_;
+    std::atomic<unsigned int> nextWorker_;
     std::atomic<bool> shouldStop_;
-    std::deque<Func> tasks_;
     bool hasStarted_;
+    bool pinsThreads_;
+};
+
+// TaskGroup runs tasks with Executor, and waits for all of them.
+//
+//   TaskGroup group(executor);
+//   group.run([]() { ... });
+//   group.run([]() { ... });
+//   group.wait();
+//
+// While waiting, the waiting thread also runs pending tasks, so it's safe to
+// wait for a TaskGroup in a task (e.g. recursive task splitting).
+// When |executor| is nullptr, tasks are run synchronously in run().
+class TaskGroup : noncopyable {
+public:
+    explicit TaskGroup(Executor* executor);
+    // Waits for the tasks.
+    ~TaskGroup();
+
+    void run(Executor::Func);
+    void wait();
+
+private:
+    Executor* executor_;
+    std::mutex mu_;
+    std::condition_variable condVar_;
+    std::atomic<int> numRunning_;
 };
 
 #endif
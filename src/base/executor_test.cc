@@ -0,0 +1,132 @@
+#include "base/executor.h"
+
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include "base/wait_group.h"
+
+TEST(ExecutorTest, submit)
+{
+    Executor executor(4);
+    executor.start();
+
+    std::atomic<int> count(0);
+    WaitGroup wg;
+    for (int i = 0; i < 100; ++i) {
+        wg.add(1);
+        executor.submit([&]() {
+            count++;
+            wg.done();
+        });
+    }
+
+    wg.waitUntilDone();
+    EXPECT_EQ(100, count);
+
+    executor.stop();
+
+    std::int64_t tasksRun = 0;
+    for (const auto& stats : executor.stats())
+        tasksRun += stats.tasksRun;
+    EXPECT_EQ(100, tasksRun);
+}
+
+TEST(ExecutorTest, stopRunsAllTasks)
+{
+    std::atomic<int> count(0);
+    {
+        Executor executor(2);
+        executor.start();
+        for (int i = 0; i < 100; ++i)
+            executor.submit([&]() { count++; });
+        executor.stop();
+    }
+
+    EXPECT_EQ(100, count);
+}
+
+TEST(TaskGroupTest, run)
+{
+    Executor executor(4);
+    executor.start();
+
+    std::atomic<int> count(0);
+    TaskGroup group(&executor);
+    for (int i = 0; i < 1000; ++i)
+        group.run([&]() { count++; });
+    group.wait();
+
+    EXPECT_EQ(1000, count);
+}
+
+TEST(TaskGroupTest, withoutExecutor)
+{
+    int count = 0;
+    TaskGroup group(nullptr);
+    for (int i = 0; i < 10; ++i)
+        group.run([&]() { count++; });
+    group.wait();
+
+    EXPECT_EQ(10, count);
+}
+
+namespace {
+
+int fib(Executor* executor, int n)
+{
+    if (n < 2)
+        return n;
+    if (n < 10)
+        return fib(executor, n - 1) + fib(executor, n - 2);
+
+    int x = 0, y = 0;
+    TaskGroup group(executor);
+    group.run([&]() { x = fib(executor, n - 1); });
+    group.run([&]() { y = fib(executor, n - 2); });
+    group.wait();
+    return x + y;
+}
+
+}
+
+TEST(TaskGroupTest, nested)
+{
+    // Even with 1 worker, nested TaskGroup::wait() should not deadlock.
+    for (int numThreads : { 1, 4 }) {
+        Executor executor(numThreads);
+        executor.start();
+        EXPECT_EQ(6765, fib(&executor, 20));
+    }
+}
+
+TEST(TaskGroupTest, steal)
+{
+    Executor executor(4);
+    executor.start();
+
+    // One task spawns many tasks into its own deque. The other workers should steal them.
+    std::atomic<int> count(0);
+    {
+        TaskGroup outer(&executor);
+        outer.run([&]() {
+            TaskGroup inner(&executor);
+            for (int i = 0; i < 1000; ++i) {
+                inner.run([&]() {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    count++;
+                });
+            }
+            inner.wait();
+        });
+        outer.wait();
+    }
+    EXPECT_EQ(1000, count);
+
+    executor.stop();
+
+    std::int64_t steals = 0;
+    for (const auto& stats : executor.stats())
+        steals += stats.steals;
+    EXPECT_LT(0, steals);
+}
@@ -0,0 +1,79 @@
+#include "base/file/mapped_file.h"
+
+#if defined(OS_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glog/logging.h>
+
+#include "base/file/file.h"
+
+using namespace std;
+
+namespace file {
+
+#if defined(OS_POSIX)
+
+// static
+unique_ptr<MappedFile> MappedFile::open(const string& filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return unique_ptr<MappedFile>();
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        PLOG(ERROR) << "failed to stat " << filename;
+        close(fd);
+        return unique_ptr<MappedFile>();
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        close(fd);
+        return unique_ptr<MappedFile>(new MappedFile(nullptr, 0));
+    }
+
+    void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping is still valid after closing the file.
+    close(fd);
+    if (p == MAP_FAILED) {
+        PLOG(ERROR) << "failed to mmap " << filename;
+        return unique_ptr<MappedFile>();
+    }
+
+    return unique_ptr<MappedFile>(new MappedFile(static_cast<const char*>(p), size));
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+}
+
+#else
+
+// static
+unique_ptr<MappedFile> MappedFile::open(const string& filename)
+{
+    string content;
+    if (!readFile(filename, &content))
+        return unique_ptr<MappedFile>();
+
+    unique_ptr<MappedFile> mappedFile(new MappedFile(nullptr, 0));
+    mappedFile->content_ = std::move(content);
+    mappedFile->data_ = mappedFile->content_.data();
+    mappedFile->size_ = mappedFile->content_.size();
+    return mappedFile;
+}
+
+MappedFile::~MappedFile()
+{
+}
+
+#endif
+
+} // namespace file
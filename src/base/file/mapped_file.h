@@ -0,0 +1,37 @@
+#ifndef BASE_FILE_MAPPED_FILE_H_
+#define BASE_FILE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "base/noncopyable.h"
+
+namespace file {
+
+// MappedFile maps a file into memory read-only. On POSIX, the file is mmap'ed, so
+// the processes mapping the same file share the physical pages.
+// On the other platforms, the whole file is read into memory.
+class MappedFile : noncopyable {
+public:
+    // Returns nullptr if |filename| cannot be mapped.
+    static std::unique_ptr<MappedFile> open(const std::string& filename);
+
+    ~MappedFile();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(const char* data, size_t size) : data_(data), size_(size) {}
+
+    const char* data_;
+    size_t size_;
+#if !defined(OS_POSIX)
+    std::string content_;
+#endif
+};
+
+} // namespace file
+
+#endif // BASE_FILE_MAPPED_FILE_H_
@@ -0,0 +1,28 @@
+#include "base/file/mapped_file.h"
+
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "base/file/file.h"
+
+using namespace std;
+
+TEST(MappedFileTest, open)
+{
+    const string filename = "mapped_file_test.tmp";
+    const string content("abc\0def", 7);
+    ASSERT_TRUE(file::writeFile(filename, content));
+
+    unique_ptr<file::MappedFile> mappedFile = file::MappedFile::open(filename);
+    ASSERT_TRUE(mappedFile.get() != nullptr);
+    EXPECT_EQ(content, string(mappedFile->data(), mappedFile->size()));
+
+    remove(filename.c_str());
+}
+
+TEST(MappedFileTest, openNonExistent)
+{
+    EXPECT_TRUE(file::MappedFile::open("/nonexistent/mapped_file_test.tmp").get() == nullptr);
+}
@@ -0,0 +1,62 @@
+#include "base/latency_histogram.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+LatencyHistogram::LatencyHistogram(double bucketWidth, int numBuckets) :
+    bucketWidth_(bucketWidth),
+    buckets_(numBuckets)
+{
+}
+
+void LatencyHistogram::add(double latency)
+{
+    int i = static_cast<int>(std::max(latency, 0.0) / bucketWidth_);
+    buckets_[std::min<int>(i, buckets_.size() - 1)]++;
+
+    count_++;
+    sum_ += latency;
+    max_ = std::max(max_, latency);
+}
+
+void LatencyHistogram::clear()
+{
+    std::fill(buckets_.begin(), buckets_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+double LatencyHistogram::percentile(int p) const
+{
+    if (count_ == 0)
+        return 0;
+
+    // nearest rank
+    int rank = std::max((count_ * p + 99) / 100, 1);
+    int accumulated = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        accumulated += buckets_[i];
+        // The last bucket doesn't have the upper bound.
+        if (accumulated >= rank && i + 1 < buckets_.size())
+            return std::min(bucketWidth_ * (i + 1), max_);
+    }
+
+    return max_;
+}
+
+string LatencyHistogram::toString() const
+{
+    stringstream ss;
+    ss << fixed << setprecision(2)
+       << "n=" << count_
+       << " ave=" << (average() * 1000) << "ms"
+       << " p50=" << (percentile(50) * 1000) << "ms"
+       << " p90=" << (percentile(90) * 1000) << "ms"
+       << " p99=" << (percentile(99) * 1000) << "ms"
+       << " max=" << (max_ * 1000) << "ms";
+    return ss.str();
+}
@@ -0,0 +1,36 @@
+#ifndef BASE_LATENCY_HISTOGRAM_H_
+#define BASE_LATENCY_HISTOGRAM_H_
+
+#include <string>
+#include <vector>
+
+// LatencyHistogram collects latencies into fixed-width buckets, so that adding
+// a sample is cheap enough to be done for every frame.
+// This is not thread-safe.
+class LatencyHistogram {
+public:
+    // Latencies are bucketed by |bucketWidth| [s]. The latencies longer than
+    // |bucketWidth| * |numBuckets| are put into the last bucket.
+    explicit LatencyHistogram(double bucketWidth = 0.0005, int numBuckets = 200);
+
+    void add(double latency);
+    void clear();
+
+    int count() const { return count_; }
+    double average() const { return count_ > 0 ? sum_ / count_ : 0.0; }
+    double max() const { return max_; }
+    // Returns the upper bound of the bucket that contains the |p|-th percentile.
+    double percentile(int p) const;
+
+    // e.g. "n=100 ave=1.23ms p50=1.00ms p90=2.00ms p99=3.50ms max=4.12ms"
+    std::string toString() const;
+
+private:
+    double bucketWidth_;
+    std::vector<int> buckets_;
+    int count_ = 0;
+    double sum_ = 0;
+    double max_ = 0;
+};
+
+#endif // BASE_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,40 @@
+#include "base/latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+TEST(LatencyHistogramTest, empty)
+{
+    LatencyHistogram h;
+    EXPECT_EQ(0, h.count());
+    EXPECT_EQ(0.0, h.average());
+    EXPECT_EQ(0.0, h.percentile(50));
+    EXPECT_EQ(0.0, h.max());
+}
+
+TEST(LatencyHistogramTest, percentile)
+{
+    LatencyHistogram h(0.001, 10);
+    for (int i = 0; i < 100; ++i)
+        h.add(i < 90 ? 0.0005 : 0.0035);
+
+    EXPECT_EQ(100, h.count());
+    EXPECT_NEAR(0.0008, h.average(), 1e-9);
+    EXPECT_DOUBLE_EQ(0.001, h.percentile(50));
+    EXPECT_DOUBLE_EQ(0.001, h.percentile(90));
+    // The upper bound of the bucket is clipped by the max.
+    EXPECT_DOUBLE_EQ(0.0035, h.percentile(99));
+    EXPECT_DOUBLE_EQ(0.0035, h.max());
+}
+
+TEST(LatencyHistogramTest, overflow)
+{
+    LatencyHistogram h(0.001, 10);
+    h.add(0.5);
+
+    EXPECT_DOUBLE_EQ(0.5, h.percentile(50));
+    EXPECT_DOUBLE_EQ(0.5, h.max());
+
+    h.clear();
+    EXPECT_EQ(0, h.count());
+    EXPECT_EQ(0.0, h.max());
+}
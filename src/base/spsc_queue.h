@@ -0,0 +1,220 @@
+#ifndef BASE_SPSC_QUEUE_H_
+#define BASE_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "base/noncopyable.h"
+
+namespace base {
+
+// SPSCQueue is a bounded lock-free queue for a single producer and a single consumer.
+// Only one thread can call tryPush() and pushWithTimeout(), and only one (another) thread
+// can call tryTake() and takeWithTimeout().
+// Unlike BlockingQueue, tryPush() and tryTake() never block. The producer and the consumer
+// can choose to wait with pushWithTimeout() and takeWithTimeout().
+template<typename T>
+class SPSCQueue : noncopyable {
+public:
+    explicit SPSCQueue(size_t capacity);
+    ~SPSCQueue();
+
+    size_t capacity() const { return capacity_; }
+
+    // These are exact only when called from the producer or the consumer.
+    bool empty() const { return size() == 0; }
+    size_t size() const;
+
+    // Returns false if the queue is full. |v| is not moved in that case.
+    bool tryPush(T&& v);
+    // Same as tryPush(), but waits for a free slot for |timeout| at most. The producer
+    // spins for a short while first, and then sleeps until the consumer takes.
+    bool pushWithTimeout(const std::chrono::milliseconds& timeout, T&& v);
+    // Returns false if the queue is empty.
+    bool tryTake(T* v);
+    // Same as tryTake(), but waits for an element for |timeout| at most. The consumer
+    // spins for a short while first, and then sleeps until the producer pushes.
+    bool takeWithTimeout(const std::chrono::milliseconds& timeout, T* v);
+
+private:
+    static const int NUM_SPINS = 64;
+
+    // Same as tryPush() and tryTake(), but don't wake up the other side. These are
+    // called while holding the mutex of this side, so waking up (which takes the mutex
+    // of the other side) here could deadlock.
+    bool tryPushWithoutNotify(T&& v);
+    bool tryTakeWithoutNotify(T* v);
+    void notifyConsumer();
+    void notifyProducer();
+
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+    T* slot(size_t pos) { return reinterpret_cast<T*>(&slots_[pos % capacity_]); }
+
+    const size_t capacity_;
+    std::unique_ptr<Storage[]> slots_;
+
+    std::atomic<size_t> head_;  // The next position to take.
+    // The producer and the consumer should update different cache lines.
+    char padding_[64];
+    std::atomic<size_t> tail_;  // The next position to push.
+
+    // Used only when the consumer sleeps in takeWithTimeout().
+    std::atomic<bool> consumerWaiting_;
+    std::mutex consumerMu_;
+    std::condition_variable pushed_;
+
+    // Used only when the producer sleeps in pushWithTimeout().
+    std::atomic<bool> producerWaiting_;
+    std::mutex producerMu_;
+    std::condition_variable taken_;
+};
+
+template<typename T>
+SPSCQueue<T>::SPSCQueue(size_t capacity) :
+    capacity_(capacity),
+    slots_(new Storage[capacity]),
+    head_(0),
+    tail_(0),
+    consumerWaiting_(false),
+    producerWaiting_(false)
+{
+}
+
+template<typename T>
+SPSCQueue<T>::~SPSCQueue()
+{
+    for (size_t pos = head_.load(); pos != tail_.load(); ++pos)
+        slot(pos)->~T();
+}
+
+template<typename T>
+size_t SPSCQueue<T>::size() const
+{
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail - head;
+}
+
+template<typename T>
+bool SPSCQueue<T>::tryPush(T&& v)
+{
+    if (!tryPushWithoutNotify(std::move(v)))
+        return false;
+    notifyConsumer();
+    return true;
+}
+
+template<typename T>
+bool SPSCQueue<T>::pushWithTimeout(const std::chrono::milliseconds& timeout, T&& v)
+{
+    // The consumer often takes an element soon, so spin before sleeping.
+    for (int i = 0; i < NUM_SPINS; ++i) {
+        if (tryPush(std::move(v)))
+            return true;
+    }
+
+    bool pushed;
+    {
+        std::unique_lock<std::mutex> lock(producerMu_);
+        producerWaiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        pushed = taken_.wait_for(lock, timeout, [this, &v]() { return tryPushWithoutNotify(std::move(v)); });
+        producerWaiting_.store(false, std::memory_order_relaxed);
+    }
+    if (pushed)
+        notifyConsumer();
+    return pushed;
+}
+
+template<typename T>
+bool SPSCQueue<T>::tryTake(T* v)
+{
+    if (!tryTakeWithoutNotify(v))
+        return false;
+    notifyProducer();
+    return true;
+}
+
+template<typename T>
+bool SPSCQueue<T>::takeWithTimeout(const std::chrono::milliseconds& timeout, T* v)
+{
+    // The next element often comes soon, so spin before sleeping.
+    for (int i = 0; i < NUM_SPINS; ++i) {
+        if (tryTake(v))
+            return true;
+    }
+
+    bool taken;
+    {
+        std::unique_lock<std::mutex> lock(consumerMu_);
+        consumerWaiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        taken = pushed_.wait_for(lock, timeout, [this, v]() { return tryTakeWithoutNotify(v); });
+        consumerWaiting_.store(false, std::memory_order_relaxed);
+    }
+    if (taken)
+        notifyProducer();
+    return taken;
+}
+
+template<typename T>
+bool SPSCQueue<T>::tryPushWithoutNotify(T&& v)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= capacity_)
+        return false;
+
+    new (slot(tail)) T(std::move(v));
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+bool SPSCQueue<T>::tryTakeWithoutNotify(T* v)
+{
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+        return false;
+
+    T* p = slot(head);
+    *v = std::move(*p);
+    p->~T();
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+void SPSCQueue<T>::notifyConsumer()
+{
+    // The fence orders the store of |tail_| before the load of |consumerWaiting_|, and
+    // takeWithTimeout() does the opposite. So either the consumer sees the new element,
+    // or we see the waiting consumer.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerWaiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(consumerMu_);
+        pushed_.notify_one();
+    }
+}
+
+template<typename T>
+void SPSCQueue<T>::notifyProducer()
+{
+    // Same as notifyConsumer(), with |head_| and |producerWaiting_|.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (producerWaiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(producerMu_);
+        taken_.notify_one();
+    }
+}
+
+} // namespace base
+
+#endif // BASE_SPSC_QUEUE_H_
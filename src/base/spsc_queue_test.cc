@@ -0,0 +1,174 @@
+#include "base/spsc_queue.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+TEST(SPSCQueue, basic)
+{
+    base::SPSCQueue<int> q(2);
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(2U, q.capacity());
+
+    EXPECT_TRUE(q.tryPush(3));
+    EXPECT_TRUE(q.tryPush(5));
+    EXPECT_FALSE(q.tryPush(7));
+    EXPECT_EQ(2U, q.size());
+
+    int v;
+    EXPECT_TRUE(q.tryTake(&v));
+    EXPECT_EQ(3, v);
+    EXPECT_TRUE(q.tryPush(7));
+    EXPECT_TRUE(q.tryTake(&v));
+    EXPECT_EQ(5, v);
+    EXPECT_TRUE(q.tryTake(&v));
+    EXPECT_EQ(7, v);
+    EXPECT_FALSE(q.tryTake(&v));
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(SPSCQueue, moveOnly)
+{
+    base::SPSCQueue<std::unique_ptr<int>> q(2);
+
+    std::unique_ptr<int> p(new int(3));
+    EXPECT_TRUE(q.tryPush(std::move(p)));
+    EXPECT_FALSE(p.get());
+
+    std::unique_ptr<int> full(new int(5));
+    EXPECT_TRUE(q.tryPush(std::move(full)));
+    std::unique_ptr<int> notPushed(new int(7));
+    EXPECT_FALSE(q.tryPush(std::move(notPushed)));
+    ASSERT_TRUE(notPushed.get());
+
+    std::unique_ptr<int> v;
+    EXPECT_TRUE(q.tryTake(&v));
+    EXPECT_EQ(3, *v);
+    // The remaining element is destructed with the queue.
+}
+
+TEST(SPSCQueue, producer_consumer)
+{
+    const int N = 100000;
+    base::SPSCQueue<int> q(16);
+
+    std::thread producer([&q]() {
+        for (int i = 0; i < N; ++i) {
+            int v = i;
+            while (!q.tryPush(std::move(v)))
+                std::this_thread::yield();
+        }
+    });
+
+    std::thread consumer([&q]() {
+        for (int i = 0; i < N; ++i) {
+            int v;
+            while (!q.tryTake(&v))
+                std::this_thread::yield();
+            EXPECT_EQ(i, v);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(SPSCQueue, takeWithTimeout)
+{
+    base::SPSCQueue<int> q(2);
+
+    int v;
+    EXPECT_FALSE(q.takeWithTimeout(std::chrono::milliseconds(1), &v));
+
+    EXPECT_TRUE(q.tryPush(3));
+    EXPECT_TRUE(q.takeWithTimeout(std::chrono::milliseconds(1), &v));
+    EXPECT_EQ(3, v);
+
+    // The sleeping consumer is woken up by the producer.
+    std::thread producer([&q]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        int pushed = 5;
+        EXPECT_TRUE(q.tryPush(std::move(pushed)));
+    });
+    EXPECT_TRUE(q.takeWithTimeout(std::chrono::seconds(10), &v));
+    EXPECT_EQ(5, v);
+    producer.join();
+}
+
+TEST(SPSCQueue, producer_consumerWithTimeout)
+{
+    const int N = 100000;
+    base::SPSCQueue<int> q(16);
+
+    std::thread producer([&q]() {
+        for (int i = 0; i < N; ++i) {
+            int v = i;
+            while (!q.tryPush(std::move(v)))
+                std::this_thread::yield();
+        }
+    });
+
+    std::thread consumer([&q]() {
+        for (int i = 0; i < N; ++i) {
+            int v;
+            while (!q.takeWithTimeout(std::chrono::milliseconds(10), &v)) {}
+            EXPECT_EQ(i, v);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(SPSCQueue, pushWithTimeout)
+{
+    base::SPSCQueue<int> q(1);
+
+    int v = 1;
+    EXPECT_TRUE(q.pushWithTimeout(std::chrono::milliseconds(1), std::move(v)));
+    v = 2;
+    EXPECT_FALSE(q.pushWithTimeout(std::chrono::milliseconds(1), std::move(v)));
+
+    std::thread consumer([&q]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        int taken;
+        EXPECT_TRUE(q.tryTake(&taken));
+        EXPECT_EQ(1, taken);
+    });
+
+    EXPECT_TRUE(q.pushWithTimeout(std::chrono::seconds(10), std::move(v)));
+    consumer.join();
+
+    int taken;
+    EXPECT_TRUE(q.tryTake(&taken));
+    EXPECT_EQ(2, taken);
+}
+
+TEST(SPSCQueue, producer_consumerBothWithTimeout)
+{
+    const int N = 100000;
+    base::SPSCQueue<int> q(2);
+
+    std::thread producer([&q]() {
+        for (int i = 0; i < N; ++i) {
+            int v = i;
+            while (!q.pushWithTimeout(std::chrono::milliseconds(10), std::move(v))) {}
+        }
+    });
+
+    std::thread consumer([&q]() {
+        for (int i = 0; i < N; ++i) {
+            int v;
+            while (!q.takeWithTimeout(std::chrono::milliseconds(10), &v)) {}
+            EXPECT_EQ(i, v);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    EXPECT_TRUE(q.empty());
+}
@@ -123,8 +123,66 @@ static RealColor estimateRealColorFromColorCount(int colorCount[NUM_REAL_COLORS]
     return result;
 }
 
+// Returns true if the result of analyzeBox() should be checked with the recognizer.
+static bool needsRecognizer(RealColor rc)
+{
+    return rc == RealColor::RC_GREEN || rc == RealColor::RC_YELLOW || rc == RealColor::RC_OJAMA;
+}
+
+// Fixes |rc| detected by analyzeBox() with |recognized| by the recognizer.
+static RealColor refineWithRecognizer(RealColor rc, RealColor recognized)
+{
+    switch (rc) {
+    case RealColor::RC_GREEN:
+        if (recognized == RealColor::RC_EMPTY)
+            return recognized;
+        break;
+    case RealColor::RC_YELLOW:
+        if (recognized == RealColor::RC_EMPTY || recognized == RealColor::RC_PURPLE || recognized == RealColor::RC_OJAMA)
+            return recognized;
+        break;
+    case RealColor::RC_OJAMA:
+        if (recognized == RealColor::RC_PURPLE)
+            return recognized;
+        break;
+    default:
+        break;
+    }
+
+    return rc;
+}
+
+// Stores the pixels of |b| to the |box|-th box of |features|.
+// If |colorCount| is not nullptr, the colors of the pixels are counted as analyzeBox() does,
+// so that each pixel is read only once.
+static void extractFeatures(const SDL_Surface* surface, const Box& b,
+                            Recognizer::FeatureMatrix* features, int box,
+                            int colorCount[NUM_REAL_COLORS] = nullptr)
+{
+    CHECK_EQ(16, b.dx - b.sx);
+    CHECK_EQ(16, b.dy - b.sy);
+
+    int pos = 0;
+    for (int by = b.sy; by < b.dy; ++by) {
+        for (int bx = b.sx; bx < b.dx; ++bx) {
+            Uint32 c = getpixel(surface, bx, by);
+            Uint8 r, g, b;
+            SDL_GetRGB(c, surface->format, &r, &g, &b);
+
+            features->set(box, pos++, r);
+            features->set(box, pos++, g);
+            features->set(box, pos++, b);
+
+            if (colorCount)
+                colorCount[static_cast<int>(toRealColor(RGB(r, g, b)))]++;
+        }
+    }
+    CHECK_EQ(Recognizer::FEATURE_SIZE, pos);
+}
+
 ACAnalyzer::ACAnalyzer() :
-    recognizer_()
+    recognizer_(),
+    fieldFeatures_(6 * 12)
 {
 }
 
@@ -181,52 +239,19 @@ RealColor ACAnalyzer::analyzeBox(const SDL_Surface* surface, const Box& b,
 
 RealColor ACAnalyzer::analyzeBoxWithRecognizer(const SDL_Surface* surface, const Box& b) const
 {
-    CHECK_EQ(16, b.dx - b.sx);
-    CHECK_EQ(16, b.dy - b.sy);
+    Recognizer::FeatureMatrix features(1);
+    extractFeatures(surface, b, &features, features.addBox());
 
-    int pos = 0;
-    double features[16 * 16 * 3];
-    for (int by = b.sy; by < b.dy; ++by) {
-        for (int bx = b.sx; bx < b.dx; ++bx) {
-            Uint32 c = getpixel(surface, bx, by);
-            Uint8 r, g, b;
-            SDL_GetRGB(c, surface->format, &r, &g, &b);
-
-            features[pos++] = r;
-            features[pos++] = g;
-            features[pos++] = b;
-        }
-    }
-    CHECK_EQ(16 * 16 * 3, pos);
-    return recognizer_.recognize(features);
+    RealColor rc;
+    recognizer_.recognizeBatch(features, &rc);
+    return rc;
 }
 
 RealColor ACAnalyzer::analyzeBoxInField(const SDL_Surface* surface, const Box& b) const
 {
     RealColor rc = analyzeBox(surface, b);
-    switch (rc) {
-    case RealColor::RC_GREEN: {
-        RealColor rc2 = analyzeBoxWithRecognizer(surface, b);
-        if (rc2 == RealColor::RC_EMPTY)
-            rc = rc2;
-        break;
-    }
-    case RealColor::RC_YELLOW: {
-        RealColor rc2 = analyzeBoxWithRecognizer(surface, b);
-        if (rc2 == RealColor::RC_EMPTY || rc2 == RealColor::RC_PURPLE || rc2 == RealColor::RC_OJAMA)
-            rc = rc2;
-        break;
-    }
-    case RealColor::RC_OJAMA: {
-        RealColor rc2 = analyzeBoxWithRecognizer(surface, b);
-        if (rc2 == RealColor::RC_PURPLE)
-            rc = rc2;
-        break;
-    }
-    default:
-        break;
-    }
-
+    if (needsRecognizer(rc))
+        rc = refineWithRecognizer(rc, analyzeBoxWithRecognizer(surface, b));
     return rc;
 }
 
@@ -274,12 +299,33 @@ unique_ptr<DetectedField> ACAnalyzer::detectField(int pi,
 {
     unique_ptr<DetectedField> result(new DetectedField);
 
-    // detect field
-    for (int y = 1; y <= 12; ++y) {
-        for (int x = 1; x <= 6; ++x) {
-            Box b = BoundingBox::boxForAnalysis(pi, x, y);
-            RealColor rc = analyzeBoxInField(surface, b);
-            result->field.set(x, y, rc);
+    // detect field. This is the same as analyzeBoxInField() for each box, but the pixels of
+    // all the boxes are read in one pass, and all the boxes are recognized at once.
+    {
+        RealColor rcs[6 * 12];
+        RealColor recognized[6 * 12];
+
+        fieldFeatures_.clear();
+        for (int y = 1; y <= 12; ++y) {
+            for (int x = 1; x <= 6; ++x) {
+                Box b = BoundingBox::boxForAnalysis(pi, x, y);
+                int box = fieldFeatures_.addBox();
+                int colorCount[NUM_REAL_COLORS] {};
+                extractFeatures(surface, b, &fieldFeatures_, box, colorCount);
+                rcs[box] = estimateRealColorFromColorCount(colorCount, BOX_THRESHOLD);
+            }
+        }
+
+        recognizer_.recognizeBatch(fieldFeatures_, recognized);
+
+        for (int y = 1; y <= 12; ++y) {
+            for (int x = 1; x <= 6; ++x) {
+                int box = (y - 1) * 6 + (x - 1);
+                RealColor rc = rcs[box];
+                if (needsRecognizer(rc))
+                    rc = refineWithRecognizer(rc, recognized[box]);
+                result->field.set(x, y, rc);
+            }
         }
     }
 
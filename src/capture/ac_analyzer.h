@@ -54,6 +54,8 @@ private:
     void drawBoxWithAnalysisResult(SDL_Surface*, const Box&);
 
     Recognizer recognizer_;
+    // The features of the field boxes. This is reused for each frame.
+    Recognizer::FeatureMatrix fieldFeatures_;
 };
 
 #endif
@@ -0,0 +1,66 @@
+#include "capture/ac_analyzer.h"
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <SDL_image.h>
+
+#include "base/time.h"
+#include "base/time_stamp_counter.h"
+#include "gui/unique_sdl_surface.h"
+
+using namespace std;
+
+DECLARE_string(testdata_dir);
+
+TEST(ACAnalyzerPerformanceTest, analyzeFrame)
+{
+    const int N = 100;
+
+    vector<UniqueSDLSurface> surfaces;
+    for (int i = 1; i <= 8; ++i) {
+        string filename = FLAGS_testdata_dir + "/images/field/field" + to_string(i) + ".png";
+        surfaces.push_back(makeUniqueSDLSurface(IMG_Load(filename.c_str())));
+        CHECK(surfaces.back().get()) << "Failed to load " << filename;
+    }
+
+    ACAnalyzer analyzer;
+    TimeStampCounterData tscd;
+    vector<double> latencies;
+    for (int i = 0; i < N; ++i) {
+        for (const auto& surface : surfaces) {
+            double begin = currentTime();
+            {
+                ScopedTimeStampCounter stsc(&tscd);
+                analyzer.analyze(surface.get(), surface.get(), surface.get(), surface.get(),
+                                 deque<unique_ptr<AnalyzerResult>>());
+            }
+            latencies.push_back(currentTime() - begin);
+        }
+    }
+
+    tscd.showStatistics();
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[static_cast<size_t>(p * (latencies.size() - 1))] * 1000;
+    };
+    double sum = 0;
+    for (double latency : latencies)
+        sum += latency;
+    cout << "latency per frame [ms]:"
+         << " ave = " << (sum / latencies.size() * 1000)
+         << " p50 = " << percentile(0.5)
+         << " p90 = " << percentile(0.9)
+         << " p99 = " << percentile(0.99)
+         << " max = " << percentile(1.0) << endl;
+
+    // A frame comes every 16 ms. The maximum is not checked, since it's easily
+    // affected by the other processes on the machine.
+    EXPECT_LT(percentile(0.5), 16.0);
+}
@@ -1,5 +1,6 @@
 #include "capture/analyzer.h"
 
+#include <algorithm>
 #include <sstream>
 #include <queue>
 
@@ -96,6 +97,43 @@ AdjustedField::AdjustedField()
     }
 }
 
+bool operator==(const DetectedField& lhs, const DetectedField& rhs)
+{
+    return lhs.field == rhs.field &&
+        std::equal(lhs.nextPuyos, lhs.nextPuyos + NUM_NEXT_PUYO_POSITION, rhs.nextPuyos) &&
+        lhs.ojamaDropDetected == rhs.ojamaDropDetected &&
+        lhs.next1AxisMoving == rhs.next1AxisMoving;
+}
+
+bool operator==(const AdjustedField& lhs, const AdjustedField& rhs)
+{
+    return lhs.field == rhs.field &&
+        lhs.vanishing == rhs.vanishing &&
+        std::equal(lhs.nextPuyos, lhs.nextPuyos + NUM_NEXT_PUYO_POSITION, rhs.nextPuyos);
+}
+
+bool operator==(const PlayerAnalyzerResult& lhs, const PlayerAnalyzerResult& rhs)
+{
+    return lhs.userEvent == rhs.userEvent &&
+        lhs.playable == rhs.playable &&
+        lhs.detectedField == rhs.detectedField &&
+        lhs.adjustedField == rhs.adjustedField &&
+        lhs.numOjama == rhs.numOjama &&
+        lhs.restFramesUserCanPlay == rhs.restFramesUserCanPlay &&
+        lhs.nextPuyoState == rhs.nextPuyoState &&
+        lhs.framesWhileNext1Disappearing == rhs.framesWhileNext1Disappearing &&
+        lhs.framesWhileNext2Disappearing == rhs.framesWhileNext2Disappearing &&
+        lhs.next1Puyos == rhs.next1Puyos &&
+        lhs.next2Puyos == rhs.next2Puyos &&
+        lhs.nextHasDisappearedIrregularly_ == rhs.nextHasDisappearedIrregularly_ &&
+        lhs.framesAfterFloorGetsStable_ == rhs.framesAfterFloorGetsStable_ &&
+        lhs.hasDetectedRensaStart_ == rhs.hasDetectedRensaStart_ &&
+        lhs.hasDetectedPuyoErase_ == rhs.hasDetectedPuyoErase_ &&
+        lhs.hasSentGrounded_ == rhs.hasSentGrounded_ &&
+        lhs.hasSentOjamaDropped_ == rhs.hasSentOjamaDropped_ &&
+        lhs.nextWillDisappearFast_ == rhs.nextWillDisappearFast_;
+}
+
 void PlayerAnalyzerResult::resetCurrentPuyoState(bool state)
 {
     nextWillDisappearFast_ = false;
@@ -169,6 +207,26 @@ string AnalyzerResult::toString() const
     return oss.str();
 }
 
+bool operator==(const AnalyzerResult& lhs, const AnalyzerResult& rhs)
+{
+    if (lhs.state() != rhs.state())
+        return false;
+
+    for (int pi = 0; pi < 2; ++pi) {
+        const PlayerAnalyzerResult* l = lhs.playerResult(pi);
+        const PlayerAnalyzerResult* r = rhs.playerResult(pi);
+        if (!l || !r) {
+            if (l != r)
+                return false;
+            continue;
+        }
+        if (*l != *r)
+            return false;
+    }
+
+    return true;
+}
+
 unique_ptr<AnalyzerResult> AnalyzerResult::copy() const
 {
     unique_ptr<PlayerAnalyzerResult> p1(playerResult(0) ? new PlayerAnalyzerResult(*playerResult(0)) : nullptr);
@@ -50,6 +50,8 @@ struct DetectedField {
 
     void setOjamaDropDetected(bool flag) { ojamaDropDetected = flag; }
 
+    friend bool operator==(const DetectedField&, const DetectedField&);
+
     RealColorField field;
     RealColor nextPuyos[NUM_NEXT_PUYO_POSITION];
     bool ojamaDropDetected = false;
@@ -68,6 +70,8 @@ struct AdjustedField {
     bool isVanishing(int x, int y) const { return vanishing.get(x, y); }
     void setVanishing(int x, int y, bool flag) { vanishing.setBit(x, y, flag); }
 
+    friend bool operator==(const AdjustedField&, const AdjustedField&);
+
     RealColorField field;
     FieldChecker vanishing;
     RealColor nextPuyos[NUM_NEXT_PUYO_POSITION];
@@ -101,6 +105,11 @@ struct PlayerAnalyzerResult {
 
     std::string toString() const;
 
+    // Returns true if all the members are the same. The next analysis result
+    // depends on only these.
+    friend bool operator==(const PlayerAnalyzerResult&, const PlayerAnalyzerResult&);
+    friend bool operator!=(const PlayerAnalyzerResult& lhs, const PlayerAnalyzerResult& rhs) { return !(lhs == rhs); }
+
 public:
     // TODO(mayah): Make these private.
 
@@ -152,6 +161,9 @@ public:
 
     std::string toString() const;
 
+    friend bool operator==(const AnalyzerResult&, const AnalyzerResult&);
+    friend bool operator!=(const AnalyzerResult& lhs, const AnalyzerResult& rhs) { return !(lhs == rhs); }
+
 private:
     CaptureGameState gameState_;
     std::unique_ptr<PlayerAnalyzerResult> playerResults_[2];
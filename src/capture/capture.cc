@@ -1,21 +1,35 @@
 #include "capture/capture.h"
 
 #include "capture/source.h"
+#include "capture/source_reader.h"
 #include "gui/screen.h"
 #include "gui/SDL_prims.h"
 
 using namespace std;
 
+namespace {
+const size_t QUEUE_CAPACITY = 4;
+// The loop waits for a frame this long at most, and checks whether it should stop.
+const chrono::milliseconds TAKE_TIMEOUT(10);
+}
+
 Capture::Capture(Source* source, Analyzer* analyzer) :
     source_(source),
     analyzer_(analyzer),
+    // Capture doesn't drop frames. All frames are analyzed.
+    reader_(new SourceReader(source, QUEUE_CAPACITY, chrono::milliseconds(0))),
     shouldStop_(false),
     surface_(makeUniqueSDLSurface(nullptr))
 {
 }
 
+Capture::~Capture()
+{
+}
+
 bool Capture::start()
 {
+    reader_->start();
     th_ = thread([this](){
         this->runLoop();
     });
@@ -28,6 +42,7 @@ void Capture::stop()
     shouldStop_ = true;
     if (th_.joinable())
         th_.join();
+    reader_->stop();
 }
 
 void Capture::runLoop()
@@ -38,9 +53,14 @@ void Capture::runLoop()
     UniqueSDLSurface prev3Surface(emptyUniqueSDLSurface());
 
     while (!shouldStop_) {
-        UniqueSDLSurface surface(source_->nextFrame());
-        if (!surface.get())
+        CapturedFrame frame;
+        if (!reader_->take(&frame, TAKE_TIMEOUT)) {
+            if (reader_->done())
+                break;
             continue;
+        }
+
+        UniqueSDLSurface surface(std::move(frame.surface));
 
         // We set frameId to surface's userdata. This will be useful for saving screen shot.
         surface->userdata = reinterpret_cast<void*>(static_cast<uintptr_t>(++frameId));
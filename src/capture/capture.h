@@ -1,6 +1,7 @@
 #ifndef CAPTURE_CAPTURE_H_
 #define CAPTURE_CAPTURE_H_
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -13,6 +14,7 @@
 
 class Analyzer;
 class Source;
+class SourceReader;
 class Screen;
 
 class Capture : public Drawer, public AnalyzerResultRetriever {
@@ -20,7 +22,7 @@ public:
     // Does not take the ownership of |source| and |analyzer|.
     // They should be alive during Capture is alive.
     explicit Capture(Source* source, Analyzer* analyzer);
-    virtual ~Capture() {}
+    virtual ~Capture();
 
     bool start();
     void stop();
@@ -35,8 +37,10 @@ private:
     Source* source_;
     Analyzer* analyzer_;
 
+    // Frames are taken from |source_| in another thread, while the previous frame is analyzed.
+    std::unique_ptr<SourceReader> reader_;
     std::thread th_;
-    volatile bool shouldStop_;
+    std::atomic<bool> shouldStop_;
 
     mutable std::mutex mu_;
     UniqueSDLSurface surface_;
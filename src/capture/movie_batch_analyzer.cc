@@ -0,0 +1,211 @@
+#include "capture/movie_batch_analyzer.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include <glog/logging.h>
+#include <json/json.h>
+
+#include "base/executor.h"
+#include "capture/movie_source.h"
+#include "gui/unique_sdl_surface.h"
+
+using namespace std;
+
+namespace {
+
+// The same number as Capture keeps.
+const size_t MAX_HISTORY_SIZE = 10;
+// Analyzer sees 3 previous frames.
+const int MIN_WARMUP_FRAMES = 3;
+
+deque<unique_ptr<AnalyzerResult>> copyHistory(const deque<unique_ptr<AnalyzerResult>>& history)
+{
+    deque<unique_ptr<AnalyzerResult>> result;
+    for (const auto& r : history)
+        result.push_back(r->copy());
+    return result;
+}
+
+bool shouldRecord(const AnalyzerResult& r, const deque<unique_ptr<AnalyzerResult>>& history)
+{
+    if (history.empty() || history.front()->state() != r.state())
+        return true;
+
+    for (int pi = 0; pi < 2; ++pi) {
+        if (r.playerResult(pi) && r.playerResult(pi)->userEvent.hasEventState())
+            return true;
+    }
+
+    return false;
+}
+
+MovieFrameRecord makeRecord(int frame, const AnalyzerResult& r)
+{
+    MovieFrameRecord record;
+    record.frame = frame;
+    record.state = r.state();
+    for (int pi = 0; pi < 2; ++pi) {
+        const PlayerAnalyzerResult* pr = r.playerResult(pi);
+        if (!pr)
+            continue;
+
+        record.userEvents[pi] = pr->userEvent;
+        for (int y = 12; y >= 1; --y) {
+            for (int x = 1; x <= 6; ++x)
+                record.fields[pi] += toChar(pr->adjustedField.realColor(x, y), true, '.');
+        }
+        for (int i = 0; i < NUM_NEXT_PUYO_POSITION; ++i)
+            record.nexts[pi] += toChar(pr->adjustedField.realColor(static_cast<NextPuyoPosition>(i)), true, '.');
+    }
+    return record;
+}
+
+}
+
+MovieBatchAnalyzer::MovieBatchAnalyzer(const string& filename, AnalyzerFactory factory) :
+    filename_(filename),
+    analyzerFactory_(factory)
+{
+}
+
+bool MovieBatchAnalyzer::run(Executor* executor, int numShards, int warmupFrames)
+{
+    {
+        MovieSource source(filename_);
+        if (!source.ok())
+            return false;
+        if (!source.scanFrames(&pts_, &keyFrames_))
+            return false;
+    }
+
+    // Too short shards make the warm up dominant.
+    const int minFrames = std::max(warmupFrames, MIN_WARMUP_FRAMES) * 2;
+    shards_ = makeMovieShards(keyFrames_, numFrames(), numShards, std::max(warmupFrames, MIN_WARMUP_FRAMES), minFrames);
+    LOG(INFO) << "frames=" << numFrames() << " keyFrames=" << keyFrames_.size() << " shards=" << shards_.size();
+
+    vector<ShardResult> results(shards_.size());
+    {
+        TaskGroup taskGroup(executor);
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            taskGroup.run([this, i, &results]() {
+                analyzeShard(shards_[i], nullptr, &results[i]);
+            });
+        }
+        taskGroup.wait();
+    }
+
+    // Stitches the shards. The i-th shard is valid only when it started from the same
+    // previous results as the end of the (i-1)-th shard.
+    numResyncs_ = 0;
+    records_.clear();
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        if (i > 0 && !isSameHistory(results[i - 1].historyAtEnd, results[i].historyAtBegin)) {
+            LOG(INFO) << "resync shard " << i << ": begin=" << shards_[i].begin;
+            ++numResyncs_;
+            History seed = copyHistory(results[i - 1].historyAtEnd);
+            results[i] = ShardResult();
+            analyzeShard(shards_[i], &seed, &results[i]);
+        }
+
+        if (!results[i].ok)
+            return false;
+
+        records_.insert(records_.end(), results[i].records.begin(), results[i].records.end());
+    }
+
+    return true;
+}
+
+void MovieBatchAnalyzer::analyzeShard(const MovieShard& shard, const History* seed, ShardResult* result) const
+{
+    unique_ptr<MovieSource> source;
+    {
+        // Opening a codec is not thread-safe in some versions of ffmpeg.
+        static mutex mu;
+        lock_guard<mutex> lock(mu);
+        source.reset(new MovieSource(filename_));
+    }
+    if (!source->ok())
+        return;
+
+    source->setFPS(-1);
+    if (!source->seek(pts_[shard.warmupBegin]))
+        return;
+
+    unique_ptr<Analyzer> analyzer = analyzerFactory_();
+
+    History history;
+    if (seed)
+        history = copyHistory(*seed);
+
+    UniqueSDLSurface prevSurface(emptyUniqueSDLSurface());
+    UniqueSDLSurface prev2Surface(emptyUniqueSDLSurface());
+    UniqueSDLSurface prev3Surface(emptyUniqueSDLSurface());
+
+    while (true) {
+        UniqueSDLSurface surface = source->nextFrame();
+        if (!surface.get()) {
+            if (source->done())
+                break;
+            continue;
+        }
+
+        // Seeking might go back to a key frame before |warmupBegin|.
+        int frame = lower_bound(pts_.begin(), pts_.end(), source->lastFramePts()) - pts_.begin();
+        if (frame < shard.warmupBegin)
+            continue;
+        if (frame >= shard.end)
+            break;
+
+        if (frame == shard.begin)
+            result->historyAtBegin = copyHistory(history);
+
+        // With |seed|, the frames before the begin are decoded only for the previous surfaces.
+        if (!seed || frame >= shard.begin) {
+            unique_ptr<AnalyzerResult> r =
+                analyzer->analyze(surface.get(), prevSurface.get(), prev2Surface.get(), prev3Surface.get(), history);
+            if (frame >= shard.begin && shouldRecord(*r, history))
+                result->records.push_back(makeRecord(frame, *r));
+
+            history.push_front(move(r));
+            while (history.size() > MAX_HISTORY_SIZE)
+                history.pop_back();
+        }
+
+        prev3Surface = move(prev2Surface);
+        prev2Surface = move(prevSurface);
+        prevSurface = move(surface);
+    }
+
+    result->historyAtEnd = move(history);
+    result->ok = true;
+}
+
+string MovieBatchAnalyzer::toJson() const
+{
+    Json::Value root;
+    root["filename"] = filename_;
+    root["frames"] = numFrames();
+    root["shards"] = numShards();
+    root["resyncs"] = numResyncs();
+
+    Json::Value& rs = root["records"];
+    rs = Json::Value(Json::arrayValue);
+    for (const auto& record : records_) {
+        Json::Value v;
+        v["frame"] = record.frame;
+        v["state"] = toString(record.state);
+        for (int pi = 0; pi < 2; ++pi) {
+            Json::Value p;
+            p["event"] = record.userEvents[pi].toString();
+            p["field"] = record.fields[pi];
+            p["next"] = record.nexts[pi];
+            v["players"].append(p);
+        }
+        rs.append(v);
+    }
+
+    Json::StyledWriter writer;
+    return writer.write(root);
+}
@@ -0,0 +1,78 @@
+#ifndef CAPTURE_MOVIE_BATCH_ANALYZER_H_
+#define CAPTURE_MOVIE_BATCH_ANALYZER_H_
+
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "capture/analyzer.h"
+#include "capture/movie_shard.h"
+#include "core/user_event.h"
+
+class Executor;
+
+// MovieFrameRecord is the analysis result of a frame where something happened.
+struct MovieFrameRecord {
+    int frame;
+    CaptureGameState state;
+    UserEvent userEvents[2];
+    // The fields are in the format which RealColorField(const std::string&) can parse.
+    std::string fields[2];
+    // CURRENT_AXIS, CURRENT_CHILD, NEXT1_AXIS, ..., NEXT2_CHILD.
+    std::string nexts[2];
+};
+
+// MovieBatchAnalyzer analyzes a movie offline as fast as possible.
+// The movie is split into shards at key frames, and the shards are analyzed in parallel.
+// Since the analysis of a frame depends on the previous results, each shard starts
+// decoding some frames before its begin to warm up the previous results. If the warmed-up
+// results don't match with the results of the previous shard, the shard is analyzed again
+// with the results of the previous shard. So the result is the same as the sequential analysis.
+class MovieBatchAnalyzer : noncopyable {
+public:
+    typedef std::function<std::unique_ptr<Analyzer>()> AnalyzerFactory;
+
+    // MovieSource::init() should be called before run().
+    MovieBatchAnalyzer(const std::string& filename, AnalyzerFactory);
+
+    // When |executor| is nullptr, the shards are analyzed sequentially.
+    bool run(Executor*, int numShards, int warmupFrames);
+
+    int numFrames() const { return static_cast<int>(pts_.size()); }
+    int numShards() const { return static_cast<int>(shards_.size()); }
+    // The number of shards which are analyzed again since the warm up was not enough.
+    int numResyncs() const { return numResyncs_; }
+    const std::vector<MovieFrameRecord>& records() const { return records_; }
+
+    std::string toJson() const;
+
+private:
+    typedef std::deque<std::unique_ptr<AnalyzerResult>> History;
+
+    struct ShardResult {
+        bool ok = false;
+        History historyAtBegin;
+        History historyAtEnd;
+        std::vector<MovieFrameRecord> records;
+    };
+
+    // When |seed| is not nullptr, the frames before the shard begin are not analyzed,
+    // and |seed| is used as the previous results of the shard begin.
+    void analyzeShard(const MovieShard&, const History* seed, ShardResult*) const;
+
+    std::string filename_;
+    AnalyzerFactory analyzerFactory_;
+
+    std::vector<int64_t> pts_;
+    std::vector<int> keyFrames_;
+    std::vector<MovieShard> shards_;
+    int numResyncs_ = 0;
+    std::vector<MovieFrameRecord> records_;
+};
+
+#endif // CAPTURE_MOVIE_BATCH_ANALYZER_H_
@@ -0,0 +1,62 @@
+#include "capture/movie_shard.h"
+
+#include <algorithm>
+
+#include "capture/analyzer.h"
+
+using namespace std;
+
+vector<MovieShard> makeMovieShards(const vector<int>& keyFrames,
+                                   int numFrames,
+                                   int numShards,
+                                   int warmupFrames,
+                                   int minFrames)
+{
+    vector<MovieShard> shards;
+    if (numFrames <= 0)
+        return shards;
+
+    const int target = std::max(numFrames / std::max(numShards, 1), minFrames);
+
+    // The first shard always begins at 0, and doesn't need to warm up.
+    vector<int> begins { 0 };
+    for (int k : keyFrames) {
+        if (k - begins.back() < target)
+            continue;
+        // Don't make the last shard too short.
+        if (numFrames - k < minFrames)
+            break;
+        begins.push_back(k);
+    }
+
+    for (size_t i = 0; i < begins.size(); ++i) {
+        MovieShard shard;
+        shard.begin = begins[i];
+        shard.end = i + 1 < begins.size() ? begins[i + 1] : numFrames;
+        shard.warmupBegin = 0;
+        for (int k : keyFrames) {
+            if (k > shard.begin - warmupFrames)
+                break;
+            shard.warmupBegin = k;
+        }
+        if (shard.begin == 0)
+            shard.warmupBegin = 0;
+        shards.push_back(shard);
+    }
+
+    return shards;
+}
+
+bool isSameHistory(const deque<unique_ptr<AnalyzerResult>>& lhs,
+                   const deque<unique_ptr<AnalyzerResult>>& rhs)
+{
+    if (lhs.size() != rhs.size())
+        return false;
+
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (*lhs[i] != *rhs[i])
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef CAPTURE_MOVIE_SHARD_H_
+#define CAPTURE_MOVIE_SHARD_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+class AnalyzerResult;
+
+// MovieShard is a range of frames [begin, end) of a movie, which is analyzed by one worker.
+// The worker starts decoding at the key frame |warmupBegin|, and analyzes the frames in
+// [warmupBegin, begin) only to build the previous results for |begin|.
+struct MovieShard {
+    int warmupBegin;
+    int begin;
+    int end;
+};
+
+// Splits the frames [0, numFrames) into about |numShards| shards. Each shard begins at
+// a key frame, and has at least |minFrames| frames if possible. |keyFrames| should be sorted.
+// The warmupBegin of a shard is the last key frame that is at least |warmupFrames| before its begin.
+std::vector<MovieShard> makeMovieShards(const std::vector<int>& keyFrames,
+                                        int numFrames,
+                                        int numShards,
+                                        int warmupFrames,
+                                        int minFrames);
+
+// Returns true if |lhs| and |rhs| have the same results. When the previous results of 2 analyses
+// are the same, the following analyses give the same results for the same frames.
+bool isSameHistory(const std::deque<std::unique_ptr<AnalyzerResult>>& lhs,
+                   const std::deque<std::unique_ptr<AnalyzerResult>>& rhs);
+
+#endif // CAPTURE_MOVIE_SHARD_H_
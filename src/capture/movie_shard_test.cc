@@ -0,0 +1,85 @@
+#include "capture/movie_shard.h"
+
+#include <gtest/gtest.h>
+
+#include "capture/analyzer.h"
+
+using namespace std;
+
+namespace {
+
+unique_ptr<AnalyzerResult> makeResult(CaptureGameState state)
+{
+    return unique_ptr<AnalyzerResult>(new AnalyzerResult(state,
+                                                         unique_ptr<PlayerAnalyzerResult>(new PlayerAnalyzerResult),
+                                                         unique_ptr<PlayerAnalyzerResult>(new PlayerAnalyzerResult)));
+}
+
+}
+
+TEST(MovieShardTest, makeMovieShards)
+{
+    vector<int> keyFrames { 0, 100, 200, 300, 400, 500, 600, 700, 800, 900 };
+    vector<MovieShard> shards = makeMovieShards(keyFrames, 1000, 4, 150, 50);
+
+    ASSERT_EQ(4U, shards.size());
+
+    EXPECT_EQ(0, shards[0].warmupBegin);
+    EXPECT_EQ(0, shards[0].begin);
+    EXPECT_EQ(300, shards[0].end);
+
+    EXPECT_EQ(100, shards[1].warmupBegin);
+    EXPECT_EQ(300, shards[1].begin);
+    EXPECT_EQ(600, shards[1].end);
+
+    EXPECT_EQ(400, shards[2].warmupBegin);
+    EXPECT_EQ(600, shards[2].begin);
+    EXPECT_EQ(900, shards[2].end);
+
+    EXPECT_EQ(700, shards[3].warmupBegin);
+    EXPECT_EQ(900, shards[3].begin);
+    EXPECT_EQ(1000, shards[3].end);
+}
+
+TEST(MovieShardTest, makeMovieShardsWithoutEnoughKeyFrames)
+{
+    // Only the first frame is a key frame.
+    vector<MovieShard> shards = makeMovieShards(vector<int> { 0 }, 1000, 4, 150, 50);
+    ASSERT_EQ(1U, shards.size());
+    EXPECT_EQ(0, shards[0].begin);
+    EXPECT_EQ(1000, shards[0].end);
+
+    EXPECT_TRUE(makeMovieShards(vector<int> {}, 0, 4, 150, 50).empty());
+}
+
+TEST(MovieShardTest, makeMovieShardsAvoidsShortLastShard)
+{
+    vector<int> keyFrames { 0, 250, 500, 750, 980 };
+    vector<MovieShard> shards = makeMovieShards(keyFrames, 1000, 5, 100, 50);
+
+    ASSERT_EQ(4U, shards.size());
+    EXPECT_EQ(750, shards[3].begin);
+    EXPECT_EQ(1000, shards[3].end);
+    // No key frame is 100 frames before 250.
+    EXPECT_EQ(0, shards[1].warmupBegin);
+    EXPECT_EQ(250, shards[2].warmupBegin);
+}
+
+TEST(MovieShardTest, isSameHistory)
+{
+    deque<unique_ptr<AnalyzerResult>> h1;
+    deque<unique_ptr<AnalyzerResult>> h2;
+    EXPECT_TRUE(isSameHistory(h1, h2));
+
+    h1.push_front(makeResult(CaptureGameState::PLAYING));
+    EXPECT_FALSE(isSameHistory(h1, h2));
+
+    h2.push_front(makeResult(CaptureGameState::PLAYING));
+    EXPECT_TRUE(isSameHistory(h1, h2));
+
+    h2.front()->mutablePlayerResult(0)->userEvent.grounded = true;
+    EXPECT_FALSE(isSameHistory(h1, h2));
+
+    h2.front() = makeResult(CaptureGameState::LEVEL_SELECT);
+    EXPECT_FALSE(isSameHistory(h1, h2));
+}
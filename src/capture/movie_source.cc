@@ -1,6 +1,8 @@
 #include "capture/movie_source.h"
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 using namespace std;
 
@@ -135,6 +137,7 @@ UniqueSDLSurface MovieSource::getNextFrame()
                                             SWS_BICUBIC, NULL, NULL, NULL);
 
                 sws_scale(sws_, frame_->data, frame_->linesize, 0, height_, frame_rgb_->data, frame_rgb_->linesize);
+                lastFramePts_ = av_frame_get_best_effort_timestamp(frame_);
                 break;
             }
         }
@@ -150,7 +153,7 @@ UniqueSDLSurface MovieSource::getNextFrame()
             SDL_Delay(10);
         }
         waitUntilTrue_ = false;
-    } else if (static_cast<int>(elapsed) < 1000 / fps_) {
+    } else if (fps_ > 0 && static_cast<int>(elapsed) < 1000 / fps_) {
         int d = 1000 / fps_ - elapsed;
         SDL_Delay(d);
     }
@@ -159,6 +162,46 @@ UniqueSDLSurface MovieSource::getNextFrame()
     return makeUniqueSDLSurface(SDL_ConvertSurface(surf_.get(), surf_->format, 0));
 }
 
+bool MovieSource::scanFrames(vector<int64_t>* pts, vector<int>* keyFrames)
+{
+    // (pts, is key frame)
+    vector<pair<int64_t, bool>> frames;
+
+    AVPacket packet;
+    while (av_read_frame(format_, &packet) >= 0) {
+        if (packet.stream_index == video_index_) {
+            int64_t t = packet.pts != static_cast<int64_t>(AV_NOPTS_VALUE) ? packet.pts : packet.dts;
+            frames.emplace_back(t, (packet.flags & AV_PKT_FLAG_KEY) != 0);
+        }
+        av_free_packet(&packet);
+    }
+
+    // Packets are in the decoding order. Sort them in the display order.
+    sort(frames.begin(), frames.end());
+
+    pts->clear();
+    keyFrames->clear();
+    for (size_t i = 0; i < frames.size(); ++i) {
+        pts->push_back(frames[i].first);
+        if (frames[i].second)
+            keyFrames->push_back(i);
+    }
+
+    return seek(frames.empty() ? 0 : frames.front().first);
+}
+
+bool MovieSource::seek(int64_t pts)
+{
+    if (av_seek_frame(format_, video_index_, pts, AVSEEK_FLAG_BACKWARD) < 0) {
+        fprintf(stderr, "Couldn't seek to %lld\n", static_cast<long long>(pts));
+        return false;
+    }
+
+    avcodec_flush_buffers(codec_);
+    done_ = false;
+    return true;
+}
+
 void MovieSource::init()
 {
     av_register_all();
@@ -5,6 +5,7 @@
 
 #include <atomic>
 #include <string>
+#include <vector>
 
 #include <SDL.h>
 
@@ -26,9 +27,20 @@ public:
 
     virtual UniqueSDLSurface getNextFrame();
 
+    // When |fps| is 0, a frame is returned after nextStep() is called.
+    // When |fps| is negative, frames are returned as fast as possible.
     void setFPS(int fps) { fps_ = fps; }
     void nextStep();
 
+    // Reads all the packets of the video stream without decoding them. The pts of
+    // the frames in the display order are stored to |pts|, and the indices of the key
+    // frames in |pts| are stored to |keyFrames|. Then, this seeks to the beginning.
+    bool scanFrames(std::vector<int64_t>* pts, std::vector<int>* keyFrames);
+    // Seeks to the key frame at or before |pts|.
+    bool seek(int64_t pts);
+    // The pts of the frame returned by the last getNextFrame().
+    int64_t lastFramePts() const { return lastFramePts_; }
+
     static void init();
 
 private:
@@ -47,6 +59,7 @@ private:
 
     AVPacket packet_;
     SwsContext* sws_;
+    int64_t lastFramePts_ = 0;
 
     UniqueSDLSurface surf_;
 };
@@ -1,10 +1,13 @@
+#include <fstream>
 #include <iostream>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "base/executor.h"
 #include "capture/ac_analyzer.h"
 #include "capture/capture.h"
+#include "capture/movie_batch_analyzer.h"
 #include "capture/movie_source.h"
 #include "capture/movie_source_key_listener.h"
 #include "gui/bounding_box_drawer.h"
@@ -17,8 +20,44 @@
 #endif
 
 
+DECLARE_int32(num_threads);
+
 DEFINE_bool(draw_result, true, "draw analyzer result");
 DEFINE_int32(fps, 60, "FPS. When 0, hitting space will go next step.");
+DEFINE_bool(batch, false, "analyze the movie offline without GUI, and output the result as JSON");
+DEFINE_string(output, "", "the JSON output path in batch mode. When empty, stdout is used.");
+DEFINE_int32(shards, 0, "the number of shards in batch mode. When 0, 4 * num_threads is used.");
+DEFINE_int32(warmup_frames, 300, "the number of frames to warm up each shard in batch mode");
+
+static int runBatch(const char* filename)
+{
+    unique_ptr<Executor> executor = Executor::makeDefaultExecutor();
+    int numShards = FLAGS_shards > 0 ? FLAGS_shards : 4 * FLAGS_num_threads;
+
+    MovieBatchAnalyzer batchAnalyzer(filename, []() {
+        return unique_ptr<Analyzer>(new ACAnalyzer);
+    });
+    bool ok = batchAnalyzer.run(executor.get(), numShards, FLAGS_warmup_frames);
+    executor->stop();
+
+    if (!ok) {
+        fprintf(stderr, "Failed to analyze %s\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    LOG(INFO) << "frames=" << batchAnalyzer.numFrames()
+              << " shards=" << batchAnalyzer.numShards()
+              << " resyncs=" << batchAnalyzer.numResyncs();
+
+    if (FLAGS_output.empty()) {
+        cout << batchAnalyzer.toJson();
+    } else {
+        ofstream ofs(FLAGS_output);
+        ofs << batchAnalyzer.toJson();
+    }
+
+    return EXIT_SUCCESS;
+}
 
 int main(int argc, char* argv[])
 {
@@ -32,6 +71,9 @@ int main(int argc, char* argv[])
 
     MovieSource::init();
 
+    if (FLAGS_batch)
+        return runBatch(argv[1]);
+
     SDL_Init(SDL_INIT_VIDEO);
     atexit(SDL_Quit);
 
@@ -31,3 +31,14 @@ RealColorField::RealColorField(const std::string& url) :
         counter++;
     }
 }
+
+bool operator==(const RealColorField& lhs, const RealColorField& rhs)
+{
+    for (int x = 0; x < FieldConstant::MAP_WIDTH; ++x) {
+        for (int y = 0; y < FieldConstant::MAP_HEIGHT; ++y) {
+            if (lhs.field_[x][y] != rhs.field_[x][y])
+                return false;
+        }
+    }
+    return true;
+}
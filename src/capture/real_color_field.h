@@ -16,6 +16,9 @@ public:
     RealColor color(int x, int y) const { return field_[x][y]; }
     void setColor(int x, int y, RealColor rc) { field_[x][y] = rc; }
 
+    friend bool operator==(const RealColorField&, const RealColorField&);
+    friend bool operator!=(const RealColorField& lhs, const RealColorField& rhs) { return !(lhs == rhs); }
+
 private:
     RealColor field_[MAP_WIDTH][MAP_HEIGHT];
 };
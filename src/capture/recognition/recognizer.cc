@@ -3,10 +3,89 @@
 #include <algorithm>
 #include <vector>
 
+#if defined(__AVX2__) && defined(__FMA__)
+#include <x86intrin.h>
+#endif
+
+#include <glog/logging.h>
+
 #include "capture/recognition/classifier_features.h"
 
 using namespace std;
 
+static_assert(NUM_RECOGNITION == 8, "the batch kernel scores 8 classes at once");
+
+namespace {
+
+// The number of boxes scored at once.
+const int BOX_BLOCK = 8;
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+// Scores BOX_BLOCK boxes from |features| against all the classes, and stores
+// the index of the best class of each box to |indices|.
+// Each feature of the 8 boxes is loaded once, and multiplied with the weights of the 8 classes,
+// so the 8 x 8 scores are kept in registers during the loop.
+void scoreBlock(const float* features, int stride, const float* weights, int indices[BOX_BLOCK])
+{
+    __m256 scores[NUM_RECOGNITION];
+    for (int i = 0; i < NUM_RECOGNITION; ++i)
+        scores[i] = _mm256_setzero_ps();
+
+    for (int j = 0; j < Recognizer::FEATURE_SIZE; ++j) {
+        const __m256 x = _mm256_loadu_ps(features + j * stride);
+        const float* w = weights + j * NUM_RECOGNITION;
+        for (int i = 0; i < NUM_RECOGNITION; ++i)
+            scores[i] = _mm256_fmadd_ps(_mm256_broadcast_ss(w + i), x, scores[i]);
+    }
+
+    // Take the first class that has the max score, as std::max_element does.
+    __m256 best = scores[0];
+    __m256i bestIndex = _mm256_setzero_si256();
+    for (int i = 1; i < NUM_RECOGNITION; ++i) {
+        const __m256 greater = _mm256_cmp_ps(scores[i], best, _CMP_GT_OQ);
+        best = _mm256_blendv_ps(best, scores[i], greater);
+        bestIndex = _mm256_blendv_epi8(bestIndex, _mm256_set1_epi32(i), _mm256_castps_si256(greater));
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+}
+
+#else
+
+void scoreBlock(const float* features, int stride, const float* weights, int indices[BOX_BLOCK])
+{
+    float scores[BOX_BLOCK][NUM_RECOGNITION] {};
+    for (int j = 0; j < Recognizer::FEATURE_SIZE; ++j) {
+        const float* x = features + j * stride;
+        const float* w = weights + j * NUM_RECOGNITION;
+        for (int b = 0; b < BOX_BLOCK; ++b) {
+            for (int i = 0; i < NUM_RECOGNITION; ++i)
+                scores[b][i] += w[i] * x[b];
+        }
+    }
+
+    for (int b = 0; b < BOX_BLOCK; ++b)
+        indices[b] = std::max_element(scores[b], scores[b] + NUM_RECOGNITION) - scores[b];
+}
+
+#endif
+
+} // anonymous namespace
+
+Recognizer::FeatureMatrix::FeatureMatrix(int maxBoxes) :
+    maxBoxes_(maxBoxes),
+    stride_((maxBoxes + BOX_BLOCK - 1) / BOX_BLOCK * BOX_BLOCK),
+    data_(static_cast<size_t>(FEATURE_SIZE) * stride_)
+{
+}
+
+int Recognizer::FeatureMatrix::addBox()
+{
+    CHECK_LT(numBoxes_, maxBoxes_);
+    return numBoxes_++;
+}
+
 Recognizer::Recognizer()
 {
     arows[static_cast<int>(RecognitionColor::RED)].setMean(std::vector<double>(RED_MEAN, RED_MEAN + RED_MEAN_SIZE));
@@ -27,6 +106,13 @@ Recognizer::Recognizer()
     arows[static_cast<int>(RecognitionColor::OJAMA)].setCov(std::vector<double>(OJAMA_COV, OJAMA_COV + OJAMA_COV_SIZE));
     arows[static_cast<int>(RecognitionColor::ZENKESHI)].setCov(std::vector<double>(ZENKESHI_COV, ZENKESHI_COV + ZENKESHI_COV_SIZE));
 
+    weights_.resize(FEATURE_SIZE * NUM_RECOGNITION);
+    for (int i = 0; i < NUM_RECOGNITION; ++i) {
+        const vector<double>& mean = arows[i].mean();
+        CHECK_EQ(static_cast<size_t>(FEATURE_SIZE), mean.size());
+        for (int j = 0; j < FEATURE_SIZE; ++j)
+            weights_[j * NUM_RECOGNITION + i] = static_cast<float>(mean[j]);
+    }
 }
 
 RealColor Recognizer::recognize(const double features[16 * 16 * 3]) const
@@ -38,3 +124,14 @@ RealColor Recognizer::recognize(const double features[16 * 16 * 3]) const
     int idx = std::max_element(vs, vs + NUM_RECOGNITION) - vs;
     return toRealColor(static_cast<RecognitionColor>(idx));
 }
+
+void Recognizer::recognizeBatch(const FeatureMatrix& features, RealColor results[]) const
+{
+    // The unused boxes in the last block are scored, too. Their results are just ignored.
+    for (int b = 0; b < features.numBoxes(); b += BOX_BLOCK) {
+        int indices[BOX_BLOCK];
+        scoreBlock(features.data() + b, features.stride(), weights_.data(), indices);
+        for (int k = 0; k < BOX_BLOCK && b + k < features.numBoxes(); ++k)
+            results[b + k] = toRealColor(static_cast<RecognitionColor>(indices[k]));
+    }
+}
@@ -1,18 +1,59 @@
 #ifndef CAPTURE_RECOGNITION_RECOGNIZER_H_
 #define CAPTURE_RECOGNITION_RECOGNIZER_H_
 
+#include <vector>
+
+#include "base/noncopyable.h"
 #include "capture/recognition/recognition_color.h"
 #include "core/real_color.h"
 #include "learning/arow.h"
 
 class Recognizer {
 public:
+    // A box is 16x16 pixels, and each pixel has r, g, b.
+    static const int FEATURE_SIZE = 16 * 16 * 3;
+
+    // FeatureMatrix has the features of several boxes. Features are stored in
+    // feature-major order, i.e. the same feature of the boxes are contiguous,
+    // so that several boxes can be scored at once.
+    class FeatureMatrix : noncopyable {
+    public:
+        explicit FeatureMatrix(int maxBoxes);
+
+        int maxBoxes() const { return maxBoxes_; }
+        int numBoxes() const { return numBoxes_; }
+        // The distance between the same box of 2 adjacent features. This is a multiple of 8.
+        int stride() const { return stride_; }
+
+        void clear() { numBoxes_ = 0; }
+        // Adds a new box, and returns its index.
+        int addBox();
+
+        float get(int box, int feature) const { return data_[feature * stride_ + box]; }
+        void set(int box, int feature, float value) { data_[feature * stride_ + box] = value; }
+
+        const float* data() const { return data_.data(); }
+
+    private:
+        int maxBoxes_;
+        int stride_;
+        int numBoxes_ = 0;
+        std::vector<float> data_;
+    };
+
     Recognizer();
 
-    RealColor recognize(const double features[16 * 16 * 3]) const;
+    RealColor recognize(const double features[FEATURE_SIZE]) const;
+
+    // Recognizes all the boxes in |features|. The result of i-th box is stored to results[i].
+    void recognizeBatch(const FeatureMatrix& features, RealColor results[]) const;
 
 private:
     Arow arows[NUM_RECOGNITION];
+
+    // The weights of the classes in float. weights_[j * NUM_RECOGNITION + i] is the
+    // weight of the j-th feature for the i-th class.
+    std::vector<float> weights_;
 };
 
 #endif // CAPTURE_RECOGNITION_RECOGNIZER_H_
@@ -0,0 +1,51 @@
+#include "capture/recognition/recognizer.h"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+TEST(RecognizerTest, featureMatrix)
+{
+    Recognizer::FeatureMatrix features(13);
+    EXPECT_EQ(13, features.maxBoxes());
+    EXPECT_EQ(16, features.stride());
+    EXPECT_EQ(0, features.numBoxes());
+
+    EXPECT_EQ(0, features.addBox());
+    EXPECT_EQ(1, features.addBox());
+    EXPECT_EQ(2, features.numBoxes());
+
+    features.set(1, 5, 3.0f);
+    EXPECT_EQ(3.0f, features.get(1, 5));
+    EXPECT_EQ(3.0f, features.data()[5 * features.stride() + 1]);
+
+    features.clear();
+    EXPECT_EQ(0, features.numBoxes());
+}
+
+TEST(RecognizerTest, recognizeBatch)
+{
+    Recognizer recognizer;
+    mt19937 mt(1);
+    uniform_int_distribution<int> dist(0, 255);
+
+    for (int numBoxes : { 1, 7, 8, 13, 72 }) {
+        vector<vector<double>> boxes(numBoxes, vector<double>(16 * 16 * 3));
+        Recognizer::FeatureMatrix features(numBoxes);
+        for (int b = 0; b < numBoxes; ++b) {
+            EXPECT_EQ(b, features.addBox());
+            for (int j = 0; j < 16 * 16 * 3; ++j) {
+                boxes[b][j] = dist(mt);
+                features.set(b, j, static_cast<float>(boxes[b][j]));
+            }
+        }
+
+        vector<RealColor> results(numBoxes);
+        recognizer.recognizeBatch(features, results.data());
+        for (int b = 0; b < numBoxes; ++b)
+            EXPECT_EQ(recognizer.recognize(boxes[b].data()), results[b]) << numBoxes << ' ' << b;
+    }
+}
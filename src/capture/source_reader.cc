@@ -0,0 +1,90 @@
+#include "capture/source_reader.h"
+
+#include <glog/logging.h>
+
+#include "capture/source.h"
+
+using namespace std;
+
+namespace {
+// The reader wakes up in this interval to check whether it should stop.
+const chrono::milliseconds PUSH_TIMEOUT(10);
+}
+
+SourceReader::SourceReader(Source* source, size_t capacity, chrono::milliseconds staleness) :
+    source_(source),
+    staleness_(staleness),
+    queue_(capacity),
+    shouldStop_(false),
+    finished_(false),
+    numNoSurfaces_(0)
+{
+}
+
+SourceReader::~SourceReader()
+{
+    stop();
+}
+
+void SourceReader::start()
+{
+    th_ = thread([this]() {
+        this->runLoop();
+    });
+}
+
+void SourceReader::stop()
+{
+    shouldStop_ = true;
+    if (th_.joinable())
+        th_.join();
+}
+
+void SourceReader::runLoop()
+{
+    while (!shouldStop_) {
+        auto begin = chrono::steady_clock::now();
+
+        CapturedFrame frame;
+        frame.surface = source_->nextFrame();
+        frame.capturedTime = chrono::steady_clock::now();
+
+        if (!frame.surface.get()) {
+            int count = ++numNoSurfaces_;
+            LOG(INFO) << "No surface?: count=" << count << " done=" << source_->done();
+            if (source_->done())
+                break;
+            // TODO(mayah): Why not sleep?
+            continue;
+        }
+
+        captureLatency_.add(chrono::duration<double>(frame.capturedTime - begin).count());
+
+        // When the queue is full, the consumer is behind. Wait for it instead of dropping
+        // the new frame. The old frames will be dropped by take() if they are stale.
+        while (!queue_.pushWithTimeout(PUSH_TIMEOUT, std::move(frame))) {
+            if (shouldStop_)
+                break;
+        }
+    }
+
+    finished_ = true;
+}
+
+bool SourceReader::take(CapturedFrame* frame, chrono::milliseconds timeout)
+{
+    if (!queue_.takeWithTimeout(timeout, frame))
+        return false;
+
+    auto now = chrono::steady_clock::now();
+    if (staleness_.count() > 0) {
+        // Skip to a newer frame while the taken frame is stale.
+        while (now - frame->capturedTime > staleness_ && queue_.tryTake(frame)) {
+            ++numDroppedFrames_;
+            now = chrono::steady_clock::now();
+        }
+    }
+
+    queueLatency_.add(chrono::duration<double>(now - frame->capturedTime).count());
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef CAPTURE_SOURCE_READER_H_
+#define CAPTURE_SOURCE_READER_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "base/latency_histogram.h"
+#include "base/noncopyable.h"
+#include "base/spsc_queue.h"
+#include "gui/unique_sdl_surface.h"
+
+class Source;
+
+struct CapturedFrame {
+    CapturedFrame() : surface(emptyUniqueSDLSurface()) {}
+
+    UniqueSDLSurface surface;
+    // When the frame is taken from the source.
+    std::chrono::steady_clock::time_point capturedTime;
+};
+
+// SourceReader takes frames from Source in its own thread, and passes them to
+// another thread via a bounded lock-free queue. So the frame acquisition doesn't
+// wait for the analysis of the previous frame.
+// Only one thread can call take().
+class SourceReader : noncopyable {
+public:
+    // Doesn't take the ownership of |source|.
+    // A frame that stays in the queue for longer than |staleness| is dropped, if a newer
+    // frame is available. 0 means no frame is dropped.
+    SourceReader(Source*, size_t capacity, std::chrono::milliseconds staleness);
+    ~SourceReader();
+
+    void start();
+    void stop();
+
+    // Takes the next frame in order. When no frame is available, waits for |timeout| at most,
+    // and returns false.
+    bool take(CapturedFrame*, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    // Returns true if the source doesn't have a frame any more, and all the frames have been taken.
+    bool done() const { return finished_ && queue_.empty(); }
+
+    int numDroppedFrames() const { return numDroppedFrames_; }
+    // The number of times the source didn't return a frame.
+    int numNoSurfaces() const { return numNoSurfaces_; }
+
+    // The latency histograms. These should be called after stop().
+    const LatencyHistogram& captureLatency() const { return captureLatency_; }
+    const LatencyHistogram& queueLatency() const { return queueLatency_; }
+
+private:
+    void runLoop();
+
+    Source* source_;
+    std::chrono::milliseconds staleness_;
+    base::SPSCQueue<CapturedFrame> queue_;
+
+    std::thread th_;
+    std::atomic<bool> shouldStop_;
+    std::atomic<bool> finished_;
+    std::atomic<int> numNoSurfaces_;
+
+    // Updated by the thread calling take().
+    int numDroppedFrames_ = 0;
+    LatencyHistogram queueLatency_;
+    // Updated by the reader thread.
+    LatencyHistogram captureLatency_;
+};
+
+#endif // CAPTURE_SOURCE_READER_H_
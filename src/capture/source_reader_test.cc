@@ -0,0 +1,86 @@
+#include "capture/source_reader.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "capture/source.h"
+
+using namespace std;
+
+namespace {
+
+// FakeSource returns |numFrames| frames. The frame number is set to userdata.
+class FakeSource : public Source {
+public:
+    explicit FakeSource(int numFrames) : numFrames_(numFrames) { ok_ = true; }
+
+protected:
+    UniqueSDLSurface getNextFrame() override
+    {
+        if (count_ >= numFrames_) {
+            end();
+            return emptyUniqueSDLSurface();
+        }
+
+        UniqueSDLSurface surface(makeUniqueSDLSurface(SDL_CreateRGBSurface(0, 1, 1, 32, 0, 0, 0, 0)));
+        surface->userdata = reinterpret_cast<void*>(static_cast<uintptr_t>(++count_));
+        return surface;
+    }
+
+private:
+    int numFrames_;
+    int count_ = 0;
+};
+
+int frameNumber(const CapturedFrame& frame)
+{
+    return static_cast<int>(reinterpret_cast<uintptr_t>(frame.surface->userdata));
+}
+
+}
+
+TEST(SourceReaderTest, inOrder)
+{
+    FakeSource source(100);
+    SourceReader reader(&source, 4, chrono::milliseconds(0));
+    reader.start();
+
+    int expected = 1;
+    while (!reader.done()) {
+        CapturedFrame frame;
+        if (!reader.take(&frame, chrono::milliseconds(10)))
+            continue;
+        EXPECT_EQ(expected++, frameNumber(frame));
+        // Makes the consumer slower than the producer.
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+    reader.stop();
+
+    EXPECT_EQ(101, expected);
+    EXPECT_EQ(0, reader.numDroppedFrames());
+    EXPECT_EQ(100, reader.captureLatency().count());
+    EXPECT_EQ(100, reader.queueLatency().count());
+}
+
+TEST(SourceReaderTest, dropStaleFrames)
+{
+    FakeSource source(4);
+    SourceReader reader(&source, 4, chrono::milliseconds(1));
+    reader.start();
+
+    // Wait until all the frames are queued, and they become stale.
+    while (reader.numNoSurfaces() == 0)
+        this_thread::yield();
+    this_thread::sleep_for(chrono::milliseconds(10));
+
+    // The stale frames are dropped except the newest one.
+    CapturedFrame frame;
+    ASSERT_TRUE(reader.take(&frame));
+    EXPECT_EQ(4, frameNumber(frame));
+    EXPECT_EQ(3, reader.numDroppedFrames());
+    EXPECT_FALSE(reader.take(&frame));
+    EXPECT_TRUE(reader.done());
+}
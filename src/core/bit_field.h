@@ -100,6 +100,8 @@ public:
 #endif
 
 private:
+    template<int N> friend class BitFieldBatch;
+
     BitField escapeInvisible();
     void recoverInvisible(const BitField&);
 
@@ -0,0 +1,492 @@
+#ifndef CORE_BIT_FIELD_BATCH_H_
+#define CORE_BIT_FIELD_BATCH_H_
+
+#include <glog/logging.h>
+
+#include "base/base.h"
+#include "base/builtin.h"
+#include "base/sse.h"
+#include "core/bit_field.h"
+#include "core/field_bits.h"
+#include "core/frame.h"
+#include "core/rensa_result.h"
+#include "core/rensa_tracker.h"
+#include "core/score.h"
+
+#if defined(__AVX2__) && defined(__BMI2__)
+#include "core/field_bits_256.h"
+#endif
+
+// BitFieldBatch holds N BitFields in structure-of-arrays form, and simulates rensa
+// of all of them at once.
+//
+// The i-th plane of lane 2k and lane 2k+1 are adjacent in memory, so when AVX2 is
+// available, one ymm register holds the same plane of 2 fields, and vanishment is
+// calculated for 2 fields at once. Otherwise, each lane is simulated with SSE.
+// The lanes whose rensa has finished are excluded from the next step (per-lane early exit).
+//
+// Trackers are passed as an array of N trackers. trackers[i] tracks the i-th lane.
+template<int N>
+class BitFieldBatch {
+    static_assert(N == 2 || N == 4 || N == 8, "BitFieldBatch supports only 2, 4 or 8 lanes.");
+public:
+    typedef BitField::SimulationContext SimulationContext;
+
+    static const int NUM_LANES = N;
+    static const int ALL_LANES = (1 << N) - 1;
+
+    // All lanes are initialized with an empty field.
+    BitFieldBatch() { clear(); }
+
+    // Makes all lanes empty.
+    void clear();
+
+    void set(int i, const BitField& bf)
+    {
+        DCHECK(0 <= i && i < N) << i;
+        for (int p = 0; p < 3; ++p)
+            m_[p][i] = bf.m_[p];
+    }
+
+    BitField get(int i) const
+    {
+        DCHECK(0 <= i && i < N) << i;
+        BitField bf;
+        for (int p = 0; p < 3; ++p)
+            bf.m_[p] = m_[p][i];
+        return bf;
+    }
+
+    // Simulates rensa of all lanes. |results| should have N elements.
+    void simulateBatch(RensaResult results[N]);
+    // Simulates rensa of all lanes with SimulationContext and Tracker.
+    // |contexts|, |results| and |trackers| should have N elements.
+    template<typename Tracker>
+    void simulateBatch(SimulationContext contexts[N], RensaResult results[N], Tracker trackers[N]);
+
+    // Faster version of simulateBatch(). The number of chains is set to |chains|.
+    void simulateFastBatch(int chains[N]);
+    template<typename Tracker>
+    void simulateFastBatch(int chains[N], Tracker trackers[N]);
+
+    // Vanishes the connected puyos, and drop the puyos in the air for each lane.
+    // The lane whose score is 0 in |results| didn't vanish anything.
+    template<typename Tracker>
+    void vanishDropBatch(SimulationContext contexts[N], RensaStepResult results[N], Tracker trackers[N]);
+
+private:
+    void escapeInvisible(FieldBits escaped[3][N]);
+    void recoverInvisible(const FieldBits escaped[3][N]);
+
+    // Vanishes puyos in |lanes| (bitmask). Scores and vanished puyos are put into
+    // |scores| and |erased|. Returns the bitmask of lanes where something is vanished.
+    template<typename Tracker>
+    int vanish(int lanes, const int currentChains[N], int scores[N], FieldBits erased[N], Tracker trackers[N]) const;
+    template<typename Tracker>
+    int vanishFast(int lanes, const int currentChains[N], FieldBits erased[N], Tracker trackers[N]) const;
+
+    // Drops puyos of |lane|. Returns max drops.
+    template<typename Tracker>
+    int dropAfterVanish(int lane, FieldBits erased, Tracker* tracker);
+    template<typename Tracker>
+    void dropAfterVanishFast(int lane, FieldBits erased, Tracker* tracker);
+
+#if defined(__AVX2__) && defined(__BMI2__)
+    // Vanishes puyos of lane |k| and lane |k + 1| using AVX2.
+    template<typename Tracker>
+    int vanishPairAVX2(int k, int lanes, const int currentChains[N], int scores[N], FieldBits erased[N], Tracker trackers[N]) const;
+    template<typename Tracker>
+    int vanishPairFastAVX2(int k, int lanes, const int currentChains[N], FieldBits erased[N], Tracker trackers[N]) const;
+
+    // Returns the |p|-th plane of lane |k| (low) and lane |k + 1| (high).
+    __m256i plane(int p, int k) const { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_[p][k])); }
+#endif
+
+    alignas(32) FieldBits m_[3][N];
+};
+
+template<int N>
+void BitFieldBatch<N>::clear()
+{
+    BitField empty;
+    for (int i = 0; i < N; ++i)
+        set(i, empty);
+}
+
+template<int N>
+void BitFieldBatch<N>::simulateBatch(RensaResult results[N])
+{
+    SimulationContext contexts[N];
+    RensaNonTracker trackers[N];
+    simulateBatch(contexts, results, trackers);
+}
+
+template<int N>
+template<typename Tracker>
+void BitFieldBatch<N>::simulateBatch(SimulationContext contexts[N], RensaResult results[N], Tracker trackers[N])
+{
+    FieldBits escaped[3][N];
+    escapeInvisible(escaped);
+
+    int currentChains[N];
+    int scores[N] {};
+    int frames[N] {};
+    bool quick[N] {};
+    for (int i = 0; i < N; ++i)
+        currentChains[i] = contexts[i].currentChain;
+
+    int lanes = ALL_LANES;
+    while (lanes) {
+        int nthChainScores[N];
+        FieldBits erased[N];
+        lanes = vanish(lanes, currentChains, nthChainScores, erased, trackers);
+
+        for (int i = 0; i < N; ++i) {
+            if (!(lanes & (1 << i)))
+                continue;
+
+            currentChains[i] += 1;
+            scores[i] += nthChainScores[i];
+            frames[i] += FRAMES_VANISH_ANIMATION;
+            int maxDrops = dropAfterVanish(i, erased[i], &trackers[i]);
+            if (maxDrops > 0) {
+                frames[i] += FRAMES_TO_DROP_FAST[maxDrops] + FRAMES_GROUNDING;
+            } else {
+                quick[i] = true;
+            }
+        }
+    }
+
+    recoverInvisible(escaped);
+
+    for (int i = 0; i < N; ++i) {
+        results[i] = RensaResult(currentChains[i] - 1, scores[i], frames[i], quick[i]);
+        contexts[i].currentChain = currentChains[i];
+    }
+}
+
+template<int N>
+void BitFieldBatch<N>::simulateFastBatch(int chains[N])
+{
+    RensaNonTracker trackers[N];
+    simulateFastBatch(chains, trackers);
+}
+
+template<int N>
+template<typename Tracker>
+void BitFieldBatch<N>::simulateFastBatch(int chains[N], Tracker trackers[N])
+{
+    FieldBits escaped[3][N];
+    escapeInvisible(escaped);
+
+    int currentChains[N];
+    for (int i = 0; i < N; ++i)
+        currentChains[i] = 1;
+
+    int lanes = ALL_LANES;
+    while (lanes) {
+        FieldBits erased[N];
+        lanes = vanishFast(lanes, currentChains, erased, trackers);
+
+        for (int i = 0; i < N; ++i) {
+            if (!(lanes & (1 << i)))
+                continue;
+            currentChains[i] += 1;
+            dropAfterVanishFast(i, erased[i], &trackers[i]);
+        }
+    }
+
+    recoverInvisible(escaped);
+
+    for (int i = 0; i < N; ++i)
+        chains[i] = currentChains[i] - 1;
+}
+
+template<int N>
+template<typename Tracker>
+void BitFieldBatch<N>::vanishDropBatch(SimulationContext contexts[N], RensaStepResult results[N], Tracker trackers[N])
+{
+    FieldBits escaped[3][N];
+    escapeInvisible(escaped);
+
+    int currentChains[N];
+    for (int i = 0; i < N; ++i)
+        currentChains[i] = contexts[i].currentChain;
+
+    int scores[N];
+    FieldBits erased[N];
+    int lanes = vanish(ALL_LANES, currentChains, scores, erased, trackers);
+
+    for (int i = 0; i < N; ++i) {
+        int maxDrops = 0;
+        int frames = FRAMES_VANISH_ANIMATION;
+        bool quick = false;
+        if (lanes & (1 << i)) {
+            maxDrops = dropAfterVanish(i, erased[i], &trackers[i]);
+            contexts[i].currentChain += 1;
+        } else {
+            scores[i] = 0;
+        }
+
+        if (maxDrops > 0) {
+            DCHECK(maxDrops < 14);
+            frames += FRAMES_TO_DROP_FAST[maxDrops] + FRAMES_GROUNDING;
+        } else {
+            quick = true;
+        }
+
+        results[i] = RensaStepResult(scores[i], frames, quick);
+    }
+
+    recoverInvisible(escaped);
+}
+
+template<int N>
+void BitFieldBatch<N>::escapeInvisible(FieldBits escaped[3][N])
+{
+    for (int p = 0; p < 3; ++p) {
+        for (int i = 0; i < N; ++i) {
+            escaped[p][i] = m_[p][i].notmask(FieldBits::FIELD_MASK_13);
+            m_[p][i] = m_[p][i].mask(FieldBits::FIELD_MASK_13);
+        }
+    }
+}
+
+template<int N>
+void BitFieldBatch<N>::recoverInvisible(const FieldBits escaped[3][N])
+{
+    for (int p = 0; p < 3; ++p) {
+        for (int i = 0; i < N; ++i)
+            m_[p][i].setAll(escaped[p][i]);
+    }
+}
+
+template<int N>
+template<typename Tracker>
+int BitFieldBatch<N>::vanish(int lanes, const int currentChains[N], int scores[N], FieldBits erased[N], Tracker trackers[N]) const
+{
+    int vanished = 0;
+#if defined(__AVX2__) && defined(__BMI2__)
+    for (int k = 0; k < N; k += 2) {
+        if (lanes & (3 << k))
+            vanished |= vanishPairAVX2(k, lanes, currentChains, scores, erased, trackers);
+    }
+#else
+    for (int i = 0; i < N; ++i) {
+        if (!(lanes & (1 << i)))
+            continue;
+        BitField bf = get(i);
+        scores[i] = bf.vanish(currentChains[i], &erased[i], &trackers[i]);
+        if (scores[i] > 0)
+            vanished |= 1 << i;
+    }
+#endif
+    return vanished;
+}
+
+template<int N>
+template<typename Tracker>
+int BitFieldBatch<N>::vanishFast(int lanes, const int currentChains[N], FieldBits erased[N], Tracker trackers[N]) const
+{
+    int vanished = 0;
+#if defined(__AVX2__) && defined(__BMI2__)
+    for (int k = 0; k < N; k += 2) {
+        if (lanes & (3 << k))
+            vanished |= vanishPairFastAVX2(k, lanes, currentChains, erased, trackers);
+    }
+#else
+    for (int i = 0; i < N; ++i) {
+        if (!(lanes & (1 << i)))
+            continue;
+        BitField bf = get(i);
+        if (bf.vanishFast(currentChains[i], &erased[i], &trackers[i]))
+            vanished |= 1 << i;
+    }
+#endif
+    return vanished;
+}
+
+template<int N>
+template<typename Tracker>
+int BitFieldBatch<N>::dropAfterVanish(int lane, FieldBits erased, Tracker* tracker)
+{
+    BitField bf = get(lane);
+#if defined(__AVX2__) && defined(__BMI2__)
+    int maxDrops = bf.dropAfterVanishAVX2(erased, tracker);
+#else
+    int maxDrops = bf.dropAfterVanish(erased, tracker);
+#endif
+    set(lane, bf);
+    return maxDrops;
+}
+
+template<int N>
+template<typename Tracker>
+void BitFieldBatch<N>::dropAfterVanishFast(int lane, FieldBits erased, Tracker* tracker)
+{
+    BitField bf = get(lane);
+#if defined(__AVX2__) && defined(__BMI2__)
+    bf.dropAfterVanishFastAVX2(erased, tracker);
+#else
+    bf.dropAfterVanishFast(erased, tracker);
+#endif
+    set(lane, bf);
+}
+
+#if defined(__AVX2__) && defined(__BMI2__)
+
+namespace bit_field_batch_internal {
+
+// Returns the 4 normal color bits of 2 fields. Colors are RED, BLUE, YELLOW and GREEN in order.
+inline void normalColorBitsAVX2(__m256i m0, __m256i m1, __m256i m2, FieldBits256 colors[4])
+{
+    const __m256i mask12 = _mm256_broadcastsi128_si256(FieldBits::FIELD_MASK_12.xmm());
+
+    __m256i redBlue = _mm256_and_si256(_mm256_andnot_si256(m1, m2), mask12);
+    __m256i yellowGreen = _mm256_and_si256(_mm256_and_si256(m1, m2), mask12);
+
+    colors[0] = _mm256_andnot_si256(m0, redBlue);
+    colors[1] = _mm256_and_si256(m0, redBlue);
+    colors[2] = _mm256_andnot_si256(m0, yellowGreen);
+    colors[3] = _mm256_and_si256(m0, yellowGreen);
+}
+
+// Returns the ojama puyos of 2 fields that are next to |erased|.
+inline FieldBits256 ojamaErasedAVX2(__m256i m0, __m256i m1, __m256i m2, FieldBits256 erased)
+{
+    const __m256i mask12 = _mm256_broadcastsi128_si256(FieldBits::FIELD_MASK_12.xmm());
+
+    // Since _mm256_slli_si256 shifts each 128bit lane separately, 2 fields don't interfere.
+    __m256i edge = _mm256_or_si256(
+        _mm256_or_si256(_mm256_slli_epi16(erased.ymm(), 1), _mm256_srli_epi16(erased.ymm(), 1)),
+        _mm256_or_si256(_mm256_slli_si256(erased.ymm(), 2), _mm256_srli_si256(erased.ymm(), 2)));
+    __m256i ojama = _mm256_andnot_si256(m2, _mm256_andnot_si256(m1, m0));
+    return _mm256_and_si256(edge, _mm256_and_si256(ojama, mask12));
+}
+
+inline int longBonusCoefOf(FieldBits vanishing, FieldBits mask, int count)
+{
+    // fast path. In most cases, >= 8 puyos won't be erased.
+    // When <= 7 puyos are erased, it won't be separated.
+    if (count <= 7)
+        return longBonus(count);
+
+    int coef = 0;
+    vanishing.iterateBitWithMasking([&](FieldBits x) -> FieldBits {
+        FieldBits expanded = x.expand(mask);
+        coef += longBonus(expanded.popcount());
+        return expanded;
+    });
+    return coef;
+}
+
+} // namespace bit_field_batch_internal
+
+template<int N>
+template<typename Tracker>
+int BitFieldBatch<N>::vanishPairAVX2(int k, int lanes, const int currentChains[N], int scores[N], FieldBits erased[N], Tracker trackers[N]) const
+{
+    using namespace bit_field_batch_internal;
+
+    const __m256i m0 = plane(0, k);
+    const __m256i m1 = plane(1, k);
+    const __m256i m2 = plane(2, k);
+
+    FieldBits256 colors[4];
+    normalColorBitsAVX2(m0, m1, m2, colors);
+
+    FieldBits256 erased256;
+    int numErasedPuyos[2] {};
+    int numColors[2] {};
+    int longBonusCoef[2] {};
+
+    for (int c = 0; c < 4; ++c) {
+        FieldBits256 vanishing;
+        if (!colors[c].findVanishingBits(&vanishing))
+            continue;
+        erased256.setAll(vanishing);
+
+        std::pair<int, int> pc = vanishing.popcountHighLow();
+        if (pc.second > 0) {
+            ++numColors[0];
+            numErasedPuyos[0] += pc.second;
+            longBonusCoef[0] += longBonusCoefOf(vanishing.low(), colors[c].low(), pc.second);
+        }
+        if (pc.first > 0) {
+            ++numColors[1];
+            numErasedPuyos[1] += pc.first;
+            longBonusCoef[1] += longBonusCoefOf(vanishing.high(), colors[c].high(), pc.first);
+        }
+    }
+
+    if (erased256.isEmpty())
+        return 0;
+
+    FieldBits256 ojamaErased256 = ojamaErasedAVX2(m0, m1, m2, erased256);
+    FieldBits ojamaErased[2] { ojamaErased256.low(), ojamaErased256.high() };
+    FieldBits vanished[2] { erased256.low(), erased256.high() };
+
+    int result = 0;
+    for (int j = 0; j < 2; ++j) {
+        int i = k + j;
+        if (!(lanes & (1 << i)) || numColors[j] == 0)
+            continue;
+
+        int colorBonusCoef = colorBonus(numColors[j]);
+        int rensaBonusCoef = calculateRensaBonusCoef(chainBonus(currentChains[i]), longBonusCoef[j], colorBonusCoef);
+        trackers[i].trackCoef(currentChains[i], numErasedPuyos[j], longBonusCoef[j], colorBonusCoef);
+
+        erased[i] = vanished[j] | ojamaErased[j];
+        trackers[i].trackVanish(currentChains[i], erased[i], ojamaErased[j]);
+
+        scores[i] = 10 * numErasedPuyos[j] * rensaBonusCoef;
+        result |= 1 << i;
+    }
+
+    return result;
+}
+
+template<int N>
+template<typename Tracker>
+int BitFieldBatch<N>::vanishPairFastAVX2(int k, int lanes, const int currentChains[N], FieldBits erased[N], Tracker trackers[N]) const
+{
+    using namespace bit_field_batch_internal;
+
+    const __m256i m0 = plane(0, k);
+    const __m256i m1 = plane(1, k);
+    const __m256i m2 = plane(2, k);
+
+    FieldBits256 colors[4];
+    normalColorBitsAVX2(m0, m1, m2, colors);
+
+    FieldBits256 erased256;
+    for (int c = 0; c < 4; ++c) {
+        FieldBits256 vanishing;
+        if (colors[c].findVanishingBits(&vanishing))
+            erased256.setAll(vanishing);
+    }
+
+    if (erased256.isEmpty())
+        return 0;
+
+    FieldBits256 ojamaErased256 = ojamaErasedAVX2(m0, m1, m2, erased256);
+    FieldBits ojamaErased[2] { ojamaErased256.low(), ojamaErased256.high() };
+    FieldBits vanished[2] { erased256.low(), erased256.high() };
+
+    int result = 0;
+    for (int j = 0; j < 2; ++j) {
+        int i = k + j;
+        if (!(lanes & (1 << i)) || vanished[j].isEmpty())
+            continue;
+
+        erased[i] = vanished[j] | ojamaErased[j];
+        trackers[i].trackVanish(currentChains[i], erased[i], ojamaErased[j]);
+        result |= 1 << i;
+    }
+
+    return result;
+}
+
+#endif // defined(__AVX2__) && defined(__BMI2__)
+
+#endif // CORE_BIT_FIELD_BATCH_H_
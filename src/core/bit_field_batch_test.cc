@@ -0,0 +1,208 @@
+#include "core/bit_field_batch.h"
+
+#include <gtest/gtest.h>
+
+#include "core/rensa_tracker/rensa_chain_tracker.h"
+
+using namespace std;
+
+namespace {
+
+const BitField FIELDS[] = {
+    BitField(".BBBB."),
+    BitField("YYYYYY"
+             "BBBBBB"),
+    BitField(".YYYG."
+             "BBBBY."),
+    BitField(".RBRB."
+             "RBRBR."
+             "RBRBR."
+             "RBRBRR"),
+    BitField(".YGGY."
+             "BBBBBB"
+             "GYBBYG"
+             "BBBBBB"),
+    BitField("R...R."
+             "RBYRGR"
+             "RRBYYG"
+             "BBYGGR"),
+    BitField("OOOOOR"
+             "OORRRR" // 12
+             "OOOOOO"
+             "OOOOOO"
+             "OOOOOO"
+             "OOOOOO" // 8
+             "OOOOOO"
+             "OOOOOO"
+             "OOOOOO"
+             "OOOOOO" // 4
+             "OOOOOO"
+             "OOOOOO"
+             "OOOOOO"),
+    BitField(".G.BRG"
+             "GBRRYR"
+             "RRYYBY"
+             "RGYRBR"
+             "YGYRBY"
+             "YGBGYR"
+             "GRBGYR"
+             "BRBYBY"
+             "RYYBYY"
+             "BRBYBR"
+             "BGBYRR"
+             "YGBGBG"
+             "RBGBGG"),
+};
+
+const int NUM_FIELDS = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+template<int N>
+void checkSimulateBatch()
+{
+    for (int offset = 0; offset < NUM_FIELDS; offset += N) {
+        BitFieldBatch<N> batch;
+        for (int i = 0; i < N && offset + i < NUM_FIELDS; ++i)
+            batch.set(i, FIELDS[offset + i]);
+
+        RensaResult results[N];
+        batch.simulateBatch(results);
+
+        for (int i = 0; i < N; ++i) {
+            BitField bf(offset + i < NUM_FIELDS ? FIELDS[offset + i] : BitField());
+            RensaResult expected = bf.simulate();
+            EXPECT_EQ(expected, results[i]) << bf;
+            EXPECT_EQ(bf, batch.get(i)) << bf;
+        }
+    }
+}
+
+template<int N>
+void checkSimulateFastBatch()
+{
+    for (int offset = 0; offset < NUM_FIELDS; offset += N) {
+        BitFieldBatch<N> batch;
+        for (int i = 0; i < N && offset + i < NUM_FIELDS; ++i)
+            batch.set(i, FIELDS[offset + i]);
+
+        int chains[N];
+        batch.simulateFastBatch(chains);
+
+        for (int i = 0; i < N; ++i) {
+            BitField bf(offset + i < NUM_FIELDS ? FIELDS[offset + i] : BitField());
+            RensaNonTracker tracker;
+            EXPECT_EQ(bf.simulateFast(&tracker), chains[i]) << bf;
+            EXPECT_EQ(bf, batch.get(i)) << bf;
+        }
+    }
+}
+
+} // anonymous namespace
+
+TEST(BitFieldBatchTest, setAndGet)
+{
+    BitFieldBatch<4> batch;
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(BitField(), batch.get(i));
+        batch.set(i, FIELDS[i]);
+    }
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(FIELDS[i], batch.get(i));
+
+    batch.clear();
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(BitField(), batch.get(i));
+}
+
+TEST(BitFieldBatchTest, simulateBatch)
+{
+    checkSimulateBatch<2>();
+    checkSimulateBatch<4>();
+    checkSimulateBatch<8>();
+}
+
+TEST(BitFieldBatchTest, simulateFastBatch)
+{
+    checkSimulateFastBatch<2>();
+    checkSimulateFastBatch<4>();
+    checkSimulateFastBatch<8>();
+}
+
+TEST(BitFieldBatchTest, simulateBatchWithContext)
+{
+    BitFieldBatch<2> batch;
+    batch.set(0, FIELDS[3]);
+    batch.set(1, FIELDS[5]);
+
+    BitFieldBatch<2>::SimulationContext contexts[2] {
+        BitFieldBatch<2>::SimulationContext(2),
+        BitFieldBatch<2>::SimulationContext(3),
+    };
+    RensaResult results[2];
+    RensaNonTracker trackers[2];
+    batch.simulateBatch(contexts, results, trackers);
+
+    for (int i = 0; i < 2; ++i) {
+        BitField bf(FIELDS[i == 0 ? 3 : 5]);
+        BitField::SimulationContext context(i + 2);
+        RensaNonTracker tracker;
+        EXPECT_EQ(bf.simulate(&context, &tracker), results[i]);
+        EXPECT_EQ(context.currentChain, contexts[i].currentChain);
+    }
+}
+
+TEST(BitFieldBatchTest, simulateBatchWithChainTracker)
+{
+    BitFieldBatch<8> batch;
+    for (int i = 0; i < 8; ++i)
+        batch.set(i, FIELDS[i]);
+
+    BitFieldBatch<8>::SimulationContext contexts[8];
+    RensaResult results[8];
+    RensaChainTracker trackers[8];
+    batch.simulateBatch(contexts, results, trackers);
+
+    for (int i = 0; i < 8; ++i) {
+        BitField bf(FIELDS[i]);
+        BitField::SimulationContext context;
+        RensaChainTracker tracker;
+        EXPECT_EQ(bf.simulate(&context, &tracker), results[i]);
+
+        for (int x = 1; x <= FieldConstant::WIDTH; ++x) {
+            for (int y = 1; y <= FieldConstant::HEIGHT; ++y) {
+                EXPECT_EQ(tracker.result().erasedAt(x, y), trackers[i].result().erasedAt(x, y))
+                    << "i=" << i << " x=" << x << " y=" << y;
+            }
+        }
+    }
+}
+
+TEST(BitFieldBatchTest, vanishDropBatch)
+{
+    BitFieldBatch<4> batch;
+    for (int i = 0; i < 4; ++i)
+        batch.set(i, FIELDS[i + 2]);
+
+    BitField bfs[4];
+    BitField::SimulationContext contexts[4];
+    for (int i = 0; i < 4; ++i)
+        bfs[i] = FIELDS[i + 2];
+
+    BitFieldBatch<4>::SimulationContext batchContexts[4];
+    RensaNonTracker trackers[4];
+
+    for (int step = 0; step < 6; ++step) {
+        RensaStepResult results[4];
+        batch.vanishDropBatch(batchContexts, results, trackers);
+
+        for (int i = 0; i < 4; ++i) {
+            RensaNonTracker tracker;
+            RensaStepResult expected = bfs[i].vanishDrop(&contexts[i], &tracker);
+            EXPECT_EQ(expected.score, results[i].score) << "step=" << step << " i=" << i;
+            EXPECT_EQ(expected.frames, results[i].frames) << "step=" << step << " i=" << i;
+            EXPECT_EQ(expected.quick, results[i].quick) << "step=" << step << " i=" << i;
+            EXPECT_EQ(contexts[i].currentChain, batchContexts[i].currentChain);
+            EXPECT_EQ(bfs[i], batch.get(i));
+        }
+    }
+}
@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include "core/bit_field_batch.h"
+
 #include "base/base.h"
 #include "base/time_stamp_counter.h"
 
@@ -86,6 +88,80 @@ TEST(BitFieldPerformanceTest, bitfield_simulate_fast_filled)
     tsc.showStatistics();
 }
 
+TEST(BitFieldPerformanceTest, bitfield_simulate_batch8_filled)
+{
+    // Each measurement simulates 8 fields.
+    const int N = 1000000 / 8;
+
+    TimeStampCounterData tsc;
+    BitField bfOriginal(
+        ".G.BRG"
+        "GBRRYR"
+        "RRYYBY"
+        "RGYRBR"
+        "YGYRBY"
+        "YGBGYR"
+        "GRBGYR"
+        "BRBYBY"
+        "RYYBYY"
+        "BRBYBR"
+        "BGBYRR"
+        "YGBGBG"
+        "RBGBGG");
+
+    for (int i = 0; i < N; i++) {
+        BitFieldBatch<8> batch;
+        for (int j = 0; j < 8; ++j)
+            batch.set(j, bfOriginal);
+        RensaResult results[8];
+        {
+            ScopedTimeStampCounter stsc(&tsc);
+            batch.simulateBatch(results);
+        }
+        for (int j = 0; j < 8; ++j)
+            EXPECT_EQ(19, results[j].chains);
+    }
+
+    tsc.showStatistics();
+}
+
+TEST(BitFieldPerformanceTest, bitfield_simulate_fast_batch8_filled)
+{
+    // Each measurement simulates 8 fields.
+    const int N = 1000000 / 8;
+
+    TimeStampCounterData tsc;
+    BitField bfOriginal(
+        ".G.BRG"
+        "GBRRYR"
+        "RRYYBY"
+        "RGYRBR"
+        "YGYRBY"
+        "YGBGYR"
+        "GRBGYR"
+        "BRBYBY"
+        "RYYBYY"
+        "BRBYBR"
+        "BGBYRR"
+        "YGBGBG"
+        "RBGBGG");
+
+    for (int i = 0; i < N; i++) {
+        BitFieldBatch<8> batch;
+        for (int j = 0; j < 8; ++j)
+            batch.set(j, bfOriginal);
+        int chains[8];
+        {
+            ScopedTimeStampCounter stsc(&tsc);
+            batch.simulateFastBatch(chains);
+        }
+        for (int j = 0; j < 8; ++j)
+            EXPECT_EQ(19, chains[j]);
+    }
+
+    tsc.showStatistics();
+}
+
 #if defined(__AVX2__) && defined(__BMI2__)
 TEST(BitFieldPerformanceTest, bitfield_simulate_avx2_filled)
 {
@@ -1,12 +1,21 @@
 #include "core/client/ai/ai.h"
 
 #include <algorithm>
+#include <chrono>
+#include <future>
+#include <sstream>
+#include <vector>
+
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "base/base.h"
+#include "base/deadline.h"
+#include "base/time.h"
 #include "core/core_field.h"
 #include "core/decision.h"
 #include "core/field_pretty_printer.h"
+#include "core/frame.h"
 #include "core/frame_request.h"
 #include "core/frame_response.h"
 #include "core/kumipuyo.h"
@@ -15,6 +24,8 @@
 #include "core/rensa_result.h"
 #include "core/user_event.h"
 
+DEFINE_bool(async_think, false, "think in another thread, and ponder while idle");
+
 using namespace std;
 
 struct DecisionSending {
@@ -26,6 +37,7 @@ struct DecisionSending {
     DropDecision dropDecision = DropDecision();
     Kumipuyo kumipuyo = Kumipuyo();
     CoreField fieldBeforeThink;
+    KumipuyoSeq seqBeforeThink;
 
     bool requested = false;
     bool ready = false;
@@ -34,6 +46,69 @@ struct DecisionSending {
     bool ojamaDropped = false;
 };
 
+// A think running in another thread. The inputs are copied, since AI keeps
+// updating its states while thinking.
+struct AsyncThink {
+    bool speculative;
+    bool cancelled = false;
+    int thinkFrameId;
+    CoreField field;
+    KumipuyoSeq seq;
+    PlayerState me;
+    PlayerState enemy;
+    Deadline deadline;
+    double beginTime;
+    future<DropDecision> result;
+};
+
+struct PonderedDecision {
+    CoreField field;
+    KumipuyoSeq seq;
+    DropDecision dropDecision;
+};
+
+struct AsyncThinkState {
+    unique_ptr<AsyncThink> running;
+    // The results of the speculative thinks in this hand.
+    vector<PonderedDecision> pondered;
+
+    bool hasDeferredGaze = false;
+    int deferredGazeFrameId = 0;
+    CoreField deferredGazeField;
+    KumipuyoSeq deferredGazeSeq;
+};
+
+namespace {
+
+// A fast rethink can use the pondered decision if the field and the first 2 kumipuyos
+// are the same. We might know more kumipuyos in the rethink, but think() can decide
+// with 2 kumipuyos.
+bool isSameThink(const CoreField& field1, const KumipuyoSeq& seq1, const CoreField& field2, const KumipuyoSeq& seq2)
+{
+    if (seq1.size() < 2 || seq2.size() < 2)
+        return false;
+    return field1 == field2 && seq1.get(0) == seq2.get(0) && seq1.get(1) == seq2.get(1);
+}
+
+} // anonymous namespace
+
+string ThinkStats::toString() const
+{
+    ostringstream ss;
+    ss << "thinks=" << numThinks
+       << " deadline_hits=" << numDeadlineHits
+       << " overruns=" << numOverruns
+       << " max_think_time=" << (maxThinkTime * 1000) << "ms"
+       << " ponders=" << numPonders
+       << " ponder_hits=" << numPonderHits;
+    return ss.str();
+}
+
+// static
+const int AI::FAST_THINK_MILLIS;
+// static
+const int AI::THINK_MILLIS;
+
 AI::AI(int argc, char* argv[], const string& name) :
     AI(name)
 {
@@ -45,14 +120,21 @@ AI::AI(const string& name) :
     name_(name),
     connector_(AIBase::makeConnector()),
     desynced_(false),
+    next1_(new DecisionSending),
+    nextThinkFrameId_(0),
     rethinkRequested_(false),
     enemyDecisionRequestFrameId_(0),
-    behaviorRethinkAfterOpponentRensa_(false)
+    behaviorRethinkAfterOpponentRensa_(false),
+    behaviorAsyncThink_(FLAGS_async_think),
+    async_(new AsyncThinkState)
 {
 }
 
 AI::~AI()
 {
+    // The subclass has already been destructed here, so the async think must have been
+    // stopped (runLoop() and gameHasEnded() do it).
+    DCHECK(!async_->running) << "async think is still running";
 }
 
 // TODO(mayah): Consider to introduce state. It's hard to maintain flags.
@@ -61,11 +143,6 @@ AI::~AI()
 // think(). However, it does, now.
 void AI::runLoop()
 {
-    DecisionSending next1;
-
-    // nextThinkFrameId is frameId in which the decision of think() is sent.
-    int nextThinkFrameId = 0;
-
     while (true) {
         google::FlushLogFiles(google::INFO);
 
@@ -79,174 +156,378 @@ void AI::runLoop()
             break;
         }
 
-        if (!frameRequest.isValid()) {
-            connector_->send(FrameResponse(frameRequest.frameId));
-            continue;
-        }
+        connector_->send(playOneFrame(frameRequest));
+    }
+
+    stopAsyncThink();
+    LOG(INFO) << "will exit run loop";
+}
+
+FrameResponse AI::playOneFrame(const FrameRequest& frameRequest)
+{
+    DecisionSending& next1 = *next1_;
+
+    if (!frameRequest.isValid())
+        return FrameResponse(frameRequest.frameId);
 
-        if (frameRequest.hasGameEnd()) {
-            gameHasEnded(frameRequest);
+    if (behaviorAsyncThink_)
+        finishAsyncThink(false);
+
+    if (frameRequest.hasGameEnd()) {
+        gameHasEnded(frameRequest);
+    }
+    // Before starting a new game, we need to think the first hand.
+    // TODO(mayah): Maybe game server should send some information that we should initialize.
+    if (frameRequest.shouldInitialize()) {
+        next1.clear();
+        nextThinkFrameId_ = 0;
+        gameWillBegin(frameRequest);
+    }
+
+    // Update enemy info if necessary.
+    if (frameRequest.enemyPlayerFrameRequest().event.decisionRequest)
+        decisionRequestedForEnemy(frameRequest);
+    if (frameRequest.enemyPlayerFrameRequest().event.ojamaDropped)
+        ojamaDroppedForEnemy(frameRequest);
+    if (frameRequest.enemyPlayerFrameRequest().event.grounded)
+        groundedForEnemy(frameRequest);
+    if (frameRequest.enemyPlayerFrameRequest().event.puyoErased)
+        puyoErasedForEnemy(frameRequest);
+    if (frameRequest.enemyPlayerFrameRequest().event.wnextAppeared)
+        next2AppearedForEnemy(frameRequest);
+
+    // STATE_YOU_GROUNDED and STATE_WNEXT_APPEARED might come out-of-order.
+    bool shouldThink = false;
+    if (frameRequest.myPlayerFrameRequest().event.wnextAppeared) {
+        next2AppearedForMe(frameRequest);
+        shouldThink = true;
+
+        // When hand == 0, nextThinkFrameId_ will be 0. We'd like to keep frameId is increasing.
+        if (nextThinkFrameId_ < frameRequest.frameId)
+            nextThinkFrameId_ = frameRequest.frameId;
+    }
+    if (frameRequest.myPlayerFrameRequest().event.puyoErased) {
+        shouldThink = true;
+        // TODO(mayah): This is not so accurate. We need to consider FRAMES_GROUNDING and frames for dropping.
+        nextThinkFrameId_ = frameRequest.frameId + FRAMES_VANISH_ANIMATION + FRAMES_PREPARING_NEXT;
+    }
+
+    if (shouldThink) {
+        const auto& kumipuyoSeq = frameRequest.myPlayerFrameRequest().kumipuyoSeq;
+        LOG(INFO) << "STATE_WNEXT_APPEARED";
+        VLOG(1) << '\n' << me_.field.toDebugString();
+
+        KumipuyoSeq seq = rememberedSequence(me_.hand + 1, kumipuyoSeq.subsequence(1));
+        if (kumipuyoSeq.get(1) != seq.get(0)) {
+            // desynced?
+            LOG(ERROR) << "desynced?";
         }
-        // Before starting a new game, we need to think the first hand.
-        // TODO(mayah): Maybe game server should send some information that we should initialize.
-        if (frameRequest.shouldInitialize()) {
-            next1.clear();
-            nextThinkFrameId = 0;
-            gameWillBegin(frameRequest);
+        if (kumipuyoSeq.size() >= 3) {
+            LOG_IF(ERROR, kumipuyoSeq.get(2) != seq.get(1))
+                << "desynced? "
+                << " kumipuyoSeq=" << kumipuyoSeq.toString()
+                << " seq=" << seq.toString();
         }
 
-        // Update enemy info if necessary.
-        if (frameRequest.enemyPlayerFrameRequest().event.decisionRequest)
-            decisionRequestedForEnemy(frameRequest);
-        if (frameRequest.enemyPlayerFrameRequest().event.ojamaDropped)
-            ojamaDroppedForEnemy(frameRequest);
-        if (frameRequest.enemyPlayerFrameRequest().event.grounded)
-            groundedForEnemy(frameRequest);
-        if (frameRequest.enemyPlayerFrameRequest().event.puyoErased)
-            puyoErasedForEnemy(frameRequest);
-        if (frameRequest.enemyPlayerFrameRequest().event.wnextAppeared)
-            next2AppearedForEnemy(frameRequest);
-
-        // STATE_YOU_GROUNDED and STATE_WNEXT_APPEARED might come out-of-order.
-        bool shouldThink = false;
-        if (frameRequest.myPlayerFrameRequest().event.wnextAppeared) {
-            next2AppearedForMe(frameRequest);
-            shouldThink = true;
-
-            // When hand == 0, nextThinkFrameId will be 0. We'd like to keep frameId is increasing.
-            if (nextThinkFrameId < frameRequest.frameId)
-                nextThinkFrameId = frameRequest.frameId;
-        }
-        if (frameRequest.myPlayerFrameRequest().event.puyoErased) {
-            shouldThink = true;
-            // TODO(mayah): This is not so accurate. We need to consider FRAMES_GROUNDING and frames for dropping.
-            nextThinkFrameId = frameRequest.frameId + FRAMES_VANISH_ANIMATION + FRAMES_PREPARING_NEXT;
+        next1.fieldBeforeThink = me_.field;
+        next1.seqBeforeThink = seq;
+        if (behaviorAsyncThink_) {
+            // The running think and the pondered decisions are for the previous state.
+            stopAsyncThink();
+            async_->pondered.clear();
+            next1.ready = false;
+            startAsyncThink(frameRequest.frameId, nextThinkFrameId_, me_.field, seq, false);
+        } else {
+            next1.dropDecision = thinkInTime(frameRequest.frameId, nextThinkFrameId_, me_.field, seq, false);
+            next1.ready = true;
         }
 
-        if (shouldThink) {
-            const auto& kumipuyoSeq = frameRequest.myPlayerFrameRequest().kumipuyoSeq;
-            LOG(INFO) << "STATE_WNEXT_APPEARED";
-            VLOG(1) << '\n' << me_.field.toDebugString();
+        next1.kumipuyo = kumipuyoSeq.get(1);
+    }
+    // Update my info if necessary.
+    if (frameRequest.myPlayerFrameRequest().event.ojamaDropped) {
+        // We need to rethink the next1 decision.
+        next1.needsRethink = true;
+        next1.ojamaDropped = true;
+        ojamaDroppedForMe(frameRequest);
+    }
+    if (frameRequest.myPlayerFrameRequest().event.grounded)
+        groundedForMe(frameRequest);
+    if (frameRequest.myPlayerFrameRequest().event.puyoErased)
+        puyoErasedForMe(frameRequest);
+    if (frameRequest.myPlayerFrameRequest().event.preDecisionRequest)
+        preDecisionRequestedForMe(frameRequest);
+    if (frameRequest.myPlayerFrameRequest().event.decisionRequest) {
+        VLOG(1) << "REQUESTED";
+        next1.requested = true;
+        decisionRequestedForMe(frameRequest);
+    }
+    if (frameRequest.myPlayerFrameRequest().event.decisionRequestAgain) {
+        // We need to handle this specially. Since we've proceeded next1, we don't have any knowledge about this turn.
+        // TODO(mayah): Should we preserve DecisionSending after we used it for this?
+        VLOG(1) << "REQUEST_AGAIN";
+        DCHECK(!frameRequest.myPlayerFrameRequest().event.decisionRequest)
+            << "decisionRequestAgain should not come with decisionRequest.";
+        // The running think can't run together with this one. A speculative think is just dropped,
+        // but the next1 think started at STATE_WNEXT_APPEARED is restarted after this.
+        const bool restartsNext1Think = async_->running && !async_->running->speculative;
+        const int next1ThinkFrameId = restartsNext1Think ? async_->running->thinkFrameId : 0;
+        stopAsyncThink();
+        DropDecision dropDecision = thinkInTime(frameRequest.frameId, frameRequest.frameId,
+                                                CoreField(frameRequest.myPlayerFrameRequest().field),
+                                                frameRequest.myPlayerFrameRequest().kumipuyoSeq,
+                                                true);
+        if (restartsNext1Think)
+            startAsyncThink(frameRequest.frameId, next1ThinkFrameId, next1.fieldBeforeThink, next1.seqBeforeThink, false);
+        return FrameResponse(frameRequest.frameId, dropDecision.decision(), dropDecision.message());
+    }
 
-            KumipuyoSeq seq = rememberedSequence(me_.hand + 1, kumipuyoSeq.subsequence(1));
-            if (kumipuyoSeq.get(1) != seq.get(0)) {
-                // desynced?
-                LOG(ERROR) << "desynced?";
-            }
-            if (kumipuyoSeq.size() >= 3) {
-                LOG_IF(ERROR, kumipuyoSeq.get(2) != seq.get(1))
-                    << "desynced? "
-                    << " kumipuyoSeq=" << kumipuyoSeq.toString()
-                    << " seq=" << seq.toString();
-            }
+    if (behaviorAsyncThink_) {
+        // The deadline of the think is around this frame, so waiting for it won't be long.
+        if (next1.requested && !next1.ready)
+            finishAsyncThink(true);
+        if (!next1.requested)
+            ponderIfUseful(frameRequest.frameId);
+    }
 
-            next1.fieldBeforeThink = me_.field;
-            next1.dropDecision = think(nextThinkFrameId, me_.field, seq,
-                                       myPlayerState(), enemyPlayerState(), false);
+    if (!next1.requested || !next1.ready) {
+        FrameResponse resp(frameRequest.frameId);
 
-            next1.kumipuyo = kumipuyoSeq.get(1);
-            next1.ready = true;
+        const bool needsSendPreDecision = next1.ready &&
+            next1.dropDecision.decision().isValid() &&
+            frameRequest.myPlayerFrameRequest().event.preDecisionRequest;
+        // Sends pre decision.
+        if (needsSendPreDecision) {
+            resp.preDecision = next1.dropDecision.decision();
         }
-        // Update my info if necessary.
-        if (frameRequest.myPlayerFrameRequest().event.ojamaDropped) {
-            // We need to rethink the next1 decision.
-            next1.needsRethink = true;
-            next1.ojamaDropped = true;
-            ojamaDroppedForMe(frameRequest);
+
+        return resp;
+    }
+
+    // Check field inconsistency. We only check when me_hand >= 3, since we cannot trust the field in 3 hands.
+    if (me_.hand >= 3 && isFieldInconsistent(next1.fieldBeforeThink.toPlainField(), frameRequest.myPlayerFrameRequest().field)) {
+        LOG(INFO) << "FIELD INCONSISTENCY DETECTED: hand=" << me_.hand;
+        VLOG(1) << '\n' << FieldPrettyPrinter::toStringFromMultipleFields(
+            { next1.fieldBeforeThink.toPlainField(), frameRequest.myPlayerFrameRequest().field },
+            { frameRequest.myPlayerFrameRequest().kumipuyoSeq, frameRequest.myPlayerFrameRequest().kumipuyoSeq });
+
+        next1.needsRethink = true;
+    }
+
+    // Rethink if necessary.
+    if (next1.needsRethink || rethinkRequested_) {
+        LOG(INFO) << "RETHINK";
+
+        me_.field = mergeField(me_.field, frameRequest.myPlayerFrameRequest().field, next1.ojamaDropped);
+        const auto& kumipuyoSeq = frameRequest.myPlayerFrameRequest().kumipuyoSeq;
+
+        KumipuyoSeq seq = rememberedSequence(me_.hand, kumipuyoSeq);
+        if (kumipuyoSeq.get(0) != seq.get(0) || kumipuyoSeq.get(1) != seq.get(1)) {
+            // desynced?
+            LOG(ERROR) << "desynced?"
+                       << " kumipuyoSeq=" << kumipuyoSeq.toString()
+                       << " seq=" << seq.toString();
         }
-        if (frameRequest.myPlayerFrameRequest().event.grounded)
-            groundedForMe(frameRequest);
-        if (frameRequest.myPlayerFrameRequest().event.puyoErased)
-            puyoErasedForMe(frameRequest);
-        if (frameRequest.myPlayerFrameRequest().event.preDecisionRequest)
-            preDecisionRequestedForMe(frameRequest);
-        if (frameRequest.myPlayerFrameRequest().event.decisionRequest) {
-            VLOG(1) << "REQUESTED";
-            next1.requested = true;
-            decisionRequestedForMe(frameRequest);
+
+        DropDecision dropDecision;
+        if (behaviorAsyncThink_ && takePonderedDecision(me_.field, seq, &dropDecision)) {
+            LOG(INFO) << "PONDER HIT";
+            next1.dropDecision = dropDecision;
+        } else {
+            stopAsyncThink();
+            next1.dropDecision = thinkInTime(frameRequest.frameId, frameRequest.frameId, me_.field, seq, true);
         }
-        if (frameRequest.myPlayerFrameRequest().event.decisionRequestAgain) {
-            // We need to handle this specially. Since we've proceeded next1, we don't have any knowledge about this turn.
-            // TODO(mayah): Should we preserve DecisionSending after we used it for this?
-            VLOG(1) << "REQUEST_AGAIN";
-            DCHECK(!frameRequest.myPlayerFrameRequest().event.decisionRequest)
-                << "decisionRequestAgain should not come with decisionRequest.";
-            DropDecision dropDecision = think(frameRequest.frameId,
-                                              CoreField(frameRequest.myPlayerFrameRequest().field),
-                                              frameRequest.myPlayerFrameRequest().kumipuyoSeq,
-                                              myPlayerState(),
-                                              enemyPlayerState(),
-                                              true);
-            connector_->send(FrameResponse(frameRequest.frameId, dropDecision.decision(), dropDecision.message()));
-            continue;
+        next1.kumipuyo = kumipuyoSeq.get(0);
+        next1.ready = true;
+        next1.needsRethink = false;
+        next1.ojamaDropped = false;
+        rethinkRequested_ = false;
+    }
+
+    // Send
+    FrameResponse resp(frameRequest.frameId, next1.dropDecision.decision(), next1.dropDecision.message());
+    nextThinkFrameId_ =
+        frameRequest.frameId +
+        next1.fieldBeforeThink.framesToDropNext(next1.dropDecision.decision()) +
+        FRAMES_PREPARING_NEXT;
+
+    // Move to next.
+    if (next1.dropDecision.decision().isValid() && next1.kumipuyo.isValid()) {
+        if (!me_.field.dropKumipuyo(next1.dropDecision.decision(), next1.kumipuyo)) {
+            LOG(WARNING) << "failed to drop kumipuyo. Moving to impossible position?";
         }
+        me_.field.simulate();
+    }
+    next1.clear();
 
-        if (!next1.requested || !next1.ready) {
-            FrameResponse resp(frameRequest.frameId);
+    return resp;
+}
 
-            const bool needsSendPreDecision = next1.ready &&
-                next1.dropDecision.decision().isValid() &&
-                frameRequest.myPlayerFrameRequest().event.preDecisionRequest;
-            // Sends pre decision.
-            if (needsSendPreDecision) {
-                resp.preDecision = next1.dropDecision.decision();
-            }
+DropDecision AI::thinkWithDeadline(int frameId, const CoreField& field, const KumipuyoSeq& seq,
+                                   const PlayerState& me, const PlayerState& enemy, bool fast,
+                                   const Deadline& deadline) const
+{
+    UNUSED_VARIABLE(deadline);
+    return think(frameId, field, seq, me, enemy, fast);
+}
 
-            connector_->send(resp);
-            continue;
-        }
+// static
+Deadline AI::makeThinkDeadline(int currentFrameId, int thinkFrameId, bool fast)
+{
+    if (fast)
+        return Deadline::afterMillis(FAST_THINK_MILLIS);
+
+    // We have time until the puyo starts moving.
+    int millis = std::max(THINK_MILLIS, (thinkFrameId - currentFrameId) * 1000 / FPS);
+    return Deadline::afterMillis(millis);
+}
+
+DropDecision AI::thinkInTime(int currentFrameId, int thinkFrameId, const CoreField& field,
+                             const KumipuyoSeq& seq, bool fast)
+{
+    Deadline deadline = makeThinkDeadline(currentFrameId, thinkFrameId, fast);
+
+    double beginTime = currentTime();
+    DropDecision dropDecision = thinkWithDeadline(thinkFrameId, field, seq, myPlayerState(), enemyPlayerState(),
+                                                  fast, deadline);
+    recordThink(deadline, currentTime() - beginTime);
+    return dropDecision;
+}
+
+void AI::recordThink(const Deadline& deadline, double thinkTime)
+{
+    thinkStats_.numThinks++;
+    if (deadline.wasHit())
+        thinkStats_.numDeadlineHits++;
+    if (deadline.remainingSeconds() < 0)
+        thinkStats_.numOverruns++;
+    thinkStats_.maxThinkTime = std::max(thinkStats_.maxThinkTime, thinkTime);
+}
 
-        // Check field inconsistency. We only check when me_hand >= 3, since we cannot trust the field in 3 hands.
-        if (me_.hand >= 3 && isFieldInconsistent(next1.fieldBeforeThink.toPlainField(), frameRequest.myPlayerFrameRequest().field)) {
-            LOG(INFO) << "FIELD INCONSISTENCY DETECTED: hand=" << me_.hand;
-            VLOG(1) << '\n' << FieldPrettyPrinter::toStringFromMultipleFields(
-                { next1.fieldBeforeThink.toPlainField(), frameRequest.myPlayerFrameRequest().field },
-                { frameRequest.myPlayerFrameRequest().kumipuyoSeq, frameRequest.myPlayerFrameRequest().kumipuyoSeq });
+void AI::startAsyncThink(int currentFrameId, int thinkFrameId, const CoreField& field, const KumipuyoSeq& seq,
+                         bool speculative)
+{
+    DCHECK(!async_->running);
+
+    unique_ptr<AsyncThink> task(new AsyncThink);
+    task->speculative = speculative;
+    task->thinkFrameId = thinkFrameId;
+    task->field = field;
+    task->seq = seq;
+    task->me = me_;
+    task->enemy = enemy_;
+    task->deadline = makeThinkDeadline(currentFrameId, thinkFrameId, false);
+    task->beginTime = currentTime();
+
+    const AsyncThink* t = task.get();
+    task->result = std::async(std::launch::async, [this, t]() {
+        return thinkWithDeadline(t->thinkFrameId, t->field, t->seq, t->me, t->enemy, false, t->deadline);
+    });
+    async_->running = std::move(task);
+}
+
+bool AI::finishAsyncThink(bool wait)
+{
+    if (!async_->running)
+        return false;
 
-            next1.needsRethink = true;
+    AsyncThink* task = async_->running.get();
+    if (!wait && task->result.wait_for(chrono::seconds(0)) != future_status::ready)
+        return false;
+
+    DropDecision dropDecision = task->result.get();
+    unique_ptr<AsyncThink> finished(std::move(async_->running));
+
+    if (!finished->cancelled) {
+        recordThink(finished->deadline, currentTime() - finished->beginTime);
+        if (finished->speculative) {
+            async_->pondered.push_back(PonderedDecision { finished->field, finished->seq, dropDecision });
+        } else {
+            next1_->dropDecision = dropDecision;
+            next1_->ready = true;
         }
+    }
 
-        // Rethink if necessary.
-        if (next1.needsRethink || rethinkRequested_) {
-            LOG(INFO) << "RETHINK";
+    if (async_->hasDeferredGaze) {
+        async_->hasDeferredGaze = false;
+        gaze(async_->deferredGazeFrameId, async_->deferredGazeField, async_->deferredGazeSeq);
+    }
 
-            me_.field = mergeField(me_.field, frameRequest.myPlayerFrameRequest().field, next1.ojamaDropped);
-            const auto& kumipuyoSeq = frameRequest.myPlayerFrameRequest().kumipuyoSeq;
+    return true;
+}
 
-            KumipuyoSeq seq = rememberedSequence(me_.hand, kumipuyoSeq);
-            if (kumipuyoSeq.get(0) != seq.get(0) || kumipuyoSeq.get(1) != seq.get(1)) {
-                // desynced?
-                LOG(ERROR) << "desynced?"
-                           << " kumipuyoSeq=" << kumipuyoSeq.toString()
-                           << " seq=" << seq.toString();
-            }
+void AI::stopAsyncThink()
+{
+    if (!async_->running)
+        return;
 
-            next1.dropDecision = think(frameRequest.frameId, me_.field, seq, myPlayerState(), enemyPlayerState(), true);
-            next1.kumipuyo = kumipuyoSeq.get(0);
-            next1.ready = true;
-            next1.needsRethink = false;
-            next1.ojamaDropped = false;
-            rethinkRequested_ = false;
+    async_->running->cancelled = true;
+    async_->running->deadline.expire();
+    finishAsyncThink(true);
+}
+
+void AI::ponderIfUseful(int currentFrameId)
+{
+    const DecisionSending& next1 = *next1_;
+    if (async_->running || !next1.ready || next1.seqBeforeThink.size() < 2)
+        return;
+
+    // When ojama will fall, we need to rethink fast. Ponder it with the ojama lines.
+    // When the number of ojama is not a multiple of 6, the columns are random,
+    // so the pondered decision won't match. We don't ponder all the possibilities.
+    int numOjama = me_.totalOjama(enemy_);
+    if (numOjama < 6)
+        return;
+
+    CoreField field(next1.fieldBeforeThink);
+    field.fallOjama(std::min(5, numOjama / 6));
+    for (const PonderedDecision& pondered : async_->pondered) {
+        if (isSameThink(pondered.field, pondered.seq, field, next1.seqBeforeThink))
+            return;
+    }
+
+    VLOG(1) << "PONDER ojama=" << numOjama;
+    thinkStats_.numPonders++;
+    startAsyncThink(currentFrameId, nextThinkFrameId_, field, next1.seqBeforeThink, true);
+}
+
+bool AI::takePonderedDecision(const CoreField& field, const KumipuyoSeq& seq, DropDecision* dropDecision)
+{
+    if (async_->running) {
+        AsyncThink* task = async_->running.get();
+        if (task->speculative && isSameThink(task->field, task->seq, field, seq)) {
+            // We're pondering this. Wait for it as long as a fast think, and take the best so far.
+            task->result.wait_for(chrono::milliseconds(FAST_THINK_MILLIS));
+            task->deadline.expire();
+            finishAsyncThink(true);
+        } else {
+            stopAsyncThink();
         }
+    }
 
-        // Send
-        connector_->send(FrameResponse(frameRequest.frameId, next1.dropDecision.decision(), next1.dropDecision.message()));
-        nextThinkFrameId =
-            frameRequest.frameId +
-            next1.fieldBeforeThink.framesToDropNext(next1.dropDecision.decision()) +
-            FRAMES_PREPARING_NEXT;
-
-        // Move to next.
-        if (next1.dropDecision.decision().isValid() && next1.kumipuyo.isValid()) {
-            if (!me_.field.dropKumipuyo(next1.dropDecision.decision(), next1.kumipuyo)) {
-                LOG(WARNING) << "failed to drop kumipuyo. Moving to impossible position?";
-            }
-            me_.field.simulate();
+    for (const PonderedDecision& pondered : async_->pondered) {
+        if (isSameThink(pondered.field, pondered.seq, field, seq)) {
+            *dropDecision = pondered.dropDecision;
+            thinkStats_.numPonderHits++;
+            return true;
         }
-        next1.clear();
     }
 
-    LOG(INFO) << "will exit run loop";
+    return false;
+}
+
+void AI::gazeOrDefer(int frameId, const CoreField& field, const KumipuyoSeq& seq)
+{
+    if (!async_->running) {
+        gaze(frameId, field, seq);
+        return;
+    }
+
+    // Only the latest gaze matters.
+    async_->hasDeferredGaze = true;
+    async_->deferredGazeFrameId = frameId;
+    async_->deferredGazeField = field;
+    async_->deferredGazeSeq = seq;
 }
 
 void AI::gaze(int frameId, const CoreField&, const KumipuyoSeq&)
@@ -256,6 +537,10 @@ void AI::gaze(int frameId, const CoreField&, const KumipuyoSeq&)
 
 void AI::gameWillBegin(const FrameRequest& frameRequest)
 {
+    async_->hasDeferredGaze = false;
+    stopAsyncThink();
+    async_->pondered.clear();
+
     me_.clear();
     enemy_.clear();
 
@@ -269,6 +554,11 @@ void AI::gameWillBegin(const FrameRequest& frameRequest)
 
 void AI::gameHasEnded(const FrameRequest& frameRequest)
 {
+    stopAsyncThink();
+
+    LOG(INFO) << "think stats: " << thinkStats_.toString();
+    thinkStats_ = ThinkStats();
+
     onGameHasEnded(frameRequest);
 }
 
@@ -368,7 +658,7 @@ void AI::puyoErasedForEnemy(const FrameRequest& frameRequest)
         CoreField cf(CoreField::fromPlainFieldWithDrop(frameRequest.enemyPlayerFrameRequest().field));
         RensaResult rensaResult = cf.simulate();
         int enemyStartingFrameId = frameRequest.frameId + rensaResult.frames;
-        gaze(enemyStartingFrameId, cf, rememberedSequence(enemy_.hand + 1, kumipuyoSeq));
+        gazeOrDefer(enemyStartingFrameId, cf, rememberedSequence(enemy_.hand + 1, kumipuyoSeq));
     }
 
     onPuyoErasedForEnemy(frameRequest);
@@ -457,7 +747,7 @@ void AI::next2AppearedForEnemy(const FrameRequest& frameRequest)
     // When enemy_.hand == 0, rememberedSequence(0) contains PuyoColor::EMPTY.
     // So, don't gaze at that time.
     if (!enemy_.isRensaOngoing() && enemy_.hand > 0)
-        gaze(enemyDecisionRequestFrameId_, enemy_.field, rememberedSequence(enemy_.hand, kumipuyoSeq));
+        gazeOrDefer(enemyDecisionRequestFrameId_, enemy_.field, rememberedSequence(enemy_.hand, kumipuyoSeq));
 
     onNext2AppearedForEnemy(frameRequest);
 }
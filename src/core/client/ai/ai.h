@@ -11,20 +11,52 @@
 #include "core/player_state.h"
 
 class CoreField;
+class Deadline;
 class PlainField;
+struct AsyncThinkState;
+struct DecisionSending;
 struct FrameRequest;
+struct FrameResponse;
+
+// Counters of think() calls. They are logged and reset when a game has ended.
+struct ThinkStats {
+    std::string toString() const;
+
+    int numThinks = 0;
+    // The number of thinks stopped by the deadline.
+    int numDeadlineHits = 0;
+    // The number of thinks returned after the deadline.
+    int numOverruns = 0;
+    // [s]
+    double maxThinkTime = 0;
+    // The number of the speculative thinks (async think only).
+    int numPonders = 0;
+    // The number of the fast rethinks answered by a speculative think.
+    int numPonderHits = 0;
+};
 
 // AI is a utility class of AI.
 // You need to implement think() at least.
 class AI : public AIBase {
 public:
+    // The time to decide the hand (see think()).
+    static const int FAST_THINK_MILLIS = 30;
+    static const int THINK_MILLIS = 300;
+
     virtual ~AI() override;
     const std::string& name() const { return name_; }
 
+    const ThinkStats& thinkStats() const { return thinkStats_; }
+
     void runLoop();
 
     // Set AI's behavior. If true, you can rethink next decision when the enemy has started his rensa.
     void setBehaviorRethinkAfterOpponentRensa(bool flag) { behaviorRethinkAfterOpponentRensa_ = flag; }
+    // Set AI's behavior. If true, think() runs in another thread, and the frames are responded
+    // while thinking. While idle, AI also ponders the fast rethink that is likely to happen
+    // (e.g. after the ojama falls), so that the decision can come from a non-fast think.
+    // The default is --async_think.
+    void setBehaviorAsyncThink(bool flag) { behaviorAsyncThink_ = flag; }
 
 protected:
     AI(int argc, char* argv[], const std::string& name);
@@ -42,9 +74,20 @@ protected:
     // Otherwise, you will have at least 300 ms to decide your hand.
     // |KumipuyoSeq| will have at least 2 kumipuyos. When we know more Kumipuyo sequence,
     // it might contain more. It's up to you if you will use >=3 kumipuyos.
+    // When async think is enabled, think() is called in another thread. gaze() is not
+    // called while thinking, but the other callbacks (onX()) might be.
     virtual DropDecision think(int frameId, const CoreField&, const KumipuyoSeq&,
                                const PlayerState& me, const PlayerState& enemy, bool fast) const = 0;
 
+    // Same as think(), but |deadline| tells when the decision should be returned.
+    // It's at least 30 ms later when |fast| is true, otherwise at least 300 ms later.
+    // A deadline-aware AI can search deeper while it has time, and should return
+    // the best decision found so far when the deadline has passed.
+    // The default implementation just calls think().
+    virtual DropDecision thinkWithDeadline(int frameId, const CoreField&, const KumipuyoSeq&,
+                                           const PlayerState& me, const PlayerState& enemy, bool fast,
+                                           const Deadline& deadline) const;
+
     // gaze will be called when AI should gaze the enemy's field.
     // |frameId| is the frameId where the enemy has started moving his puyo.
     // His moving puyo is the front puyo of the KumipuyoSeq.
@@ -82,6 +125,10 @@ protected:
     // ----------------------------------------------------------------------
     // Usually, you don't need to care about methods below here.
 
+    // Handles one frame request, and returns the response for it.
+    // runLoop() calls this for each request from the connector.
+    FrameResponse playOneFrame(const FrameRequest&);
+
     // |gameWillBegin| will be called just before a new game will begin.
     // FrameRequest might contain NEXT and NEXT2 puyos, but it's not guaranteed.
     // Please initialize your AI in this function.
@@ -121,11 +168,33 @@ protected:
 private:
     friend class AITest;
     friend class Endless;
+    friend class HeadlessDuel;
     friend class Solver;
 
     static bool isFieldInconsistent(const PlainField& ours, const PlainField& provided);
     static CoreField mergeField(const CoreField& ours, const PlainField& provided, bool ojamaDropped);
 
+    // Returns the deadline of the think() called in |currentFrameId|.
+    static Deadline makeThinkDeadline(int currentFrameId, int thinkFrameId, bool fast);
+    // Calls thinkWithDeadline() with the deadline, and updates |thinkStats_|.
+    DropDecision thinkInTime(int currentFrameId, int thinkFrameId, const CoreField&, const KumipuyoSeq&, bool fast);
+    void recordThink(const Deadline&, double thinkTime);
+
+    // Starts thinking the next1 decision (or pondering if |speculative|) in another thread.
+    // Nothing should be running.
+    void startAsyncThink(int currentFrameId, int thinkFrameId, const CoreField&, const KumipuyoSeq&, bool speculative);
+    // Takes the result of the running async think if it has finished. If |wait| is true,
+    // waits for it. Returns true if the result is taken.
+    bool finishAsyncThink(bool wait);
+    // Cancels the running async think, and discards its result.
+    void stopAsyncThink();
+    // Starts pondering the fast rethink that is likely to happen in this hand.
+    void ponderIfUseful(int currentFrameId);
+    // Returns true if the decision for |field| and |seq| has been pondered.
+    bool takePonderedDecision(const CoreField&, const KumipuyoSeq&, DropDecision*);
+    // Calls gaze(), or defers it until the running async think finishes.
+    void gazeOrDefer(int frameId, const CoreField&, const KumipuyoSeq&);
+
     // Returns the remembered sequence. If desynced, provided is returned as is.
     KumipuyoSeq rememberedSequence(int indexFrom, const KumipuyoSeq& provided) const;
 
@@ -136,6 +205,11 @@ private:
     // Probably color recognizer misunderstand the field.
     bool desynced_;
 
+    // The decision for NEXT1. This is sent when the decision is requested.
+    std::unique_ptr<DecisionSending> next1_;
+    // The frameId in which the decision of the next think() is sent.
+    int nextThinkFrameId_;
+
     bool rethinkRequested_;
     int enemyDecisionRequestFrameId_;
 
@@ -143,6 +217,10 @@ private:
     PlayerState enemy_;
 
     bool behaviorRethinkAfterOpponentRensa_;
+    bool behaviorAsyncThink_;
+    std::unique_ptr<AsyncThinkState> async_;
+
+    ThinkStats thinkStats_;
 };
 
 #endif // CORE_CLIENT_AI_AI_H_
@@ -4,6 +4,9 @@
 #include <glog/logging.h>
 
 #include "base/strings.h"
+#ifdef OS_POSIX
+#include "core/connector/shm_connector_impl.h"
+#endif
 #include "core/connector/socket_connector_impl.h"
 #include "core/connector/stdio_connector_impl.h"
 #if defined(USE_TCP)
@@ -11,7 +14,7 @@
 #include "net/socket/unix_domain_client_socket.h"
 #endif
 
-DEFINE_string(connector, "stdio", "stdio, unix:<unix domain path>, or tcp:<hostname>:<port>");
+DEFINE_string(connector, "stdio", "stdio, unix:<unix domain path>, tcp:<hostname>:<port>, or shm:<shared memory name>");
 
 // static
 std::unique_ptr<ClientConnector> AIBase::makeConnector()
@@ -54,5 +57,14 @@ std::unique_ptr<ClientConnector> AIBase::makeConnector()
     }
 #endif
 
+#if defined(OS_POSIX)
+    if (strings::hasPrefix(FLAGS_connector, "shm:")) {
+        std::unique_ptr<ShmChannel> channel = ShmChannel::open(FLAGS_connector.substr(4));
+        CHECK(channel) << "failed to open " << FLAGS_connector;
+        std::unique_ptr<ConnectorImpl> impl(new ShmConnectorImpl(std::move(channel)));
+        return std::unique_ptr<ClientConnector>(new ClientConnector(std::move(impl)));
+    }
+#endif
+
     CHECK(false) << "Unknown connector: " << FLAGS_connector;
 }
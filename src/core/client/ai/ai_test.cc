@@ -2,9 +2,15 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "base/time.h"
 #include "core/core_field.h"
 #include "core/decision.h"
 #include "core/frame_request.h"
+#include "core/frame_response.h"
 #include "core/plain_field.h"
 
 class TestAI : public AI {
@@ -31,8 +37,37 @@ private:
     static const char* argv[];
 };
 
+// Takes 100 ms to think unless |fast|.
+class SlowTestAI : public AI {
+public:
+    SlowTestAI() : AI("slow") { setBehaviorAsyncThink(true); }
+    virtual ~SlowTestAI() {}
+
+    using AI::playOneFrame;
+    using AI::mutableMyPlayerState;
+
+    std::atomic<int> numFastThinks { 0 };
+    std::atomic<int> numSlowThinks { 0 };
+
+protected:
+    virtual DropDecision think(int, const CoreField&, const KumipuyoSeq&,
+                               const PlayerState&, const PlayerState&, bool fast) const override
+    {
+        if (fast) {
+            ++const_cast<SlowTestAI*>(this)->numFastThinks;
+            return DropDecision(Decision(1, 0), "fast");
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ++const_cast<SlowTestAI*>(this)->numSlowThinks;
+        return DropDecision(Decision(3, 0), "slow");
+    }
+};
+
 class AITest : public testing::Test {
 protected:
+    static void stopAsyncThink(AI* ai) { ai->stopAsyncThink(); }
+
     static bool isFieldInconsistent(const PlainField& lhs, const PlainField& rhs)
     {
         return AI::isFieldInconsistent(lhs, rhs);
@@ -593,3 +628,99 @@ TEST_F(AITest, mergeFieldOjama)
     EXPECT_EQ(expected1, mergeField(original, provided1, true));
     EXPECT_EQ(expected2, mergeField(original, provided2, true));
 }
+
+TEST_F(AITest, asyncThink)
+{
+    SlowTestAI ai;
+
+    FrameRequest req;
+    req.frameId = 1;
+    req.playerFrameRequest[0].kumipuyoSeq = KumipuyoSeq("RRBBYY");
+    req.playerFrameRequest[0].event.wnextAppeared = true;
+
+    // The frame is responded while thinking.
+    double beginTime = currentTime();
+    FrameResponse resp = ai.playOneFrame(req);
+    EXPECT_GT(0.05, currentTime() - beginTime);
+    EXPECT_FALSE(resp.decision.isValid());
+
+    req.frameId = 2;
+    req.playerFrameRequest[0].event.clear();
+    resp = ai.playOneFrame(req);
+    EXPECT_FALSE(resp.decision.isValid());
+
+    // When the decision is requested, the think is waited.
+    req.frameId = 3;
+    req.playerFrameRequest[0].event.decisionRequest = true;
+    resp = ai.playOneFrame(req);
+    EXPECT_EQ(Decision(3, 0), resp.decision);
+    EXPECT_EQ(1, ai.numSlowThinks);
+    EXPECT_EQ(0, ai.numFastThinks);
+
+    stopAsyncThink(&ai);
+}
+
+TEST_F(AITest, asyncThinkWithDecisionRequestAgain)
+{
+    SlowTestAI ai;
+
+    FrameRequest req;
+    req.frameId = 1;
+    req.playerFrameRequest[0].kumipuyoSeq = KumipuyoSeq("RRBBYY");
+    req.playerFrameRequest[0].event.wnextAppeared = true;
+    ai.playOneFrame(req);
+
+    // The current hand is thought again fast, while the next hand is being thought.
+    req.frameId = 2;
+    req.playerFrameRequest[0].event.clear();
+    req.playerFrameRequest[0].event.decisionRequestAgain = true;
+    FrameResponse resp = ai.playOneFrame(req);
+    EXPECT_EQ(Decision(1, 0), resp.decision);
+    EXPECT_EQ(1, ai.numFastThinks);
+
+    // The think of the next hand is not lost.
+    req.frameId = 3;
+    req.playerFrameRequest[0].event.clear();
+    req.playerFrameRequest[0].event.decisionRequest = true;
+    resp = ai.playOneFrame(req);
+    EXPECT_EQ(Decision(3, 0), resp.decision);
+    EXPECT_EQ(1, ai.numFastThinks);
+
+    stopAsyncThink(&ai);
+}
+
+TEST_F(AITest, ponderOjama)
+{
+    SlowTestAI ai;
+
+    FrameRequest req;
+    req.frameId = 1;
+    req.playerFrameRequest[0].kumipuyoSeq = KumipuyoSeq("RRBBYY");
+    req.playerFrameRequest[0].event.wnextAppeared = true;
+    ai.playOneFrame(req);
+
+    // 6 ojama will fall.
+    ai.mutableMyPlayerState()->fixedOjama = 6;
+
+    // The think has finished. Now AI ponders the field with 1 line of ojama.
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    req.frameId = 2;
+    req.playerFrameRequest[0].event.clear();
+    ai.playOneFrame(req);
+    EXPECT_EQ(1, ai.thinkStats().numPonders);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    req.frameId = 3;
+    req.playerFrameRequest[0].field = PlainField("OOOOOO");
+    req.playerFrameRequest[0].event.ojamaDropped = true;
+    req.playerFrameRequest[0].event.decisionRequest = true;
+    FrameResponse resp = ai.playOneFrame(req);
+
+    // The rethink is answered by the pondered (slow) think.
+    EXPECT_EQ(Decision(3, 0), resp.decision);
+    EXPECT_EQ(1, ai.thinkStats().numPonderHits);
+    EXPECT_EQ(2, ai.numSlowThinks);
+    EXPECT_EQ(0, ai.numFastThinks);
+
+    stopAsyncThink(&ai);
+}
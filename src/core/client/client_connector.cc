@@ -1,5 +1,6 @@
 #include "core/client/client_connector.h"
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include <string>
@@ -7,6 +8,8 @@
 #include "core/frame_request.h"
 #include "core/frame_response.h"
 
+DEFINE_bool(accept_binary_protocol, true, "Accept the binary protocol if the server offers it");
+
 using namespace std;
 
 namespace {
@@ -28,33 +31,52 @@ bool ClientConnector::receive(FrameRequest* frameRequest)
         return false;
     }
 
-    if (header.size > kBufferSize) {
-        LOG(ERROR) << "size too large: size=" << header.size;
+    const uint32_t size = header.payloadSize();
+    if (size > kBufferSize) {
+        LOG(ERROR) << "size too large: size=" << size;
         return false;
     }
 
     // TODO(mayah): This might cause buffer overflow.
     char payload[kBufferSize + 1];
-    if (!impl_->readExactly(payload, header.size)) {
+    if (!impl_->readExactly(payload, size)) {
         LOG(ERROR) << "unepxected eof when reading payload";
         return false;
     }
 
-    payload[header.size] = '\0';
+    payload[size] = '\0';
+
+    // Once the server sends a binary request, we reply in the binary protocol.
+    if (header.isBinary()) {
+        usesBinaryProtocol_ = true;
+        *frameRequest = FrameRequest::parseBinaryPayload(payload, size);
+        return true;
+    }
 
     // TODO: Use LOG(INFO) for informative frames.
     VLOG(1) << "RECEIVED: " << payload;
-    *frameRequest = FrameRequest::parsePayload(payload, header.size);
+    *frameRequest = FrameRequest::parsePayload(payload, size);
+    if (frameRequest->offersBinaryProtocol && FLAGS_accept_binary_protocol)
+        binaryProtocolOffered_ = true;
     return true;
 }
 
 void ClientConnector::send(const FrameResponse& resp)
 {
-    string s = resp.toString();
+    string s;
+    if (usesBinaryProtocol_) {
+        s = resp.toBinaryString();
+    } else if (binaryProtocolOffered_ && !resp.acceptsBinaryProtocol) {
+        FrameResponse accept(resp);
+        accept.acceptsBinaryProtocol = true;
+        s = accept.toString();
+    } else {
+        s = resp.toString();
+    }
 
     // Send size as header.
-    uint32_t size = s.size();
-    if (!impl_->writeExactly(&size, sizeof(size))) {
+    FrameResponseHeader header(s.size(), usesBinaryProtocol_);
+    if (!impl_->writeExactly(&header, sizeof(header))) {
         LOG(ERROR) << "failed to write header";
         return;
     }
@@ -65,8 +87,8 @@ void ClientConnector::send(const FrameResponse& resp)
     impl_->flush();
 
     if (resp.isValid()) {
-        LOG(INFO) << "SEND: " << s;
+        LOG(INFO) << "SEND: " << (usesBinaryProtocol_ ? resp.toString() : s);
     } else {
-        VLOG(1) << "SEND: " << s;
+        VLOG(1) << "SEND: " << (usesBinaryProtocol_ ? resp.toString() : s);
     }
 }
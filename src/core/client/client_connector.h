@@ -19,9 +19,14 @@ public:
     void send(const FrameResponse&);
 
     bool isClosed() { return closed_; }
+    // True if the server has switched to the binary protocol.
+    bool usesBinaryProtocol() const { return usesBinaryProtocol_; }
 
 protected:
     bool closed_ = false;
+    // True if the server has offered the binary protocol in the text protocol.
+    bool binaryProtocolOffered_ = false;
+    bool usesBinaryProtocol_ = false;
     std::unique_ptr<ConnectorImpl> impl_;
 
     DISALLOW_COPY_AND_ASSIGN(ClientConnector);
@@ -110,7 +110,7 @@ public:
 
             SmallIntSet newPlaceHolder;
             for (int j = 0; j < size_[i]; ++j) {
-                if (isPlaceHolder(cpl.puyos_[i][j]))
+                if (isPlaceHolder(puyos_[i][j]))
                     newPlaceHolder.set(j);
             }
             placeHolders_[i] = newPlaceHolder;
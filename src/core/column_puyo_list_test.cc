@@ -144,3 +144,31 @@ TEST(ColumnPuyoListTest, mergeWithPlaceHolders3)
 
     EXPECT_FALSE(cpl1.merge(cpl2));
 }
+
+TEST(ColumnPuyoListTest, mergeWithRemovedPlaceHolders)
+{
+    ColumnPuyoList cpl1;
+    ASSERT_TRUE(cpl1.add(3, PuyoColor::RED, 3));
+
+    // cpl2 still stores the removed place holders, but they are not in the list.
+    ColumnPuyoList cpl2;
+    ASSERT_TRUE(cpl2.add(3, PuyoColor::IRON, 3));
+    cpl2.removeTopFrom(3);
+    cpl2.removeTopFrom(3);
+    cpl2.removeTopFrom(3);
+    ASSERT_TRUE(cpl2.add(3, PuyoColor::YELLOW));
+
+    EXPECT_TRUE(cpl1.merge(cpl2));
+    EXPECT_FALSE(cpl1.hasPlaceHolder());
+
+    ColumnPuyoList cpl3;
+    ASSERT_TRUE(cpl3.add(3, PuyoColor::BLUE));
+    EXPECT_TRUE(cpl1.merge(cpl3));
+
+    EXPECT_EQ(5, cpl1.sizeOn(3));
+    EXPECT_EQ(PuyoColor::RED, cpl1.get(3, 0));
+    EXPECT_EQ(PuyoColor::RED, cpl1.get(3, 1));
+    EXPECT_EQ(PuyoColor::RED, cpl1.get(3, 2));
+    EXPECT_EQ(PuyoColor::YELLOW, cpl1.get(3, 3));
+    EXPECT_EQ(PuyoColor::BLUE, cpl1.get(3, 4));
+}
@@ -0,0 +1,180 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "base/latency_histogram.h"
+#include "core/connector/shm_channel.h"
+
+using namespace std;
+
+namespace {
+
+// The typical size of a FrameRequest in the binary protocol.
+const size_t MESSAGE_SIZE = 512;
+const int NUM_ROUND_TRIPS = 20000;
+
+bool readFully(int fd, void* buf, size_t size)
+{
+    char* p = static_cast<char*>(buf);
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* buf, size_t size)
+{
+    const char* p = static_cast<const char*>(buf);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+template<typename Write, typename Read>
+void measure(const char* label, Write write, Read read)
+{
+    LatencyHistogram histogram(0.000001, 1000);
+    char buf[MESSAGE_SIZE] {};
+    for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+        auto begin = chrono::steady_clock::now();
+        ASSERT_TRUE(write(buf, sizeof(buf)));
+        ASSERT_TRUE(read(buf, sizeof(buf)));
+        auto end = chrono::steady_clock::now();
+        histogram.add(chrono::duration<double>(end - begin).count());
+    }
+
+    cout << label << ": " << histogram.toString() << endl;
+}
+
+// Runs an echo server on the fds in a child process. Returns the pid.
+// The child closes |parentFd| so that it can see EOF when the parent closes it.
+pid_t forkFdEcho(int readFd, int writeFd, int parentFd)
+{
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    close(parentFd);
+
+    char buf[MESSAGE_SIZE];
+    while (readFully(readFd, buf, sizeof(buf)) && writeFully(writeFd, buf, sizeof(buf))) {}
+    _exit(0);
+}
+
+} // anonymous namespace
+
+TEST(ConnectorPerformanceTest, pipe)
+{
+    int toChild[2], toParent[2];
+    ASSERT_EQ(0, pipe(toChild));
+    ASSERT_EQ(0, pipe(toParent));
+
+    pid_t pid = forkFdEcho(toChild[0], toParent[1], toChild[1]);
+    ASSERT_LE(0, pid);
+    close(toChild[0]);
+    close(toParent[1]);
+
+    measure("pipe",
+            [&](const void* buf, size_t size) { return writeFully(toChild[1], buf, size); },
+            [&](void* buf, size_t size) { return readFully(toParent[0], buf, size); });
+
+    close(toChild[1]);
+    close(toParent[0]);
+    waitpid(pid, nullptr, 0);
+}
+
+TEST(ConnectorPerformanceTest, unixSocket)
+{
+    int sv[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+
+    pid_t pid = forkFdEcho(sv[1], sv[1], sv[0]);
+    ASSERT_LE(0, pid);
+    close(sv[1]);
+
+    measure("unix",
+            [&](const void* buf, size_t size) { return writeFully(sv[0], buf, size); },
+            [&](void* buf, size_t size) { return readFully(sv[0], buf, size); });
+
+    close(sv[0]);
+    waitpid(pid, nullptr, 0);
+}
+
+TEST(ConnectorPerformanceTest, tcpLoopback)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_LE(0, listener);
+
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    ASSERT_EQ(0, bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)));
+    ASSERT_EQ(0, listen(listener, 1));
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(0, getsockname(listener, reinterpret_cast<struct sockaddr*>(&addr), &len));
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, connect(client, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)));
+    int accepted = accept(listener, nullptr, nullptr);
+    ASSERT_LE(0, accepted);
+    close(listener);
+
+    int one = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(accepted, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    pid_t pid = forkFdEcho(accepted, accepted, client);
+    ASSERT_LE(0, pid);
+    close(accepted);
+
+    measure("tcp",
+            [&](const void* buf, size_t size) { return writeFully(client, buf, size); },
+            [&](void* buf, size_t size) { return readFully(client, buf, size); });
+
+    close(client);
+    waitpid(pid, nullptr, 0);
+}
+
+TEST(ConnectorPerformanceTest, shm)
+{
+    string name = "/puyoai_perf." + to_string(getpid());
+    unique_ptr<ShmChannel> server = ShmChannel::create(name);
+    ASSERT_TRUE(server.get());
+
+    pid_t pid = fork();
+    ASSERT_LE(0, pid);
+    if (pid == 0) {
+        unique_ptr<ShmChannel> client = ShmChannel::open(name);
+        char buf[MESSAGE_SIZE];
+        while (client && client->readExactly(buf, sizeof(buf)) && client->writeExactly(buf, sizeof(buf))) {}
+        _exit(0);
+    }
+    server->setPeerPid(pid);
+
+    measure("shm",
+            [&](const void* buf, size_t size) { return server->writeExactly(buf, size); },
+            [&](void* buf, size_t size) { return server->readExactly(buf, size); });
+
+    server.reset();
+    waitpid(pid, nullptr, 0);
+}
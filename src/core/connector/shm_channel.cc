@@ -0,0 +1,335 @@
+#include "core/connector/shm_channel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef OS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/macros.h"
+
+DEFINE_int32(shm_spin_count, 2000, "the number of polls before sleeping in the shm connector. Ignored on a single CPU.");
+
+using namespace std;
+
+namespace {
+
+const uint32_t SHM_MAGIC = 0x4d485350;  // "PSHM"
+const uint32_t RING_CAPACITY = 64 * 1024;
+
+static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "RING_CAPACITY should be a power of 2");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "atomic<uint32_t> should be lock-free to be shared between processes");
+
+inline void cpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Sleeps while |*word| is |value|, up to 100ms.
+void futexWait(atomic<uint32_t>* word, uint32_t value)
+{
+#ifdef OS_LINUX
+    struct timespec timeout = { 0, 100 * 1000 * 1000 };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+#else
+    if (word->load() == value)
+        usleep(100);
+#endif
+}
+
+void futexWake(atomic<uint32_t>* word)
+{
+#ifdef OS_LINUX
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    UNUSED_VARIABLE(word);
+#endif
+}
+
+} // anonymous namespace
+
+struct ShmRing {
+    // The position to read next. Only the consumer updates this.
+    atomic<uint32_t> head;
+    // True while the producer is sleeping on |head|.
+    atomic<uint32_t> writerSleeping;
+    // The producer and the consumer should update different cache lines.
+    char padding1[56];
+
+    // The position to write next. Only the producer updates this.
+    atomic<uint32_t> tail;
+    // True while the consumer is sleeping on |tail|.
+    atomic<uint32_t> readerSleeping;
+    char padding2[56];
+
+    char data[RING_CAPACITY];
+};
+
+struct ShmSegment {
+    uint32_t magic;
+    // Indexed by ShmChannel::Side.
+    atomic<int32_t> pids[2];
+    atomic<uint32_t> closed[2];
+    char padding[44];
+
+    // rings[0] is from the server to the client, and rings[1] is from the client to the server.
+    ShmRing rings[2];
+};
+
+// static
+unique_ptr<ShmChannel> ShmChannel::create(const string& name)
+{
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        PLOG(ERROR) << "failed to create shared memory " << name;
+        return unique_ptr<ShmChannel>();
+    }
+
+    if (ftruncate(fd, sizeof(ShmSegment)) < 0) {
+        PLOG(ERROR) << "failed to ftruncate shared memory " << name;
+        close(fd);
+        shm_unlink(name.c_str());
+        return unique_ptr<ShmChannel>();
+    }
+
+    void* p = mmap(nullptr, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        PLOG(ERROR) << "failed to mmap shared memory " << name;
+        shm_unlink(name.c_str());
+        return unique_ptr<ShmChannel>();
+    }
+
+    ShmSegment* segment = new (p) ShmSegment();
+    segment->pids[static_cast<int>(Side::SERVER)] = getpid();
+    segment->magic = SHM_MAGIC;
+
+    return unique_ptr<ShmChannel>(new ShmChannel(name, segment, Side::SERVER));
+}
+
+// static
+unique_ptr<ShmChannel> ShmChannel::open(const string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        PLOG(ERROR) << "failed to open shared memory " << name;
+        return unique_ptr<ShmChannel>();
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) != sizeof(ShmSegment)) {
+        LOG(ERROR) << "unexpected shared memory size: " << name;
+        close(fd);
+        return unique_ptr<ShmChannel>();
+    }
+
+    void* p = mmap(nullptr, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        PLOG(ERROR) << "failed to mmap shared memory " << name;
+        return unique_ptr<ShmChannel>();
+    }
+
+    ShmSegment* segment = static_cast<ShmSegment*>(p);
+    if (segment->magic != SHM_MAGIC) {
+        LOG(ERROR) << name << " is not a shm channel";
+        munmap(p, sizeof(ShmSegment));
+        return unique_ptr<ShmChannel>();
+    }
+    segment->pids[static_cast<int>(Side::CLIENT)] = getpid();
+
+    // Nobody else opens the segment, so the name is removed as soon as the client
+    // has attached. Otherwise, the name is leaked when the server crashes.
+    if (shm_unlink(name.c_str()) < 0 && errno != ENOENT)
+        PLOG(ERROR) << "failed to unlink shared memory " << name;
+
+    unique_ptr<ShmChannel> channel(new ShmChannel(name, segment, Side::CLIENT));
+    channel->unlinked_ = true;
+    return channel;
+}
+
+ShmChannel::ShmChannel(const string& name, ShmSegment* segment, Side side) :
+    name_(name),
+    segment_(segment),
+    side_(side),
+    // Spinning only steals the time slice from the peer on a single CPU.
+    spinCount_(sysconf(_SC_NPROCESSORS_ONLN) > 1 ? FLAGS_shm_spin_count : 0)
+{
+}
+
+ShmChannel::~ShmChannel()
+{
+    segment_->closed[static_cast<int>(side_)] = 1;
+    for (ShmRing& ring : segment_->rings) {
+        futexWake(&ring.head);
+        futexWake(&ring.tail);
+    }
+
+    munmap(segment_, sizeof(ShmSegment));
+    unlink();
+}
+
+void ShmChannel::unlink()
+{
+    if (unlinked_)
+        return;
+
+    // The client removes the name when it opens the channel.
+    if (shm_unlink(name_.c_str()) < 0 && errno != ENOENT)
+        PLOG(ERROR) << "failed to unlink shared memory " << name_;
+    unlinked_ = true;
+}
+
+void ShmChannel::setPeerPid(pid_t pid)
+{
+    DCHECK(side_ == Side::SERVER);
+    segment_->pids[static_cast<int>(Side::CLIENT)] = pid;
+}
+
+int ShmChannel::peerIndex() const
+{
+    return static_cast<int>(side_ == Side::SERVER ? Side::CLIENT : Side::SERVER);
+}
+
+ShmRing* ShmChannel::readRing() const
+{
+    return &segment_->rings[side_ == Side::SERVER ? 1 : 0];
+}
+
+ShmRing* ShmChannel::writeRing() const
+{
+    return &segment_->rings[side_ == Side::SERVER ? 0 : 1];
+}
+
+bool ShmChannel::isPeerClosed() const
+{
+    int peer = peerIndex();
+    if (segment_->closed[peer])
+        return true;
+
+    pid_t pid = segment_->pids[peer];
+    if (pid <= 0)
+        return false;
+
+    // The client is a child of the server. A dead child remains as a zombie, so kill() cannot
+    // tell it's dead. WNOWAIT leaves the child waitable, so the owner of the child can still
+    // reap it.
+    if (side_ == Side::SERVER) {
+        siginfo_t info;
+        memset(&info, 0, sizeof(info));
+        if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid)
+            return true;
+    }
+
+    return kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+bool ShmChannel::readExactly(void* buf, size_t size)
+{
+    ShmRing* ring = readRing();
+    char* out = static_cast<char*>(buf);
+
+    int spin = 0;
+    while (size > 0) {
+        uint32_t head = ring->head.load(memory_order_relaxed);
+        uint32_t tail = ring->tail.load(memory_order_acquire);
+        if (head == tail) {
+            if (spin++ < spinCount_) {
+                cpuRelax();
+                continue;
+            }
+
+            // The producer checks |readerSleeping| after updating |tail|, so either it wakes us up,
+            // or we see the new |tail| here.
+            ring->readerSleeping.store(1);
+            if (ring->tail.load() == tail)
+                futexWait(&ring->tail, tail);
+            ring->readerSleeping.store(0);
+
+            if (ring->tail.load() == tail && isPeerClosed())
+                return false;
+            continue;
+        }
+
+        spin = 0;
+        size_t n = min<size_t>(size, tail - head);
+        size_t offset = head & (RING_CAPACITY - 1);
+        size_t first = min<size_t>(n, RING_CAPACITY - offset);
+        memcpy(out, ring->data + offset, first);
+        memcpy(out + first, ring->data, n - first);
+
+        ring->head.store(head + n);
+        if (ring->writerSleeping.load())
+            futexWake(&ring->head);
+
+        out += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+bool ShmChannel::writeExactly(const void* buf, size_t size)
+{
+    ShmRing* ring = writeRing();
+    const char* in = static_cast<const char*>(buf);
+
+    int spin = 0;
+    while (size > 0) {
+        // Writing to a closed channel is meaningless.
+        if (segment_->closed[peerIndex()])
+            return false;
+
+        uint32_t tail = ring->tail.load(memory_order_relaxed);
+        uint32_t head = ring->head.load(memory_order_acquire);
+        if (tail - head == RING_CAPACITY) {
+            if (spin++ < spinCount_) {
+                cpuRelax();
+                continue;
+            }
+
+            ring->writerSleeping.store(1);
+            if (ring->head.load() == head)
+                futexWait(&ring->head, head);
+            ring->writerSleeping.store(0);
+
+            if (ring->head.load() == head && isPeerClosed())
+                return false;
+            continue;
+        }
+
+        spin = 0;
+        size_t n = min<size_t>(size, RING_CAPACITY - (tail - head));
+        size_t offset = tail & (RING_CAPACITY - 1);
+        size_t first = min<size_t>(n, RING_CAPACITY - offset);
+        memcpy(ring->data + offset, in, first);
+        memcpy(ring->data, in + first, n - first);
+
+        ring->tail.store(tail + n);
+        if (ring->readerSleeping.load())
+            futexWake(&ring->tail);
+
+        in += n;
+        size -= n;
+    }
+
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef CORE_CONNECTOR_SHM_CHANNEL_H_
+#define CORE_CONNECTOR_SHM_CHANNEL_H_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "base/noncopyable.h"
+
+struct ShmSegment;
+struct ShmRing;
+
+// ShmChannel is a bidirectional byte stream between 2 processes on POSIX shared memory.
+// Each direction is a single-producer single-consumer ring buffer, so no lock is used.
+// A reader (or a writer of a full ring) spins for a while, then sleeps on a futex until
+// the peer wakes it up. The peer calls the futex syscall only when someone is sleeping,
+// so a message usually doesn't need any syscall.
+//
+// The server creates the channel, and the client opens it by name.
+// On non-Linux platforms, sleeping on a futex is replaced with short sleeps.
+class ShmChannel : noncopyable {
+public:
+    enum class Side { SERVER, CLIENT };
+
+    // Creates a new shared memory segment |name| (e.g. "/puyoai.1234.0").
+    // Returns nullptr if failed.
+    static std::unique_ptr<ShmChannel> create(const std::string& name);
+    // Opens the segment created by the server, and removes its name, since
+    // the segment has only one client. Returns nullptr if failed.
+    static std::unique_ptr<ShmChannel> open(const std::string& name);
+
+    // Closes the channel. The peer fails to read after the remaining data.
+    ~ShmChannel();
+
+    // Removes the name of the segment if the client hasn't removed it yet.
+    // The segment remains until both sides unmap it.
+    void unlink();
+
+    // The server sets the pid of the client process, so that the server can notice
+    // the client process has died before opening the channel.
+    void setPeerPid(pid_t);
+
+    // The number of polls before sleeping. 0 means sleeping immediately.
+    void setSpinCount(int spinCount) { spinCount_ = spinCount; }
+
+    // Returns false when the peer has closed the channel or died.
+    bool readExactly(void* buf, size_t size);
+    bool writeExactly(const void* buf, size_t size);
+
+    // True if the peer has closed the channel or died. This doesn't reap the dead
+    // client process, so the caller can still wait for it.
+    bool isPeerClosed() const;
+
+private:
+    ShmChannel(const std::string& name, ShmSegment*, Side);
+
+    int peerIndex() const;
+    ShmRing* readRing() const;
+    ShmRing* writeRing() const;
+
+    std::string name_;
+    ShmSegment* segment_;
+    Side side_;
+    int spinCount_;
+    bool unlinked_ = false;
+};
+
+#endif // CORE_CONNECTOR_SHM_CHANNEL_H_
@@ -0,0 +1,150 @@
+#include "core/connector/shm_channel.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+string makeName(const char* suffix)
+{
+    return "/puyoai_test." + to_string(getpid()) + "." + suffix;
+}
+
+// Echoes back everything read from |name| until the channel is closed.
+void runEchoClient(const string& name)
+{
+    unique_ptr<ShmChannel> channel = ShmChannel::open(name);
+    if (!channel)
+        _exit(1);
+
+    char buf[1000];
+    while (channel->readExactly(buf, sizeof(buf))) {
+        if (!channel->writeExactly(buf, sizeof(buf)))
+            _exit(2);
+    }
+    _exit(0);
+}
+
+} // anonymous namespace
+
+TEST(ShmChannelTest, roundTrip)
+{
+    string name = makeName("roundTrip");
+    unique_ptr<ShmChannel> server = ShmChannel::create(name);
+    ASSERT_TRUE(server.get());
+
+    pid_t pid = fork();
+    ASSERT_LE(0, pid);
+    if (pid == 0)
+        runEchoClient(name);
+    server->setPeerPid(pid);
+
+    // 200KB in total passes through the 64KB ring several times.
+    for (int i = 0; i < 200; ++i) {
+        char sent[1000];
+        for (size_t j = 0; j < sizeof(sent); ++j)
+            sent[j] = static_cast<char>(i + j);
+
+        char received[1000];
+        ASSERT_TRUE(server->writeExactly(sent, sizeof(sent)));
+        ASSERT_TRUE(server->readExactly(received, sizeof(received)));
+        ASSERT_EQ(0, memcmp(sent, received, sizeof(sent))) << i;
+    }
+
+    server.reset();
+
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST(ShmChannelTest, writeLargerThanRing)
+{
+    string name = makeName("writeLargerThanRing");
+    unique_ptr<ShmChannel> server = ShmChannel::create(name);
+    ASSERT_TRUE(server.get());
+
+    pid_t pid = fork();
+    ASSERT_LE(0, pid);
+    if (pid == 0) {
+        unique_ptr<ShmChannel> client = ShmChannel::open(name);
+        vector<char> data(300 * 1000);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<char>(i * 7);
+        // The writer blocks until the server reads.
+        _exit(client && client->writeExactly(data.data(), data.size()) ? 0 : 1);
+    }
+    server->setPeerPid(pid);
+
+    vector<char> data(300 * 1000);
+    ASSERT_TRUE(server->readExactly(data.data(), data.size()));
+    for (size_t i = 0; i < data.size(); ++i)
+        ASSERT_EQ(static_cast<char>(i * 7), data[i]) << i;
+
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST(ShmChannelTest, readFailsAfterPeerDied)
+{
+    string name = makeName("readFailsAfterPeerDied");
+    unique_ptr<ShmChannel> server = ShmChannel::create(name);
+    ASSERT_TRUE(server.get());
+    server->setSpinCount(0);
+
+    pid_t pid = fork();
+    ASSERT_LE(0, pid);
+    if (pid == 0) {
+        // Die without closing the channel.
+        unique_ptr<ShmChannel> client = ShmChannel::open(name);
+        char c = 'x';
+        client->writeExactly(&c, 1);
+        _exit(0);
+    }
+    server->setPeerPid(pid);
+
+    // The data written before dying should be readable.
+    char c;
+    ASSERT_TRUE(server->readExactly(&c, 1));
+    EXPECT_EQ('x', c);
+    EXPECT_FALSE(server->readExactly(&c, 1));
+    EXPECT_TRUE(server->isPeerClosed());
+
+    // The channel should not have reaped the child.
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST(ShmChannelTest, nameIsRemovedAfterClientOpens)
+{
+    string name = makeName("nameIsRemovedAfterClientOpens");
+    unique_ptr<ShmChannel> server = ShmChannel::create(name);
+    ASSERT_TRUE(server.get());
+
+    unique_ptr<ShmChannel> client = ShmChannel::open(name);
+    ASSERT_TRUE(client.get());
+    EXPECT_FALSE(ShmChannel::open(name).get());
+
+    // The channel still works without the name.
+    char c = 'x';
+    ASSERT_TRUE(client->writeExactly(&c, 1));
+    c = '\0';
+    ASSERT_TRUE(server->readExactly(&c, 1));
+    EXPECT_EQ('x', c);
+}
+
+TEST(ShmChannelTest, openUnknownName)
+{
+    EXPECT_FALSE(ShmChannel::open(makeName("unknown")).get());
+}
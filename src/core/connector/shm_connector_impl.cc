@@ -0,0 +1,27 @@
+#include "core/connector/shm_connector_impl.h"
+
+#include <utility>
+
+ShmConnectorImpl::ShmConnectorImpl(std::unique_ptr<ShmChannel> channel) :
+    channel_(std::move(channel))
+{
+}
+
+ShmConnectorImpl::~ShmConnectorImpl()
+{
+}
+
+bool ShmConnectorImpl::readExactly(void* buf, size_t size)
+{
+    return channel_->readExactly(buf, size);
+}
+
+bool ShmConnectorImpl::writeExactly(const void* buf, size_t size)
+{
+    return channel_->writeExactly(buf, size);
+}
+
+void ShmConnectorImpl::flush()
+{
+    // do nothing. The peer can read the data as soon as it's written.
+}
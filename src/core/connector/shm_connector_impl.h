@@ -0,0 +1,22 @@
+#ifndef CORE_CONNECTOR_SHM_CONNECTOR_IMPL_H_
+#define CORE_CONNECTOR_SHM_CONNECTOR_IMPL_H_
+
+#include <memory>
+
+#include "core/connector/connector_impl.h"
+#include "core/connector/shm_channel.h"
+
+class ShmConnectorImpl : public ConnectorImpl {
+public:
+    explicit ShmConnectorImpl(std::unique_ptr<ShmChannel> channel);
+    ~ShmConnectorImpl();
+
+    bool readExactly(void* buf, size_t size) override;
+    bool writeExactly(const void* buf, size_t size) override;
+    void flush() override;
+
+private:
+    std::unique_ptr<ShmChannel> channel_;
+};
+
+#endif // CORE_CONNECTOR_SHM_CONNECTOR_IMPL_H_
@@ -43,6 +43,16 @@ public:
 
     bool operator()(int x, int y) const { return get(x, y); }
 
+    friend bool operator==(const FieldChecker& lhs, const FieldChecker& rhs)
+    {
+        for (int x = 0; x < FieldConstant::MAP_WIDTH; ++x) {
+            if (lhs.col_[x] != rhs.col_[x])
+                return false;
+        }
+        return true;
+    }
+    friend bool operator!=(const FieldChecker& lhs, const FieldChecker& rhs) { return !(lhs == rhs); }
+
 private:
     std::uint16_t col_[8];
 };
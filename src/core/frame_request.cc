@@ -2,10 +2,15 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <sstream>
+#include <vector>
 
+#include "base/sse.h"
+#include "core/bit_field.h"
+#include "core/field_bits.h"
 #include "core/field_pretty_printer.h"
 #include "core/kumipuyo.h"
 #include "core/plain_field.h"
@@ -58,6 +63,145 @@ static string formatNext(const KumipuyoSeq& seq)
     return ss.str();
 }
 
+// The binary format is a fixed-width little-endian layout.
+//
+//   offset  size  content
+//        0     1  version (BINARY_VERSION)
+//        1     4  frameId
+//        5     1  game result (BinaryEnd)
+//        6     1  matchEnd
+//        7    96  my player
+//      103    96  enemy player
+//
+// and each player is
+//
+//   offset  size  content
+//        0    80  FieldBits of OJAMA, RED, BLUE, YELLOW, and GREEN. (16 bytes each)
+//               Like the text format, only the rows 1-12 are carried.
+//       80     1  the number of kumipuyos (up to 3)
+//       81     3  kumipuyos. axis in the lower 4 bits, child in the higher 4 bits.
+//       84     3  kumipuyo pos (x, y, r)
+//       87     1  UserEvent bits
+//       88     4  score
+//       92     4  ojama
+
+namespace {
+
+const std::uint8_t BINARY_VERSION = 1;
+const size_t BINARY_PLAYER_SIZE = 96;
+
+// The same as "END=" in the text format.
+enum class BinaryEnd : std::uint8_t {
+    PLAYING, P1_WIN, P2_WIN, DRAW,
+};
+
+const PuyoColor BINARY_FIELD_COLORS[] = {
+    PuyoColor::OJAMA, PuyoColor::RED, PuyoColor::BLUE, PuyoColor::YELLOW, PuyoColor::GREEN,
+};
+
+void writeInt32(char* p, std::int32_t v)
+{
+    std::uint32_t u = static_cast<std::uint32_t>(v);
+    p[0] = static_cast<char>(u);
+    p[1] = static_cast<char>(u >> 8);
+    p[2] = static_cast<char>(u >> 16);
+    p[3] = static_cast<char>(u >> 24);
+}
+
+std::int32_t readInt32(const char* p)
+{
+    const unsigned char* q = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<std::int32_t>(q[0] | (q[1] << 8) | (q[2] << 16) | (static_cast<std::uint32_t>(q[3]) << 24));
+}
+
+std::uint8_t toBinaryEvent(const UserEvent& event)
+{
+    return (event.wnextAppeared ? 1 : 0) |
+        (event.grounded ? 2 : 0) |
+        (event.preDecisionRequest ? 4 : 0) |
+        (event.decisionRequest ? 8 : 0) |
+        (event.decisionRequestAgain ? 16 : 0) |
+        (event.ojamaDropped ? 32 : 0) |
+        (event.puyoErased ? 64 : 0);
+}
+
+UserEvent fromBinaryEvent(std::uint8_t bits)
+{
+    UserEvent event;
+    event.wnextAppeared = bits & 1;
+    event.grounded = bits & 2;
+    event.preDecisionRequest = bits & 4;
+    event.decisionRequest = bits & 8;
+    event.decisionRequestAgain = bits & 16;
+    event.ojamaDropped = bits & 32;
+    event.puyoErased = bits & 64;
+    return event;
+}
+
+void writeBinaryPlayer(char* p, const PlayerFrameRequest& req)
+{
+    BitField bf(req.field);
+    for (PuyoColor c : BINARY_FIELD_COLORS) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), bf.bits(c).maskedField12().xmm());
+        p += 16;
+    }
+
+    int numKumipuyos = std::min(req.kumipuyoSeq.size(), 3);
+    *p++ = static_cast<char>(numKumipuyos);
+    for (int i = 0; i < 3; ++i) {
+        if (i < numKumipuyos)
+            *p++ = static_cast<char>(ordinal(req.kumipuyoSeq.axis(i)) | (ordinal(req.kumipuyoSeq.child(i)) << 4));
+        else
+            *p++ = 0;
+    }
+
+    *p++ = static_cast<char>(req.kumipuyoPos.x);
+    *p++ = static_cast<char>(req.kumipuyoPos.y);
+    *p++ = static_cast<char>(req.kumipuyoPos.r);
+    *p++ = static_cast<char>(toBinaryEvent(req.event));
+    writeInt32(p, req.score);
+    writeInt32(p + 4, req.ojama);
+}
+
+bool readBinaryPlayer(const char* p, PlayerFrameRequest* req)
+{
+    PlainField field;
+    for (PuyoColor c : BINARY_FIELD_COLORS) {
+        FieldBits bits(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        bits.maskedField12().iterateBitPositions([&](int x, int y) {
+            field.setColor(x, y, c);
+        });
+        p += 16;
+    }
+    req->field = field;
+
+    int numKumipuyos = static_cast<unsigned char>(*p++);
+    if (numKumipuyos > 3)
+        return false;
+    std::vector<Kumipuyo> kumipuyos;
+    kumipuyos.reserve(numKumipuyos);
+    for (int i = 0; i < numKumipuyos; ++i) {
+        unsigned char v = static_cast<unsigned char>(p[i]);
+        if ((v & 0xF) >= NUM_PUYO_COLORS || (v >> 4) >= NUM_PUYO_COLORS)
+            return false;
+        kumipuyos.emplace_back(static_cast<PuyoColor>(v & 0xF), static_cast<PuyoColor>(v >> 4));
+    }
+    p += 3;
+    req->kumipuyoSeq = KumipuyoSeq(kumipuyos);
+
+    req->kumipuyoPos.x = static_cast<signed char>(p[0]);
+    req->kumipuyoPos.y = static_cast<signed char>(p[1]);
+    req->kumipuyoPos.r = static_cast<signed char>(p[2]);
+    req->event = fromBinaryEvent(static_cast<std::uint8_t>(p[3]));
+    req->score = readInt32(p + 4);
+    req->ojama = readInt32(p + 8);
+    return true;
+}
+
+} // namespace anonymous
+
+const size_t FrameRequest::BINARY_PAYLOAD_SIZE;
+
 static GameResult parseEnd(const char* value)
 {
     int x = std::atoi(value);
@@ -103,6 +247,9 @@ FrameRequest FrameRequest::parsePayload(const char* payload, size_t size)
         } else if (strncmp(key, "MATCHEND", 8) == 0) {
             req.matchEnd = parseMatchEnd(value);
             continue;
+        } else if (strncmp(key, "BINARY", 6) == 0) {
+            req.offersBinaryProtocol = std::atoi(value) == 1;
+            continue;
         }
 
         PlayerFrameRequest& pReq = req.playerFrameRequest[(key[0] == 'Y') ? 0 : 1];
@@ -139,6 +286,39 @@ FrameRequest FrameRequest::parsePayload(const char* payload, size_t size)
     return req;
 }
 
+// static
+FrameRequest FrameRequest::parseBinaryPayload(const char* payload, size_t size)
+{
+    if (size != BINARY_PAYLOAD_SIZE || static_cast<std::uint8_t>(payload[0]) != BINARY_VERSION) {
+        LOG(ERROR) << "malformed binary payload: size=" << size;
+        return FrameRequest();
+    }
+
+    FrameRequest req;
+    req.frameId = readInt32(payload + 1);
+    switch (static_cast<BinaryEnd>(payload[5])) {
+    case BinaryEnd::PLAYING: req.gameResult = GameResult::PLAYING; break;
+    case BinaryEnd::P1_WIN:  req.gameResult = GameResult::P1_WIN; break;
+    case BinaryEnd::P2_WIN:  req.gameResult = GameResult::P2_WIN; break;
+    case BinaryEnd::DRAW:    req.gameResult = GameResult::DRAW; break;
+    default:
+        LOG(ERROR) << "malformed binary payload: unknown end " << static_cast<int>(payload[5]);
+        return FrameRequest();
+    }
+    req.matchEnd = payload[6] != 0;
+
+    for (int i = 0; i < NUM_PLAYERS; ++i) {
+        if (!readBinaryPlayer(payload + 7 + BINARY_PLAYER_SIZE * i, &req.playerFrameRequest[i])) {
+            LOG(ERROR) << "malformed binary payload: player " << i;
+            return FrameRequest();
+        }
+    }
+
+    VLOG(1) << req.toDebugString();
+
+    return req;
+}
+
 string FrameRequest::toDebugString() const
 {
     stringstream ss;
@@ -188,6 +368,11 @@ string FrameRequest::toString() const
         matchEndStr = "MATCHEND=1 ";
     }
 
+    string binaryStr;
+    if (offersBinaryProtocol) {
+        binaryStr = "BINARY=1 ";
+    }
+
     stringstream ss;
     ss << "ID=" << frameId << " "
        << "YF=" << f0 << " "
@@ -207,6 +392,31 @@ string FrameRequest::toString() const
        << "YS=" << score0 << " "
        << "OS=" << score1 << " "
        << winStr
-       << matchEndStr;
+       << matchEndStr
+       << binaryStr;
     return ss.str();
 }
+
+string FrameRequest::toBinaryString() const
+{
+    string s(BINARY_PAYLOAD_SIZE, '\0');
+    char* p = &s[0];
+
+    p[0] = static_cast<char>(BINARY_VERSION);
+    writeInt32(p + 1, frameId);
+
+    BinaryEnd end;
+    switch (gameResult) {
+    case GameResult::PLAYING: end = BinaryEnd::PLAYING; break;
+    case GameResult::P1_WIN:  end = BinaryEnd::P1_WIN; break;
+    case GameResult::P2_WIN:  end = BinaryEnd::P2_WIN; break;
+    default:                  end = BinaryEnd::DRAW; break;
+    }
+    p[5] = static_cast<char>(end);
+    p[6] = matchEnd ? 1 : 0;
+
+    for (int i = 0; i < NUM_PLAYERS; ++i)
+        writeBinaryPlayer(p + 7 + BINARY_PLAYER_SIZE * i, playerFrameRequest[i]);
+
+    return s;
+}
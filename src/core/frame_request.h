@@ -11,7 +11,14 @@
 #include "core/user_event.h"
 
 struct FrameRequestHeader {
-    explicit FrameRequestHeader(uint32_t size = 0) : size(size) {}
+    // The most significant bit of |size| is set when the payload is in the binary format.
+    static const uint32_t BINARY_PAYLOAD_FLAG = 1U << 31;
+
+    explicit FrameRequestHeader(uint32_t size = 0, bool binary = false) :
+        size(binary ? (size | BINARY_PAYLOAD_FLAG) : size) {}
+
+    bool isBinary() const { return (size & BINARY_PAYLOAD_FLAG) != 0; }
+    uint32_t payloadSize() const { return size & ~BINARY_PAYLOAD_FLAG; }
 
     uint32_t size;
 };
@@ -26,9 +33,18 @@ struct PlayerFrameRequest {
 };
 
 struct FrameRequest {
+    // The size of the payload in the binary format.
+    static const size_t BINARY_PAYLOAD_SIZE = 199;
+
     static FrameRequest parsePayload(const char* payload, size_t size);
+    // Parses the payload in the binary format. If the payload is malformed,
+    // an invalid FrameRequest is returned.
+    static FrameRequest parseBinaryPayload(const char* payload, size_t size);
 
     std::string toString() const;
+    // Serializes this in the binary format. The binary format carries the same
+    // information as toString().
+    std::string toBinaryString() const;
     std::string toDebugString() const;
 
     bool isValid() const { return frameId != -1; }
@@ -41,6 +57,8 @@ struct FrameRequest {
     int frameId = -1;
     GameResult gameResult = GameResult::PLAYING;
     bool matchEnd = false;
+    // True if the server can talk the binary protocol. Only sent in the text format.
+    bool offersBinaryProtocol = false;
     PlayerFrameRequest playerFrameRequest[NUM_PLAYERS];
 };
 
@@ -0,0 +1,130 @@
+#include "core/frame_request.h"
+
+#include <iostream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "base/time_stamp_counter.h"
+#include "core/frame_response.h"
+
+using namespace std;
+
+namespace {
+
+FrameRequest makeFrameRequest()
+{
+    FrameRequest req;
+    req.frameId = 12345;
+
+    PlayerFrameRequest& me = req.playerFrameRequest[0];
+    me.field = PlainField(
+        "..YY.."
+        "GGBRRO"
+        "RRGBBY"
+        "GGRYYB"
+        "BBRRYY"
+        "OOOOOO");
+    me.kumipuyoSeq = KumipuyoSeq("RBYYGR");
+    me.kumipuyoPos = KumipuyoPos(3, 12, 0);
+    me.event.decisionRequest = true;
+    me.score = 12340;
+    me.ojama = 30;
+
+    PlayerFrameRequest& enemy = req.playerFrameRequest[1];
+    enemy.field = PlainField(
+        "Y....."
+        "GGYRRB"
+        "RRGBBY");
+    enemy.kumipuyoSeq = KumipuyoSeq("GGBRYB");
+    enemy.kumipuyoPos = KumipuyoPos(4, 11, 2);
+    enemy.score = 840;
+
+    return req;
+}
+
+} // namespace anonymous
+
+TEST(FrameRequestPerformanceTest, request)
+{
+    const int N = 100000;
+    const FrameRequest req = makeFrameRequest();
+    const string text = req.toString();
+    const string binary = req.toBinaryString();
+
+    TimeStampCounterData tscTextSerialize;
+    TimeStampCounterData tscTextParse;
+    TimeStampCounterData tscBinarySerialize;
+    TimeStampCounterData tscBinaryParse;
+
+    size_t n = 0;
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscTextSerialize);
+        n += req.toString().size();
+    }
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscTextParse);
+        n += FrameRequest::parsePayload(text.data(), text.size()).frameId;
+    }
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscBinarySerialize);
+        n += req.toBinaryString().size();
+    }
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscBinaryParse);
+        n += FrameRequest::parseBinaryPayload(binary.data(), binary.size()).frameId;
+    }
+    EXPECT_LT(0U, n);
+
+    cout << "text: " << text.size() << " bytes, binary: " << binary.size() << " bytes" << endl;
+    cout << "text serialize:" << endl;
+    tscTextSerialize.showStatistics();
+    cout << "text parse:" << endl;
+    tscTextParse.showStatistics();
+    cout << "binary serialize:" << endl;
+    tscBinarySerialize.showStatistics();
+    cout << "binary parse:" << endl;
+    tscBinaryParse.showStatistics();
+}
+
+TEST(FrameRequestPerformanceTest, response)
+{
+    const int N = 100000;
+    const FrameResponse resp(12345, Decision(3, 1), "thinking");
+    const string text = resp.toString();
+    const string binary = resp.toBinaryString();
+
+    TimeStampCounterData tscTextSerialize;
+    TimeStampCounterData tscTextParse;
+    TimeStampCounterData tscBinarySerialize;
+    TimeStampCounterData tscBinaryParse;
+
+    size_t n = 0;
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscTextSerialize);
+        n += resp.toString().size();
+    }
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscTextParse);
+        n += FrameResponse::parsePayload(text.data(), text.size()).frameId;
+    }
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscBinarySerialize);
+        n += resp.toBinaryString().size();
+    }
+    for (int i = 0; i < N; ++i) {
+        ScopedTimeStampCounter stsc(&tscBinaryParse);
+        n += FrameResponse::parseBinaryPayload(binary.data(), binary.size()).frameId;
+    }
+    EXPECT_LT(0U, n);
+
+    cout << "text: " << text.size() << " bytes, binary: " << binary.size() << " bytes" << endl;
+    cout << "text serialize:" << endl;
+    tscTextSerialize.showStatistics();
+    cout << "text parse:" << endl;
+    tscTextParse.showStatistics();
+    cout << "binary serialize:" << endl;
+    tscBinarySerialize.showStatistics();
+    cout << "binary parse:" << endl;
+    tscBinaryParse.showStatistics();
+}
@@ -39,3 +39,87 @@ TEST(FrameRequestTest, parseMatchEnd_false2)
 
     EXPECT_FALSE(request.matchEnd);
 }
+
+TEST(FrameRequestTest, parseBinaryOffer)
+{
+    std::string line = "ID=1 OP=4455 BINARY=1";
+    FrameRequest request = FrameRequest::parsePayload(line.data(), line.size());
+
+    EXPECT_TRUE(request.offersBinaryProtocol);
+    // The offer should not affect the enemy's request.
+    EXPECT_EQ(KumipuyoPos(), request.enemyPlayerFrameRequest().kumipuyoPos);
+}
+
+TEST(FrameRequestTest, toBinaryStringAndParse)
+{
+    FrameRequest expected;
+    expected.frameId = 12345;
+    expected.gameResult = GameResult::P2_WIN;
+    expected.matchEnd = true;
+
+    PlayerFrameRequest& me = expected.playerFrameRequest[0];
+    me.field = PlainField(
+        "O....."
+        "RRB..."
+        "BBYGGO");
+    me.kumipuyoSeq = KumipuyoSeq("RBYYGR");
+    me.kumipuyoPos = KumipuyoPos(3, 12, 1);
+    me.event.grounded = true;
+    me.event.decisionRequest = true;
+    me.score = 1234567;
+    me.ojama = -30;
+
+    PlayerFrameRequest& enemy = expected.playerFrameRequest[1];
+    enemy.field = PlainField(
+        "GGGYYY"
+        "RRRBBB");
+    enemy.kumipuyoSeq = KumipuyoSeq("RR");
+    enemy.kumipuyoPos = KumipuyoPos(6, 2, 3);
+    enemy.event.puyoErased = true;
+    enemy.score = 40;
+    enemy.ojama = 72;
+
+    std::string binary = expected.toBinaryString();
+    EXPECT_EQ(FrameRequest::BINARY_PAYLOAD_SIZE, binary.size());
+    FrameRequest actual = FrameRequest::parseBinaryPayload(binary.data(), binary.size());
+
+    // The binary format should carry the same information as the text format.
+    std::string text = expected.toString();
+    FrameRequest textActual = FrameRequest::parsePayload(text.data(), text.size());
+    EXPECT_EQ(textActual.toString(), actual.toString());
+
+    EXPECT_EQ(expected.frameId, actual.frameId);
+    EXPECT_EQ(expected.gameResult, actual.gameResult);
+    EXPECT_TRUE(actual.matchEnd);
+    for (int i = 0; i < NUM_PLAYERS; ++i) {
+        EXPECT_EQ(expected.playerFrameRequest[i].field, actual.playerFrameRequest[i].field);
+        EXPECT_EQ(expected.playerFrameRequest[i].kumipuyoSeq, actual.playerFrameRequest[i].kumipuyoSeq);
+        EXPECT_EQ(expected.playerFrameRequest[i].kumipuyoPos, actual.playerFrameRequest[i].kumipuyoPos);
+        EXPECT_EQ(expected.playerFrameRequest[i].event.toString(), actual.playerFrameRequest[i].event.toString());
+        EXPECT_EQ(expected.playerFrameRequest[i].score, actual.playerFrameRequest[i].score);
+        EXPECT_EQ(expected.playerFrameRequest[i].ojama, actual.playerFrameRequest[i].ojama);
+    }
+}
+
+TEST(FrameRequestTest, parseMalformedBinary)
+{
+    FrameRequest request;
+    request.frameId = 1;
+    std::string binary = request.toBinaryString();
+
+    EXPECT_FALSE(FrameRequest::parseBinaryPayload(binary.data(), binary.size() - 1).isValid());
+
+    binary[0] = 0;
+    EXPECT_FALSE(FrameRequest::parseBinaryPayload(binary.data(), binary.size()).isValid());
+}
+
+TEST(FrameRequestTest, header)
+{
+    FrameRequestHeader text(100);
+    EXPECT_FALSE(text.isBinary());
+    EXPECT_EQ(100U, text.payloadSize());
+
+    FrameRequestHeader binary(100, true);
+    EXPECT_TRUE(binary.isBinary());
+    EXPECT_EQ(100U, binary.payloadSize());
+}
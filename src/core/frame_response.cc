@@ -1,11 +1,32 @@
 #include "core/frame_response.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <string>
 
+#include <glog/logging.h>
+
 using namespace std;
 
+// The binary format is a little-endian layout.
+//
+//   offset  size  content
+//        0     1  version (BINARY_VERSION)
+//        1     4  frameId
+//        5     2  decision (x, r)
+//        7     2  preDecision (x, r)
+//        9     2  the length of message (n)
+//       11     n  message
+
+namespace {
+
+const std::uint8_t BINARY_VERSION = 1;
+const size_t BINARY_HEADER_SIZE = 11;
+
+} // namespace anonymous
+
 static string unescapeMessage(const string& str)
 {
     string result;
@@ -66,6 +87,8 @@ FrameResponse FrameResponse::parsePayload(const char* payload, size_t size)
             data.message = unescapeMessage(tmp.c_str() + 4);
         } else if (tmp.substr(0, 3) == "MA=") {
             data.mawashiArea = tmp.c_str() + 3;
+        } else if (tmp.substr(0, 7) == "BINARY=") {
+            data.acceptsBinaryProtocol = tmp.substr(7) == "1";
         }
     }
 
@@ -92,6 +115,56 @@ std::string FrameResponse::toString() const
     if (!message.empty()) {
         ss << " MSG=" << escapeMessage(message);
     }
+    if (acceptsBinaryProtocol) {
+        ss << " BINARY=1";
+    }
 
     return ss.str();
 }
+
+// static
+FrameResponse FrameResponse::parseBinaryPayload(const char* payload, size_t size)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(payload);
+    if (size < BINARY_HEADER_SIZE || p[0] != BINARY_VERSION) {
+        LOG(ERROR) << "malformed binary payload: size=" << size;
+        return FrameResponse();
+    }
+
+    size_t messageSize = p[9] | (p[10] << 8);
+    if (size != BINARY_HEADER_SIZE + messageSize) {
+        LOG(ERROR) << "malformed binary payload: size=" << size << " message size=" << messageSize;
+        return FrameResponse();
+    }
+
+    FrameResponse data;
+    data.frameId = static_cast<std::int32_t>(p[1] | (p[2] << 8) | (p[3] << 16) | (static_cast<std::uint32_t>(p[4]) << 24));
+    data.decision = Decision(static_cast<signed char>(p[5]), static_cast<signed char>(p[6]));
+    data.preDecision = Decision(static_cast<signed char>(p[7]), static_cast<signed char>(p[8]));
+    data.message.assign(payload + BINARY_HEADER_SIZE, messageSize);
+    return data;
+}
+
+std::string FrameResponse::toBinaryString() const
+{
+    // Like toString(), an invalid decision is not carried.
+    const Decision d = decision.isValid() ? decision : Decision();
+    const Decision pd = preDecision.isValid() ? preDecision : Decision();
+    const size_t messageSize = std::min<size_t>(message.size(), 0xFFFF);
+
+    string s(BINARY_HEADER_SIZE + messageSize, '\0');
+    const std::uint32_t id = static_cast<std::uint32_t>(frameId);
+    s[0] = static_cast<char>(BINARY_VERSION);
+    s[1] = static_cast<char>(id);
+    s[2] = static_cast<char>(id >> 8);
+    s[3] = static_cast<char>(id >> 16);
+    s[4] = static_cast<char>(id >> 24);
+    s[5] = static_cast<char>(d.x);
+    s[6] = static_cast<char>(d.r);
+    s[7] = static_cast<char>(pd.x);
+    s[8] = static_cast<char>(pd.r);
+    s[9] = static_cast<char>(messageSize);
+    s[10] = static_cast<char>(messageSize >> 8);
+    s.replace(BINARY_HEADER_SIZE, messageSize, message, 0, messageSize);
+    return s;
+}
@@ -7,13 +7,23 @@
 #include "core/key_set.h"
 
 struct FrameResponseHeader {
-    explicit FrameResponseHeader(uint32_t size = 0) : size(size) {}
+    // The most significant bit of |size| is set when the payload is in the binary format.
+    static const uint32_t BINARY_PAYLOAD_FLAG = 1U << 31;
+
+    explicit FrameResponseHeader(uint32_t size = 0, bool binary = false) :
+        size(binary ? (size | BINARY_PAYLOAD_FLAG) : size) {}
+
+    bool isBinary() const { return (size & BINARY_PAYLOAD_FLAG) != 0; }
+    uint32_t payloadSize() const { return size & ~BINARY_PAYLOAD_FLAG; }
 
     uint32_t size;
 };
 
 struct FrameResponse {
     static FrameResponse parsePayload(const char* payload, size_t size);
+    // Parses the payload in the binary format. If the payload is malformed,
+    // a FrameResponse whose frameId is -1 is returned.
+    static FrameResponse parseBinaryPayload(const char* payload, size_t size);
 
     FrameResponse() {}
     explicit FrameResponse(int frameId,
@@ -24,11 +34,17 @@ struct FrameResponse {
     // TODO(mayah): Rename this method.
     bool isValid() const;
     std::string toString() const;
+    // Serializes this in the binary format. The binary format carries the same
+    // information as toString().
+    std::string toBinaryString() const;
 
     int frameId = -1;
     Decision decision;
     Decision preDecision;
     std::string message;
+    // True if the client accepts the binary protocol offered by the server.
+    // Only sent in the text format.
+    bool acceptsBinaryProtocol = false;
 
     // Mostly for HumanConnection.
     KeySet keySet;
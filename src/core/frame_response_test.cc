@@ -35,3 +35,39 @@ TEST(FrameResponseTest, toStringAndParse)
     EXPECT_EQ(expected.decision, actual.decision);
     EXPECT_EQ(expected.message, actual.message);
 }
+
+TEST(FrameResponseTest, parseBinaryAccept)
+{
+    std::string line = "ID=1 X=3 R=0 BINARY=1";
+    FrameResponse response = FrameResponse::parsePayload(line.data(), line.size());
+
+    EXPECT_TRUE(response.acceptsBinaryProtocol);
+    EXPECT_EQ(Decision(3, 0), response.decision);
+}
+
+TEST(FrameResponseTest, toBinaryStringAndParse)
+{
+    FrameResponse expected;
+    expected.frameId = 100000;
+    expected.decision = Decision(6, 3);
+    expected.preDecision = Decision(1, 1);
+    expected.message = "message with space (1)\nmessage with space (2)";
+
+    std::string binary = expected.toBinaryString();
+    FrameResponse actual = FrameResponse::parseBinaryPayload(binary.data(), binary.size());
+
+    EXPECT_TRUE(actual.isValid());
+    EXPECT_EQ(expected.frameId, actual.frameId);
+    EXPECT_EQ(expected.decision, actual.decision);
+    EXPECT_EQ(expected.preDecision, actual.preDecision);
+    EXPECT_EQ(expected.message, actual.message);
+}
+
+TEST(FrameResponseTest, parseMalformedBinary)
+{
+    FrameResponse response(1, Decision(3, 0), "hello");
+    std::string binary = response.toBinaryString();
+
+    EXPECT_EQ(-1, FrameResponse::parseBinaryPayload(binary.data(), binary.size() - 1).frameId);
+    EXPECT_EQ(-1, FrameResponse::parseBinaryPayload(binary.data(), 3).frameId);
+}
@@ -28,6 +28,7 @@ ColumnPuyoList diff(const CoreField& before, const BitField& after)
 PatternBook::PatternBook() :
     root_(new PatternTree())
 {
+    compile();
 }
 
 PatternBook::~PatternBook()
@@ -146,9 +147,49 @@ bool PatternBook::loadFromValue(const toml::Value& patterns, bool ignoreDuplicat
         }
     }
 
+    compile();
     return true;
 }
 
+void PatternBook::compile()
+{
+    nodes_.clear();
+    compileNode(*root_, PatternBit(FieldBits(), FieldBits()));
+}
+
+void PatternBook::compileNode(const PatternTree& tree, const PatternBit& patternBit)
+{
+    const int index = static_cast<int>(nodes_.size());
+    nodes_.emplace_back(patternBit, tree.isLeaf() ? &tree.patternBookField() : nullptr);
+
+    bool hasRequiredVarBits = false;
+    bool hasRequiredMustBits = false;
+    FieldBits requiredVarBits;
+    FieldBits requiredMustBits;
+    if (tree.isLeaf()) {
+        // A path can end here, so the children can't require anything.
+        hasRequiredVarBits = true;
+        hasRequiredMustBits = true;
+        requiredMustBits = tree.patternBookField().mustBits();
+    }
+
+    for (const auto& entry : tree.children_) {
+        const int childIndex = static_cast<int>(nodes_.size());
+        compileNode(*entry.second, entry.first);
+
+        // Note that |nodes_| might be reallocated in compileNode().
+        const Node& child = nodes_[childIndex];
+        requiredVarBits = hasRequiredVarBits ? (requiredVarBits & child.requiredVarBits) : child.requiredVarBits;
+        requiredMustBits = hasRequiredMustBits ? (requiredMustBits & child.requiredMustBits) : child.requiredMustBits;
+        hasRequiredVarBits = hasRequiredMustBits = true;
+    }
+
+    Node& node = nodes_[index];
+    node.requiredVarBits = node.varBits | requiredVarBits;
+    node.requiredMustBits = requiredMustBits;
+    node.subtreeEnd = static_cast<int>(nodes_.size());
+}
+
 void PatternBook::complement(const CoreField& originalField,
                                 const PatternBook::ComplementCallback& callback) const
 {
@@ -159,7 +200,7 @@ void PatternBook::complement(const CoreField& originalField,
                                 int allowedNumUnusedVariables,
                                 const ComplementCallback& callback) const
 {
-    iterate(*root_, originalField, originalField.bitField(), FieldBits(), allowedNumUnusedVariables, 0, callback);
+    iterate(0, originalField, originalField.bitField(), FieldBits(), allowedNumUnusedVariables, 0, callback);
 }
 
 void PatternBook::complement(const CoreField& originalField,
@@ -167,17 +208,17 @@ void PatternBook::complement(const CoreField& originalField,
                              int allowedNumUnusedVariables,
                              const ComplementCallback& callback) const
 {
-    for (const auto& entry : root_->children_) {
-        if (entry.first.varBits() != ignitionBits)
+    for (int i = 1; i < nodes_[0].subtreeEnd; i = nodes_[i].subtreeEnd) {
+        if (nodes_[i].varBits != ignitionBits)
             continue;
         // TODO(mayah): Probably, we don't need to check notBits.
-        iterate(*entry.second, originalField, originalField.bitField(),
-                entry.first.varBits() & ignitionBits,
+        iterate(i, originalField, originalField.bitField(),
+                nodes_[i].varBits & ignitionBits,
                 allowedNumUnusedVariables, 0, callback);
     }
 }
 
-void PatternBook::iterate(const PatternTree& tree,
+void PatternBook::iterate(int nodeIndex,
                           const CoreField& originalField,
                           const BitField& currentField,
                           const FieldBits& matchedBits,
@@ -185,24 +226,37 @@ void PatternBook::iterate(const PatternTree& tree,
                           int numUnusedVariables,
                           const ComplementCallback& callback) const
 {
-    if (tree.isLeaf()) {
-        if ((tree.patternBookField().mustBits() & originalField.bitField().field13Bits()) == tree.patternBookField().mustBits()) {
+    const Node& node = nodes_[nodeIndex];
+    const FieldBits originalBits = originalField.bitField().field13Bits();
+
+    if (node.patternBookField) {
+        const PatternBookField& patternBookField = *node.patternBookField;
+        if ((patternBookField.mustBits() & originalBits) == patternBookField.mustBits()) {
             BitField bf(currentField);
-            bf.setColorAllIfEmpty(tree.patternBookField().ironBits(), PuyoColor::IRON);
+            bf.setColorAllIfEmpty(patternBookField.ironBits(), PuyoColor::IRON);
             if (!bf.hasFloatingPuyo()) {
                 CoreField cf(bf);
-                callback(std::move(cf), diff(originalField, bf), numUnusedVariables, matchedBits, tree.patternBookField());
+                callback(std::move(cf), diff(originalField, bf), numUnusedVariables, matchedBits, patternBookField);
             }
         }
     }
 
     FieldBits ojamaBits = currentField.bits(PuyoColor::OJAMA);
-    for (const auto& entry : tree.children_) {
+    for (int childIndex = nodeIndex + 1; childIndex < node.subtreeEnd; childIndex = nodes_[childIndex].subtreeEnd) {
+        const Node& child = nodes_[childIndex];
+
+        // Prefilter the whole subtree. The ojama won't move while iterating, and
+        // the original field won't change.
+        if (!(child.requiredVarBits & ojamaBits).isEmpty())
+            continue;
+        if ((child.requiredMustBits & originalBits) != child.requiredMustBits)
+            continue;
+
         PuyoColor foundColor = PuyoColor::EMPTY;
         bool ok = true;
         FieldBits newMatchedBits(matchedBits);
         for (PuyoColor c : NORMAL_PUYO_COLORS) {
-            FieldBits matched = entry.first.varBits() & currentField.bits(c);
+            FieldBits matched = child.varBits & currentField.bits(c);
             if (matched.isEmpty())
                 continue;
             if (foundColor != PuyoColor::EMPTY) {
@@ -216,10 +270,6 @@ void PatternBook::iterate(const PatternTree& tree,
         if (!ok)
             continue;
 
-        // Check ojama.
-        if (!(entry.first.varBits() & ojamaBits).isEmpty())
-            continue;
-
         bool unusedVariableUsed = false;
         if (foundColor == PuyoColor::EMPTY) {
             if (allowedNumUnusedVariables <= numUnusedVariables)
@@ -227,7 +277,7 @@ void PatternBook::iterate(const PatternTree& tree,
 
             // TODO(mayah): Should check all colors?
             for (PuyoColor c : NORMAL_PUYO_COLORS) {
-                if ((entry.first.notBits() & currentField.bits(c)).isEmpty()) {
+                if ((child.notBits & currentField.bits(c)).isEmpty()) {
                     foundColor = c;
                     break;
                 }
@@ -239,12 +289,12 @@ void PatternBook::iterate(const PatternTree& tree,
             unusedVariableUsed = true;
         } else {
             // Check not bits.
-            if (!(entry.first.notBits() & currentField.bits(foundColor)).isEmpty())
+            if (!(child.notBits & currentField.bits(foundColor)).isEmpty())
                 continue;
         }
 
         BitField bf(currentField);
-        bf.setColorAll(entry.first.varBits(), foundColor);
-        iterate(*entry.second, originalField, bf, newMatchedBits, allowedNumUnusedVariables, unusedVariableUsed ? numUnusedVariables + 1 : numUnusedVariables, callback);
+        bf.setColorAll(child.varBits, foundColor);
+        iterate(childIndex, originalField, bf, newMatchedBits, allowedNumUnusedVariables, unusedVariableUsed ? numUnusedVariables + 1 : numUnusedVariables, callback);
     }
 }
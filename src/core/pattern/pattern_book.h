@@ -38,7 +38,30 @@ public:
     void complement(const CoreField&, const FieldBits& ignitionBits, int allowedNumUnusedVariables, const ComplementCallback&) const;
 
 private:
-    void iterate(const PatternTree&,
+    // After loading, PatternTree is compiled into a flat array of Node.
+    // The nodes are stored in pre-order. The first child of nodes_[i] is nodes_[i + 1],
+    // the next sibling of nodes_[j] is nodes_[nodes_[j].subtreeEnd], and the children
+    // of nodes_[i] end at nodes_[i].subtreeEnd.
+    struct Node {
+        Node(const PatternBit& patternBit, const PatternBookField* patternBookField) :
+            varBits(patternBit.varBits()), notBits(patternBit.notBits()), patternBookField(patternBookField) {}
+
+        FieldBits varBits;
+        FieldBits notBits;
+        // The bits that every path from this node to a leaf will match as a variable.
+        // If an ojama is on these bits, no pattern in this subtree matches.
+        FieldBits requiredVarBits;
+        // The bits that every leaf in this subtree requires as a precondition.
+        FieldBits requiredMustBits;
+        int subtreeEnd = 0;
+        // nullptr if not leaf.
+        const PatternBookField* patternBookField;
+    };
+
+    void compile();
+    void compileNode(const PatternTree&, const PatternBit&);
+
+    void iterate(int nodeIndex,
                  const CoreField& oridinalField,
                  const BitField& currentField,
                  const FieldBits& matchedBits,
@@ -47,6 +70,7 @@ private:
                  const ComplementCallback&) const;
 
     std::unique_ptr<PatternTree> root_;
+    std::vector<Node> nodes_;
 };
 
 #endif // CPU_MAYAH_PATTERN_BOOK_H_
@@ -575,3 +575,46 @@ ignition = 2
 
     testUnmatch(BOOK, original);
 }
+
+TEST(PatternBookTest, emptyBook)
+{
+    PatternBook patternBook;
+
+    bool found = false;
+    auto callback = [&](CoreField&& /*cf*/, const ColumnPuyoList& /*cpl*/,
+                        int /*numFilledUnusedVariables*/, const FieldBits& /*matchedBits*/,
+                        const PatternBookField& /*patternBookField*/) {
+        found = true;
+    };
+
+    patternBook.complement(CoreField("RRRBBB"), callback);
+    EXPECT_FALSE(found);
+}
+
+TEST(PatternBookTest, complementWithOjamaInSubtree)
+{
+    // Both patterns share "AAA". The first one can't match since (4, 1) is ojama,
+    // but the second one should still match.
+    static const char BOOK[] = R"(
+[[pattern]]
+field = [
+    "AAAB..",
+]
+
+[[pattern]]
+field = [
+    "B.....",
+    "AAA...",
+]
+)";
+
+    CoreField original("RRRO..");
+
+    CoreField expected[] {
+        CoreField(
+            "B....."
+            "RRRO.."),
+    };
+
+    testComplement(BOOK, original, expected, ARRAY_SIZE(expected), 1);
+}
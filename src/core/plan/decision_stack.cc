@@ -0,0 +1,61 @@
+#include "core/plan/decision_stack.h"
+
+#include <memory>
+
+#include <glog/logging.h>
+
+using namespace std;
+
+namespace {
+
+struct DecisionStoragePool {
+    vector<unique_ptr<vector<Decision>>> storages;
+    vector<vector<Decision>*> freeList;
+};
+
+thread_local DecisionStoragePool pool;
+
+vector<Decision>* acquireStorage()
+{
+    if (pool.freeList.empty()) {
+        pool.storages.emplace_back(new vector<Decision>);
+        pool.storages.back()->reserve(DecisionStack::DEFAULT_CAPACITY);
+        return pool.storages.back().get();
+    }
+
+    vector<Decision>* storage = pool.freeList.back();
+    pool.freeList.pop_back();
+    return storage;
+}
+
+void releaseStorage(vector<Decision>* storage)
+{
+    storage->clear();
+    pool.freeList.push_back(storage);
+}
+
+}
+
+DecisionStack::DecisionStack() :
+    decisions_(acquireStorage())
+{
+}
+
+DecisionStack::DecisionStack(const vector<Decision>& initialDecisions) :
+    decisions_(acquireStorage())
+{
+    decisions_->assign(initialDecisions.begin(), initialDecisions.end());
+}
+
+DecisionStack::~DecisionStack()
+{
+    DCHECK_LE(pool.freeList.size() + 1, pool.storages.size())
+        << "DecisionStack should be destructed in the thread that constructed it";
+    releaseStorage(decisions_);
+}
+
+// static
+int DecisionStack::numStoragesInThisThread()
+{
+    return static_cast<int>(pool.storages.size());
+}
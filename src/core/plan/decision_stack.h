@@ -0,0 +1,42 @@
+#ifndef CORE_PLAN_DECISION_STACK_H_
+#define CORE_PLAN_DECISION_STACK_H_
+
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "core/decision.h"
+
+// DecisionStack is a stack of decisions used while enumerating plans.
+//
+// The storage is borrowed from a per-thread pool, and returned to the pool when
+// the stack is destructed. So, once the pool is warmed up, pushing and popping
+// decisions won't allocate memory, and constructing a DecisionStack won't either.
+// Since each thread has its own pool, DecisionStack must be destructed in
+// the thread that constructed it.
+class DecisionStack : noncopyable {
+public:
+    // The storage has at least this capacity. Deeper stack still works,
+    // but it might allocate.
+    static const int DEFAULT_CAPACITY = 16;
+
+    DecisionStack();
+    explicit DecisionStack(const std::vector<Decision>& initialDecisions);
+    ~DecisionStack();
+
+    void push(const Decision& decision) { decisions_->push_back(decision); }
+    void pop() { decisions_->pop_back(); }
+
+    bool empty() const { return decisions_->empty(); }
+    size_t size() const { return decisions_->size(); }
+    const Decision& operator[](int nth) const { return (*decisions_)[nth]; }
+
+    const std::vector<Decision>& decisions() const { return *decisions_; }
+
+    // Returns the number of storages the pool of the current thread has made.
+    static int numStoragesInThisThread();
+
+private:
+    std::vector<Decision>* decisions_;
+};
+
+#endif // CORE_PLAN_DECISION_STACK_H_
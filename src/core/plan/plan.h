@@ -5,12 +5,17 @@
 #include <string>
 #include <vector>
 
+#include <glog/logging.h>
+
+#include "base/builtin.h"
 #include "base/noncopyable.h"
 #include "core/core_field.h"
 #include "core/decision.h"
+#include "core/kumipuyo_seq.h"
+#include "core/plan/decision_stack.h"
+#include "core/puyo_controller.h"
 #include "core/rensa_result.h"
 
-class KumipuyoSeq;
 class RefPlan;
 
 class Plan {
@@ -26,13 +31,23 @@ public:
     {
     }
 
+    // The iteration functions take any callable as a callback, so the callback is called
+    // without std::function. The decisions passed to the callback are valid only
+    // while the callback is running. Call RefPlan::toPlan() to keep the plan.
+    // Once warmed up, the iteration itself doesn't allocate memory.
+
+    // IterationCallback: void (const RefPlan&)
     typedef std::function<void (const RefPlan&)> IterationCallback;
     // if |kumipuyos.size()| < |depth|, we will add extra kumipuyo.
-    static void iterateAvailablePlans(const CoreField&, const KumipuyoSeq&, int depth, const IterationCallback&);
+    template<typename Callback>
+    static void iterateAvailablePlans(const CoreField&, const KumipuyoSeq&, int depth, Callback);
 
+    // RensaIterationCallback: void (const CoreField&, const std::vector<Decision>&,
+    //                               int numChigiri, int framesToIgnite, int lastDropFrames, bool shouldFire)
     typedef std::function<void (const CoreField&, const std::vector<Decision>&,
                                 int numChigiri, int framesToIgnite, int lastDropFrames, bool shouldFire)> RensaIterationCallback;
-    static void iterateAvailablePlansWithoutFiring(const CoreField&, const KumipuyoSeq&, int depth, const RensaIterationCallback&);
+    template<typename Callback>
+    static void iterateAvailablePlansWithoutFiring(const CoreField&, const KumipuyoSeq&, int depth, Callback);
 
     const CoreField& field() const { return field_; }
 
@@ -64,6 +79,8 @@ public:
 
     friend bool operator==(const Plan& lhs, const Plan& rhs);
 private:
+    friend class RefPlan;
+
     CoreField field_;      // Future field (after the rensa has been finished).
     std::vector<Decision> decisions_;
     RensaResult rensaResult_;
@@ -125,7 +142,10 @@ public:
     bool hasZenkeshi() const { return hasZenkeshi_; }
 
     Plan toPlan() const { return Plan(field_, decisions_, rensaResult_, numChigiri_, framesToIgnite_, lastDropFrames_,
-                                      fallenOjama_, pendingOjama_, fixedOjama_, ojamaCommittingFrameId_, hasZenkeshi_); }
+                                      fallenOjama_, fixedOjama_, pendingOjama_, ojamaCommittingFrameId_, hasZenkeshi_); }
+    // Same as |*plan = toPlan()|, but reuses the decision storage of |plan|.
+    // This is useful to keep the best plan without allocating memory for each plan.
+    void copyTo(Plan* plan) const;
 
     std::string decisionText() const;
 
@@ -143,4 +163,114 @@ private:
     bool hasZenkeshi_;
 };
 
+// ----------------------------------------------------------------------
+
+namespace plan_internal {
+
+extern const Kumipuyo ALL_KUMIPUYO_KINDS[10];
+
+template<typename Callback>
+void iterateAvailablePlansInternal(const CoreField& field,
+                                   const KumipuyoSeq& kumipuyoSeq,
+                                   DecisionStack* decisions,
+                                   int currentDepth,
+                                   int maxDepth,
+                                   int currentNumChigiri,
+                                   int totalFrames,
+                                   Callback& callback)
+{
+    const Kumipuyo* ptr;
+    int n;
+
+    Kumipuyo tmp;
+    if (currentDepth < kumipuyoSeq.size()) {
+        tmp = kumipuyoSeq.get(currentDepth);
+        ptr = &tmp;
+        n = 1;
+    } else {
+        ptr = ALL_KUMIPUYO_KINDS;
+        n = 10;
+    }
+
+    std::uint32_t reachableMask = PuyoController::reachableDecisionMask(field);
+    for (; reachableMask; reachableMask &= reachableMask - 1) {
+        int j = countTrailingZeros32(reachableMask);
+        const Decision& decision = PuyoController::ALL_DECISIONS[j];
+
+        bool isChigiri = field.isChigiriDecision(decision);
+        int dropFrames = field.framesToDropNext(decision);
+        if (totalFrames != 0) { // is not first?
+            dropFrames += FRAMES_PREPARING_NEXT;
+        }
+
+        decisions->push(decision);
+        for (int i = 0; i < n; ++i) {
+            const Kumipuyo& kumipuyo = ptr[i];
+            int num_decisions = (kumipuyo.axis == kumipuyo.child) ? 11 : 22;
+            if (j >= num_decisions)
+                continue;
+
+            CoreField nextField(field);
+            if (!nextField.dropKumipuyo(decision, kumipuyo))
+                continue;
+
+            bool shouldFire = nextField.rensaWillOccurWhenLastDecisionIs(decision);
+            if (!shouldFire && !nextField.isEmpty(3, 12))
+                continue;
+
+            if (currentDepth + 1 == maxDepth || shouldFire) {
+                callback(nextField, decisions->decisions(), currentNumChigiri + isChigiri, totalFrames, dropFrames, shouldFire);
+            } else {
+                iterateAvailablePlansInternal(nextField, kumipuyoSeq, decisions, currentDepth + 1, maxDepth,
+                                              currentNumChigiri + isChigiri, totalFrames + dropFrames, callback);
+            }
+        }
+        decisions->pop();
+    }
+}
+
+} // namespace plan_internal
+
+// static
+template<typename Callback>
+void Plan::iterateAvailablePlans(const CoreField& field,
+                                 const KumipuyoSeq& kumipuyoSeq,
+                                 int maxDepth,
+                                 Callback callback)
+{
+    auto f = [&callback](const CoreField& fieldBeforeRensa, const std::vector<Decision>& decisions,
+                         int numChigiri, int framesToIgnite, int lastDropFrames, bool shouldFire) {
+        DCHECK(!decisions.empty());
+
+        if (shouldFire) {
+            CoreField cf(fieldBeforeRensa);
+            RensaResult rensaResult = cf.simulate();
+            DCHECK_GT(rensaResult.chains, 0);
+            if (cf.isEmpty(3, 12)) {
+                callback(RefPlan(cf, decisions, rensaResult, numChigiri,
+                                 framesToIgnite, lastDropFrames, 0, 0, 0, 0, false));
+            }
+        } else {
+            DCHECK(fieldBeforeRensa.isEmpty(3, 12));
+            RensaResult rensaResult;
+            callback(RefPlan(fieldBeforeRensa, decisions, rensaResult, numChigiri,
+                             framesToIgnite, lastDropFrames, 0, 0, 0, 0, false));
+        }
+    };
+
+    DecisionStack decisions;
+    plan_internal::iterateAvailablePlansInternal(field, kumipuyoSeq, &decisions, 0, maxDepth, 0, 0, f);
+}
+
+// static
+template<typename Callback>
+void Plan::iterateAvailablePlansWithoutFiring(const CoreField& field,
+                                              const KumipuyoSeq& kumipuyoSeq,
+                                              int maxDepth,
+                                              Callback callback)
+{
+    DecisionStack decisions;
+    plan_internal::iterateAvailablePlansInternal(field, kumipuyoSeq, &decisions, 0, maxDepth, 0, 0, callback);
+}
+
 #endif // CORE_PLAN_PLAN_H_
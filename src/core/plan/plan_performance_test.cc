@@ -1,5 +1,10 @@
 #include "core/plan/plan.h"
 
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
 #include <gtest/gtest.h>
 
 #include "base/time_stamp_counter.h"
@@ -8,6 +13,51 @@
 
 using namespace std;
 
+namespace {
+long long numAllocations = 0;
+}
+
+// Counts the allocations to check the enumeration doesn't allocate memory.
+void* operator new(size_t size)
+{
+    ++numAllocations;
+    if (void* p = malloc(size))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+namespace {
+
+// Runs |f| |n| times, and shows the number of nodes per second and the number of allocations per run.
+// |f| should return the number of visited nodes.
+template<typename F>
+void showNodesAndAllocations(const char* name, int n, F f)
+{
+    // Warm up.
+    f();
+
+    long long nodes = 0;
+    long long allocations = numAllocations;
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i)
+        nodes += f();
+    auto end = chrono::steady_clock::now();
+    allocations = numAllocations - allocations;
+
+    double seconds = chrono::duration<double>(end - begin).count();
+    cout << name << ": "
+         << nodes / n << " nodes/think, "
+         << nodes / seconds << " nodes/sec, "
+         << static_cast<double>(allocations) / n << " allocations/think" << endl;
+}
+
+}
+
 TEST(PlanPerformanceTest, Empty44)
 {
     TimeStampCounterData tsc;
@@ -125,3 +175,52 @@ TEST(PlanPerformanceTest, Filled24)
 
     tsc.showStatistics();
 }
+
+TEST(PlanPerformanceTest, NodesAndAllocations)
+{
+    CoreField f("B....."
+                "R....."
+                "B....."
+                "R....."
+                "BR...."
+                "BR...."
+                "BYRBY."
+                "RBYRBY"
+                "RBYRBY"
+                "RBYRBY");
+    // Only the first kumipuyo is known. The rest will try all kumipuyo kinds.
+    KumipuyoSeq seq("BB");
+
+    showNodesAndAllocations("iterate", 10, [&]() {
+        long long nodes = 0;
+        Plan::iterateAvailablePlans(f, seq, 3, [&nodes](const RefPlan&) { ++nodes; });
+        return nodes;
+    });
+
+    showNodesAndAllocations("iterate + toPlan", 10, [&]() {
+        long long nodes = 0;
+        Plan best;
+        Plan::iterateAvailablePlans(f, seq, 3, [&](const RefPlan& plan) {
+            ++nodes;
+            if (best.score() <= plan.score())
+                best = plan.toPlan();
+        });
+        return nodes;
+    });
+
+    showNodesAndAllocations("iterate + copyTo", 10, [&]() {
+        long long nodes = 0;
+        Plan best;
+        Plan::iterateAvailablePlans(f, seq, 3, [&](const RefPlan& plan) {
+            ++nodes;
+            if (best.score() <= plan.score())
+                plan.copyTo(&best);
+        });
+        return nodes;
+    });
+
+    // Once warmed up, enumeration itself shouldn't allocate.
+    long long allocations = numAllocations;
+    Plan::iterateAvailablePlans(f, seq, 3, [](const RefPlan&) {});
+    EXPECT_EQ(0, numAllocations - allocations);
+}
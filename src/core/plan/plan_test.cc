@@ -72,3 +72,57 @@ TEST(Plan, numChigiri)
 
     EXPECT_TRUE(found);
 }
+
+TEST(Plan, copyTo)
+{
+    CoreField field("  RR  ");
+    KumipuyoSeq seq("RRBB");
+
+    int count = 0;
+    Plan plan;
+    Plan::iterateAvailablePlans(field, seq, 2, [&](const RefPlan& p) {
+        p.copyTo(&plan);
+        EXPECT_EQ(p.toPlan(), plan);
+        ++count;
+    });
+
+    EXPECT_LT(0, count);
+}
+
+TEST(DecisionStack, pushAndPop)
+{
+    DecisionStack stack;
+    EXPECT_TRUE(stack.empty());
+
+    stack.push(Decision(3, 0));
+    stack.push(Decision(4, 1));
+    EXPECT_EQ(2U, stack.size());
+    EXPECT_EQ(Decision(4, 1), stack[1]);
+
+    stack.pop();
+    EXPECT_EQ(vector<Decision> { Decision(3, 0) }, stack.decisions());
+
+    DecisionStack copied(stack.decisions());
+    EXPECT_EQ(stack.decisions(), copied.decisions());
+}
+
+TEST(DecisionStack, reuseStorage)
+{
+    {
+        DecisionStack stack1;
+        DecisionStack stack2;
+        stack1.push(Decision(3, 0));
+    }
+    int numStorages = DecisionStack::numStoragesInThisThread();
+
+    {
+        // The storages should be reused, and they should be empty.
+        DecisionStack stack1;
+        DecisionStack stack2;
+        EXPECT_TRUE(stack1.empty());
+        EXPECT_TRUE(stack2.empty());
+    }
+    Plan::iterateAvailablePlans(CoreField(), KumipuyoSeq("RRBB"), 2, [](const RefPlan&) {});
+
+    EXPECT_EQ(numStorages, DecisionStack::numStoragesInThisThread());
+}
@@ -1,15 +1,37 @@
 #include "core/probability/column_puyo_list_probability.h"
 
-#include <fstream>
 #include <limits>
-#include <iostream>
+#include <unordered_map>
+
+#include <glog/logging.h>
 
-#include "base/strings.h"
 #include "core/kumipuyo.h"
+#include "core/probability/probability_table.h"
 #include "core/probability/puyo_set_probability.h"
 
 using namespace std;
 
+namespace {
+
+// NUM_COMPOSITIONS[n][k] is the number of ways to put |n| puyos into |k| columns.
+const int NUM_COMPOSITIONS[ColumnPuyoListProbability::MAX_PUYOS + 1][7] = {
+    { 1, 1, 1,  1,   1,   1,   1 },
+    { 0, 1, 2,  3,   4,   5,   6 },
+    { 0, 1, 3,  6,  10,  15,  21 },
+    { 0, 1, 4, 10,  20,  35,  56 },
+    { 0, 1, 5, 15,  35,  70, 126 },
+    { 0, 1, 6, 21,  56, 126, 252 },
+    { 0, 1, 7, 28,  84, 210, 462 },
+};
+
+// OFFSETS[n] is the index of the first ColumnPuyoList that has |n| puyos, i.e.
+// \sum_{i < n} NUM_COMPOSITIONS[i][6] * 4^i.
+const int OFFSETS[ColumnPuyoListProbability::MAX_PUYOS + 2] = {
+    0, 1, 25, 361, 3945, 36201, 294249, 2186601
+};
+
+} // anonymous namespace
+
 static const Kumipuyo ALL_KUMIPUYO_KINDS[] = {
     Kumipuyo(PuyoColor::RED, PuyoColor::RED),
     Kumipuyo(PuyoColor::RED, PuyoColor::BLUE),
@@ -143,76 +165,44 @@ static void iter(int n, int leftX, ColumnPuyoList* cpl, unordered_map<ColumnPuyo
     }
 }
 
-static void iterForSave(int n, int leftX, ColumnPuyoList* cpl, const unordered_map<ColumnPuyoList, double>& m,
-                        vector<double>* vs, size_t* index)
+static void iterForTable(int n, int leftX, ColumnPuyoList* cpl, const unordered_map<ColumnPuyoList, double>& m,
+                         vector<float>* table, int* count)
 {
     auto it = m.find(*cpl);
     CHECK(it != m.end()) << cpl->toString();
-    (*vs)[*index] = it->second;
-    *index += 1;
+    (*table)[ColumnPuyoListProbability::index(*cpl)] = static_cast<float>(it->second);
+    *count += 1;
 
     for (int x = leftX; x <= 6; ++x) {
         for (PuyoColor c : NORMAL_PUYO_COLORS) {
             cpl->add(x, c);
             if (n > 0)
-                iterForSave(n - 1, x, cpl, m, vs, index);
+                iterForTable(n - 1, x, cpl, m, table, count);
             cpl->removeTopFrom(x);
         }
     }
 }
 
-static void iterForLoad(int n, int leftX, ColumnPuyoList* cpl, unordered_map<ColumnPuyoList, double>* m,
-                        const vector<double>& vs, size_t* index)
+ColumnPuyoListProbability::ColumnPuyoListProbability() :
+    table_(makeTable()),
+    p_(table_.data())
 {
-    (*m)[*cpl] = vs[*index];
-    *index += 1;
-
-    for (int x = leftX; x <= 6; ++x) {
-        for (PuyoColor c : NORMAL_PUYO_COLORS) {
-            cpl->add(x, c);
-            if (n > 0)
-                iterForLoad(n - 1, x, cpl, m, vs, index);
-            cpl->removeTopFrom(x);
-        }
-    }
 }
 
-ColumnPuyoListProbability::ColumnPuyoListProbability()
+// static
+vector<float> ColumnPuyoListProbability::makeTable()
 {
-    const int N = 6;
-    const string filename = "column-puyo-possibility-" + std::to_string(N) + ".dat";
-
-    m_.reserve(1000000);
-
-    // try to read from the file.
-    ifstream ifs(filename);
-    if (ifs) {
-        ifstream::pos_type begin = ifs.tellg();
-        ifs.seekg(0, fstream::end);
-        ifstream::pos_type end = ifs.tellg();
-        ifs.seekg(0, fstream::beg);
-        ifs.clear();
-
-        size_t size = end - begin;
-        vector<double> vs(size / sizeof(double));
-        ifs.read(reinterpret_cast<char*>(vs.data()), size);
-
-        size_t index = 0;
-        ColumnPuyoList initial;
-        iterForLoad(N, 1, &initial, &m_, vs, &index);
-
-        return;
-    }
-
     unordered_map<ColumnPuyoList, double> reverseMap;
-    reverseMap.reserve(1000000);
+    reverseMap.reserve(tableSize());
     ColumnPuyoList initial;
     reverseMap[initial] = 0.0;
-    iter(N, 1, &initial, &reverseMap);
+    iter(MAX_PUYOS, 1, &initial, &reverseMap);
 
     CHECK(initial.size() == 0);
 
-    //
+    // necessaryPuyosReverse() sees each column upside down.
+    unordered_map<ColumnPuyoList, double> m;
+    m.reserve(reverseMap.size());
     for (const auto& entry : reverseMap) {
         ColumnPuyoList cpl;
         for (int x = 1; x <= 6; ++x) {
@@ -221,32 +211,71 @@ ColumnPuyoListProbability::ColumnPuyoListProbability()
             }
         }
 
-        m_[cpl] = entry.second;
+        m[cpl] = entry.second;
     }
 
-    vector<double> vs(m_.size());
-    size_t index = 0;
-    iterForSave(N, 1, &initial, m_, &vs, &index);
+    vector<float> table(tableSize());
+    int count = 0;
+    iterForTable(MAX_PUYOS, 1, &initial, m, &table, &count);
     CHECK(initial.size() == 0);
+    CHECK_EQ(tableSize(), count);
 
-    CHECK_EQ(vs.size(), index);
+    return table;
+}
 
-    ofstream ofs(filename);
-    ofs.write(reinterpret_cast<char*>(vs.data()), sizeof(double) * vs.size());
+// static
+int ColumnPuyoListProbability::tableSize()
+{
+    return OFFSETS[MAX_PUYOS + 1];
+}
+
+// static
+int ColumnPuyoListProbability::index(const ColumnPuyoList& cpl)
+{
+    const int n = cpl.size();
+    if (n > MAX_PUYOS)
+        return -1;
+
+    int rank = 0;
+    int colors = 0;
+    int rest = n;
+    for (int x = 1; x <= 6; ++x) {
+        const int size = cpl.sizeOn(x);
+        // Count the distributions that have less puyos in column |x|.
+        for (int i = 0; i < size; ++i)
+            rank += NUM_COMPOSITIONS[rest - i][6 - x];
+        rest -= size;
+
+        for (int i = 0; i < size; ++i) {
+            PuyoColor c = cpl.get(x, i);
+            if (!isNormalColor(c))
+                return -1;
+            colors = colors * NUM_NORMAL_PUYO_COLORS + (ordinal(c) - ordinal(PuyoColor::RED));
+        }
+    }
+
+    return OFFSETS[n] + (rank << (2 * n)) + colors;
 }
 
 // static
 const ColumnPuyoListProbability* ColumnPuyoListProbability::instanceSlow()
 {
-    static std::unique_ptr<ColumnPuyoListProbability> s_instance(new ColumnPuyoListProbability);
+    static std::unique_ptr<ColumnPuyoListProbability> s_instance = []() {
+        const ProbabilityTable* table = ProbabilityTable::instance();
+        if (table && table->columnPuyoListTableSize() == static_cast<size_t>(tableSize()))
+            return std::unique_ptr<ColumnPuyoListProbability>(new ColumnPuyoListProbability(table->columnPuyoListTable()));
+
+        LOG_IF(WARNING, table) << "probability table has unexpected ColumnPuyoListProbability table size";
+        return std::unique_ptr<ColumnPuyoListProbability>(new ColumnPuyoListProbability);
+    }();
     return s_instance.get();
 }
 
 double ColumnPuyoListProbability::necessaryKumipuyos(const ColumnPuyoList& cpl) const
 {
-    auto it = m_.find(cpl);
-    if (it != m_.end())
-        return it->second;
+    int i = index(cpl);
+    if (i >= 0)
+        return p_[i];
 
     // TODO(mayah): This is not accurate, but better than returning infinity.
     PuyoSet ps(cpl);
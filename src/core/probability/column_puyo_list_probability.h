@@ -1,25 +1,41 @@
 #ifndef CORE_PROBABILITY_COLUMN_PUYO_LIST_PROBABILITY_H_
 #define CORE_PROBABILITY_COLUMN_PUYO_LIST_PROBABILITY_H_
 
-#include <memory>
-#include <unordered_map>
+#include <vector>
 
 #include "base/noncopyable.h"
 #include "core/column_puyo_list.h"
 
+// ColumnPuyoListProbability is thread-safe.
 class ColumnPuyoListProbability : noncopyable, nonmovable {
 public:
-    // Taking ColumnPuyoListProbability instance. This might be slow.
+    // The table has the values for ColumnPuyoList that has at most MAX_PUYOS normal puyos.
+    static const int MAX_PUYOS = 6;
+
+    // Taking ColumnPuyoListProbability instance. If the precomputed ProbabilityTable is
+    // available, it's used. Otherwise, the table is computed, which might be slow.
     static const ColumnPuyoListProbability* instanceSlow();
 
+    // Computes the table. The table is indexed by index().
+    static std::vector<float> makeTable();
+    // The number of entries of the table.
+    static int tableSize();
+
+    // Returns the index of |cpl| in the table, or -1 if the table doesn't have it.
+    // ColumnPuyoList is ordered by the number of puyos, the number of puyos in
+    // each column (lexicographically), and the colors.
+    static int index(const ColumnPuyoList& cpl);
+
     // Returns the expected numbef of kumipuyos to fill ColumnPuyoList.
-    // NOTE: currently this is not thread-safe.
     double necessaryKumipuyos(const ColumnPuyoList&) const;
 
 private:
     ColumnPuyoListProbability();
+    // Uses |table| made by makeTable(). |table| should outlive |this|.
+    explicit ColumnPuyoListProbability(const float* table) : p_(table) {}
 
-    std::unordered_map<ColumnPuyoList, double> m_;
+    std::vector<float> table_;
+    const float* p_;
 };
 
 #endif // CORE_PROBABILITY_COLUMN_PUYO_LIST_PROBABILITY_H_
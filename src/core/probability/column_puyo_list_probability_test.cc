@@ -1,17 +1,68 @@
 #include "core/probability/column_puyo_list_probability.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
+using namespace std;
+
 TEST(ColumnPuyoListProbabilityTest, necessaryPuyosWithColumnPuyoList)
 {
     const ColumnPuyoListProbability* instance = ColumnPuyoListProbability::instanceSlow();
 
     ColumnPuyoList cpl;
-    EXPECT_DOUBLE_EQ(0, instance->necessaryKumipuyos(cpl));
+    EXPECT_FLOAT_EQ(0, instance->necessaryKumipuyos(cpl));
 
     cpl.add(1, PuyoColor::RED);
-    EXPECT_DOUBLE_EQ(16.0 / 7, instance->necessaryKumipuyos(cpl));
+    EXPECT_FLOAT_EQ(16.0 / 7, instance->necessaryKumipuyos(cpl));
 
     cpl.add(2, PuyoColor::RED);
-    EXPECT_DOUBLE_EQ(13.0 * 16 / 49, instance->necessaryKumipuyos(cpl));
+    EXPECT_FLOAT_EQ(13.0 * 16 / 49, instance->necessaryKumipuyos(cpl));
+}
+
+TEST(ColumnPuyoListProbabilityTest, index)
+{
+    const int size = ColumnPuyoListProbability::tableSize();
+    vector<bool> used(size);
+
+    // Enumerates all ColumnPuyoList that has at most 3 puyos.
+    int count = 0;
+    ColumnPuyoList cpl;
+    for (int x1 = 0; x1 <= 6; ++x1) {
+        for (int x2 = x1; x2 <= 6; ++x2) {
+            for (int x3 = x2; x3 <= 6; ++x3) {
+                for (int c = 0; c < 64; ++c) {
+                    cpl.clear();
+                    if (x1 > 0) cpl.add(x1, NORMAL_PUYO_COLORS[c % 4]);
+                    if (x2 > 0) cpl.add(x2, NORMAL_PUYO_COLORS[c / 4 % 4]);
+                    if (x3 > 0) cpl.add(x3, NORMAL_PUYO_COLORS[c / 16]);
+
+                    int index = ColumnPuyoListProbability::index(cpl);
+                    ASSERT_LE(0, index);
+                    ASSERT_LT(index, size);
+                    if (!used[index]) {
+                        used[index] = true;
+                        ++count;
+                    }
+                }
+            }
+        }
+    }
+
+    // 1 + 6 * 4 + 21 * 16 + 56 * 64
+    EXPECT_EQ(3945, count);
+    for (int i = 0; i < 3945; ++i)
+        EXPECT_TRUE(used[i]) << i;
+}
+
+TEST(ColumnPuyoListProbabilityTest, indexNotInTable)
+{
+    ColumnPuyoList cpl;
+    cpl.add(1, PuyoColor::IRON);
+    EXPECT_EQ(-1, ColumnPuyoListProbability::index(cpl));
+
+    cpl.clear();
+    for (int i = 0; i <= ColumnPuyoListProbability::MAX_PUYOS; ++i)
+        cpl.add(1, PuyoColor::RED);
+    EXPECT_EQ(-1, ColumnPuyoListProbability::index(cpl));
 }
@@ -0,0 +1,115 @@
+#include "core/probability/probability_table.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/file/file.h"
+#include "base/file/path.h"
+
+DECLARE_string(data_dir);
+DEFINE_string(probability_table, "",
+              "the precomputed probability table. If empty, <data_dir>/probability_table.bin is used.");
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = { 'P', 'U', 'Y', 'O', 'P', 'R', 'O', 'B' };
+const uint32_t VERSION = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t puyoSetTableSize;
+    uint32_t columnPuyoListTableSize;
+    char padding[12];
+};
+
+static_assert(sizeof(Header) == 32, "Header should be 32 bytes to align the tables");
+
+} // anonymous namespace
+
+// static
+const ProbabilityTable* ProbabilityTable::instance()
+{
+    static unique_ptr<ProbabilityTable> s_instance = []() {
+        string filename = defaultFilename();
+        unique_ptr<ProbabilityTable> table = open(filename);
+        if (!table)
+            LOG(INFO) << "probability table is not available: " << filename;
+        return table;
+    }();
+    return s_instance.get();
+}
+
+// static
+string ProbabilityTable::defaultFilename()
+{
+    if (!FLAGS_probability_table.empty())
+        return FLAGS_probability_table;
+    return file::joinPath(FLAGS_data_dir, "probability_table.bin");
+}
+
+// static
+unique_ptr<ProbabilityTable> ProbabilityTable::open(const string& filename)
+{
+    unique_ptr<file::MappedFile> mappedFile = file::MappedFile::open(filename);
+    if (!mappedFile)
+        return unique_ptr<ProbabilityTable>();
+
+    if (mappedFile->size() < sizeof(Header)) {
+        LOG(ERROR) << filename << " is too small";
+        return unique_ptr<ProbabilityTable>();
+    }
+
+    Header header;
+    memcpy(&header, mappedFile->data(), sizeof(Header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        LOG(ERROR) << filename << " is not a probability table of version " << VERSION;
+        return unique_ptr<ProbabilityTable>();
+    }
+
+    size_t expectedSize = sizeof(Header) +
+        sizeof(float) * (static_cast<size_t>(header.puyoSetTableSize) + header.columnPuyoListTableSize);
+    if (mappedFile->size() != expectedSize) {
+        LOG(ERROR) << filename << " has unexpected size: " << mappedFile->size() << " (expected " << expectedSize << ")";
+        return unique_ptr<ProbabilityTable>();
+    }
+
+    const float* tables = reinterpret_cast<const float*>(mappedFile->data() + sizeof(Header));
+    unique_ptr<ProbabilityTable> table(new ProbabilityTable(std::move(mappedFile)));
+    table->puyoSetTable_ = tables;
+    table->puyoSetTableSize_ = header.puyoSetTableSize;
+    table->columnPuyoListTable_ = tables + header.puyoSetTableSize;
+    table->columnPuyoListTableSize_ = header.columnPuyoListTableSize;
+    return table;
+}
+
+// static
+bool ProbabilityTable::write(const string& filename,
+                             const vector<float>& puyoSetTable,
+                             const vector<float>& columnPuyoListTable)
+{
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.puyoSetTableSize = static_cast<uint32_t>(puyoSetTable.size());
+    header.columnPuyoListTableSize = static_cast<uint32_t>(columnPuyoListTable.size());
+
+    string content;
+    content.reserve(sizeof(Header) + sizeof(float) * (puyoSetTable.size() + columnPuyoListTable.size()));
+    content.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+    content.append(reinterpret_cast<const char*>(puyoSetTable.data()), sizeof(float) * puyoSetTable.size());
+    content.append(reinterpret_cast<const char*>(columnPuyoListTable.data()), sizeof(float) * columnPuyoListTable.size());
+
+    return file::writeFile(filename, content);
+}
+
+ProbabilityTable::ProbabilityTable(unique_ptr<file::MappedFile> file) :
+    file_(std::move(file))
+{
+}
@@ -0,0 +1,52 @@
+#ifndef CORE_PROBABILITY_PROBABILITY_TABLE_H_
+#define CORE_PROBABILITY_PROBABILITY_TABLE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/file/mapped_file.h"
+#include "base/noncopyable.h"
+
+// ProbabilityTable is the precomputed tables of PuyoSetProbability and
+// ColumnPuyoListProbability, made by probability_table_generator.
+// The file is mapped read-only, so AI processes on the same host share it.
+//
+// Layout (native endian):
+//   char[8]   magic "PUYOPROB"
+//   uint32    version
+//   uint32    the number of entries of PuyoSetProbability table
+//   uint32    the number of entries of ColumnPuyoListProbability table
+//   char[12]  padding
+//   float[]   PuyoSetProbability table
+//   float[]   ColumnPuyoListProbability table
+class ProbabilityTable : noncopyable {
+public:
+    // Returns the table of --probability_table (or <data_dir>/probability_table.bin).
+    // Returns nullptr if the file doesn't exist or is broken.
+    static const ProbabilityTable* instance();
+
+    static std::unique_ptr<ProbabilityTable> open(const std::string& filename);
+    static bool write(const std::string& filename,
+                      const std::vector<float>& puyoSetTable,
+                      const std::vector<float>& columnPuyoListTable);
+
+    static std::string defaultFilename();
+
+    const float* puyoSetTable() const { return puyoSetTable_; }
+    size_t puyoSetTableSize() const { return puyoSetTableSize_; }
+    const float* columnPuyoListTable() const { return columnPuyoListTable_; }
+    size_t columnPuyoListTableSize() const { return columnPuyoListTableSize_; }
+
+private:
+    explicit ProbabilityTable(std::unique_ptr<file::MappedFile>);
+
+    std::unique_ptr<file::MappedFile> file_;
+    const float* puyoSetTable_ = nullptr;
+    size_t puyoSetTableSize_ = 0;
+    const float* columnPuyoListTable_ = nullptr;
+    size_t columnPuyoListTableSize_ = 0;
+};
+
+#endif // CORE_PROBABILITY_PROBABILITY_TABLE_H_
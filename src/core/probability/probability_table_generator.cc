@@ -0,0 +1,34 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/probability/column_puyo_list_probability.h"
+#include "core/probability/probability_table.h"
+#include "core/probability/puyo_set_probability.h"
+
+DEFINE_string(output, "", "the output file. If empty, the default probability table path is used.");
+
+using namespace std;
+
+// Generates the precomputed tables for PuyoSetProbability and ColumnPuyoListProbability.
+int main(int argc, char* argv[])
+{
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    const string filename = FLAGS_output.empty() ? ProbabilityTable::defaultFilename() : FLAGS_output;
+
+    vector<float> puyoSetTable = PuyoSetProbability::makeTable();
+    vector<float> columnPuyoListTable = ColumnPuyoListProbability::makeTable();
+
+    if (!ProbabilityTable::write(filename, puyoSetTable, columnPuyoListTable)) {
+        cerr << "failed to write " << filename << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "wrote " << filename << endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+#include "core/probability/probability_table.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base/file/file.h"
+
+using namespace std;
+
+TEST(ProbabilityTableTest, writeAndOpen)
+{
+    const string filename = "probability_table_test.tmp";
+    const vector<float> puyoSetTable { 0.0f, 0.25f, 1.0f };
+    const vector<float> columnPuyoListTable { 3.5f, 1e9f };
+
+    ASSERT_TRUE(ProbabilityTable::write(filename, puyoSetTable, columnPuyoListTable));
+
+    unique_ptr<ProbabilityTable> table = ProbabilityTable::open(filename);
+    ASSERT_TRUE(table.get() != nullptr);
+    ASSERT_EQ(puyoSetTable.size(), table->puyoSetTableSize());
+    ASSERT_EQ(columnPuyoListTable.size(), table->columnPuyoListTableSize());
+    for (size_t i = 0; i < puyoSetTable.size(); ++i)
+        EXPECT_EQ(puyoSetTable[i], table->puyoSetTable()[i]);
+    for (size_t i = 0; i < columnPuyoListTable.size(); ++i)
+        EXPECT_EQ(columnPuyoListTable[i], table->columnPuyoListTable()[i]);
+
+    remove(filename.c_str());
+}
+
+TEST(ProbabilityTableTest, openBroken)
+{
+    const string filename = "probability_table_test.tmp";
+
+    ASSERT_TRUE(file::writeFile(filename, "PUYOPROB"));
+    EXPECT_TRUE(ProbabilityTable::open(filename).get() == nullptr);
+
+    // Truncated.
+    ASSERT_TRUE(ProbabilityTable::write(filename, vector<float>(10), vector<float>(10)));
+    string content;
+    ASSERT_TRUE(file::readFile(filename, &content));
+    ASSERT_TRUE(file::writeFile(filename, content.substr(0, content.size() - 4)));
+    EXPECT_TRUE(ProbabilityTable::open(filename).get() == nullptr);
+
+    remove(filename.c_str());
+
+    EXPECT_TRUE(ProbabilityTable::open(filename).get() == nullptr);
+}
@@ -4,10 +4,18 @@
 #include <memory>
 
 #include "core/kumipuyo_seq.h"
+#include "core/probability/probability_table.h"
 
 using namespace std;
 
-PuyoSetProbability::PuyoSetProbability()
+PuyoSetProbability::PuyoSetProbability() :
+    table_(makeTable()),
+    p_(table_.data())
+{
+}
+
+// static
+vector<float> PuyoSetProbability::makeTable()
 {
     auto p = new double[MAX_N][MAX_N][MAX_N][MAX_N][MAX_K];
     auto q = new double[MAX_N][MAX_N][MAX_N][MAX_N][MAX_K];
@@ -96,12 +104,13 @@ PuyoSetProbability::PuyoSetProbability()
         }
     }
 
+    vector<float> table(TABLE_SIZE);
     for (int a = 0; a < MAX_N; ++a) {
         for (int b = 0; b < MAX_N; ++b) {
             for (int c = 0; c < MAX_N; ++c) {
                 for (int d = 0; d < MAX_N; ++d) {
                     for (int k = 0; k < MAX_K; ++k) {
-                        p_[a][b][c][d][k] = p[a][b][c][d][k];
+                        table[index(a, b, c, d, k)] = static_cast<float>(p[a][b][c][d][k]);
                     }
                 }
             }
@@ -110,11 +119,21 @@ PuyoSetProbability::PuyoSetProbability()
 
     delete[] p;
     delete[] q;
+
+    return table;
 }
 
+// static
 const PuyoSetProbability* PuyoSetProbability::instanceSlow()
 {
-    static std::unique_ptr<PuyoSetProbability> s_instance(new PuyoSetProbability);
+    static std::unique_ptr<PuyoSetProbability> s_instance = []() {
+        const ProbabilityTable* table = ProbabilityTable::instance();
+        if (table && table->puyoSetTableSize() == TABLE_SIZE)
+            return std::unique_ptr<PuyoSetProbability>(new PuyoSetProbability(table->puyoSetTable()));
+
+        LOG_IF(WARNING, table) << "probability table has unexpected PuyoSetProbability table size";
+        return std::unique_ptr<PuyoSetProbability>(new PuyoSetProbability);
+    }();
     return s_instance.get();
 }
 
@@ -4,18 +4,31 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <vector>
 
 #include "base/noncopyable.h"
 #include "core/probability/puyo_set.h"
 
 class KumipuyoSeq;
 
+// PuyoSetProbability is thread-safe.
 class PuyoSetProbability : noncopyable, nonmovable {
 public:
-    // Returns PuyoSetProbability instance. This might take time.
+    static const int MAX_N = 16;
+    static const int MAX_K = 32;
+    static const int TABLE_SIZE = MAX_N * MAX_N * MAX_N * MAX_N * MAX_K;
+
+    // Returns PuyoSetProbability instance. If the precomputed ProbabilityTable is
+    // available, it's used. Otherwise, the table is computed, which might take time.
     static const PuyoSetProbability* instanceSlow();
 
+    // Computes the table. The table is indexed by index(a, b, c, d, k).
+    static std::vector<float> makeTable();
+
+    // Computes the table.
     PuyoSetProbability();
+    // Uses |table| made by makeTable(). |table| should outlive |this|.
+    explicit PuyoSetProbability(const float* table) : p_(table) {}
 
     // Returns the possibility that when there are randomly |k| puyos,
     // that set will contain |puyoSet|.
@@ -27,7 +40,7 @@ public:
         int d = std::min(MAX_N - 1, puyoSet.green());
         int kk = std::min(MAX_K - 1, k);
 
-        return p_[a][b][c][d][kk];
+        return p_[index(a, b, c, d, kk)];
     }
 
     // Returns how many puyos are required to get |puyoSet| with possibility |threshold|?
@@ -40,7 +53,7 @@ public:
         int c = std::min(MAX_N - 1, puyoSet.yellow());
         int d = std::min(MAX_N - 1, puyoSet.green());
 
-        const double* p = p_[a][b][c][d];
+        const float* p = p_ + index(a, b, c, d, 0);
 
         for (int k = 0; k < MAX_K; ++k) {
             if (p[k] >= threshold)
@@ -55,10 +68,13 @@ public:
     int necessaryPuyos(const PuyoSet&, const KumipuyoSeq&, double threshold) const;
 
 private:
-    static const int MAX_N = 16;
-    static const int MAX_K = 32;
+    static int index(int a, int b, int c, int d, int k)
+    {
+        return (((a * MAX_N + b) * MAX_N + c) * MAX_N + d) * MAX_K + k;
+    }
 
-    double p_[MAX_N][MAX_N][MAX_N][MAX_N][MAX_K];
+    std::vector<float> table_;
+    const float* p_;
 };
 
 #endif // CORE_PROBABILITY_PUYO_POSSIBILITY_H_
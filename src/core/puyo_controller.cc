@@ -382,9 +382,9 @@ PrecedeKeySetSeq findKeyStrokeFastpath63(const CoreField& field)
     return PrecedeKeySetSeq();
 }
 
-} // namespace anomymous
-
-bool PuyoController::isReachable(const CoreField& field, const Decision& decision)
+// Returns true if |decision| is reachable when the column heights are |heights|.
+// |heights[x]| is the height of column x (1 <= x <= 6).
+bool isReachableOnHeights(const int heights[], const Decision& decision)
 {
     DCHECK(decision.isValid()) << decision.toString();
 
@@ -406,21 +406,21 @@ bool PuyoController::isReachable(const CoreField& field, const Decision& decisio
     // When decision is valid, this should hold.
     DCHECK(0 <= checkerIdx && checkerIdx < 6) << checkerIdx;
 
-    bool yMightBe13 = field.height(2) >= 12 && field.height(4) >= 12;
+    bool yMightBe13 = heights[2] >= 12 && heights[4] >= 12;
     for (int i = 1; checker[checkerIdx][i] != 0; ++i) {
         int x = checker[checkerIdx][i];
-        if (field.height(x) <= 11) {
+        if (heights[x] <= 11) {
             yMightBe13 = false;
             continue;
         }
-        if (field.height(x) == 12) {
+        if (heights[x] == 12) {
             if (yMightBe13)
                 continue;
-            if (field.height(checker[checkerIdx][i - 1]) == 11) {
+            if (heights[checker[checkerIdx][i - 1]] == 11) {
                 yMightBe13 = true;
                 continue;
             }
-            if (i - 2 >= 0 && field.height(checker[checkerIdx][i - 2]) == 12) {
+            if (i - 2 >= 0 && heights[checker[checkerIdx][i - 2]] == 12) {
                 yMightBe13 = true;
                 continue;
             }
@@ -428,12 +428,82 @@ bool PuyoController::isReachable(const CoreField& field, const Decision& decisio
         return false;
     }
 
-    if (decision.r == 2 && field.height(decision.x) >= 12)
+    if (decision.r == 2 && heights[decision.x] >= 12)
         return false;
 
     return true;
 }
 
+// isReachableOnHeights() can't distinguish the heights <= 10, and the heights >= 13.
+// So we clip the heights into [10, 13], and represent it with 2 bits.
+inline int clipHeightForReachability(int height)
+{
+    return std::min(std::max(height - 10, 0), 3);
+}
+
+struct ReachableDecisionMaskTable {
+    ReachableDecisionMaskTable()
+    {
+        for (int key = 0; key < (1 << 12); ++key) {
+            int heights[7] {};
+            for (int x = 1; x <= 6; ++x)
+                heights[x] = 10 + ((key >> (2 * (x - 1))) & 3);
+
+            uint32_t mask = 0;
+            for (int i = 0; i < PuyoController::NUM_DECISIONS; ++i) {
+                if (isReachableOnHeights(heights, PuyoController::ALL_DECISIONS[i]))
+                    mask |= 1U << i;
+            }
+            masks[key] = mask;
+        }
+    }
+
+    uint32_t masks[1 << 12];
+};
+
+} // namespace anomymous
+
+const Decision PuyoController::ALL_DECISIONS[PuyoController::NUM_DECISIONS] = {
+    Decision(2, 3), Decision(3, 3), Decision(3, 1), Decision(4, 1),
+    Decision(5, 1), Decision(1, 2), Decision(2, 2), Decision(3, 2),
+    Decision(4, 2), Decision(5, 2), Decision(6, 2), Decision(1, 1),
+    Decision(2, 1), Decision(4, 3), Decision(5, 3), Decision(6, 3),
+    Decision(1, 0), Decision(2, 0), Decision(3, 0), Decision(4, 0),
+    Decision(5, 0), Decision(6, 0),
+};
+
+// 31 is used for invalid decisions. The bit is never set in a reachable decision mask.
+const uint8_t PuyoController::DECISION_INDEX[7][4] = {
+    { 31, 31, 31, 31 },
+    { 16, 11,  5, 31 },
+    { 17, 12,  6,  0 },
+    { 18,  2,  7,  1 },
+    { 19,  3,  8, 13 },
+    { 20,  4,  9, 14 },
+    { 21, 31, 10, 15 },
+};
+
+bool PuyoController::isReachable(const CoreField& field, const Decision& decision)
+{
+    int heights[7];
+    for (int x = 1; x <= 6; ++x)
+        heights[x] = field.height(x);
+
+    return isReachableOnHeights(heights, decision);
+}
+
+// static
+uint32_t PuyoController::reachableDecisionMask(const CoreField& field)
+{
+    static const ReachableDecisionMaskTable table;
+
+    int key = 0;
+    for (int x = 1; x <= 6; ++x)
+        key |= clipHeightForReachability(field.height(x)) << (2 * (x - 1));
+
+    return table.masks[key];
+}
+
 bool PuyoController::isReachableFrom(const CoreField& field, const KumipuyoMovingState& mks, const Decision& decision)
 {
     return !findKeyStrokeOnlineInternal(field, mks, decision).empty();
@@ -1,15 +1,30 @@
 #ifndef CORE_PUYO_CONTROLLER_H_
 #define CORE_PUYO_CONTROLLER_H_
 
+#include <cstdint>
+
+#include "core/decision.h"
 #include "core/key_set_seq.h"
 
 class CoreField;
-class Decision;
 class KumipuyoMovingState;
 
 class PuyoController {
 public:
+    static const int NUM_DECISIONS = 22;
+    // All the valid decisions. The first 11 decisions are enough for a kumipuyo
+    // whose axis and child have the same color.
+    static const Decision ALL_DECISIONS[NUM_DECISIONS];
+
     static bool isReachable(const CoreField&, const Decision&);
+
+    // Returns a mask of the reachable decisions. When the i-th bit is set,
+    // ALL_DECISIONS[i] is reachable. Since the reachability depends only on the
+    // column heights, this just looks up a precomputed table. This is much faster
+    // than calling isReachable() for each decision.
+    static std::uint32_t reachableDecisionMask(const CoreField&);
+    // Returns the bit corresponding to |decision| in a reachable decision mask.
+    static std::uint32_t decisionBit(const Decision& decision) { return 1U << DECISION_INDEX[decision.x][decision.r]; }
     static bool isReachableFrom(const CoreField&, const KumipuyoMovingState&, const Decision&);
 
     // Finds a key stroke to move puyo from |KumipuyoMovingState| to |Decision|.
@@ -18,6 +33,9 @@ public:
     static KeySetSeq findKeyStrokeFrom(const CoreField&, const KumipuyoMovingState&, const Decision&);
 
 private:
+    // DECISION_INDEX[x][r] is the index of Decision(x, r) in ALL_DECISIONS.
+    static const std::uint8_t DECISION_INDEX[7][4];
+
     static KeySetSeq findKeyStrokeOnlineInternal(const CoreField&, const KumipuyoMovingState&, const Decision&);
 
     // Fast, but usable in limited situation.
@@ -1,7 +1,10 @@
 #include "core/puyo_controller.h"
 
+#include <iostream>
+
 #include <gtest/gtest.h>
 
+#include "base/builtin.h"
 #include "base/time_stamp_counter.h"
 #include "core/core_field.h"
 #include "core/decision.h"
@@ -50,3 +53,46 @@ TEST(PuyoControllerPerformanceTest, unreachable)
 
     tsc.showStatistics();
 }
+
+TEST(PuyoControllerPerformanceTest, isReachable)
+{
+    TimeStampCounterData tscIsReachable;
+    TimeStampCounterData tscMask;
+
+    CoreField f(
+        "  O   "
+        " OO O " // 12
+        " OO O "
+        " OO OO"
+        " OO OO"
+        " OO OO" // 8
+        " OO OO"
+        " OO OO"
+        " OO OO"
+        "OOO OO" // 4
+        "OOO OO"
+        "OOO OO"
+        "OOO OO");
+
+    int n1 = 0;
+    for (int i = 0; i < 10000; ++i) {
+        ScopedTimeStampCounter stsc(&tscIsReachable);
+        for (int j = 0; j < PuyoController::NUM_DECISIONS; ++j) {
+            if (PuyoController::isReachable(f, PuyoController::ALL_DECISIONS[j]))
+                ++n1;
+        }
+    }
+
+    int n2 = 0;
+    for (int i = 0; i < 10000; ++i) {
+        ScopedTimeStampCounter stsc(&tscMask);
+        n2 += popCount32(PuyoController::reachableDecisionMask(f));
+    }
+
+    EXPECT_EQ(n1, n2);
+
+    cout << "isReachable x 22:" << endl;
+    tscIsReachable.showStatistics();
+    cout << "reachableDecisionMask:" << endl;
+    tscMask.showStatistics();
+}
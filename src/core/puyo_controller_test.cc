@@ -959,3 +959,44 @@ TEST(PuyoControllerTest, reachable6)
         }
     }
 }
+
+TEST(PuyoControllerTest, decisionBit)
+{
+    for (int i = 0; i < PuyoController::NUM_DECISIONS; ++i) {
+        const Decision& d = PuyoController::ALL_DECISIONS[i];
+        EXPECT_TRUE(d.isValid());
+        EXPECT_EQ(1U << i, PuyoController::decisionBit(d)) << d.toString();
+    }
+}
+
+TEST(PuyoControllerTest, reachableDecisionMask)
+{
+    // Try all the height profiles which isReachable() can distinguish.
+    static const int HEIGHTS[] = { 0, 10, 11, 12, 13 };
+    const int numHeights = sizeof(HEIGHTS) / sizeof(HEIGHTS[0]);
+
+    int numProfiles = 1;
+    for (int x = 1; x <= 6; ++x)
+        numProfiles *= numHeights;
+
+    for (int profile = 0; profile < numProfiles; ++profile) {
+        CoreField f;
+        int p = profile;
+        for (int x = 1; x <= 6; ++x) {
+            for (int y = 0; y < HEIGHTS[p % numHeights]; ++y)
+                f.dropPuyoOn(x, PuyoColor::OJAMA);
+            p /= numHeights;
+        }
+
+        uint32_t mask = PuyoController::reachableDecisionMask(f);
+        for (int x = 1; x <= 6; ++x) {
+            for (int r = 0; r <= 3; ++r) {
+                Decision d(x, r);
+                if (!d.isValid())
+                    continue;
+                EXPECT_EQ(PuyoController::isReachable(f, d), (mask & PuyoController::decisionBit(d)) != 0)
+                    << d.toString() << endl << f.toDebugString();
+            }
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#include "core/rensa/rensa_detection_cache.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "base/deadline.h"
+
+using namespace std;
+
+string RensaDetectionCacheStats::toString() const
+{
+    ostringstream ss;
+    ss << "hits=" << hits
+       << " misses=" << misses
+       << " hit_rate=" << hitRate()
+       << " evictions=" << evictions
+       << " fields=" << numFields;
+    return ss.str();
+}
+
+double RensaDetectionCacheStats::hitRate() const
+{
+    if (hits + misses == 0)
+        return 0.0;
+    return static_cast<double>(hits) / (hits + misses);
+}
+
+RensaDetectionCache::RensaDetectionCache(size_t megaBytes) :
+    maxBytesPerShard_(megaBytes * 1024 * 1024 / NUM_SHARDS)
+{
+}
+
+// static
+RensaDetectionCache::Key RensaDetectionCache::makeKey(const CoreField& field,
+                                                      const RensaDetectorStrategy& strategy,
+                                                      int maxIteration)
+{
+    DCHECK(0 <= maxIteration && maxIteration < 256) << maxIteration;
+    DCHECK(0 <= strategy.maxNumOfComplementPuyosForKey() && strategy.maxNumOfComplementPuyosForKey() < 256);
+    DCHECK(0 <= strategy.maxNumOfComplementPuyosForFire() && strategy.maxNumOfComplementPuyosForFire() < 16);
+
+    Key key;
+    key.field = field.bitField();
+    key.params = static_cast<uint32_t>(maxIteration) |
+        (static_cast<uint32_t>(strategy.maxNumOfComplementPuyosForKey()) << 8) |
+        (static_cast<uint32_t>(strategy.maxNumOfComplementPuyosForFire()) << 16) |
+        (static_cast<uint32_t>(strategy.mode()) << 20) |
+        (strategy.allowsPuttingKeyPuyoOn13thRow() ? (1U << 24) : 0);
+    return key;
+}
+
+// static
+int RensaDetectionCache::compareDetectedRensa(const DetectedRensa& lhs, const DetectedRensa& rhs)
+{
+    // Compares the hashes first, since making the strings is slow.
+    if (lhs.complementedField.hash() != rhs.complementedField.hash())
+        return lhs.complementedField.hash() < rhs.complementedField.hash() ? -1 : 1;
+    if (lhs.complementedPuyos.hash() != rhs.complementedPuyos.hash())
+        return lhs.complementedPuyos.hash() < rhs.complementedPuyos.hash() ? -1 : 1;
+    if (lhs.complementedField == rhs.complementedField && lhs.complementedPuyos == rhs.complementedPuyos)
+        return 0;
+
+    int result = lhs.complementedField.toDebugString().compare(rhs.complementedField.toDebugString());
+    if (result != 0)
+        return result;
+    return lhs.complementedPuyos.toString().compare(rhs.complementedPuyos.toString());
+}
+
+// static
+size_t RensaDetectionCache::estimateBytes(const DetectedRensas& rensas)
+{
+    // The key is stored in both the list and the map. 64 is for the nodes and the buckets.
+    return 2 * sizeof(Key) + 64 + sizeof(DetectedRensas) + rensas.capacity() * sizeof(DetectedRensa);
+}
+
+shared_ptr<const RensaDetectionCache::DetectedRensas>
+RensaDetectionCache::detectIteratively(const CoreField& field, const RensaDetectorStrategy& strategy, int maxIteration,
+                                       Executor* executor, const Deadline* deadline)
+{
+    const Key key = makeKey(field, strategy, maxIteration);
+    if (shared_ptr<const DetectedRensas> rensas = lookup(key)) {
+        ++hits_;
+        return rensas;
+    }
+    ++misses_;
+
+    // Detects without the lock. When several threads miss the same field at the same time,
+    // all of them detect it, and the last one is cached.
+    shared_ptr<DetectedRensas> rensas = make_shared<DetectedRensas>();
+    mutex mu;
+    auto callback = [&](CoreField&& complementedField, const ColumnPuyoList& complementedPuyos) -> RensaResult {
+        CoreField cf(complementedField);
+        RensaResult rensaResult = cf.simulate();
+        lock_guard<mutex> lock(mu);
+        rensas->emplace_back(complementedField, complementedPuyos, rensaResult);
+        return rensaResult;
+    };
+    if (executor)
+        RensaDetector::detectIterativelyParallel(field, strategy, maxIteration, executor, callback, nullptr, deadline);
+    else
+        RensaDetector::detectIteratively(field, strategy, maxIteration, callback, nullptr, deadline);
+    // The parallel detector calls |callback| in thread order, and the serial one can call it
+    // with the same arguments several times. Sort and dedupe them, so the result doesn't
+    // depend on how it was detected.
+    sort(rensas->begin(), rensas->end(), [](const DetectedRensa& lhs, const DetectedRensa& rhs) {
+        return compareDetectedRensa(lhs, rhs) < 0;
+    });
+    rensas->erase(unique(rensas->begin(), rensas->end(), [](const DetectedRensa& lhs, const DetectedRensa& rhs) {
+        return compareDetectedRensa(lhs, rhs) == 0;
+    }), rensas->end());
+    rensas->shrink_to_fit();
+
+    // The detection might have been stopped in the middle.
+    if (deadline && deadline->hasPassed())
+        return rensas;
+
+    insert(key, rensas);
+    return rensas;
+}
+
+void RensaDetectionCache::detectIteratively(const CoreField& field,
+                                            const RensaDetectorStrategy& strategy,
+                                            int maxIteration,
+                                            const RensaDetector::RensaSimulationCallback& callback,
+                                            Executor* executor,
+                                            const Deadline* deadline)
+{
+    shared_ptr<const DetectedRensas> rensas = detectIteratively(field, strategy, maxIteration, executor, deadline);
+    for (const DetectedRensa& rensa : *rensas) {
+        CoreField complementedField(rensa.complementedField);
+        (void)callback(std::move(complementedField), rensa.complementedPuyos);
+    }
+}
+
+shared_ptr<const RensaDetectionCache::DetectedRensas> RensaDetectionCache::lookup(const Key& key)
+{
+    Shard& s = shard(key);
+    lock_guard<mutex> lock(s.mu);
+
+    auto it = s.entries.find(key);
+    if (it == s.entries.end())
+        return shared_ptr<const DetectedRensas>();
+
+    s.lru.splice(s.lru.begin(), s.lru, it->second.lruIterator);
+    return it->second.rensas;
+}
+
+void RensaDetectionCache::insert(const Key& key, shared_ptr<const DetectedRensas> rensas)
+{
+    const size_t bytes = estimateBytes(*rensas);
+    if (bytes > maxBytesPerShard_)
+        return;
+
+    Shard& s = shard(key);
+    lock_guard<mutex> lock(s.mu);
+
+    auto it = s.entries.find(key);
+    if (it != s.entries.end()) {
+        s.bytes -= it->second.bytes;
+        s.lru.erase(it->second.lruIterator);
+        s.entries.erase(it);
+    }
+
+    while (!s.lru.empty() && s.bytes + bytes > maxBytesPerShard_) {
+        auto victim = s.entries.find(s.lru.back());
+        DCHECK(victim != s.entries.end());
+        s.bytes -= victim->second.bytes;
+        s.entries.erase(victim);
+        s.lru.pop_back();
+        ++evictions_;
+    }
+
+    s.lru.push_front(key);
+    Shard::Value value;
+    value.rensas = std::move(rensas);
+    value.lruIterator = s.lru.begin();
+    value.bytes = bytes;
+    s.entries.emplace(key, std::move(value));
+    s.bytes += bytes;
+}
+
+RensaDetectionCacheStats RensaDetectionCache::stats() const
+{
+    RensaDetectionCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.evictions = evictions_;
+    for (const Shard& s : shards_) {
+        lock_guard<mutex> lock(s.mu);
+        stats.numFields += s.entries.size();
+    }
+    return stats;
+}
+
+void RensaDetectionCache::clear()
+{
+    for (Shard& s : shards_) {
+        lock_guard<mutex> lock(s.mu);
+        s.entries.clear();
+        s.lru.clear();
+        s.bytes = 0;
+    }
+}
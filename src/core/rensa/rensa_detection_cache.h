@@ -0,0 +1,142 @@
+#ifndef CORE_RENSA_RENSA_DETECTION_CACHE_H_
+#define CORE_RENSA_RENSA_DETECTION_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "core/bit_field.h"
+#include "core/column_puyo_list.h"
+#include "core/core_field.h"
+#include "core/rensa/rensa_detector.h"
+#include "core/rensa/rensa_detector_strategy.h"
+#include "core/rensa_result.h"
+
+class Deadline;
+class Executor;
+
+struct RensaDetectionCacheStats {
+    std::string toString() const;
+
+    // Returns hits / (hits + misses). 0 if nothing has been looked up.
+    double hitRate() const;
+
+    std::int64_t hits = 0;
+    std::int64_t misses = 0;
+    std::int64_t evictions = 0;
+    // The number of the fields (not rensas) in the cache.
+    std::int64_t numFields = 0;
+};
+
+// RensaDetectionCache memoizes RensaDetector::detectIteratively().
+// The field changes by only one kumipuyo per hand, so the same field is often detected
+// again in the next think() or gaze().
+//
+// The cache is keyed by the field, the strategy and the number of iterations, and
+// holds the complemented fields with their RensaResult. The cache is bounded by
+// the memory size, and the least recently used field is evicted first.
+// The cache can be shared by several threads.
+class RensaDetectionCache : noncopyable {
+public:
+    struct DetectedRensa {
+        DetectedRensa(const CoreField& complementedField,
+                      const ColumnPuyoList& complementedPuyos,
+                      const RensaResult& rensaResult) :
+            complementedField(complementedField),
+            complementedPuyos(complementedPuyos),
+            rensaResult(rensaResult) {}
+
+        CoreField complementedField;
+        ColumnPuyoList complementedPuyos;
+        RensaResult rensaResult;
+    };
+    typedef std::vector<DetectedRensa> DetectedRensas;
+
+    // The cache will use about |megaBytes| MB.
+    explicit RensaDetectionCache(size_t megaBytes);
+
+    // Returns the detected rensas of |field|. When not cached, they are detected
+    // with RensaDetector::detectIteratively(), or with detectIterativelyParallel()
+    // when |executor| is not nullptr. The rensas are sorted in a fixed order without
+    // duplicates, so the result doesn't depend on |executor|.
+    // The result is not invalidated by the later calls, even if it is evicted from the cache.
+    // When |deadline| passes during the detection, the rensas found so far are
+    // returned, and they are not cached.
+    std::shared_ptr<const DetectedRensas> detectIteratively(const CoreField& field,
+                                                            const RensaDetectorStrategy&,
+                                                            int maxIteration,
+                                                            Executor* executor = nullptr,
+                                                            const Deadline* deadline = nullptr);
+
+    // Same as RensaDetector::detectIteratively(), but the detection is memoized.
+    // Unlike RensaDetector, the return value of |callback| is not used to prune the
+    // rensas: the complemented field is simulated in the cache.
+    // |callback| is called in the current thread.
+    void detectIteratively(const CoreField& field,
+                           const RensaDetectorStrategy&,
+                           int maxIteration,
+                           const RensaDetector::RensaSimulationCallback& callback,
+                           Executor* executor = nullptr,
+                           const Deadline* deadline = nullptr);
+
+    RensaDetectionCacheStats stats() const;
+
+    // Removes all the entries. The stats are not reset.
+    void clear();
+
+private:
+    struct Key {
+        BitField field;
+        std::uint32_t params;
+
+        friend bool operator==(const Key& lhs, const Key& rhs)
+        {
+            return lhs.params == rhs.params && lhs.field == rhs.field;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return key.field.hash() ^ (key.params * 0x9E3779B97F4A7C15ULL); }
+    };
+
+    struct Shard {
+        mutable std::mutex mu;
+        // The front is the most recently used.
+        std::list<Key> lru;
+        struct Value {
+            std::shared_ptr<const DetectedRensas> rensas;
+            std::list<Key>::iterator lruIterator;
+            size_t bytes;
+        };
+        std::unordered_map<Key, Value, KeyHash> entries;
+        size_t bytes = 0;
+    };
+
+    static const int NUM_SHARDS = 16;
+
+    static Key makeKey(const CoreField&, const RensaDetectorStrategy&, int maxIteration);
+    static size_t estimateBytes(const DetectedRensas&);
+    // Returns negative, 0 or positive as strcmp(). The order is arbitrary, but stable.
+    static int compareDetectedRensa(const DetectedRensa&, const DetectedRensa&);
+
+    Shard& shard(const Key& key) { return shards_[(KeyHash()(key) >> 7) % NUM_SHARDS]; }
+
+    std::shared_ptr<const DetectedRensas> lookup(const Key&);
+    void insert(const Key&, std::shared_ptr<const DetectedRensas>);
+
+    size_t maxBytesPerShard_;
+    Shard shards_[NUM_SHARDS];
+
+    std::atomic<std::int64_t> hits_ { 0 };
+    std::atomic<std::int64_t> misses_ { 0 };
+    std::atomic<std::int64_t> evictions_ { 0 };
+};
+
+#endif // CORE_RENSA_RENSA_DETECTION_CACHE_H_
@@ -0,0 +1,210 @@
+#include "core/rensa/rensa_detection_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "base/deadline.h"
+#include "base/executor.h"
+#include "core/column_puyo_list.h"
+#include "core/core_field.h"
+#include "core/rensa_result.h"
+
+using namespace std;
+
+TEST(RensaDetectionCacheTest, sameAsRensaDetector)
+{
+    const CoreField original(
+        "  R G "
+        "R GRBG"
+        "RBGRBG"
+        "RBGRBG");
+
+    // The detector can find the same rensa several times, but the cache has it only once.
+    map<pair<string, string>, RensaResult> expected;
+    RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3,
+                                     [&](CoreField&& cf, const ColumnPuyoList& cpl) -> RensaResult {
+        string key = cf.toDebugString();
+        RensaResult rensaResult = cf.simulate();
+        expected.emplace(make_pair(key, cpl.toString()), rensaResult);
+        return rensaResult;
+    });
+    ASSERT_FALSE(expected.empty());
+
+    RensaDetectionCache cache(1);
+    vector<pair<string, string>> firstOrder;
+    for (int i = 0; i < 2; ++i) {
+        vector<pair<string, string>> order;
+        map<pair<string, string>, RensaResult> actual;
+        cache.detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3,
+                                [&](CoreField&& cf, const ColumnPuyoList& cpl) -> RensaResult {
+            order.emplace_back(cf.toDebugString(), cpl.toString());
+            RensaResult rensaResult = cf.simulate();
+            actual.emplace(order.back(), rensaResult);
+            return rensaResult;
+        });
+        EXPECT_EQ(expected, actual);
+        EXPECT_EQ(actual.size(), order.size());
+        if (i == 0)
+            firstOrder = order;
+        else
+            EXPECT_EQ(firstOrder, order);
+    }
+
+    RensaDetectionCacheStats stats = cache.stats();
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(1, stats.misses);
+    EXPECT_EQ(1, stats.numFields);
+    EXPECT_DOUBLE_EQ(0.5, stats.hitRate());
+}
+
+TEST(RensaDetectionCacheTest, detectWithExecutor)
+{
+    const CoreField original(
+        "  R G "
+        "R GRBG"
+        "RBGRBG"
+        "RBGRBG");
+
+    unordered_set<CoreField> expected;
+    RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3,
+                                     [&](CoreField&& cf, const ColumnPuyoList&) -> RensaResult {
+        expected.insert(cf);
+        return cf.simulate();
+    });
+
+    Executor executor(4);
+    executor.start();
+
+    RensaDetectionCache cache(1);
+    auto rensas = cache.detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3, &executor);
+    unordered_set<CoreField> actual;
+    for (const auto& rensa : *rensas) {
+        CoreField cf(rensa.complementedField);
+        EXPECT_EQ(cf.simulate(), rensa.rensaResult);
+        actual.insert(rensa.complementedField);
+    }
+    EXPECT_EQ(expected, actual);
+
+    // The order is the same as the one detected without the executor.
+    RensaDetectionCache serialCache(1);
+    auto serialRensas = serialCache.detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3);
+    ASSERT_EQ(serialRensas->size(), rensas->size());
+    for (size_t i = 0; i < rensas->size(); ++i) {
+        EXPECT_EQ((*serialRensas)[i].complementedField, (*rensas)[i].complementedField);
+        EXPECT_EQ((*serialRensas)[i].complementedPuyos, (*rensas)[i].complementedPuyos);
+    }
+
+    executor.stop();
+}
+
+TEST(RensaDetectionCacheTest, deadline)
+{
+    const CoreField field(
+        "R GRBG"
+        "RBGRBG");
+
+    RensaDetectionCache cache(1);
+    Deadline passed(Deadline::afterMillis(0));
+    auto stopped = cache.detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 2, nullptr, &passed);
+    EXPECT_TRUE(stopped->empty());
+    // The stopped detection is not cached.
+    EXPECT_EQ(0, cache.stats().numFields);
+
+    Deadline never;
+    auto detected = cache.detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 2, nullptr, &never);
+    EXPECT_FALSE(detected->empty());
+    EXPECT_EQ(1, cache.stats().numFields);
+}
+
+TEST(RensaDetectionCacheTest, keyContainsStrategyAndIteration)
+{
+    const CoreField field(
+        "R GRBG"
+        "RBGRBG");
+
+    RensaDetectionCache cache(1);
+    cache.detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 2);
+    cache.detectIteratively(field, RensaDetectorStrategy::defaultFloatStrategy(), 2);
+    cache.detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 3);
+    EXPECT_EQ(0, cache.stats().hits);
+    EXPECT_EQ(3, cache.stats().numFields);
+
+    cache.detectIteratively(field, RensaDetectorStrategy::defaultFloatStrategy(), 2);
+    EXPECT_EQ(1, cache.stats().hits);
+}
+
+TEST(RensaDetectionCacheTest, eviction)
+{
+    // 0MB cannot hold anything.
+    RensaDetectionCache cache(0);
+    const CoreField field(
+        "R GRBG"
+        "RBGRBG");
+
+    auto first = cache.detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 2);
+    auto second = cache.detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 2);
+    EXPECT_EQ(0, cache.stats().hits);
+    EXPECT_EQ(0, cache.stats().numFields);
+    // The evicted result is still valid.
+    EXPECT_EQ(first->size(), second->size());
+}
+
+TEST(RensaDetectionCacheTest, lru)
+{
+    RensaDetectionCache cache(1);
+
+    // Fill the cache with many fields, so that the old ones are evicted.
+    unordered_set<CoreField> fields;
+    const char colors[] = { 'R', 'B', 'Y', 'G' };
+    for (int i = 0; i < 4096; ++i) {
+        string s;
+        for (int j = 0; j < 12; ++j)
+            s += colors[(i >> ((j % 6) * 2)) & 3];
+        fields.insert(CoreField(s));
+    }
+
+    CoreField last;
+    for (const CoreField& field : fields) {
+        cache.detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 1);
+        last = field;
+    }
+
+    RensaDetectionCacheStats stats = cache.stats();
+    EXPECT_LT(0, stats.evictions);
+    EXPECT_GT(static_cast<int64_t>(fields.size()), stats.numFields);
+    EXPECT_EQ(static_cast<int64_t>(fields.size()), stats.numFields + stats.evictions);
+
+    // The most recently used field should not have been evicted.
+    cache.detectIteratively(last, RensaDetectorStrategy::defaultDropStrategy(), 1);
+    EXPECT_EQ(stats.hits + 1, cache.stats().hits);
+}
+
+TEST(RensaDetectionCacheTest, multiThread)
+{
+    const CoreField original(
+        "  R G "
+        "R GRBG"
+        "RBGRBG"
+        "RBGRBG");
+
+    RensaDetectionCache cache(1);
+    size_t expectedSize = cache.detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3)->size();
+
+    vector<thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 100; ++j)
+                EXPECT_EQ(expectedSize, cache.detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3)->size());
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(400, cache.stats().hits);
+}
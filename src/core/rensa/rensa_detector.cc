@@ -3,10 +3,19 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "base/base.h"
+#include "base/deadline.h"
+#include "base/executor.h"
+#include "base/noncopyable.h"
 #include "core/column_puyo.h"
 #include "core/column_puyo_list.h"
 #include "core/core_field.h"
@@ -76,8 +85,116 @@ const int EXTENTIONS[][3][2] = {
     {{-1, 1}, { 0, 1}, { 0, 2}},
 };
 
+inline void countProhibited(int* numProhibited)
+{
+    if (numProhibited)
+        ++*numProhibited;
+}
+
+// VisitedStateSet is a set of the states of the iteration, which can be accessed
+// from several threads. A state is everything the iteration after it depends on:
+// the field to detect the next rensa in, the puyos complemented so far, the number
+// of chains the combined rensa should have, and the prohibited columns. So a state
+// found again can be skipped without losing any rensa.
+// The set is split into shards by hash to reduce lock contention.
+class VisitedStateSet : noncopyable {
+public:
+    // Returns true if the state is newly inserted.
+    bool insert(const CoreField& field, const ColumnPuyoList& keyPuyos, const ColumnPuyoList& firePuyos,
+                int chains, const bool prohibits[FieldConstant::MAP_WIDTH])
+    {
+        State state { field, keyPuyos, firePuyos, chains, 0 };
+        for (int x = 0; x < FieldConstant::MAP_WIDTH; ++x) {
+            if (prohibits[x])
+                state.prohibitMask |= 1 << x;
+        }
+        size_t h = StateHash()(state);
+        Shard& shard = shards_[(h >> 7) % NUM_SHARDS];
+        lock_guard<mutex> lock(shard.mu);
+        return shard.states.insert(std::move(state)).second;
+    }
+
+private:
+    static const int NUM_SHARDS = 16;
+
+    struct State {
+        CoreField field;
+        ColumnPuyoList keyPuyos;
+        ColumnPuyoList firePuyos;
+        int chains;
+        int prohibitMask;
+
+        friend bool operator==(const State& lhs, const State& rhs)
+        {
+            return lhs.chains == rhs.chains && lhs.prohibitMask == rhs.prohibitMask &&
+                lhs.field == rhs.field && lhs.keyPuyos == rhs.keyPuyos && lhs.firePuyos == rhs.firePuyos;
+        }
+    };
+
+    struct StateHash {
+        size_t operator()(const State& state) const
+        {
+            return state.field.hash() ^ (state.keyPuyos.hash() * 31) ^ (state.firePuyos.hash() * 0x9E3779B97F4A7C15ULL) ^
+                (static_cast<size_t>(state.chains) << 8) ^ static_cast<size_t>(state.prohibitMask);
+        }
+    };
+
+    struct Shard {
+        mutex mu;
+        unordered_set<State, StateHash> states;
+    };
+
+    Shard shards_[NUM_SHARDS];
+};
+
 }  // namespace anomymous
 
+struct RensaDetector::IterationContext {
+    IterationContext(bool dedupes, int maxIteration, const Deadline* deadline) :
+        deadline(deadline)
+    {
+        if (dedupes) {
+            for (int i = 0; i < maxIteration; ++i)
+                visitedStates.emplace_back(new VisitedStateSet);
+        }
+    }
+
+    // Returns false if the same state has already been found with the same |restIterations|.
+    bool markVisited(const CoreField& field, const ColumnPuyoList& keyPuyos, const ColumnPuyoList& firePuyos,
+                     int chains, const bool prohibits[FieldConstant::MAP_WIDTH], int restIterations)
+    {
+        if (visitedStates.empty())
+            return true;
+        if (visitedStates[restIterations]->insert(field, keyPuyos, firePuyos, chains, prohibits))
+            return true;
+        ++numDuplicated;
+        return false;
+    }
+
+    bool deadlineHasPassed() const { return deadline && deadline->hasPassed(); }
+
+    void addStatsTo(RensaDetectorStats* stats) const
+    {
+        if (!stats)
+            return;
+        stats->numCandidates += numCandidates;
+        stats->numProhibited += numProhibited;
+        stats->numDuplicated += numDuplicated;
+        stats->numSimulated += numSimulated;
+    }
+
+    // These are updated from several threads in parallel mode.
+    atomic<int64_t> numCandidates { 0 };
+    atomic<int64_t> numProhibited { 0 };
+    atomic<int64_t> numDuplicated { 0 };
+    atomic<int64_t> numSimulated { 0 };
+
+    // Indexed by the rest iterations. Empty if we don't dedupe.
+    vector<unique_ptr<VisitedStateSet>> visitedStates;
+
+    const Deadline* deadline;
+};
+
 // detectByDropStrategy complements puyos in |originalField|, and fires a rensa.
 // The complemented puyos are always grounded (This is the different point of tryFloatFire).
 // For each detected rensa, |callback| is called.
@@ -87,7 +204,8 @@ void RensaDetector::detectByDropStrategy(const CoreField& originalField,
                                          PurposeForFindingRensa purpose,
                                          int maxComplementPuyos,
                                          int maxPuyoHeight,
-                                         const RensaDetector::ComplementCallback& callback)
+                                         const RensaDetector::ComplementCallback& callback,
+                                         int* numProhibited)
 {
     bool visited[FieldConstant::MAP_WIDTH][NUM_PUYO_COLORS] {};
 
@@ -103,8 +221,10 @@ void RensaDetector::detectByDropStrategy(const CoreField& originalField,
 
         // Drop puyo on
         for (int d = -1; d <= 1; ++d) {
-            if (prohibits[x + d])
+            if (prohibits[x + d]) {
+                countProhibited(numProhibited);
                 continue;
+            }
 
             if (visited[x + d][ordinal(c)])
                 continue;
@@ -169,7 +289,8 @@ void RensaDetector::detectByFloatStrategy(const CoreField& originalField,
                                           const bool prohibits[FieldConstant::MAP_WIDTH],
                                           int maxComplementPuyos,
                                           int maxPuyoHeight,
-                                          const RensaDetector::ComplementCallback& callback)
+                                          const RensaDetector::ComplementCallback& callback,
+                                          int* numProhibited)
 {
     FieldBits normalColorBits = originalField.bitField().normalColorBits();
     FieldBits emptyBits = originalField.bitField().bits(PuyoColor::EMPTY);
@@ -189,8 +310,10 @@ void RensaDetector::detectByFloatStrategy(const CoreField& originalField,
         for (int dx = x - 1; dx <= x + 1; ++dx) {
             if (dx <= 0 || FieldConstant::WIDTH < dx)
                 continue;
-            if (prohibits[dx])
+            if (prohibits[dx]) {
+                countProhibited(numProhibited);
                 continue;
+            }
             if (x != dx && !originalField.isEmpty(dx, y))
                 continue;
 
@@ -236,7 +359,8 @@ void RensaDetector::detectByExtendStrategy(const CoreField& originalField,
                                            const bool prohibits[FieldConstant::MAP_WIDTH],
                                            int maxComplementPuyos,
                                            int maxPuyoHeight,
-                                           const RensaDetector::ComplementCallback& callback)
+                                           const RensaDetector::ComplementCallback& callback,
+                                           int* numProhibited)
 {
     FieldBits checked;
     Position positions[FieldConstant::HEIGHT * FieldConstant::WIDTH];
@@ -290,6 +414,7 @@ void RensaDetector::detectByExtendStrategy(const CoreField& originalField,
                             break;
                         }
                         if (prohibits[xx]) {
+                            countProhibited(numProhibited);
                             ok = false;
                             break;
                         }
@@ -358,6 +483,7 @@ void RensaDetector::detectByExtendStrategy(const CoreField& originalField,
                             break;
                         }
                         if (prohibits[xx]) {
+                            countProhibited(numProhibited);
                             ok = false;
                             break;
                         }
@@ -399,8 +525,10 @@ void RensaDetector::detectByExtendStrategy(const CoreField& originalField,
                 int* endX = std::unique(working, working + pos);
                 for (int i = 0; i < endX - working; ++i) {
                     int xx = working[i];
-                    if (prohibits[xx])
+                    if (prohibits[xx]) {
+                        countProhibited(numProhibited);
                         continue;
+                    }
                     CoreField cf(originalField);
                     if (!cf.dropPuyoOn(xx, c))
                         continue;
@@ -425,7 +553,8 @@ void RensaDetector::detect(const CoreField& originalField,
                            const RensaDetectorStrategy& strategy,
                            PurposeForFindingRensa purpose,
                            const bool prohibits[FieldConstant::MAP_WIDTH],
-                           const RensaDetector::ComplementCallback& callback)
+                           const RensaDetector::ComplementCallback& callback,
+                           int* numProhibited)
 {
     int maxPuyoHeight = 12;
     int complementPuyos;
@@ -444,13 +573,13 @@ void RensaDetector::detect(const CoreField& originalField,
 
     switch (strategy.mode()) {
     case RensaDetectorStrategy::Mode::DROP:
-        detectByDropStrategy(originalField, prohibits, purpose, complementPuyos, maxPuyoHeight, callback);
+        detectByDropStrategy(originalField, prohibits, purpose, complementPuyos, maxPuyoHeight, callback, numProhibited);
         break;
     case RensaDetectorStrategy::Mode::FLOAT:
-        detectByFloatStrategy(originalField, prohibits, complementPuyos, maxPuyoHeight, callback);
+        detectByFloatStrategy(originalField, prohibits, complementPuyos, maxPuyoHeight, callback, numProhibited);
         break;
     case RensaDetectorStrategy::Mode::EXTEND:
-        detectByExtendStrategy(originalField, prohibits, complementPuyos, maxPuyoHeight, callback);
+        detectByExtendStrategy(originalField, prohibits, complementPuyos, maxPuyoHeight, callback, numProhibited);
         break;
     default:
         CHECK(false) << "Unknown mode : " << static_cast<int>(strategy.mode());
@@ -470,29 +599,96 @@ void RensaDetector::detectSingle(const CoreField& cf,
 void RensaDetector::detectIteratively(const CoreField& originalField,
                                       const RensaDetectorStrategy& strategy,
                                       int maxIteration,
-                                      const RensaSimulationCallback& callback)
+                                      const RensaSimulationCallback& callback,
+                                      RensaDetectorStats* stats,
+                                      const Deadline* deadline)
 {
     DCHECK_LE(1, maxIteration);
 
+    IterationContext context(false, maxIteration, deadline);
     auto detectCallback = [&](CoreField&& complementedField, const ColumnPuyoList& firePuyos) {
-        CoreField cf(complementedField);
-        RensaLastVanishedPositionTracker tracker;
+        detectIterativelyFirst(originalField, strategy, maxIteration, std::move(complementedField), firePuyos,
+                               &context, callback);
+    };
 
-        int chains = cf.simulateFast(&tracker);
-        if (chains == 0)
-            return;
+    bool prohibits[FieldConstant::MAP_WIDTH] {};
+    int numProhibited = 0;
+    detect(originalField, strategy, PurposeForFindingRensa::FOR_FIRE, prohibits, detectCallback, &numProhibited);
+    context.numProhibited += numProhibited;
 
-        (void)callback(std::move(complementedField), firePuyos);
+    context.addStatsTo(stats);
+}
 
-        // Don't put key puyo on the column which fire puyo will be placed.
-        bool prohibits[FieldConstant::MAP_WIDTH] {};
-        makeProhibitArray(originalField, strategy, tracker.result(), firePuyos, prohibits);
-        detectIterativelyInternal(originalField, strategy, cf, maxIteration - 1,
-                                  ColumnPuyoList(), firePuyos, chains, prohibits, callback);
+// static
+void RensaDetector::detectIterativelyParallel(const CoreField& originalField,
+                                              const RensaDetectorStrategy& strategy,
+                                              int maxIteration,
+                                              Executor* executor,
+                                              const RensaSimulationCallback& callback,
+                                              RensaDetectorStats* stats,
+                                              const Deadline* deadline)
+{
+    DCHECK_LE(1, maxIteration);
+
+    // Collect the candidates of the first rensa, and process each of them in a task.
+    // The number of the candidates is small (tens), so collecting them is cheap.
+    vector<pair<CoreField, ColumnPuyoList>> candidates;
+    auto detectCallback = [&](CoreField&& complementedField, const ColumnPuyoList& firePuyos) {
+        candidates.emplace_back(std::move(complementedField), firePuyos);
     };
 
     bool prohibits[FieldConstant::MAP_WIDTH] {};
-    detect(originalField, strategy, PurposeForFindingRensa::FOR_FIRE, prohibits, detectCallback);
+    int numProhibited = 0;
+    detect(originalField, strategy, PurposeForFindingRensa::FOR_FIRE, prohibits, detectCallback, &numProhibited);
+
+    IterationContext context(true, maxIteration, deadline);
+    context.numProhibited += numProhibited;
+
+    TaskGroup group(executor);
+    for (auto& candidate : candidates) {
+        group.run([&]() {
+            detectIterativelyFirst(originalField, strategy, maxIteration, std::move(candidate.first), candidate.second,
+                                   &context, callback);
+        });
+    }
+    group.wait();
+
+    context.addStatsTo(stats);
+}
+
+// static
+void RensaDetector::detectIterativelyFirst(const CoreField& originalField,
+                                           const RensaDetectorStrategy& strategy,
+                                           int maxIteration,
+                                           CoreField&& complementedField,
+                                           const ColumnPuyoList& firePuyos,
+                                           IterationContext* context,
+                                           const RensaSimulationCallback& callback)
+{
+    if (context->deadlineHasPassed())
+        return;
+
+    ++context->numCandidates;
+
+    CoreField cf(complementedField);
+    RensaLastVanishedPositionTracker tracker;
+
+    int chains = cf.simulateFast(&tracker);
+    if (chains == 0)
+        return;
+
+    // Don't put key puyo on the column which fire puyo will be placed.
+    bool prohibits[FieldConstant::MAP_WIDTH] {};
+    makeProhibitArray(originalField, strategy, tracker.result(), firePuyos, prohibits);
+
+    if (!context->markVisited(complementedField, ColumnPuyoList(), firePuyos, chains, prohibits, maxIteration - 1))
+        return;
+
+    ++context->numSimulated;
+    (void)callback(std::move(complementedField), firePuyos);
+
+    detectIterativelyInternal(originalField, strategy, cf, maxIteration - 1,
+                              ColumnPuyoList(), firePuyos, chains, prohibits, context, callback);
 }
 
 // static
@@ -504,12 +700,18 @@ void RensaDetector::detectIterativelyInternal(const CoreField& originalField,
                                               const ColumnPuyoList& firstRensaFirePuyos,
                                               int currentTotalChains,
                                               const bool prohibits[FieldConstant::MAP_WIDTH],
+                                              IterationContext* context,
                                               const RensaSimulationCallback& callback)
 {
     if (restIterations <= 0)
         return;
 
     auto detectCallback = [&](CoreField&& complementedField, const ColumnPuyoList& currentFirePuyos) {
+        if (context->deadlineHasPassed())
+            return;
+
+        ++context->numCandidates;
+
         RensaLastVanishedPositionTracker tracker;
         int partialChains = complementedField.simulateFast(&tracker);
         if (partialChains == 0)
@@ -536,25 +738,34 @@ void RensaDetector::detectIterativelyInternal(const CoreField& originalField,
         if (!cf.dropPuyoListWithMaxHeight(firstRensaFirePuyos, maxHeight))
             return;
 
+        int expectedChains = currentTotalChains + partialChains;
+
+        // Don't put key puyo on the column which fire puyo will be placed.
+        bool newProhibits[FieldConstant::MAP_WIDTH];
+        makeProhibitArray(originalField, strategy, trackResult, firstRensaFirePuyos, newProhibits);
+
+        if (!context->markVisited(complementedField, combinedKeyPuyos, firstRensaFirePuyos,
+                                  expectedChains, newProhibits, restIterations - 1))
+            return;
+
         ColumnPuyoList allComplemented(combinedKeyPuyos);
         allComplemented.merge(firstRensaFirePuyos);
 
+        ++context->numSimulated;
         RensaResult combinedRensaResult = callback(std::move(cf), allComplemented);
-        if (combinedRensaResult.chains != currentTotalChains + partialChains) {
+        if (combinedRensaResult.chains != expectedChains) {
             // Rensa looks broken. We don't count such rensa.
             return;
         }
 
-        // Don't put key puyo on the column which fire puyo will be placed.
-        bool newProhibits[FieldConstant::MAP_WIDTH];
-        makeProhibitArray(originalField, strategy, trackResult, firstRensaFirePuyos, newProhibits);
-
         detectIterativelyInternal(originalField, strategy, complementedField,
                                   restIterations - 1, combinedKeyPuyos, firstRensaFirePuyos,
-                                  combinedRensaResult.chains, newProhibits, callback);
+                                  combinedRensaResult.chains, newProhibits, context, callback);
     };
 
-    detect(currentField, strategy, PurposeForFindingRensa::FOR_KEY, prohibits, detectCallback);
+    int numProhibited = 0;
+    detect(currentField, strategy, PurposeForFindingRensa::FOR_KEY, prohibits, detectCallback, &numProhibited);
+    context->numProhibited += numProhibited;
 }
 
 // static
@@ -1,6 +1,7 @@
 #ifndef CORE_RENSA_RENSA_DETECTOR_H_
 #define CORE_RENSA_RENSA_DETECTOR_H_
 
+#include <cstdint>
 #include <functional>
 
 #include "base/base.h"
@@ -10,6 +11,8 @@
 #include "core/rensa_tracker/rensa_last_vanished_position_tracker.h"
 
 class ColumnPuyoList;
+class Deadline;
+class Executor;
 struct RensaResult;
 
 enum class PurposeForFindingRensa {
@@ -17,6 +20,19 @@ enum class PurposeForFindingRensa {
     FOR_KEY,
 };
 
+// Counters of detectIteratively().
+struct RensaDetectorStats {
+    // The number of complemented fields generated by detect().
+    std::int64_t numCandidates = 0;
+    // The number of complement positions skipped because of the prohibits array.
+    std::int64_t numProhibited = 0;
+    // The number of complemented fields skipped because the same iteration state
+    // was already found.
+    std::int64_t numDuplicated = 0;
+    // The number of fields passed to RensaSimulationCallback.
+    std::int64_t numSimulated = 0;
+};
+
 // RensaDetector is a set of functions to find a rensa from the specified field.
 // Using detectIteratively() is recommended for most cases.
 class RensaDetector {
@@ -38,10 +54,30 @@ public:
     // 2. Try to detect another rensa after the field where the previous rensa is finished.
     // 3. Complement 2's ColumnPuyoList, and 1's ColumnPuyoList, and check the size of rensa.
     // Do (2)-(3) |maxIteration - 1| times.
+    // When |stats| is not nullptr, the counters are added to |stats|.
+    // When |deadline| is not nullptr and has passed, the detection stops. The callback
+    // has been called for the rensa found so far.
     static void detectIteratively(const CoreField&,
                                   const RensaDetectorStrategy&,
                                   int maxIteration,
-                                  const RensaSimulationCallback&);
+                                  const RensaSimulationCallback&,
+                                  RensaDetectorStats* stats = nullptr,
+                                  const Deadline* deadline = nullptr);
+
+    // Same as detectIteratively(), but the candidates of the first rensa are processed
+    // in parallel with |executor|. When the same iteration state (the field, the complemented
+    // puyos, the expected chains and the prohibited columns) is found again, it's skipped,
+    // so the number of callback calls can be smaller than detectIteratively().
+    // The set of the callback arguments is the same.
+    // |callback| might be called from several threads at the same time.
+    // When |executor| is nullptr, this runs in the current thread.
+    static void detectIterativelyParallel(const CoreField&,
+                                          const RensaDetectorStrategy&,
+                                          int maxIteration,
+                                          Executor* executor,
+                                          const RensaSimulationCallback&,
+                                          RensaDetectorStats* stats = nullptr,
+                                          const Deadline* deadline = nullptr);
 
     // Finds 2-double (or more).
     static void detectSideChain(const CoreField&,
@@ -51,25 +87,31 @@ public:
     // ----------------------------------------------------------------------
     // Don't use the following functions without understanding the algorithm.
 
+    // When |numProhibited| is not nullptr, the number of complement positions skipped
+    // because of |prohibits| is added to |*numProhibited|.
+
     // Detects rensa by DROP strategy.
     static void detectByDropStrategy(const CoreField&,
                                      const bool prohibits[FieldConstant::MAP_WIDTH],
                                      PurposeForFindingRensa,
                                      int maxComplementPuyos,
                                      int maxPuyoHeight,
-                                     const ComplementCallback&);
+                                     const ComplementCallback&,
+                                     int* numProhibited = nullptr);
     // Detects rensa by FLOAT strategy.
     static void detectByFloatStrategy(const CoreField&,
                                       const bool prohibits[FieldConstant::MAP_WIDTH],
                                       int maxComplementPuyos,
                                       int maxPuyoHeight,
-                                      const ComplementCallback&);
+                                      const ComplementCallback&,
+                                      int* numProhibited = nullptr);
     // Detects rensa by EXTEND strategy.
     static void detectByExtendStrategy(const CoreField&,
                                        const bool prohibits[FieldConstant::MAP_WIDTH],
                                        int maxComplementPuyos,
                                        int maxPuyoHeight,
-                                       const ComplementCallback&);
+                                       const ComplementCallback&,
+                                       int* numProhibited = nullptr);
 
     // Detects a rensa from the field. The ColumnPuyoList to fire a rensa will be passed to
     // |callback|. Note that invalid column puyo list might be passed to |callback|.
@@ -77,7 +119,8 @@ public:
                        const RensaDetectorStrategy&,
                        PurposeForFindingRensa,
                        const bool prohibits[FieldConstant::MAP_WIDTH],
-                       const ComplementCallback&);
+                       const ComplementCallback&,
+                       int* numProhibited = nullptr);
 
     static void detectSideChainFromDetectedField(const CoreField& originalField,
                                                  const CoreField& detectedField,
@@ -99,6 +142,15 @@ public:
                                   bool prohibits[FieldConstant::MAP_WIDTH]);
 
 private:
+    struct IterationContext;
+
+    static void detectIterativelyFirst(const CoreField& originalField,
+                                       const RensaDetectorStrategy& strategy,
+                                       int maxIteration,
+                                       CoreField&& complementedField,
+                                       const ColumnPuyoList& firePuyos,
+                                       IterationContext*,
+                                       const RensaSimulationCallback&);
     static void detectIterativelyInternal(const CoreField& originalField,
                                           const RensaDetectorStrategy& strategy,
                                           const CoreField& currentField,
@@ -107,6 +159,7 @@ private:
                                           const ColumnPuyoList& firstRensaFirePuyos,
                                           int currentTotalChains,
                                           const bool prohibits[FieldConstant::MAP_WIDTH],
+                                          IterationContext*,
                                           const RensaSimulationCallback&);
 
     static void complementKeyPuyos13thRowInternal(CoreField& currentField,
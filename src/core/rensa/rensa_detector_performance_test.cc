@@ -5,8 +5,10 @@
 #include <cstddef>
 #include <iostream>
 
+#include "base/executor.h"
 #include "base/time_stamp_counter.h"
 #include "core/core_field.h"
+#include "core/rensa/rensa_detection_cache.h"
 
 class ColumnPuyoList;
 class RensaChainTrackResult;
@@ -36,6 +38,30 @@ TEST(RensaDetectorPerformanceTest, detectIteratively_Drop)
     tsc.showStatistics();
 }
 
+TEST(RensaDetectorPerformanceTest, detectIteratively_DropCached)
+{
+    TimeStampCounterData tsc;
+
+    const CoreField original(
+        "  R G "
+        "R GRBG"
+        "RBGRBG"
+        "RBGRBG");
+
+    auto callback = [&](CoreField&& cf, const ColumnPuyoList&) -> RensaResult {
+        return cf.simulate();
+    };
+
+    RensaDetectionCache cache(1);
+    for (int i = 0; i < 10000; ++i) {
+        ScopedTimeStampCounter stsc(&tsc);
+        cache.detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3, callback);
+    }
+
+    tsc.showStatistics();
+    cout << cache.stats().toString() << endl;
+}
+
 TEST(RensaDetectorPerformanceTest, detectIteratively_Float)
 {
     TimeStampCounterData tsc;
@@ -79,3 +105,47 @@ TEST(RensaDetectorPerformanceTest, detectIteratively_Extend)
 
     tsc.showStatistics();
 }
+
+TEST(RensaDetectorPerformanceTest, detectIterativelyParallel_Drop)
+{
+    const CoreField original(
+        "  R G "
+        "R GRBG"
+        "RBGRBG"
+        "RBGRBG");
+
+    auto callback = [&](CoreField&& cf, const ColumnPuyoList&) -> RensaResult {
+        return cf.simulate();
+    };
+
+    {
+        TimeStampCounterData tsc;
+        RensaDetectorStats stats;
+        for (int i = 0; i < 1000; ++i) {
+            ScopedTimeStampCounter stsc(&tsc);
+            RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3, callback, &stats);
+        }
+        cout << "serial: candidates=" << stats.numCandidates / 1000
+             << " prohibited=" << stats.numProhibited / 1000
+             << " simulated=" << stats.numSimulated / 1000 << endl;
+        tsc.showStatistics();
+    }
+
+    for (int numThreads : { 1, 4 }) {
+        Executor executor(numThreads);
+        executor.start();
+
+        TimeStampCounterData tsc;
+        RensaDetectorStats stats;
+        for (int i = 0; i < 1000; ++i) {
+            ScopedTimeStampCounter stsc(&tsc);
+            RensaDetector::detectIterativelyParallel(original, RensaDetectorStrategy::defaultDropStrategy(), 3,
+                                                     &executor, callback, &stats);
+        }
+        cout << "parallel (" << numThreads << " threads): candidates=" << stats.numCandidates / 1000
+             << " prohibited=" << stats.numProhibited / 1000
+             << " duplicated=" << stats.numDuplicated / 1000
+             << " simulated=" << stats.numSimulated / 1000 << endl;
+        tsc.showStatistics();
+    }
+}
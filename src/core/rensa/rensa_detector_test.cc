@@ -3,10 +3,14 @@
 #include <gtest/gtest.h>
 
 #include <cstddef>
+#include <mutex>
+#include <set>
 #include <string>
 #include <utility>
 
 #include "base/base.h"
+#include "base/deadline.h"
+#include "base/executor.h"
 #include "core/column_puyo.h"
 #include "core/column_puyo_list.h"
 #include "core/core_field.h"
@@ -779,3 +783,153 @@ TEST(RensaDetectorTest, detectSideChain)
     RensaDetector::detectSideChain(original, RensaDetectorStrategy::defaultDropStrategy(), callback);
     EXPECT_TRUE(found);
 }
+
+TEST(RensaDetectorTest, detectIteratively_stats)
+{
+    const CoreField original(
+        "B     "
+        "B     "
+        "RGGY  "
+        "RBBG  ");
+
+    int numCalled = 0;
+    auto callback = [&](CoreField&& complementedField, const ColumnPuyoList&) -> RensaResult {
+        ++numCalled;
+        return complementedField.simulate();
+    };
+
+    RensaDetectorStats stats;
+    RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3, callback, &stats);
+
+    EXPECT_EQ(numCalled, stats.numSimulated);
+    EXPECT_LE(stats.numSimulated, stats.numCandidates);
+    EXPECT_LT(0, stats.numProhibited);
+    EXPECT_EQ(0, stats.numDuplicated);
+}
+
+TEST(RensaDetectorTest, detectIterativelyParallel)
+{
+    const CoreField original(
+        "  R G "
+        "R GRBG"
+        "RBGRBG"
+        "RBGRBG");
+
+    // The same field can be found with different complemented puyos.
+    set<pair<string, string>> serialResults;
+    auto serialCallback = [&](CoreField&& complementedField, const ColumnPuyoList& cpl) -> RensaResult {
+        serialResults.emplace(complementedField.toDebugString(), cpl.toString());
+        return complementedField.simulate();
+    };
+    RensaDetectorStats serialStats;
+    RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3, serialCallback, &serialStats);
+
+    for (int numThreads : { 0, 1, 4 }) {
+        unique_ptr<Executor> executor;
+        if (numThreads > 0) {
+            executor.reset(new Executor(numThreads));
+            executor->start();
+        }
+
+        mutex mu;
+        set<pair<string, string>> parallelResults;
+        auto parallelCallback = [&](CoreField&& complementedField, const ColumnPuyoList& cpl) -> RensaResult {
+            {
+                lock_guard<mutex> lock(mu);
+                parallelResults.emplace(complementedField.toDebugString(), cpl.toString());
+            }
+            return complementedField.simulate();
+        };
+
+        RensaDetectorStats stats;
+        RensaDetector::detectIterativelyParallel(original, RensaDetectorStrategy::defaultDropStrategy(), 3,
+                                                 executor.get(), parallelCallback, &stats);
+
+        EXPECT_EQ(serialResults, parallelResults) << numThreads;
+        EXPECT_LE(static_cast<int64_t>(parallelResults.size()), stats.numSimulated);
+        EXPECT_GE(serialStats.numSimulated, stats.numSimulated);
+    }
+}
+
+TEST(RensaDetectorTest, detectIterativelyParallelSameAsSerial)
+{
+    const CoreField fields[] = {
+        CoreField(
+            "B     "
+            "B     "
+            "RGGY  "
+            "RBBG  "),
+        CoreField(
+            "  Y   "
+            "R GYB "
+            "RRGYBB"
+            "GGBRYY"),
+        CoreField(
+            "    B "
+            "YG  RB"
+            "YGBGRR"
+            "GBYBGR"
+            "GBYYGB"),
+        CoreField(
+            "R     "
+            "G Y   "
+            "BRY   "
+            "BRGG  "
+            "RBBYYG"),
+    };
+
+    auto collect = [](set<pair<string, string>>* results, mutex* mu) {
+        return [results, mu](CoreField&& complementedField, const ColumnPuyoList& cpl) -> RensaResult {
+            {
+                lock_guard<mutex> lock(*mu);
+                results->emplace(complementedField.toDebugString(), cpl.toString());
+            }
+            return complementedField.simulate();
+        };
+    };
+
+    Executor executor(4);
+    executor.start();
+
+    for (const CoreField& original : fields) {
+        mutex mu;
+        set<pair<string, string>> serialResults;
+        RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3,
+                                         collect(&serialResults, &mu));
+
+        set<pair<string, string>> parallelResults;
+        RensaDetector::detectIterativelyParallel(original, RensaDetectorStrategy::defaultDropStrategy(), 3,
+                                                 &executor, collect(&parallelResults, &mu));
+
+        EXPECT_FALSE(serialResults.empty()) << original.toDebugString();
+        EXPECT_EQ(serialResults, parallelResults) << original.toDebugString();
+    }
+
+    executor.stop();
+}
+
+TEST(RensaDetectorTest, detectIteratively_deadline)
+{
+    const CoreField original(
+        "B     "
+        "B     "
+        "RGGY  "
+        "RBBG  ");
+
+    int numCalled = 0;
+    auto callback = [&](CoreField&& complementedField, const ColumnPuyoList&) -> RensaResult {
+        ++numCalled;
+        return complementedField.simulate();
+    };
+
+    Deadline never;
+    RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3, callback, nullptr, &never);
+    EXPECT_LT(0, numCalled);
+    EXPECT_FALSE(never.wasHit());
+
+    numCalled = 0;
+    Deadline passed(Deadline::afterMillis(0));
+    RensaDetector::detectIteratively(original, RensaDetectorStrategy::defaultDropStrategy(), 3, callback, nullptr, &passed);
+    EXPECT_EQ(0, numCalled);
+    EXPECT_TRUE(passed.wasHit());
+}
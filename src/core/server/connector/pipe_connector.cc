@@ -15,20 +15,35 @@
 #include "core/server/connector/pipe_connector_posix.h"
 #endif
 
+DEFINE_bool(binary_protocol, false, "Offer the binary protocol to the clients");
+
 using namespace std;
 
 PipeConnector::PipeConnector(int player) :
     ServerConnector(player),
-    closed_(false)
+    closed_(false),
+    offersBinaryProtocol_(FLAGS_binary_protocol)
 {
 }
 
 void PipeConnector::send(const FrameRequest& req)
 {
-    std::string s = req.toString();
+    // The binary protocol is offered in the text protocol until the client accepts it.
+    // Old clients just ignore the offer.
+    const bool binary = usesBinaryProtocol_;
+    std::string s;
+    if (binary) {
+        s = req.toBinaryString();
+    } else if (offersBinaryProtocol_ && !req.offersBinaryProtocol) {
+        FrameRequest offer(req);
+        offer.offersBinaryProtocol = true;
+        s = offer.toString();
+    } else {
+        s = req.toString();
+    }
 
     // Send header first.
-    FrameRequestHeader header(s.size());
+    FrameRequestHeader header(s.size(), binary);
     if (!writeData(reinterpret_cast<const void*>(&header), sizeof(header))) {
         LOG(ERROR) << "failed to write message header";
         return;
@@ -49,18 +64,58 @@ bool PipeConnector::receive(FrameResponse* response)
         return false;
     }
 
-    if (header.size > kBufferSize) {
-        LOG(ERROR) << "body is too large to read: size=" << header.size;
+    const uint32_t size = header.payloadSize();
+    if (size > kBufferSize) {
+        LOG(ERROR) << "body is too large to read: size=" << size;
         return false;
     }
 
     char payload[kBufferSize];
-    if (!readData(reinterpret_cast<void*>(payload), header.size)) {
+    if (!readData(reinterpret_cast<void*>(payload), size)) {
         LOG(ERROR) << "failed to read payload";
         return false;
     }
 
-    *response = FrameResponse::parsePayload(payload, header.size);
-    LOG(INFO) << "RECEIVED: " << response->toString();
+    *response = parseResponse(header, payload);
     return true;
 }
+
+bool PipeConnector::parseReceivedData(const char* data, size_t size, vector<FrameResponse>* responses)
+{
+    receivedData_.append(data, size);
+
+    size_t pos = 0;
+    while (receivedData_.size() - pos >= sizeof(FrameResponseHeader)) {
+        FrameResponseHeader header;
+        memcpy(&header, receivedData_.data() + pos, sizeof(header));
+
+        const uint32_t payloadSize = header.payloadSize();
+        if (payloadSize > kBufferSize) {
+            LOG(ERROR) << "body is too large to read: size=" << payloadSize;
+            return false;
+        }
+        if (receivedData_.size() - pos - sizeof(header) < payloadSize)
+            break;
+
+        responses->push_back(parseResponse(header, receivedData_.data() + pos + sizeof(header)));
+        pos += sizeof(header) + payloadSize;
+    }
+
+    receivedData_.erase(0, pos);
+    return true;
+}
+
+FrameResponse PipeConnector::parseResponse(const FrameResponseHeader& header, const char* payload)
+{
+    const uint32_t size = header.payloadSize();
+    FrameResponse response;
+    if (header.isBinary()) {
+        response = FrameResponse::parseBinaryPayload(payload, size);
+    } else {
+        response = FrameResponse::parsePayload(payload, size);
+        if (offersBinaryProtocol_ && response.acceptsBinaryProtocol && !usesBinaryProtocol_.exchange(true))
+            LOG(INFO) << "player " << playerId() << " switches to the binary protocol";
+    }
+    LOG(INFO) << "RECEIVED: " << response.toString();
+    return response;
+}
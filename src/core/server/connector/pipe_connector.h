@@ -1,14 +1,17 @@
 #ifndef CORE_SERVER_CONNECTOR_PIPE_CONNECTOR_H_
 #define CORE_SERVER_CONNECTOR_PIPE_CONNECTOR_H_
 
+#include <atomic>
 #include <chrono>
 #include <cstdio>
 #include <string>
+#include <vector>
 
 #include "core/server/connector/server_connector.h"
 
 struct FrameRequest;
 struct FrameResponse;
+struct FrameResponseHeader;
 
 class PipeConnector : public ServerConnector {
 public:
@@ -24,6 +27,18 @@ public:
     virtual bool isClosed() const final { return closed_; }
     void setClosed(bool flag) { closed_ = flag; }
 
+    // True if the client has accepted the binary protocol.
+    bool usesBinaryProtocol() const { return usesBinaryProtocol_; }
+
+    // Returns the fd that becomes readable when the client sends data, so that
+    // a caller can poll many connectors at once. -1 if the connector can't be polled.
+    virtual int pollableFd() const { return -1; }
+
+    // Parses |data| that the caller has read from pollableFd() without blocking, and appends
+    // the complete responses to |responses|. A partial response is kept until the rest is given.
+    // Returns false if the data is broken. Don't mix this with receive().
+    bool parseReceivedData(const char* data, size_t size, std::vector<FrameResponse>* responses);
+
 protected:
     static const int kBufferSize = 1024;
 
@@ -33,7 +48,14 @@ protected:
     virtual bool readData(void*, size_t) = 0;
 
 private:
+    FrameResponse parseResponse(const FrameResponseHeader&, const char* payload);
+
     bool closed_;
+    bool offersBinaryProtocol_;
+    // Set by receive() and read by send(), which can run on different threads.
+    std::atomic<bool> usesBinaryProtocol_ { false };
+    // The data given to parseReceivedData() that doesn't make a complete response yet.
+    std::string receivedData_;
 };
 
 #endif // CORE_SERVER_CONNECTOR_PIPE_CONNECTOR_H_
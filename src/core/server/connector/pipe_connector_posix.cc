@@ -118,7 +118,7 @@ bool PipeConnectorPosix::writeData(const void* data, size_t size)
         }
 
         size -= n;
-        data = reinterpret_cast<const void*>(reinterpret_cast<const char*>(data) + size);
+        data = reinterpret_cast<const void*>(reinterpret_cast<const char*>(data) + n);
     }
 
     return true;
@@ -141,7 +141,7 @@ bool PipeConnectorPosix::readData(void* data, size_t size)
         }
 
         size -= n;
-        data = reinterpret_cast<void*>(reinterpret_cast<char*>(data) + size);
+        data = reinterpret_cast<void*>(reinterpret_cast<char*>(data) + n);
     }
 
     return true;
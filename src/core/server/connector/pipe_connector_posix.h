@@ -17,6 +17,8 @@ public:
 
     virtual ~PipeConnectorPosix() override;
 
+    int pollableFd() const override { return readerFd_; }
+
 private:
     PipeConnectorPosix(int player, int writerFd, int readerFd);
 
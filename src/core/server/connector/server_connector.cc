@@ -11,6 +11,7 @@
 // TODO(mayah): These should not be POSIX only. Implement this for Win, and
 // allow windows users to use these.
 #ifdef OS_POSIX
+# include "core/server/connector/shm_connector.h"
 # include "core/server/connector/socket_connector.h"
 # include "net/socket/tcp_server_socket.h"
 # include "net/socket/socket_factory.h"
@@ -22,7 +23,7 @@
 # include "core/server/connector/pipe_connector_posix.h"
 #endif
 
-DEFINE_string(server_connector, "stdio", "set connector type: stdio, unix, or tcp");
+DEFINE_string(server_connector, "stdio", "set connector type: stdio, unix, tcp, or shm");
 
 using namespace std;
 
@@ -53,6 +54,8 @@ unique_ptr<ServerConnector> ServerConnector::create(int playerId, const string&
 #ifdef OS_POSIX
     if (FLAGS_server_connector == "tcp")
         return createTCPSocketConnector(playerId, programName);
+    if (FLAGS_server_connector == "shm")
+        return ShmConnector::create(playerId, programName);
 #endif
 
     CHECK(false) << "Unknown connector";
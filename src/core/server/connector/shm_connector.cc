@@ -0,0 +1,66 @@
+#include "core/server/connector/shm_connector.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+
+#include <glog/logging.h>
+
+#include "base/memory.h"
+
+using namespace std;
+
+namespace {
+// A process can create several connectors for the same player id (e.g. MultiDuelServer),
+// so the name has a sequence number in the process.
+atomic<int> nextConnectorId(0);
+}
+
+ShmConnector::ShmConnector(int player_id, unique_ptr<ShmChannel> channel) :
+    PipeConnector(player_id),
+    channel_(std::move(channel))
+{
+}
+
+// static
+unique_ptr<ServerConnector> ShmConnector::create(int playerId, const string& programName)
+{
+    string name = "/puyoai." + to_string(getpid()) + "." + to_string(nextConnectorId++) + "." + to_string(playerId);
+    unique_ptr<ShmChannel> channel = ShmChannel::create(name);
+    CHECK(channel) << "failed to create shared memory " << name;
+
+    base::unique_ptr_malloc<char> program_name(strdup(programName.c_str()));
+    char player_name[] = "Player_";
+    player_name[6] = '1' + playerId;
+    string connector = "--connector=shm:" + name;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        PLOG(FATAL) << "failed to fork";
+        return unique_ptr<ServerConnector>();
+    }
+
+    if (pid == 0) {
+        // child
+        if (execl(program_name.get(), program_name.get(), player_name, connector.c_str(), nullptr) < 0) {
+            PLOG(FATAL) << "failed to exec";
+            return unique_ptr<ServerConnector>();
+        }
+
+        PLOG(FATAL) << "should not be reached here";
+    }
+
+    channel->setPeerPid(pid);
+    return unique_ptr<ServerConnector>(new ShmConnector(playerId, std::move(channel)));
+}
+
+bool ShmConnector::writeData(const void* data, size_t size)
+{
+    return channel_->writeExactly(data, size);
+}
+
+bool ShmConnector::readData(void* data, size_t size)
+{
+    return channel_->readExactly(data, size);
+}
@@ -0,0 +1,26 @@
+#ifndef CORE_SERVER_CONNECTOR_SHM_CONNECTOR_H_
+#define CORE_SERVER_CONNECTOR_SHM_CONNECTOR_H_
+
+#include <memory>
+#include <string>
+
+#include "core/connector/shm_channel.h"
+#include "core/server/connector/pipe_connector.h"
+
+// ShmConnector talks with a client via a shared memory ring buffer (see ShmChannel).
+class ShmConnector : public PipeConnector {
+public:
+    ShmConnector(int player_id, std::unique_ptr<ShmChannel> channel);
+    ~ShmConnector() override {}
+
+    // Invokes |program| with --connector=shm:<name>.
+    static std::unique_ptr<ServerConnector> create(int player_id, const std::string& program);
+
+protected:
+    bool writeData(const void*, size_t) override;
+    bool readData(void*, size_t) override;
+
+    std::unique_ptr<ShmChannel> channel_;
+};
+
+#endif // CORE_SERVER_CONNECTOR_SHM_CONNECTOR_H_
@@ -11,6 +11,8 @@ public:
 
     static std::unique_ptr<ServerConnector> create(int player_id, net::Socket socket);
 
+    int pollableFd() const override { return socket_.get(); }
+
 protected:
     bool writeData(const void*, size_t) override;
     bool readData(void*, size_t) override;
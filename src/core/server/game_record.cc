@@ -0,0 +1,616 @@
+#include "core/server/game_record.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include <glog/logging.h>
+
+#include "core/kumipuyo.h"
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = { 'P', 'U', 'Y', 'O', 'G', 'R', 'E', 'C' };
+const char INDEX_MAGIC[8] = { 'P', 'U', 'Y', 'O', 'G', 'I', 'D', 'X' };
+const uint32_t VERSION = 1;
+const size_t HEADER_SIZE = 16;
+const size_t FOOTER_SIZE = 16;
+
+// The parts of PlayerGameState. A record has only the changed parts.
+enum ChangedPart {
+    FIELD    = 1 << 0,
+    SEQ      = 1 << 1,
+    POS      = 1 << 2,
+    DECISION = 1 << 3,
+    SCORE    = 1 << 4,
+    OJAMA    = 1 << 5,
+    STATE    = 1 << 6,
+    MESSAGE  = 1 << 7,
+};
+
+// The rows 1-14 can have puyos.
+const int FIELD_ROWS = FieldConstant::MAP_HEIGHT - 2;
+
+void putVarint(string* out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out->push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out->push_back(static_cast<char>(v));
+}
+
+void putSignedVarint(string* out, int64_t v)
+{
+    // zigzag encoding
+    putVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+void putFixed(string* out, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        out->push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+uint64_t getFixed(const char* p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i)
+        v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+// Decoder reads values from [p, end). Once it reads beyond |end|, ok() becomes false.
+class Decoder {
+public:
+    Decoder(const char* p, const char* end) : p_(p), end_(end) {}
+
+    bool ok() const { return ok_; }
+    const char* position() const { return p_; }
+    bool atEnd() const { return p_ >= end_; }
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p_ >= end_) {
+                ok_ = false;
+                return 0;
+            }
+            uint8_t b = static_cast<uint8_t>(*p_++);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        ok_ = false;
+        return 0;
+    }
+
+    int64_t signedVarint()
+    {
+        uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    uint8_t byte()
+    {
+        if (p_ >= end_) {
+            ok_ = false;
+            return 0;
+        }
+        return static_cast<uint8_t>(*p_++);
+    }
+
+    string bytes(size_t n)
+    {
+        if (static_cast<size_t>(end_ - p_) < n) {
+            ok_ = false;
+            return string();
+        }
+        string s(p_, n);
+        p_ += n;
+        return s;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+GameState emptyGameState(int frameId)
+{
+    GameState gs(frameId);
+    for (int pi = 0; pi < 2; ++pi)
+        *gs.mutablePlayerGameState(pi) = PlayerGameState();
+    return gs;
+}
+
+int toStateBits(const PlayerGameState& pgs)
+{
+    const UserEvent& e = pgs.event;
+    const bool bits[] = {
+        pgs.dead, pgs.playable,
+        e.wnextAppeared, e.grounded, e.preDecisionRequest, e.decisionRequest,
+        e.decisionRequestAgain, e.ojamaDropped, e.puyoErased,
+    };
+
+    int result = 0;
+    for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); ++i) {
+        if (bits[i])
+            result |= 1 << i;
+    }
+    return result;
+}
+
+void fromStateBits(int bits, PlayerGameState* pgs)
+{
+    UserEvent* e = &pgs->event;
+    bool* flags[] = {
+        &pgs->dead, &pgs->playable,
+        &e->wnextAppeared, &e->grounded, &e->preDecisionRequest, &e->decisionRequest,
+        &e->decisionRequestAgain, &e->ojamaDropped, &e->puyoErased,
+    };
+
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i)
+        *flags[i] = (bits >> i) & 1;
+}
+
+void encodePlayer(const PlayerGameState& prev, const PlayerGameState& cur, string* out)
+{
+    int changed = 0;
+    if (!(prev.field == cur.field))
+        changed |= FIELD;
+    if (prev.kumipuyoSeq != cur.kumipuyoSeq)
+        changed |= SEQ;
+    if (prev.kumipuyoPos != cur.kumipuyoPos)
+        changed |= POS;
+    if (prev.decision != cur.decision)
+        changed |= DECISION;
+    if (prev.score != cur.score)
+        changed |= SCORE;
+    if (prev.pendingOjama != cur.pendingOjama || prev.fixedOjama != cur.fixedOjama)
+        changed |= OJAMA;
+    if (toStateBits(prev) != toStateBits(cur))
+        changed |= STATE;
+    if (prev.message != cur.message)
+        changed |= MESSAGE;
+
+    putVarint(out, changed);
+
+    if (changed & FIELD) {
+        // The changed cells as (x << 4 | y, color).
+        string cells;
+        int numCells = 0;
+        for (int x = 1; x <= FieldConstant::WIDTH; ++x) {
+            for (int y = 1; y <= FIELD_ROWS; ++y) {
+                if (prev.field.color(x, y) == cur.field.color(x, y))
+                    continue;
+                cells.push_back(static_cast<char>(x << 4 | y));
+                cells.push_back(static_cast<char>(cur.field.color(x, y)));
+                ++numCells;
+            }
+        }
+        putVarint(out, numCells);
+        out->append(cells);
+    }
+    if (changed & SEQ) {
+        putVarint(out, cur.kumipuyoSeq.size());
+        for (const Kumipuyo& kp : cur.kumipuyoSeq)
+            out->push_back(static_cast<char>(static_cast<int>(kp.axis) << 4 | static_cast<int>(kp.child)));
+    }
+    if (changed & POS) {
+        putSignedVarint(out, cur.kumipuyoPos.x);
+        putSignedVarint(out, cur.kumipuyoPos.y);
+        putSignedVarint(out, cur.kumipuyoPos.r);
+    }
+    if (changed & DECISION) {
+        putSignedVarint(out, cur.decision.x);
+        putSignedVarint(out, cur.decision.r);
+    }
+    if (changed & SCORE)
+        putSignedVarint(out, static_cast<int64_t>(cur.score) - prev.score);
+    if (changed & OJAMA) {
+        putSignedVarint(out, cur.pendingOjama);
+        putSignedVarint(out, cur.fixedOjama);
+    }
+    if (changed & STATE)
+        putVarint(out, toStateBits(cur));
+    if (changed & MESSAGE) {
+        putVarint(out, cur.message.size());
+        out->append(cur.message);
+    }
+}
+
+// |pgs| should have the previous state, and is updated.
+bool decodePlayer(Decoder* decoder, PlayerGameState* pgs)
+{
+    int changed = static_cast<int>(decoder->varint());
+
+    if (changed & FIELD) {
+        int numCells = static_cast<int>(decoder->varint());
+        for (int i = 0; i < numCells && decoder->ok(); ++i) {
+            int pos = decoder->byte();
+            int color = decoder->byte();
+            int x = pos >> 4;
+            int y = pos & 0xF;
+            if (x < 1 || FieldConstant::WIDTH < x || y < 1 || FIELD_ROWS < y || NUM_PUYO_COLORS <= color)
+                return false;
+            pgs->field.setColor(x, y, static_cast<PuyoColor>(color));
+        }
+    }
+    if (changed & SEQ) {
+        int n = static_cast<int>(decoder->varint());
+        vector<Kumipuyo> kps;
+        for (int i = 0; i < n && decoder->ok(); ++i) {
+            int b = decoder->byte();
+            kps.push_back(Kumipuyo(static_cast<PuyoColor>(b >> 4), static_cast<PuyoColor>(b & 0xF)));
+        }
+        pgs->kumipuyoSeq = KumipuyoSeq(kps);
+    }
+    if (changed & POS) {
+        int x = static_cast<int>(decoder->signedVarint());
+        int y = static_cast<int>(decoder->signedVarint());
+        int r = static_cast<int>(decoder->signedVarint());
+        pgs->kumipuyoPos = KumipuyoPos(x, y, r);
+    }
+    if (changed & DECISION) {
+        int x = static_cast<int>(decoder->signedVarint());
+        int r = static_cast<int>(decoder->signedVarint());
+        pgs->decision = Decision(x, r);
+    }
+    if (changed & SCORE)
+        pgs->score += static_cast<int>(decoder->signedVarint());
+    if (changed & OJAMA) {
+        pgs->pendingOjama = static_cast<int>(decoder->signedVarint());
+        pgs->fixedOjama = static_cast<int>(decoder->signedVarint());
+    }
+    if (changed & STATE)
+        fromStateBits(static_cast<int>(decoder->varint()), pgs);
+    if (changed & MESSAGE) {
+        size_t n = decoder->varint();
+        pgs->message = decoder->bytes(n);
+    }
+
+    return decoder->ok();
+}
+
+void encodeRecord(const GameState& prev, const GameState& cur, bool keyFrame, string* out)
+{
+    out->push_back(keyFrame ? 1 : 0);
+    putSignedVarint(out, static_cast<int64_t>(cur.frameId()) - prev.frameId());
+    for (int pi = 0; pi < 2; ++pi)
+        encodePlayer(prev.playerGameState(pi), cur.playerGameState(pi), out);
+}
+
+// |state| should have the previous state, and is updated.
+bool decodeRecord(Decoder* decoder, GameState* state, bool* keyFrame)
+{
+    *keyFrame = decoder->byte() != 0;
+    if (*keyFrame)
+        *state = emptyGameState(0);
+
+    GameState cur(static_cast<int>(state->frameId() + decoder->signedVarint()));
+    for (int pi = 0; pi < 2; ++pi) {
+        *cur.mutablePlayerGameState(pi) = state->playerGameState(pi);
+        if (!decodePlayer(decoder, cur.mutablePlayerGameState(pi)))
+            return false;
+    }
+
+    *state = cur;
+    return true;
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------
+
+GameRecordWriter::GameRecordWriter(size_t bufferSize, int keyFrameInterval) :
+    bufferSize_(bufferSize),
+    keyFrameInterval_(keyFrameInterval),
+    last_(emptyGameState(0))
+{
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+    if (isOpen())
+        close();
+}
+
+bool GameRecordWriter::open(const string& filename)
+{
+    CHECK(!isOpen());
+
+    ofs_.open(filename, ios::out | ios::binary | ios::trunc);
+    if (!ofs_)
+        return false;
+
+    buffer_.clear();
+    offset_ = 0;
+    numRecords_ = 0;
+    keyFrames_.clear();
+    last_ = emptyGameState(0);
+
+    buffer_.append(MAGIC, sizeof(MAGIC));
+    putFixed(&buffer_, VERSION, 4);
+    putFixed(&buffer_, keyFrameInterval_, 4);
+    return flush();
+}
+
+bool GameRecordWriter::add(const GameState& gameState)
+{
+    DCHECK(isOpen());
+
+    bool keyFrame = numRecords_ % keyFrameInterval_ == 0;
+    if (keyFrame) {
+        keyFrames_.emplace_back(numRecords_, offset_ + buffer_.size());
+        last_ = emptyGameState(0);
+    }
+
+    encodeRecord(last_, gameState, keyFrame, &buffer_);
+    last_ = gameState;
+    ++numRecords_;
+
+    if (buffer_.size() >= bufferSize_)
+        return flush();
+    return true;
+}
+
+bool GameRecordWriter::close()
+{
+    DCHECK(isOpen());
+
+    uint64_t indexOffset = offset_ + buffer_.size();
+    putVarint(&buffer_, numRecords_);
+    putVarint(&buffer_, keyFrames_.size());
+    pair<size_t, uint64_t> prev(0, 0);
+    for (const auto& kf : keyFrames_) {
+        putVarint(&buffer_, kf.first - prev.first);
+        putVarint(&buffer_, kf.second - prev.second);
+        prev = kf;
+    }
+    putFixed(&buffer_, indexOffset, 8);
+    buffer_.append(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+    bool ok = flush();
+    ofs_.close();
+    return ok && !ofs_.fail();
+}
+
+bool GameRecordWriter::flush()
+{
+    ofs_.write(buffer_.data(), buffer_.size());
+    offset_ += buffer_.size();
+    buffer_.clear();
+    ofs_.flush();
+    return static_cast<bool>(ofs_);
+}
+
+// ----------------------------------------------------------------------
+
+// static
+unique_ptr<GameRecordReader> GameRecordReader::open(const string& filename)
+{
+    unique_ptr<file::MappedFile> mappedFile = file::MappedFile::open(filename);
+    if (!mappedFile)
+        return unique_ptr<GameRecordReader>();
+
+    if (mappedFile->size() < HEADER_SIZE ||
+        memcmp(mappedFile->data(), MAGIC, sizeof(MAGIC)) != 0 ||
+        getFixed(mappedFile->data() + sizeof(MAGIC), 4) != VERSION) {
+        LOG(ERROR) << filename << " is not a game record of version " << VERSION;
+        return unique_ptr<GameRecordReader>();
+    }
+
+    unique_ptr<GameRecordReader> reader(new GameRecordReader(std::move(mappedFile)));
+    if (!reader->readIndex()) {
+        LOG(WARNING) << filename << " doesn't have a valid index. Scanning the records.";
+        if (!reader->scan())
+            LOG(WARNING) << filename << " is truncated. Read " << reader->size() << " records.";
+    }
+
+    return reader;
+}
+
+// static
+bool GameRecordReader::isGameRecord(const string& filename)
+{
+    ifstream ifs(filename, ios::in | ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!ifs.read(magic, sizeof(magic)))
+        return false;
+    return memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+GameRecordReader::GameRecordReader(unique_ptr<file::MappedFile> file) :
+    file_(std::move(file)),
+    begin_(file_->data()),
+    end_(file_->data() + file_->size())
+{
+}
+
+bool GameRecordReader::readIndex()
+{
+    size_t size = file_->size();
+    if (size < HEADER_SIZE + FOOTER_SIZE)
+        return false;
+
+    const char* footer = begin_ + size - FOOTER_SIZE;
+    if (memcmp(footer + 8, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+        return false;
+
+    uint64_t indexOffset = getFixed(footer, 8);
+    if (indexOffset < HEADER_SIZE || size - FOOTER_SIZE < indexOffset)
+        return false;
+
+    Decoder decoder(begin_ + indexOffset, footer);
+    size_t numRecords = decoder.varint();
+    size_t numKeyFrames = decoder.varint();
+    vector<pair<size_t, uint64_t>> keyFrames;
+    pair<size_t, uint64_t> kf(0, 0);
+    for (size_t i = 0; i < numKeyFrames && decoder.ok(); ++i) {
+        kf.first += decoder.varint();
+        kf.second += decoder.varint();
+        if (kf.second < HEADER_SIZE || indexOffset <= kf.second || numRecords <= kf.first)
+            return false;
+        keyFrames.push_back(kf);
+    }
+    if (!decoder.ok() || (numRecords > 0 && (keyFrames.empty() || keyFrames.front().first != 0)))
+        return false;
+
+    // A key frame has its frame id as the difference from 0.
+    vector<int> keyFrameIds;
+    for (const auto& kf : keyFrames) {
+        Decoder record(begin_ + kf.second, begin_ + indexOffset);
+        if (record.byte() != 1)
+            return false;
+        keyFrameIds.push_back(static_cast<int>(record.signedVarint()));
+        if (!record.ok())
+            return false;
+    }
+
+    numRecords_ = numRecords;
+    keyFrames_ = std::move(keyFrames);
+    keyFrameIds_ = std::move(keyFrameIds);
+    end_ = begin_ + indexOffset;
+    return true;
+}
+
+bool GameRecordReader::scan()
+{
+    numRecords_ = 0;
+    keyFrames_.clear();
+    keyFrameIds_.clear();
+
+    Decoder decoder(begin_ + HEADER_SIZE, end_);
+    GameState state(emptyGameState(0));
+    while (!decoder.atEnd()) {
+        const char* p = decoder.position();
+        bool keyFrame;
+        if (!decodeRecord(&decoder, &state, &keyFrame)) {
+            // Ignore the last broken record.
+            end_ = p;
+            return false;
+        }
+        if (keyFrame) {
+            keyFrames_.emplace_back(numRecords_, p - begin_);
+            keyFrameIds_.push_back(state.frameId());
+        }
+        ++numRecords_;
+    }
+
+    return true;
+}
+
+const pair<size_t, uint64_t>& GameRecordReader::lastKeyFrame(size_t i) const
+{
+    DCHECK_LT(i, numRecords_);
+
+    auto it = upper_bound(keyFrames_.begin(), keyFrames_.end(), make_pair(i, numeric_limits<uint64_t>::max()));
+    DCHECK(it != keyFrames_.begin());
+    return *--it;
+}
+
+GameRecordReader::Iterator GameRecordReader::iterate(size_t i) const
+{
+    if (numRecords_ <= i)
+        return Iterator(this, numRecords_, end_ - begin_);
+
+    const pair<size_t, uint64_t>& kf = lastKeyFrame(i);
+    Iterator it(this, kf.first, kf.second);
+    while (it.valid() && it.index() < i)
+        it.next();
+    return it;
+}
+
+size_t GameRecordReader::findFrame(int frameId) const
+{
+    // The last key frame whose frame id is smaller than |frameId|. The answer is
+    // between it and the next key frame.
+    auto kfId = lower_bound(keyFrameIds_.begin(), keyFrameIds_.end(), frameId);
+    if (kfId == keyFrameIds_.begin())
+        return 0;
+    const pair<size_t, uint64_t>& kf = keyFrames_[kfId - keyFrameIds_.begin() - 1];
+
+    Iterator it(this, kf.first, kf.second);
+    while (it.valid() && it.gameState().frameId() < frameId)
+        it.next();
+    return it.valid() ? it.index() : numRecords_;
+}
+
+bool GameRecordReader::read(size_t i, GameState* gameState)
+{
+    if (numRecords_ <= i)
+        return false;
+
+    // Seek unless |i| can be reached from the last read position without passing a key frame.
+    if (!current_.valid() || i < current_.index() || current_.index() < lastKeyFrame(i).first) {
+        current_ = iterate(i);
+    } else {
+        while (current_.valid() && current_.index() < i)
+            current_.next();
+    }
+
+    if (!current_.valid())
+        return false;
+
+    *gameState = current_.gameState();
+    return true;
+}
+
+string GameRecordReader::toJson() const
+{
+    ostringstream ss;
+    ss << "[";
+    for (Iterator it = iterate(); it.valid(); it.next()) {
+        if (it.index() > 0)
+            ss << "," << endl;
+        ss << it.gameState().toJson();
+    }
+    ss << "]";
+    return ss.str();
+}
+
+// ----------------------------------------------------------------------
+
+GameRecordReader::Iterator::Iterator() :
+    reader_(nullptr),
+    cursor_(nullptr),
+    index_(0),
+    gameState_(emptyGameState(0))
+{
+}
+
+GameRecordReader::Iterator::Iterator(const GameRecordReader* reader, size_t keyFrameIndex, uint64_t keyFrameOffset) :
+    reader_(reader),
+    cursor_(reader->begin_ + keyFrameOffset),
+    index_(keyFrameIndex),
+    gameState_(emptyGameState(0))
+{
+    if (index_ < reader_->size())
+        broken_ = !decode();
+}
+
+void GameRecordReader::Iterator::next()
+{
+    DCHECK(valid());
+
+    ++index_;
+    if (index_ < reader_->size())
+        broken_ = !decode();
+}
+
+bool GameRecordReader::Iterator::decode()
+{
+    Decoder decoder(cursor_, reader_->end_);
+    bool keyFrame;
+    if (!decodeRecord(&decoder, &gameState_, &keyFrame))
+        return false;
+
+    cursor_ = decoder.position();
+    return true;
+}
@@ -0,0 +1,155 @@
+#ifndef CORE_SERVER_GAME_RECORD_H_
+#define CORE_SERVER_GAME_RECORD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/file/mapped_file.h"
+#include "base/noncopyable.h"
+#include "core/server/game_state.h"
+
+// A game record is a compact binary file of the GameStates of a game.
+// Each GameState is encoded as the difference from the previous one, so usually
+// a frame takes only a few bytes. Every |keyFrameInterval| frames, a key frame is
+// encoded as the difference from the empty state, so a reader can start decoding there.
+//
+// Layout:
+//   char[8]   magic "PUYOGREC"
+//   uint32    version (little endian)
+//   uint32    key frame interval (little endian)
+//   records
+//   index     varint: the number of records, the number of key frames, and
+//             for each key frame, (record index, file offset) as the deltas from the previous one.
+//   uint64    the file offset of the index (little endian)
+//   char[8]   magic "PUYOGIDX"
+//
+// Record:
+//   byte      1 for a key frame, 0 otherwise
+//   varint    frame id (zigzag delta from the previous frame id)
+//   for each player:
+//     varint  the bit mask of the changed parts, and the changed parts follow in the order of the bits.
+//
+// The index is written by GameRecordWriter::close(). When a writer didn't close the file
+// (e.g. the process crashed), GameRecordReader scans the records instead.
+
+class GameRecordWriter : noncopyable {
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+    static const int DEFAULT_KEY_FRAME_INTERVAL = 256;
+
+    // At most |bufferSize| bytes are buffered before written to the file.
+    explicit GameRecordWriter(size_t bufferSize = DEFAULT_BUFFER_SIZE,
+                              int keyFrameInterval = DEFAULT_KEY_FRAME_INTERVAL);
+    // Closes the file if it's still open.
+    ~GameRecordWriter();
+
+    bool open(const std::string& filename);
+    bool add(const GameState&);
+    // Writes the index, and closes the file.
+    bool close();
+
+    bool isOpen() const { return ofs_.is_open(); }
+    // The number of the added GameStates.
+    size_t size() const { return numRecords_; }
+
+private:
+    bool flush();
+
+    const size_t bufferSize_;
+    const int keyFrameInterval_;
+
+    std::ofstream ofs_;
+    std::string buffer_;
+    // The file offset of the head of |buffer_|.
+    uint64_t offset_ = 0;
+
+    size_t numRecords_ = 0;
+    // (record index, file offset)
+    std::vector<std::pair<size_t, uint64_t>> keyFrames_;
+    GameState last_;
+};
+
+class GameRecordReader : noncopyable {
+public:
+    // Iterator decodes the GameStates one by one. Only the current GameState is kept
+    // in memory, so a long record can be analyzed without loading all of it.
+    class Iterator {
+    public:
+        // An invalid iterator.
+        Iterator();
+
+        // false after the last GameState or a broken record.
+        bool valid() const { return reader_ && !broken_ && index_ < reader_->size(); }
+        // The index of the current GameState.
+        size_t index() const { return index_; }
+        const GameState& gameState() const { return gameState_; }
+
+        void next();
+
+    private:
+        friend class GameRecordReader;
+        Iterator(const GameRecordReader*, size_t keyFrameIndex, uint64_t keyFrameOffset);
+
+        // Decodes the record at |cursor_| into |gameState_|.
+        bool decode();
+
+        const GameRecordReader* reader_;
+        // The position of the next record.
+        const char* cursor_;
+        size_t index_;
+        bool broken_ = false;
+        GameState gameState_;
+    };
+
+    // Returns nullptr if |filename| is not a game record.
+    static std::unique_ptr<GameRecordReader> open(const std::string& filename);
+    // Returns true if |filename| starts with the magic of a game record.
+    static bool isGameRecord(const std::string& filename);
+
+    // The number of GameStates in the record.
+    size_t size() const { return numRecords_; }
+
+    // Returns an iterator at the |i|-th GameState. This decodes at most a key frame
+    // interval of records.
+    Iterator iterate(size_t i = 0) const;
+
+    // Returns the index of the first GameState whose frame id is |frameId| or larger,
+    // or size() if there is no such GameState. The frame ids should be non-decreasing.
+    // This decodes at most a key frame interval of records.
+    size_t findFrame(int frameId) const;
+
+    // Reads the |i|-th GameState. Reading the next of the last read GameState doesn't seek.
+    bool read(size_t i, GameState*);
+
+    // Returns the record as the JSON which GameStateRecorder used to emit.
+    std::string toJson() const;
+
+private:
+    explicit GameRecordReader(std::unique_ptr<file::MappedFile>);
+
+    bool readIndex();
+    bool scan();
+
+    // The last key frame at or before the |i|-th record.
+    const std::pair<size_t, uint64_t>& lastKeyFrame(size_t i) const;
+
+    std::unique_ptr<file::MappedFile> file_;
+    const char* begin_ = nullptr;
+    // The end of the records.
+    const char* end_ = nullptr;
+
+    size_t numRecords_ = 0;
+    // (record index, file offset)
+    std::vector<std::pair<size_t, uint64_t>> keyFrames_;
+    // The frame id of each key frame.
+    std::vector<int> keyFrameIds_;
+
+    // The last read position of read().
+    Iterator current_;
+};
+
+#endif // CORE_SERVER_GAME_RECORD_H_
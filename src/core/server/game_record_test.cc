@@ -0,0 +1,259 @@
+#include "core/server/game_record.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+string tempFilename()
+{
+    char buf[] = "/tmp/game_record_test.XXXXXX";
+    int fd = mkstemp(buf);
+    EXPECT_LE(0, fd);
+    close(fd);
+    return buf;
+}
+
+GameState makeGameState(int frameId)
+{
+    GameState gs(frameId);
+    for (int pi = 0; pi < 2; ++pi) {
+        PlayerGameState* pgs = gs.mutablePlayerGameState(pi);
+        *pgs = PlayerGameState();
+        // Puts a puyo every 10 frames.
+        for (int i = 0; i < frameId / 10 && i < 72; ++i)
+            pgs->field.setColor(i % 6 + 1, i / 6 + 1, static_cast<PuyoColor>(4 + (i + pi) % 4));
+        pgs->kumipuyoSeq = KumipuyoSeq(frameId / 10 % 2 ? "RRBBYY" : "BBYYGG");
+        pgs->kumipuyoPos = KumipuyoPos(3, 12 - frameId % 10, frameId % 4);
+        pgs->playable = frameId % 10 != 0;
+        pgs->dead = false;
+        pgs->event.grounded = frameId % 10 == 9;
+        pgs->score = frameId / 10 * 40;
+        pgs->pendingOjama = frameId / 30;
+        pgs->fixedOjama = 0;
+        pgs->decision = Decision(frameId % 6 + 1, 0);
+        if (frameId % 25 == 0)
+            pgs->message = "frame " + to_string(frameId);
+    }
+    return gs;
+}
+
+void expectSameGameState(const GameState& expected, const GameState& actual)
+{
+    EXPECT_EQ(expected.frameId(), actual.frameId());
+    for (int pi = 0; pi < 2; ++pi) {
+        const PlayerGameState& e = expected.playerGameState(pi);
+        const PlayerGameState& a = actual.playerGameState(pi);
+        EXPECT_EQ(e.field, a.field);
+        EXPECT_EQ(e.kumipuyoSeq, a.kumipuyoSeq);
+        EXPECT_EQ(e.kumipuyoPos, a.kumipuyoPos);
+        EXPECT_EQ(e.event, a.event);
+        EXPECT_EQ(e.dead, a.dead);
+        EXPECT_EQ(e.playable, a.playable);
+        EXPECT_EQ(e.score, a.score);
+        EXPECT_EQ(e.pendingOjama, a.pendingOjama);
+        EXPECT_EQ(e.fixedOjama, a.fixedOjama);
+        EXPECT_EQ(e.decision, a.decision);
+        EXPECT_EQ(e.message, a.message);
+    }
+}
+
+}
+
+TEST(GameRecordTest, writeAndRead)
+{
+    const string filename = tempFilename();
+    const int N = 1000;
+
+    {
+        // Small buffer and key frame interval to test flushing and seeking.
+        GameRecordWriter writer(128, 64);
+        ASSERT_TRUE(writer.open(filename));
+        for (int i = 0; i < N; ++i)
+            ASSERT_TRUE(writer.add(makeGameState(i + 1)));
+        EXPECT_EQ(static_cast<size_t>(N), writer.size());
+        ASSERT_TRUE(writer.close());
+    }
+
+    EXPECT_TRUE(GameRecordReader::isGameRecord(filename));
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(filename);
+    ASSERT_TRUE(reader.get());
+    ASSERT_EQ(static_cast<size_t>(N), reader->size());
+
+    GameState gs(0);
+    // Sequential
+    for (int i = 0; i < N; ++i) {
+        ASSERT_TRUE(reader->read(i, &gs));
+        expectSameGameState(makeGameState(i + 1), gs);
+    }
+    // Random access
+    for (int i : vector<int> { 500, 3, 999, 0, 64, 63, 128, 700, 701 }) {
+        ASSERT_TRUE(reader->read(i, &gs));
+        expectSameGameState(makeGameState(i + 1), gs);
+    }
+    EXPECT_FALSE(reader->read(N, &gs));
+
+    remove(filename.c_str());
+}
+
+TEST(GameRecordTest, iterate)
+{
+    const string filename = tempFilename();
+    const int N = 300;
+    {
+        GameRecordWriter writer(1024, 64);
+        ASSERT_TRUE(writer.open(filename));
+        for (int i = 0; i < N; ++i)
+            ASSERT_TRUE(writer.add(makeGameState(i + 1)));
+        ASSERT_TRUE(writer.close());
+    }
+
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(filename);
+    ASSERT_TRUE(reader.get());
+
+    int n = 0;
+    for (GameRecordReader::Iterator it = reader->iterate(); it.valid(); it.next()) {
+        EXPECT_EQ(static_cast<size_t>(n), it.index());
+        expectSameGameState(makeGameState(n + 1), it.gameState());
+        ++n;
+    }
+    EXPECT_EQ(N, n);
+
+    // Starts from the middle of a key frame interval.
+    GameRecordReader::Iterator it = reader->iterate(100);
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(100U, it.index());
+    expectSameGameState(makeGameState(101), it.gameState());
+    it.next();
+    expectSameGameState(makeGameState(102), it.gameState());
+
+    EXPECT_FALSE(reader->iterate(N).valid());
+    EXPECT_FALSE(GameRecordReader::Iterator().valid());
+
+    remove(filename.c_str());
+}
+
+TEST(GameRecordTest, findFrame)
+{
+    const string filename = tempFilename();
+    const int N = 200;
+    {
+        GameRecordWriter writer(1024, 16);
+        ASSERT_TRUE(writer.open(filename));
+        // Frame ids are 10, 13, 16, ...
+        for (int i = 0; i < N; ++i)
+            ASSERT_TRUE(writer.add(makeGameState(10 + 3 * i)));
+        ASSERT_TRUE(writer.close());
+    }
+
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(filename);
+    ASSERT_TRUE(reader.get());
+
+    EXPECT_EQ(0U, reader->findFrame(0));
+    EXPECT_EQ(0U, reader->findFrame(10));
+    EXPECT_EQ(1U, reader->findFrame(11));
+    EXPECT_EQ(16U, reader->findFrame(10 + 3 * 16));
+    EXPECT_EQ(17U, reader->findFrame(10 + 3 * 16 + 1));
+    EXPECT_EQ(150U, reader->findFrame(10 + 3 * 150 - 2));
+    EXPECT_EQ(static_cast<size_t>(N - 1), reader->findFrame(10 + 3 * (N - 1)));
+    EXPECT_EQ(static_cast<size_t>(N), reader->findFrame(10 + 3 * N));
+
+    remove(filename.c_str());
+}
+
+TEST(GameRecordTest, toJson)
+{
+    const string filename = tempFilename();
+    vector<GameState> states;
+    {
+        GameRecordWriter writer;
+        ASSERT_TRUE(writer.open(filename));
+        for (int i = 0; i < 30; ++i) {
+            states.push_back(makeGameState(i + 1));
+            ASSERT_TRUE(writer.add(states.back()));
+        }
+    }
+
+    // The same JSON as GameStateRecorder used to emit.
+    ostringstream expected;
+    expected << "[";
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (i > 0)
+            expected << "," << endl;
+        expected << states[i].toJson();
+    }
+    expected << "]";
+
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(filename);
+    ASSERT_TRUE(reader.get());
+    EXPECT_EQ(expected.str(), reader->toJson());
+
+    remove(filename.c_str());
+}
+
+TEST(GameRecordTest, truncated)
+{
+    const string filename = tempFilename();
+    const int N = 100;
+    {
+        GameRecordWriter writer(1024 * 1024, 16);
+        ASSERT_TRUE(writer.open(filename));
+        for (int i = 0; i < N; ++i)
+            ASSERT_TRUE(writer.add(makeGameState(i + 1)));
+        ASSERT_TRUE(writer.close());
+    }
+
+    // Drop the index and a part of the last record, as if the writer crashed.
+    string content;
+    {
+        ifstream ifs(filename, ios::binary);
+        content.assign(istreambuf_iterator<char>(ifs), istreambuf_iterator<char>());
+    }
+    {
+        // The footer has the offset of the index.
+        size_t indexOffset = 0;
+        for (int i = 0; i < 8; ++i)
+            indexOffset |= static_cast<size_t>(static_cast<unsigned char>(content[content.size() - 16 + i])) << (8 * i);
+        ofstream ofs(filename, ios::binary | ios::trunc);
+        ofs.write(content.data(), indexOffset - 1);
+    }
+
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(filename);
+    ASSERT_TRUE(reader.get());
+    EXPECT_LT(0U, reader->size());
+    EXPECT_GT(static_cast<size_t>(N), reader->size());
+
+    GameState gs(0);
+    for (size_t i = 0; i < reader->size(); ++i) {
+        ASSERT_TRUE(reader->read(i, &gs));
+        expectSameGameState(makeGameState(i + 1), gs);
+    }
+    // The key frames are found by scanning.
+    EXPECT_EQ(40U, reader->findFrame(41));
+
+    remove(filename.c_str());
+}
+
+TEST(GameRecordTest, notGameRecord)
+{
+    const string filename = tempFilename();
+    {
+        ofstream ofs(filename);
+        ofs << "[]";
+    }
+
+    EXPECT_FALSE(GameRecordReader::isGameRecord(filename));
+    EXPECT_FALSE(GameRecordReader::open(filename).get());
+    EXPECT_FALSE(GameRecordReader::isGameRecord(filename + ".nonexistent"));
+
+    remove(filename.c_str());
+}
@@ -0,0 +1,45 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/server/game_record.h"
+
+DEFINE_string(output, "", "the output JSON file. If empty, stdout is used.");
+
+using namespace std;
+
+// Converts a game record made by GameStateRecorder to JSON.
+int main(int argc, char* argv[])
+{
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " [--output=<json>] <record>" << endl;
+        return EXIT_FAILURE;
+    }
+
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(argv[1]);
+    if (!reader) {
+        cerr << "failed to open " << argv[1] << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (FLAGS_output.empty()) {
+        cout << reader->toJson();
+        return EXIT_SUCCESS;
+    }
+
+    ofstream ofs(FLAGS_output);
+    ofs << reader->toJson();
+    if (!ofs) {
+        cerr << "failed to write " << FLAGS_output << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
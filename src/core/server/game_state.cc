@@ -26,15 +26,18 @@ GameResult GameState::gameResult() const
     return GameResult::PLAYING;
 }
 
-string GameState::toJson() const
+static Json::Value toJsonValue(const GameState& gameState)
 {
-    PlainField f[2] = { playerGameState_[0].field, playerGameState_[1].field };
+    const PlayerGameState& pgs1 = gameState.playerGameState(0);
+    const PlayerGameState& pgs2 = gameState.playerGameState(1);
+    PlainField f[2] = { pgs1.field, pgs2.field };
 
     for (int i = 0; i < 2; ++i) {
-        if (playerGameState_[i].playable) {
-            const KumipuyoPos& pos = playerGameState_[i].kumipuyoPos;
-            if (!playerGameState_[i].kumipuyoSeq.isEmpty()) {
-                const Kumipuyo& kp = playerGameState_[i].kumipuyoSeq.front();
+        const PlayerGameState& pgs = gameState.playerGameState(i);
+        if (pgs.playable) {
+            const KumipuyoPos& pos = pgs.kumipuyoPos;
+            if (!pgs.kumipuyoSeq.isEmpty()) {
+                const Kumipuyo& kp = pgs.kumipuyoSeq.front();
                 f[i].setColor(pos.axisX(), pos.axisY(), kp.axis);
                 f[i].setColor(pos.childX(), pos.childY(), kp.child);
             }
@@ -42,21 +45,55 @@ string GameState::toJson() const
     }
 
     Json::Value root;
-    root["result"] = toString(gameResult());
+    root["result"] = toString(gameState.gameResult());
     root["p1"] = f[0].toString();
-    root["s1"] = playerGameState_[0].score;
-    root["o1"] = playerGameState_[0].ojama();
-    root["n1"] = playerGameState_[0].kumipuyoSeq.toString();
-    root["m1"] = playerGameState_[0].message;
+    root["s1"] = pgs1.score;
+    root["o1"] = pgs1.ojama();
+    root["n1"] = pgs1.kumipuyoSeq.toString();
+    root["m1"] = pgs1.message;
 
     root["p2"] = f[1].toString();
-    root["s2"] = playerGameState_[1].score;
-    root["o2"] = playerGameState_[1].ojama();
-    root["n2"] = playerGameState_[1].kumipuyoSeq.toString();
-    root["m2"] = playerGameState_[1].message;
+    root["s2"] = pgs2.score;
+    root["o2"] = pgs2.ojama();
+    root["n2"] = pgs2.kumipuyoSeq.toString();
+    root["m2"] = pgs2.message;
+
+    return root;
+}
+
+static string toCompactString(const Json::Value& value)
+{
+    Json::FastWriter writer;
+    string s = writer.write(value);
+    // FastWriter appends a newline.
+    if (!s.empty() && s.back() == '\n')
+        s.pop_back();
+    return s;
+}
 
+string GameState::toJson() const
+{
     Json::StyledWriter writer;
-    return writer.write(root);
+    return writer.write(toJsonValue(*this));
+}
+
+string GameState::toCompactJson() const
+{
+    return toCompactString(toJsonValue(*this));
+}
+
+string GameState::toCompactJsonDelta(const GameState& previous) const
+{
+    const Json::Value current = toJsonValue(*this);
+    const Json::Value base = toJsonValue(previous);
+
+    Json::Value delta(Json::objectValue);
+    for (const string& name : current.getMemberNames()) {
+        if (current[name] != base[name])
+            delta[name] = current[name];
+    }
+
+    return toCompactString(delta);
 }
 
 string GameState::toDebugString() const
@@ -40,6 +40,11 @@ public:
     int frameId() const { return frameId_; }
 
     std::string toJson() const;
+    // Same as toJson(), but in one line.
+    std::string toCompactJson() const;
+    // The members of toCompactJson() that differ from |previous|, in one line.
+    // "{}" if nothing has changed. A client can merge it into the previous state.
+    std::string toCompactJsonDelta(const GameState& previous) const;
     std::string toDebugString() const;
 
     GameResult gameResult() const;
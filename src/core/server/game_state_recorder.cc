@@ -1,7 +1,7 @@
 #include "core/server/game_state_recorder.h"
 
 #include <chrono>
-#include <fstream>
+#include <cstdio>
 #include <iomanip>
 #include <sstream>
 
@@ -26,7 +26,7 @@ void GameStateRecorder::newGameWillStart()
 
 #if defined(_MSC_VER)
     ostringstream oss;
-    oss << std::put_time(std::localtime(&now), "puyoai.gamestate.%Y%m%d-%H%M%S.json");
+    oss << std::put_time(std::localtime(&now), "puyoai.gamestate.%Y%m%d-%H%M%S.rec");
 
     filename_ = oss.str();
 #else
@@ -36,13 +36,21 @@ void GameStateRecorder::newGameWillStart()
     localtime_r(&now, &ltm);
 
     char buf[1024];
-    strftime(buf, 1024, "puyoai.gamestate.%Y%m%d-%H%M%S.json", &ltm);
+    strftime(buf, 1024, "puyoai.gamestate.%Y%m%d-%H%M%S.rec", &ltm);
 
     filename_ = buf;
 #endif
+
+    const string path = file::joinPath(dirPath_, filename_);
+    if (writer_.isOpen())
+        writer_.close();
+    if (!writer_.open(path)) {
+        PLOG(ERROR) << "couldn't open game state record path: " << path;
+        return;
+    }
     recording_ = true;
 
-    LOG(INFO) << "will start game state logging to " << filename_;
+    LOG(INFO) << "will start game state logging to " << path;
 }
 
 void GameStateRecorder::onUpdate(const GameState& gameState)
@@ -50,38 +58,34 @@ void GameStateRecorder::onUpdate(const GameState& gameState)
     if (!recording_)
         return;
 
-    gameStates_.push_back(gameState);
+    if (!writer_.add(gameState)) {
+        LOG(ERROR) << "couldn't write game state to " << filename_;
+        recording_ = false;
+    }
 }
 
 void GameStateRecorder::gameHasDone(GameResult gameResult)
 {
+    if (!writer_.isOpen())
+        return;
+
     recording_ = false;
-    vector<GameState> gs(std::move(gameStates_));
-    gameStates_.clear();
+    size_t numStates = writer_.size();
+    bool ok = writer_.close();
 
+    const string path = file::joinPath(dirPath_, filename_);
     if (record_only_p1_win_) {
         if (gameResult != GameResult::P1_WIN) {
             LOG(INFO) << "game state won't be emitted since P1 didn't win";
+            remove(path.c_str());
             return;
         }
     }
 
-    LOG(INFO) << "will emit game state to " << filename_;
-
-    // emits json here.
-    const string path = file::joinPath(dirPath_, filename_);
-    ofstream fs(path);
-    if (!fs) {
-        PLOG(ERROR) << "couldn't open game state record path: " << path;
+    if (!ok) {
+        LOG(ERROR) << "couldn't write game state record: " << path;
         return;
     }
 
-    fs << "[";
-    for (size_t i = 0; i < gs.size(); ++i) {
-        if (i > 0) {
-            fs << "," << endl;
-        }
-        fs << gs[i].toJson();
-    }
-    fs << "]";
+    LOG(INFO) << "emitted " << numStates << " game states to " << path;
 }
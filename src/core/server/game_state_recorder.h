@@ -2,13 +2,14 @@
 #define CORE_SERVER_GAME_STATE_RECORDER_H_
 
 #include <string>
-#include <vector>
 
+#include "core/server/game_record.h"
 #include "core/server/game_state.h"
 #include "core/server/game_state_observer.h"
 
-// GameStateRecorder records GameState, and emits as json for each game.
-//
+// GameStateRecorder records GameState into a game record file for each game.
+// The states are written while the game is running, so only a bounded buffer is kept in memory.
+// Use game_record_to_json to convert the record to JSON.
 class GameStateRecorder : public GameStateObserver {
 public:
     explicit GameStateRecorder(const std::string& dirPath,
@@ -23,7 +24,7 @@ private:
     bool recording_;
     std::string dirPath_;
     std::string filename_;
-    std::vector<GameState> gameStates_;
+    GameRecordWriter writer_;
 };
 
 #endif // CORE_SERVER_GAME_STATE_RECORDER_H_
@@ -0,0 +1,53 @@
+#include "core/server/game_state.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+GameState makeGameState(int score)
+{
+    GameState gs(1);
+    for (int pi = 0; pi < 2; ++pi) {
+        PlayerGameState* pgs = gs.mutablePlayerGameState(pi);
+        *pgs = PlayerGameState();
+        pgs->kumipuyoSeq = KumipuyoSeq("RRBBYY");
+        pgs->kumipuyoPos = KumipuyoPos(3, 12, 0);
+        pgs->playable = true;
+        pgs->dead = false;
+        pgs->score = 0;
+        pgs->pendingOjama = 0;
+        pgs->fixedOjama = 0;
+    }
+    gs.mutablePlayerGameState(0)->score = score;
+    return gs;
+}
+
+}
+
+TEST(GameStateTest, toCompactJson)
+{
+    string json = makeGameState(40).toCompactJson();
+    EXPECT_EQ(string::npos, json.find('\n'));
+    EXPECT_NE(string::npos, json.find("\"s1\":40"));
+}
+
+TEST(GameStateTest, toCompactJsonDelta)
+{
+    GameState previous = makeGameState(0);
+    GameState current = makeGameState(40);
+
+    EXPECT_EQ("{\"s1\":40}", current.toCompactJsonDelta(previous));
+    EXPECT_EQ("{}", current.toCompactJsonDelta(current));
+
+    // Moving the kumipuyo changes only the field of 2P.
+    current.mutablePlayerGameState(1)->kumipuyoPos = KumipuyoPos(4, 12, 0);
+    string delta = current.toCompactJsonDelta(previous);
+    EXPECT_NE(string::npos, delta.find("\"p2\""));
+    EXPECT_NE(string::npos, delta.find("\"s1\""));
+    EXPECT_EQ(string::npos, delta.find("\"p1\""));
+    EXPECT_EQ(string::npos, delta.find("\"n2\""));
+}
@@ -30,3 +30,14 @@ string UserEvent::toString() const
     r[6] = puyoErased           ? 'E' : '-';
     return r;
 }
+
+bool operator==(const UserEvent& lhs, const UserEvent& rhs)
+{
+    return lhs.wnextAppeared == rhs.wnextAppeared &&
+        lhs.grounded == rhs.grounded &&
+        lhs.preDecisionRequest == rhs.preDecisionRequest &&
+        lhs.decisionRequest == rhs.decisionRequest &&
+        lhs.decisionRequestAgain == rhs.decisionRequestAgain &&
+        lhs.ojamaDropped == rhs.ojamaDropped &&
+        lhs.puyoErased == rhs.puyoErased;
+}
@@ -21,6 +21,9 @@ struct UserEvent {
 
     std::string toString() const;
 
+    friend bool operator==(const UserEvent&, const UserEvent&);
+    friend bool operator!=(const UserEvent& lhs, const UserEvent& rhs) { return !(lhs == rhs); }
+
     bool wnextAppeared = false;
     bool grounded = false;
     // preDecisionRequest is used for precede input.
@@ -103,6 +103,7 @@ public:
                                 candidates.push_back(v);
                             }
                         }
+                        const uint32_t reachableMask = PuyoController::reachableDecisionMask(f2);
                         while(true) {
                             if(candidates.empty()) {
                                 dead = true;
@@ -113,7 +114,7 @@ public:
                             candidates[i] = candidates.back();
                             candidates.pop_back();
                             auto & de = DECISIONS[v];
-                            if(!PuyoController::isReachable(f2, de)) {
+                            if(!(reachableMask & PuyoController::decisionBit(de))) {
                                 continue;
                             }
                             int dropFrames = f2.framesToDropNext(de);
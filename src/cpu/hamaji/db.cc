@@ -132,6 +132,12 @@ string normalizeSeqUni(const string& seq) {
 }
 
 string normalizeSeq(const string& seq, bool* swapped) {
+  return normalizeSeq(seq, swapped, 0, 0);
+}
+
+string normalizeSeq(const string& seq, bool* swapped,
+                    int flips, int* num_undecided) {
+  int undecided = 0;
   if (swapped) {
     for (size_t i = 0; i < seq.size() / 3; i++) {
       swapped[i] = false;
@@ -165,6 +171,7 @@ string normalizeSeq(const string& seq, bool* swapped) {
           swap(a, b);
 
         bool a_first = true;
+        bool decided = false;
         for (size_t j = i + 3; j < seq.size(); j += 3) {
           int x = seq[j] - 'A';
           int y = seq[j+1] - 'A';
@@ -175,13 +182,21 @@ string normalizeSeq(const string& seq, bool* swapped) {
             continue;
 
           if (a == x || a == y) {
+            decided = true;
             break;
           } else if (b == x || b == y) {
             a_first = false;
+            decided = true;
             break;
           }
         }
 
+        if (!decided) {
+          if (flips & (1 << undecided))
+            a_first = false;
+          undecided++;
+        }
+
         if (a_first) {
           tbl[a] = cur++;
           tbl[b] = cur++;
@@ -211,6 +226,8 @@ string normalizeSeq(const string& seq, bool* swapped) {
 
     out.push_back('-');
   }
+  if (num_undecided)
+    *num_undecided = undecided;
   return out;
 }
 
@@ -237,14 +254,12 @@ static void parseNext(const char* p, string* next) {
     int c = p[i] - '0';
     CHECK_GE(c, 0) << i;
     CHECK_LE(c, 5) << i;
-    (*next)[i] = "045671"[c] - '0';
+    (*next)[i] = "045671"[c];
   }
 #else
-  next->resize(6);
-  for (int i = 0; i < 6; i++) {
-    if (p[i])
-      (*next)[i] = p[i] - '0';
-  }
+  // KumipuyoSeq accepts both digits and letters, so PuyofuRecorder logs can
+  // be parsed, too.
+  *next = string(p).substr(0, 6);
 #endif
 }
 
@@ -270,7 +285,7 @@ void parseMatches(const char* filename,
   LOG(INFO) << "reading " << filename;
   FILE* fp = fopen(filename, "rb");
   CHECK(fp) << filename;
-  char buf[1024], pbuf[256], nbuf[6], abuf[256];
+  char buf[1024], pbuf[256], nbuf[256], abuf[256];
   int turn = 0;
   bool should_read = true;
   int prev_puyo_cnt = 0;
@@ -356,8 +371,8 @@ void parseMatches(const char* filename,
       continue;
     }
 
-    match.seq += next[0] - 4 + 'A';
-    match.seq += next[1] - 4 + 'A';
+    match.seq += static_cast<int>(toPuyoColor(next[0])) - 4 + 'A';
+    match.seq += static_cast<int>(toPuyoColor(next[1])) - 4 + 'A';
     match.seq += '-';
     match.decisions.push_back(decision);
   }
@@ -29,6 +29,13 @@ struct Match {
 };
 
 string normalizeSeq(const string& seq, bool* swapped = 0);
+// Same as above, but the order of 2 new colors which |seq| doesn't decide is
+// chosen by |flips|: when its k-th bit is set, the k-th such pair is ordered
+// against the default. The number of such pairs is stored in |num_undecided|.
+// A longer sequence starting with |seq| is normalized to a sequence starting
+// with one of the 2^|num_undecided| results.
+string normalizeSeq(const string& seq, bool* swapped,
+                    int flips, int* num_undecided);
 string normalizeSeqUni(const string& seq);
 
 void parseMatches(const char* filename,
@@ -47,3 +47,21 @@ TEST(DB, normalizeSeqUni) {
       "DD-BD-BD-CC-BB-DB-BD-CB-CC-CA-CC-BC-DC-BA-BA-BB-CB-DC-CC-"),
     "AA-AB-AB-CC-BB-AB-AB-BC-CC-CD-CC-BC-AC-BD-BD-BB-BC-AC-CC-");
 }
+
+TEST(DB, normalizeSeqUndecided) {
+  bool swapped[3];
+  int num_undecided;
+  EXPECT_EQ(normalizeSeq("AB-CD-CA-", swapped, 1, &num_undecided),
+            "AB-CD-AC-");
+  EXPECT_EQ(0, num_undecided);
+
+  // Nothing after "CD" decides the order of C and D.
+  EXPECT_EQ(normalizeSeq("AA-CD-AA-", swapped, 0, &num_undecided),
+            "AA-BC-AA-");
+  EXPECT_EQ(1, num_undecided);
+  EXPECT_FALSE(swapped[1]);
+  EXPECT_EQ(normalizeSeq("AA-CD-AA-", swapped, 1, &num_undecided),
+            "AA-BC-AA-");
+  EXPECT_EQ(1, num_undecided);
+  EXPECT_TRUE(swapped[1]);
+}
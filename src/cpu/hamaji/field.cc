@@ -105,9 +105,10 @@ void LF::FindAvailablePlansInternal(const LF& field, const KumipuyoSeq& next, co
     }
   }
 
+  const uint32_t reachable_mask = PuyoController::reachableDecisionMask(field);
   for (int i = 0; i < num_decisions; i++) {
     const Decision& decision = decisions[i];
-    if (!PuyoController::isReachable(field, decision)) {
+    if (!(reachable_mask & PuyoController::decisionBit(decision))) {
       continue;
     }
 
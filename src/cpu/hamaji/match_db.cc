@@ -0,0 +1,265 @@
+#include "match_db.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace {
+
+const char kMagic[8] = { 'H', 'A', 'M', 'A', 'J', 'I', 'D', 'B' };
+const uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_matches;
+  uint32_t num_turns;
+  uint32_t padding;
+};
+
+static_assert(sizeof(Header) == 24, "Header should be 24 bytes to align the columns");
+
+// Encodes "AB-CD-" to { 0 << 2 | 1, 2 << 2 | 3 }.
+string encodeSeq(const string& normalized) {
+  string out;
+  for (size_t i = 0; i + 1 < normalized.size(); i += 3) {
+    out.push_back(static_cast<char>((normalized[i] - 'A') << 2 |
+                                    (normalized[i+1] - 'A')));
+  }
+  return out;
+}
+
+template <typename T>
+void writeArray(ofstream* ofs, const vector<T>& v) {
+  ofs->write(reinterpret_cast<const char*>(v.data()), sizeof(T) * v.size());
+}
+
+}  // namespace
+
+void normalizeMatch(const Match& match,
+                    string* normalized_seq,
+                    vector<Decision>* normalized_decisions) {
+  CHECK_EQ(match.seq.size(), match.decisions.size() * 3);
+  unique_ptr<bool[]> swapped(new bool[match.decisions.size() + 1]);
+  *normalized_seq = normalizeSeq(match.seq, swapped.get());
+
+  normalized_decisions->clear();
+  for (size_t i = 0; i < match.decisions.size(); i++) {
+    const Decision& decision = match.decisions[i];
+    normalized_decisions->push_back(swapped[i] ? decision.reverse() : decision);
+  }
+}
+
+// static
+bool MatchDB::write(const string& filename, const vector<Match>& matches) {
+  vector<uint32_t> begin;
+  vector<uint8_t> seqs;
+  vector<uint8_t> decisions;
+  vector<uint8_t> eof_reasons;
+  vector<string> encoded;
+
+  begin.push_back(0);
+  for (const Match& match : matches) {
+    string normalized;
+    vector<Decision> normalized_decisions;
+    normalizeMatch(match, &normalized, &normalized_decisions);
+
+    encoded.push_back(encodeSeq(normalized));
+    seqs.insert(seqs.end(), encoded.back().begin(), encoded.back().end());
+    for (const Decision& d : normalized_decisions) {
+      CHECK(d.isValid());
+      decisions.push_back(static_cast<uint8_t>(d.x << 2 | d.r));
+    }
+    begin.push_back(seqs.size());
+    eof_reasons.push_back(static_cast<uint8_t>(match.eof_reason));
+  }
+
+  vector<uint32_t> sorted(matches.size());
+  iota(sorted.begin(), sorted.end(), 0);
+  stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) {
+    return encoded[a] < encoded[b];
+  });
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.num_matches = matches.size();
+  header.num_turns = seqs.size();
+
+  ofstream ofs(filename, ios::out | ios::binary | ios::trunc);
+  if (!ofs)
+    return false;
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  writeArray(&ofs, begin);
+  writeArray(&ofs, sorted);
+  writeArray(&ofs, seqs);
+  writeArray(&ofs, decisions);
+  writeArray(&ofs, eof_reasons);
+  return static_cast<bool>(ofs);
+}
+
+// static
+unique_ptr<MatchDB> MatchDB::open(const string& filename) {
+  unique_ptr<file::MappedFile> file = file::MappedFile::open(filename);
+  if (!file)
+    return unique_ptr<MatchDB>();
+
+  Header header;
+  if (file->size() < sizeof(header)) {
+    LOG(ERROR) << filename << " is too small";
+    return unique_ptr<MatchDB>();
+  }
+  memcpy(&header, file->data(), sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    LOG(ERROR) << filename << " is not a match db of version " << kVersion;
+    return unique_ptr<MatchDB>();
+  }
+
+  size_t expected_size = sizeof(header) +
+      sizeof(uint32_t) * (2 * static_cast<size_t>(header.num_matches) + 1) +
+      2 * static_cast<size_t>(header.num_turns) + header.num_matches;
+  if (file->size() != expected_size) {
+    LOG(ERROR) << filename << " has unexpected size: " << file->size()
+               << " (expected " << expected_size << ")";
+    return unique_ptr<MatchDB>();
+  }
+
+  return unique_ptr<MatchDB>(new MatchDB(move(file)));
+}
+
+MatchDB::MatchDB(unique_ptr<file::MappedFile> file)
+    : file_(move(file)) {
+  Header header;
+  memcpy(&header, file_->data(), sizeof(header));
+  num_matches_ = header.num_matches;
+  num_turns_ = header.num_turns;
+
+  const char* p = file_->data() + sizeof(header);
+  begin_ = reinterpret_cast<const uint32_t*>(p);
+  p += sizeof(uint32_t) * (num_matches_ + 1);
+  sorted_ = reinterpret_cast<const uint32_t*>(p);
+  p += sizeof(uint32_t) * num_matches_;
+  seqs_ = reinterpret_cast<const uint8_t*>(p);
+  p += num_turns_;
+  decisions_ = reinterpret_cast<const uint8_t*>(p);
+  p += num_turns_;
+  eof_reasons_ = reinterpret_cast<const uint8_t*>(p);
+}
+
+string MatchDB::normalizedSeq(size_t i) const {
+  string out;
+  for (uint32_t t = begin_[i]; t < begin_[i + 1]; t++) {
+    out.push_back('A' + (seqs_[t] >> 2));
+    out.push_back('A' + (seqs_[t] & 3));
+    out.push_back('-');
+  }
+  return out;
+}
+
+Decision MatchDB::decision(size_t i, int turn) const {
+  uint8_t d = decisions_[begin_[i] + turn];
+  return Decision(d >> 2, d & 3);
+}
+
+Match::EofReason MatchDB::eofReason(size_t i) const {
+  return static_cast<Match::EofReason>(eof_reasons_[i]);
+}
+
+Match MatchDB::match(size_t i) const {
+  Match match;
+  match.seq = normalizedSeq(i);
+  for (int t = 0; t < numTurns(i); t++)
+    match.decisions.push_back(decision(i, t));
+  match.eof_reason = eofReason(i);
+  return match;
+}
+
+pair<const uint32_t*, const uint32_t*> MatchDB::findByPrefix(
+    const string& normalized_prefix) const {
+  const string key = encodeSeq(normalized_prefix);
+  const uint8_t* key_begin = reinterpret_cast<const uint8_t*>(key.data());
+  const uint8_t* key_end = key_begin + key.size();
+
+  // Compares the sequences truncated to the length of |key|, so the matches
+  // starting with |key| are equal to |key|.
+  auto truncated = [&](uint32_t id) {
+    const uint8_t* s = seqs_ + begin_[id];
+    size_t n = min<size_t>(begin_[id + 1] - begin_[id], key.size());
+    return make_pair(s, s + n);
+  };
+
+  const uint32_t* first = lower_bound(
+      sorted_, sorted_ + num_matches_, key,
+      [&](uint32_t id, const string&) {
+        auto s = truncated(id);
+        return lexicographical_compare(s.first, s.second, key_begin, key_end);
+      });
+  const uint32_t* last = upper_bound(
+      first, sorted_ + num_matches_, key,
+      [&](const string&, uint32_t id) {
+        auto s = truncated(id);
+        return lexicographical_compare(key_begin, key_end, s.first, s.second);
+      });
+  return make_pair(first, last);
+}
+
+vector<pair<Decision, int>> MatchDB::lookupDecisions(const string& seq,
+                                                     int turn) const {
+  CHECK_LT(turn * 3, static_cast<int>(seq.size()));
+
+  // When |seq| is too short to decide the order of 2 new colors, the matches
+  // starting with |seq| are normalized to the same prefix with either order,
+  // but their decisions on the pair are reversed in one of them. So the
+  // decisions are looked at with both orders (|swapped[flips]|), and each
+  // match uses the order in which its first decision on the k-th pair
+  // (|first_turns[k]|) has the child above or right of the axis.
+  int num_undecided;
+  const string normalized = normalizeSeq(seq, nullptr, 0, &num_undecided);
+  const size_t num_seq_turns = seq.size() / 3;
+  vector<vector<bool>> swapped;
+  for (int flips = 0; flips < (1 << num_undecided); flips++) {
+    unique_ptr<bool[]> s(new bool[num_seq_turns + 1]);
+    normalizeSeq(seq, s.get(), flips, nullptr);
+    swapped.emplace_back(s.get(), s.get() + num_seq_turns);
+  }
+  vector<int> first_turns;
+  for (int k = 0; k < num_undecided; k++) {
+    int t = 0;
+    while (swapped[0][t] == swapped[1 << k][t])
+      t++;
+    first_turns.push_back(t);
+  }
+
+  map<Decision, int> counts;
+  auto range = findByPrefix(normalized);
+  for (const uint32_t* it = range.first; it != range.second; ++it) {
+    if (numTurns(*it) <= turn)
+      continue;
+    int flips = 0;
+    for (int k = 0; k < num_undecided; k++) {
+      const int t = first_turns[k];
+      if (t > turn)
+        continue;
+      Decision d = decision(*it, t);
+      if ((swapped[0][t] ? d.reverse() : d).r >= 2)
+        flips |= 1 << k;
+    }
+    Decision d = decision(*it, turn);
+    counts[swapped[flips][turn] ? d.reverse() : d]++;
+  }
+
+  vector<pair<Decision, int>> result(counts.begin(), counts.end());
+  stable_sort(result.begin(), result.end(),
+              [](const pair<Decision, int>& a, const pair<Decision, int>& b) {
+                return a.second > b.second;
+              });
+  return result;
+}
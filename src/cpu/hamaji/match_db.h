@@ -0,0 +1,85 @@
+#ifndef HAMAJI_MATCH_DB_H_
+#define HAMAJI_MATCH_DB_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/file/mapped_file.h"
+#include "core/decision.h"
+
+#include "base.h"
+#include "db.h"
+
+// MatchDB is a read-only database of matches made by mkmatchdb. The file is
+// mmapped, so opening it doesn't parse anything.
+//
+// The matches are stored with their normalized sequences (see normalizeSeq),
+// and the decisions are reversed where normalizeSeq swapped the axis and the
+// child. The data is stored column by column:
+//
+//   char[8]   magic "HAMAJIDB"
+//   uint32    version
+//   uint32    the number of matches (M)
+//   uint32    the number of turns of all the matches (T)
+//   uint32    padding
+//   uint32[M+1]  the first turn of each match. The turns of the i-th match
+//                are [begin[i], begin[i+1]).
+//   uint32[M]    the match ids sorted by their normalized sequences.
+//   uint8[T]     the normalized kumipuyo of each turn as (axis << 2 | child).
+//   uint8[T]     the normalized decision of each turn as (x << 2 | r).
+//   uint8[M]     the EofReason of each match.
+//
+// All integers are native endian.
+class MatchDB {
+ public:
+  // Returns nullptr if |filename| is not a match database.
+  static unique_ptr<MatchDB> open(const string& filename);
+  static bool write(const string& filename, const vector<Match>& matches);
+
+  size_t size() const { return num_matches_; }
+
+  int numTurns(size_t i) const { return begin_[i + 1] - begin_[i]; }
+  // Returns the normalized sequence in the format of normalizeSeq.
+  string normalizedSeq(size_t i) const;
+  Decision decision(size_t i, int turn) const;
+  Match::EofReason eofReason(size_t i) const;
+  // Returns the i-th match. The sequence and the decisions are normalized.
+  Match match(size_t i) const;
+
+  // Returns the range of the sorted match ids whose normalized sequences start
+  // with |normalized_prefix|. This is a binary search on the sorted ids.
+  pair<const uint32_t*, const uint32_t*> findByPrefix(
+      const string& normalized_prefix) const;
+
+  // Returns the decisions made at |turn| in the matches starting with |seq|,
+  // with their counts in the descending order. |seq| is not normalized, and
+  // should have more than |turn| kumipuyos. The decisions are for |seq|.
+  // When |seq| is too short to decide the order of 2 new colors, the colors
+  // are interchangeable, so each match is read with the order in which its
+  // first decision on them has the child above or right of the axis.
+  vector<pair<Decision, int>> lookupDecisions(const string& seq,
+                                              int turn) const;
+
+ private:
+  explicit MatchDB(unique_ptr<file::MappedFile> file);
+
+  unique_ptr<file::MappedFile> file_;
+  uint32_t num_matches_;
+  uint32_t num_turns_;
+  const uint32_t* begin_;
+  const uint32_t* sorted_;
+  const uint8_t* seqs_;
+  const uint8_t* decisions_;
+  const uint8_t* eof_reasons_;
+};
+
+// Normalizes the sequence and the decisions of |match| as mkdb does.
+void normalizeMatch(const Match& match,
+                    string* normalized_seq,
+                    vector<Decision>* normalized_decisions);
+
+#endif  // HAMAJI_MATCH_DB_H_
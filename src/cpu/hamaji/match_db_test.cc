@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "match_db.h"
+
+using namespace std;
+
+namespace {
+
+string tempFilename() {
+  char buf[] = "/tmp/match_db_test.XXXXXX";
+  int fd = mkstemp(buf);
+  EXPECT_LE(0, fd);
+  close(fd);
+  return buf;
+}
+
+Match makeMatch(const string& seq, const vector<Decision>& decisions) {
+  Match match;
+  match.seq = seq;
+  match.decisions = decisions;
+  match.eof_reason = Match::MANY_TURNS;
+  return match;
+}
+
+}  // namespace
+
+TEST(MatchDBTest, writeAndOpen) {
+  vector<Match> matches {
+    makeMatch("CD-DA-DA-", { Decision(1, 0), Decision(2, 1), Decision(3, 2) }),
+    makeMatch("AB-CD-CD-", { Decision(6, 0), Decision(5, 3), Decision(4, 0) }),
+    makeMatch("DC-DA-CA-", { Decision(3, 0), Decision(3, 0), Decision(3, 0) }),
+    makeMatch("", {}),
+  };
+  matches[3].eof_reason = Match::VANISH_PUYO;
+
+  const string filename = tempFilename();
+  ASSERT_TRUE(MatchDB::write(filename, matches));
+  unique_ptr<MatchDB> db = MatchDB::open(filename);
+  ASSERT_TRUE(db.get());
+  ASSERT_EQ(4U, db->size());
+
+  for (size_t i = 0; i < matches.size(); i++) {
+    string normalized;
+    vector<Decision> decisions;
+    normalizeMatch(matches[i], &normalized, &decisions);
+
+    Match match = db->match(i);
+    EXPECT_EQ(normalized, match.seq);
+    EXPECT_EQ(decisions, match.decisions);
+    EXPECT_EQ(matches[i].eof_reason, match.eof_reason);
+  }
+
+  // "CD" is normalized to "BA", and swapped to "AB". So the decision is reversed.
+  EXPECT_EQ(Decision(1, 2), db->decision(0, 0));
+
+  remove(filename.c_str());
+}
+
+TEST(MatchDBTest, findByPrefix) {
+  vector<Match> matches {
+    makeMatch("AB-AC-AC-", { Decision(1, 0), Decision(2, 0), Decision(3, 0) }),
+    makeMatch("AB-CD-CD-", { Decision(1, 0), Decision(2, 0), Decision(3, 0) }),
+    makeMatch("AB-AC-BC-", { Decision(1, 0), Decision(4, 0), Decision(3, 0) }),
+    makeMatch("AB-AC-", { Decision(1, 0), Decision(2, 0) }),
+    makeMatch("AA-BB-", { Decision(1, 0), Decision(2, 0) }),
+  };
+
+  const string filename = tempFilename();
+  ASSERT_TRUE(MatchDB::write(filename, matches));
+  unique_ptr<MatchDB> db = MatchDB::open(filename);
+  ASSERT_TRUE(db.get());
+
+  auto range = db->findByPrefix("AB-AC-");
+  vector<uint32_t> ids(range.first, range.second);
+  sort(ids.begin(), ids.end());
+  EXPECT_EQ((vector<uint32_t> { 0, 2, 3 }), ids);
+
+  range = db->findByPrefix("AB-");
+  EXPECT_EQ(4, range.second - range.first);
+  range = db->findByPrefix("");
+  EXPECT_EQ(5, range.second - range.first);
+  range = db->findByPrefix("AC-");
+  EXPECT_EQ(0, range.second - range.first);
+
+  // The 2nd decisions of the matches starting with "AB-AC-".
+  vector<pair<Decision, int>> decisions = db->lookupDecisions("AB-AC-", 1);
+  ASSERT_EQ(2U, decisions.size());
+  EXPECT_EQ(Decision(2, 0), decisions[0].first);
+  EXPECT_EQ(2, decisions[0].second);
+  EXPECT_EQ(Decision(4, 0), decisions[1].first);
+  EXPECT_EQ(1, decisions[1].second);
+
+  // The same sequence with other colors and a swapped pair.
+  decisions = db->lookupDecisions("DC-CB-", 0);
+  ASSERT_EQ(1U, decisions.size());
+  EXPECT_EQ(Decision(1, 0).reverse(), decisions[0].first);
+  EXPECT_EQ(3, decisions[0].second);
+
+  remove(filename.c_str());
+}
+
+TEST(MatchDBTest, lookupDecisionsUndecidedOrder) {
+  // The first 2 put C as the axis and D above it. "CD" is normalized to "CD"
+  // in the first match, but to "DC" in the second one since D comes first in
+  // "DA". The third puts D below C, which is the same as C below D.
+  vector<Match> matches {
+    makeMatch("AB-CD-CA-", { Decision(1, 0), Decision(3, 0), Decision(5, 0) }),
+    makeMatch("AB-CD-DA-", { Decision(1, 0), Decision(3, 0), Decision(5, 0) }),
+    makeMatch("AB-CD-DB-", { Decision(1, 0), Decision(4, 2), Decision(5, 0) }),
+  };
+
+  const string filename = tempFilename();
+  ASSERT_TRUE(MatchDB::write(filename, matches));
+  unique_ptr<MatchDB> db = MatchDB::open(filename);
+  ASSERT_TRUE(db.get());
+
+  // "AB-CD-" can't decide the order of C and D.
+  vector<pair<Decision, int>> decisions = db->lookupDecisions("AB-CD-", 1);
+  ASSERT_EQ(2U, decisions.size());
+  EXPECT_EQ(Decision(3, 0), decisions[0].first);
+  EXPECT_EQ(2, decisions[0].second);
+  EXPECT_EQ(Decision(4, 0), decisions[1].first);
+  EXPECT_EQ(1, decisions[1].second);
+
+  // "CA" decides C comes first, so the second match puts the other color,
+  // which comes first in it, above.
+  decisions = db->lookupDecisions("AB-CD-CA-", 1);
+  ASSERT_EQ(3U, decisions.size());
+  EXPECT_EQ(Decision(3, 0), decisions[0].first);
+  EXPECT_EQ(Decision(3, 2), decisions[1].first);
+  EXPECT_EQ(Decision(4, 0), decisions[2].first);
+
+  remove(filename.c_str());
+}
+
+TEST(MatchDBTest, parsePuyofuRecorderLog) {
+  const string filename = tempFilename();
+  {
+    FILE* fp = fopen(filename.c_str(), "w");
+    ASSERT_TRUE(fp);
+    fprintf(fp, "0 RRBBYY R00000R00000\n");
+    fprintf(fp, "R00000R00000 BBYYGG RB0000RB0000\n");
+    fprintf(fp, "=== end ===\n");
+    fclose(fp);
+  }
+
+  vector<Match> matches;
+  parseMatches(filename.c_str(), 20, 0, &matches);
+  ASSERT_EQ(1U, matches.size());
+  EXPECT_EQ("AA-BB-", matches[0].seq);
+  EXPECT_EQ((vector<Decision> { Decision(1, 0), Decision(2, 0) }), matches[0].decisions);
+  EXPECT_EQ(Match::END_MATCH, matches[0].eof_reason);
+
+  remove(filename.c_str());
+}
+
+TEST(MatchDBTest, notMatchDB) {
+  const string filename = tempFilename();
+  EXPECT_FALSE(MatchDB::open(filename).get());
+  remove(filename.c_str());
+}
@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "db.h"
+#include "match_db.h"
+
+DEFINE_string(output, "matches.db", "the output match db");
+DEFINE_int32(num_turns, 20, "the max number of turns to import for each match");
+
+// Imports the match files (the text format of parse_movie, or the transition
+// logs of PuyofuRecorder) into a MatchDB.
+int main(int argc, char* argv[]) {
+  ParseCommandLineFlags(&argc, &argv, true);
+  InitGoogleLogging(argv[0]);
+
+  FLAGS_logtostderr = true;
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s [--output=matches.db] <match files>...\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  vector<Match> matches;
+  for (int i = 1; i < argc; i++)
+    parseMatches(argv[i], FLAGS_num_turns, 0, &matches);
+
+  if (!MatchDB::write(FLAGS_output, matches)) {
+    LOG(ERROR) << "failed to write " << FLAGS_output;
+    return EXIT_FAILURE;
+  }
+
+  LOG(INFO) << "wrote " << matches.size() << " matches to " << FLAGS_output;
+  return EXIT_SUCCESS;
+}
@@ -179,13 +179,14 @@ public:
 		int bestScore = BIG_MINUS;
 
 		Kumipuyo puyo = seq.get(depth);
+		const uint32_t reachableMask = PuyoController::reachableDecisionMask(f);
 		for(int i = 0; i < 22; i++){
 			if((puyo.axis == puyo.child) && (i % 2 == 1)){
 				continue;
 			}
 			CoreField field = f;
 			const Decision & decision = DECISIONS[i];
-			if(!PuyoController::isReachable(field, decision)){
+			if(!(reachableMask & PuyoController::decisionBit(decision))){
 				continue;
 			}
 			if(field.isChigiriDecision(decision)){
@@ -259,13 +260,14 @@ public:
 	{
 		int bestScore = BIG_MINUS;
 
+		const uint32_t reachableMask = PuyoController::reachableDecisionMask(f);
 		for(int i = 0; i < 22; i++){
 			if((puyo.axis == puyo.child) && (i % 2 == 1)){
 				continue;
 			}
 			CoreField field = f;
 			const Decision & decision = DECISIONS[i];
-			if(!PuyoController::isReachable(field, decision)){
+			if(!(reachableMask & PuyoController::decisionBit(decision))){
 				continue;
 			}
 
@@ -5,7 +5,7 @@
 #include <unordered_set>
 
 #include "base/time.h"
-#include "base/wait_group.h"
+#include "core/bit_field_batch.h"
 #include "core/field_pretty_printer.h"
 #include "core/kumipuyo_seq_generator.h"
 #include "core/plan/plan.h"
@@ -16,6 +16,7 @@
 DEFINE_int32(beam_width, 400, "beam width");
 DEFINE_int32(beam_depth, 50, "beam depth");
 DEFINE_int32(beam_num, 12, "beam iteration number");
+DEFINE_int32(beam_transposition_table_mb, 64, "the size of transposition table for beam search (MB)");
 
 using namespace std;
 
@@ -54,12 +55,27 @@ struct State {
 
 std::pair<double, int> evalSuperLight(const CoreField& fieldBeforeRensa)
 {
+    // Complemented fields are simulated 8 fields at once.
     int maxChains = 0;
-    auto callback = [&maxChains](CoreField&& complementedField, const ColumnPuyoList& /*cpl*/) {
-        maxChains = std::max(maxChains, complementedField.simulateFast());
+    BitFieldBatch<8> batch;
+    int batchSize = 0;
+    auto flush = [&]() {
+        int chains[8];
+        batch.simulateFastBatch(chains);
+        for (int i = 0; i < batchSize; ++i)
+            maxChains = std::max(maxChains, chains[i]);
+        batch.clear();
+        batchSize = 0;
+    };
+    auto callback = [&](CoreField&& complementedField, const ColumnPuyoList& /*cpl*/) {
+        batch.set(batchSize++, complementedField.bitField());
+        if (batchSize == 8)
+            flush();
     };
     static const bool prohibits[FieldConstant::MAP_WIDTH] {};
     RensaDetector::detectByDropStrategy(fieldBeforeRensa, prohibits, PurposeForFindingRensa::FOR_FIRE, 2, 13, callback);
+    if (batchSize > 0)
+        flush();
 
     double maxScore = 0;
     maxScore += maxChains * 1000;
@@ -95,7 +111,7 @@ std::pair<double, int> evalSuperLight(const CoreField& fieldBeforeRensa)
 }
 
 SearchResult run(const std::vector<State>& initialStates, KumipuyoSeq seq, int maxSearchTurns,
-                 std::mutex& mu)
+                 TranspositionTable* table, std::mutex& mu, const Deadline& deadline)
 {
     SearchResult result;
 
@@ -112,6 +128,9 @@ SearchResult run(const std::vector<State>& initialStates, KumipuyoSeq seq, int m
     double beginTime = currentTime();
 
     for (int turn = 3; turn < maxSearchTurns; ++turn) {
+        if (deadline.hasPassed())
+            break;
+
         time[turn] = currentTime();
 
         seq.dropFront();
@@ -141,10 +160,19 @@ SearchResult run(const std::vector<State>& initialStates, KumipuyoSeq seq, int m
                     return;
                 }
 
-                double maxScore;
-                int maxChains;
-                std::tie(maxScore, maxChains) = evalSuperLight(fieldBeforeRensa);
-                nextStates.emplace_back(plan.field(), s.firstDecision, maxScore, maxChains, total_frames);
+                // The same field often appears in the later turns, in the other runs,
+                // and in the next think(). So the evaluation is cached.
+                TranspositionTable::Entry entry;
+                if (!table->probe(fieldBeforeRensa.hash(), &entry)) {
+                    double maxScore;
+                    int maxChains;
+                    std::tie(maxScore, maxChains) = evalSuperLight(fieldBeforeRensa);
+                    entry.score = static_cast<float>(maxScore);
+                    entry.maxChains = maxChains;
+                    entry.depth = turn;
+                    table->store(fieldBeforeRensa.hash(), entry);
+                }
+                nextStates.emplace_back(plan.field(), s.firstDecision, entry.score, entry.maxChains, total_frames);
             });
         }
 
@@ -210,8 +238,22 @@ SearchResult run(const std::vector<State>& initialStates, KumipuyoSeq seq, int m
 
 } // anonymous namespace
 
+BeamThinker::BeamThinker(Executor* executor) :
+    executor_(executor)
+{
+}
+
+TranspositionTable* BeamThinker::table() const
+{
+    call_once(tableOnce_, [this]() {
+        table_.reset(new TranspositionTable(FLAGS_beam_transposition_table_mb));
+    });
+    return table_.get();
+}
+
 DropDecision BeamThinker::think(int /*frameId*/, const CoreField& field, const KumipuyoSeq& seq,
-                                const PlayerState& /*me*/, const PlayerState& /*enemy*/, bool /*fast*/) const
+                                const PlayerState& /*me*/, const PlayerState& /*enemy*/, bool /*fast*/,
+                                const Deadline& deadline) const
 {
     // If large enough, fire.
     if (true) {
@@ -225,6 +267,9 @@ DropDecision BeamThinker::think(int /*frameId*/, const CoreField& field, const K
         }
     }
 
+    TranspositionTable* table = this->table();
+    table->newGeneration();
+
     // Decision -> max chains
     std::map<Decision, int> score;
 
@@ -249,7 +294,7 @@ DropDecision BeamThinker::think(int /*frameId*/, const CoreField& field, const K
         });
     }
 
-    WaitGroup wg;
+    TaskGroup group(executor_);
     std::mutex mu;
 
     const int maxSearchTurns = std::min(FLAGS_beam_depth, (78 - field.countPuyos()) / 2 + 4);
@@ -258,26 +303,25 @@ DropDecision BeamThinker::think(int /*frameId*/, const CoreField& field, const K
 #endif
 
     for (int k = 0; k < FLAGS_beam_num; ++k) {
-        wg.add(1);
+        group.run([&, k]() {
+            // A run started after the deadline would stop immediately. The first run
+            // is always made so that we have a decision.
+            if (k > 0 && deadline.hasPassed())
+                return;
 
-        executor_->submit([&]() {
             KumipuyoSeq tmpSeq(seq.subsequence(2));
             tmpSeq.append(KumipuyoSeqGenerator::generateRandomSequence(40));
 
-            SearchResult searchResult = run(nextStates, tmpSeq, maxSearchTurns, mu_);
+            SearchResult searchResult = run(nextStates, tmpSeq, maxSearchTurns, table, mu_, deadline);
 
-            {
-                lock_guard<mutex> lk(mu);
-                for (const auto& d : searchResult.firstDecisions) {
-                    score[d] += searchResult.maxChains;
-                }
+            lock_guard<mutex> lk(mu);
+            for (const auto& d : searchResult.firstDecisions) {
+                score[d] += searchResult.maxChains;
             }
-            // wg.done() should be called after releasing mu, because of deadlock.
-            wg.done();
         });
     }
 
-    wg.waitUntilDone();
+    group.wait();
 
     Decision d;
     int s = 0;
@@ -1,23 +1,37 @@
 #ifndef CPU_MAYAH_BEAM_THINKER_H_
 #define CPU_MAYAH_BEAM_THINKER_H_
 
+#include <memory>
 #include <mutex>
 
+#include "base/deadline.h"
 #include "base/executor.h"
 #include "core/client/ai/drop_decision.h"
 #include "core/core_field.h"
 #include "core/kumipuyo_seq.h"
 #include "core/player_state.h"
 
+#include "transposition_table.h"
+
 class BeamThinker {
 public:
-    explicit BeamThinker(Executor* executor) : executor_(executor) {}
+    explicit BeamThinker(Executor* executor);
 
+    // The beam search proceeds turn by turn. When |deadline| has passed, it stops at
+    // the current turn, and the decision is made from the states searched so far.
     DropDecision think(int frame_id, const CoreField& field, const KumipuyoSeq& seq,
-                       const PlayerState& me, const PlayerState& enemy, bool fast) const;
+                       const PlayerState& me, const PlayerState& enemy, bool fast,
+                       const Deadline& deadline = Deadline()) const;
 
 private:
+    // Allocates the table at the first call, so an AI that never runs the beam search
+    // doesn't pay for it.
+    TranspositionTable* table() const;
+
     Executor* executor_;
+    // Shared by all the beam search runs. This is kept across think() calls.
+    mutable std::once_flag tableOnce_;
+    mutable std::unique_ptr<TranspositionTable> table_;
 
     mutable std::mutex mu_;  // for cout
 };
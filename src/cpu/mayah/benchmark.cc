@@ -0,0 +1,99 @@
+#include "mayah_ai.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "base/file/file.h"
+#include "solver/endless_benchmark.h"
+
+#include "evaluation_parameter.h"
+
+DECLARE_string(feature);
+
+DEFINE_int32(size, 100, "the number of seeds.");
+DEFINE_int32(offset, 0, "offset for random seed");
+DEFINE_string(csv, "", "if set, the per-seed results are written to this file as CSV.");
+DEFINE_string(json, "", "if set, the per-seed results and the summary are written to this file as JSON.");
+DEFINE_string(baseline, "", "if set, the summary is compared with this JSON, and exits with failure on regression.");
+DEFINE_double(rate_tolerance, 0.05, "the allowed decrease of the main chain rate.");
+DEFINE_double(score_tolerance, 0.05, "the allowed relative decrease of the average main chain score.");
+DEFINE_double(think_time_tolerance, 0.2, "the allowed relative increase of the 90 percentile think time.");
+
+using namespace std;
+
+// Runs mayah in endless mode for many seeds, and reports the statistics.
+int main(int argc, char* argv[])
+{
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+#if !defined(_MSC_VER)
+    google::InstallFailureSignalHandler();
+#endif
+
+    unique_ptr<Executor> executor = Executor::makeDefaultExecutor();
+
+    EvaluationParameterMap paramMap;
+    if (!paramMap.load(FLAGS_feature)) {
+        std::string filename = string(SRC_DIR) + "/cpu/mayah/" + FLAGS_feature;
+        if (!paramMap.load(filename))
+            CHECK(false) << "parameter cannot be loaded correctly.";
+    }
+    paramMap.removeNontokopuyoParameter();
+
+    EndlessBenchmark benchmark([&paramMap]() {
+        auto ai = new DebuggableMayahAI;
+        ai->setUsesRensaHandTree(false);
+        ai->setEvaluationParameterMap(paramMap);
+        return unique_ptr<AI>(ai);
+    });
+
+    vector<EndlessBenchmarkCase> cases = benchmark.run(executor.get(), FLAGS_offset, FLAGS_size);
+    executor->stop();
+
+    for (const auto& c : cases) {
+        cout << "seed " << setw(4) << c.seed << ": "
+             << "score=" << setw(6) << c.result.score << " rensa=" << setw(2) << c.result.maxRensa;
+        if (c.result.zenkeshi)
+            cout << " / ZENKESHI";
+        cout << endl;
+    }
+
+    EndlessBenchmarkSummary summary = EndlessBenchmarkSummary::summarize(cases);
+    cout << summary.toString();
+
+    if (!FLAGS_csv.empty())
+        CHECK(file::writeFile(FLAGS_csv, EndlessBenchmark::toCSV(cases))) << "failed to write " << FLAGS_csv;
+    if (!FLAGS_json.empty())
+        CHECK(file::writeFile(FLAGS_json, EndlessBenchmark::toJson(cases, summary))) << "failed to write " << FLAGS_json;
+
+    if (FLAGS_baseline.empty())
+        return EXIT_SUCCESS;
+
+    string json;
+    CHECK(file::readFile(FLAGS_baseline, &json)) << "failed to read " << FLAGS_baseline;
+    EndlessBenchmarkSummary baseline;
+    CHECK(EndlessBenchmarkSummary::parseJson(json, &baseline)) << "failed to parse " << FLAGS_baseline;
+
+    EndlessBenchmarkTolerance tolerance;
+    tolerance.rate = FLAGS_rate_tolerance;
+    tolerance.score = FLAGS_score_tolerance;
+    tolerance.thinkTime = FLAGS_think_time_tolerance;
+
+    vector<string> regressions = findEndlessRegressions(baseline, summary, tolerance);
+    if (regressions.empty()) {
+        cout << "no regression" << endl;
+        return EXIT_SUCCESS;
+    }
+
+    cout << "REGRESSION:" << endl;
+    for (const auto& r : regressions)
+        cout << "  " << r << endl;
+    return EXIT_FAILURE;
+}
@@ -7,6 +7,7 @@
 
 #include "evaluation_feature.h"
 #include "evaluation_parameter.h"
+#include "evaluation_weight_matrix.h"
 
 struct CollectedCoef {
     double coef(EvaluationMode mode) const { return coefMap[ordinal(mode)]; }
@@ -25,7 +26,11 @@ struct CollectedSimpleSubScore {
         return s;
     }
 
-    std::array<double, NUM_EVALUATION_MODES> scoreMap {{}};
+    // Adds |v| times |weights|, which is a row of EvaluationWeightMatrix.
+    void add(const double* weights, double v) { addWeightedScores(scoreMap.data(), weights, v); }
+
+    // Only the first NUM_EVALUATION_MODES elements are used. The rest is padding for SIMD.
+    std::array<double, EVALUATION_MODE_STRIDE> scoreMap {{}};
 };
 
 typedef CollectedSimpleSubScore CollectedSimpleMoveScore;
@@ -5,8 +5,9 @@
 
 #include <vector>
 
+#include "base/builtin.h"
+#include "base/deadline.h"
 #include "base/executor.h"
-#include "base/wait_group.h"
 #include "core/plan/plan.h"
 #include "core/core_field.h"
 #include "core/kumipuyo_seq.h"
@@ -35,6 +36,9 @@ public:
 
     // When decision sequence is specified, we consider only this decision sequence.
     void setSpecifiedDecisions(const std::vector<Decision>& decisions) { decisions_ = decisions; }
+    // When |deadline| has passed, the rest of the plans are not evaluated.
+    // Doesn't take ownership. |deadline| can be nullptr.
+    void setDeadline(const Deadline* deadline) { deadline_ = deadline; }
 
     void iterate(int frameId, const CoreField& originalField, const KumipuyoSeq& kumipuyoSeq,
                  const PlayerState& me, const PlayerState& enemy, int maxDepth);
@@ -43,7 +47,7 @@ private:
     void iterateRest(int initialFrameId,
                      const CoreField& currentField,
                      const KumipuyoSeq& kumipuyoSeq,
-                     const std::vector<Decision>& currentDecisions,
+                     DecisionStack* decisions,
                      int currentNumChigiri,
                      int currentTotalFrames,
                      int currentDepth,
@@ -54,9 +58,11 @@ private:
                      int ojamaCommittingFrameId,
                      bool hasZenkeshi,
                      const MidEvaluationResult& midEvaluationResult,
-                     WaitGroup* wg);
+                     TaskGroup* group);
 
-    void parallelEval(int currentDepth, const RefPlan& plan, const MidEvaluationResult& midEvaluationResult, WaitGroup* wg);
+    void parallelEval(int currentDepth, const RefPlan& plan, const MidEvaluationResult& midEvaluationResult, TaskGroup* group);
+
+    bool deadlineHasPassed() const { return deadline_ && deadline_->hasPassed(); }
 
      // callback: void (const CoreField&, const Decision&, bool isChigiri, int dropFrames);
     template<typename Callback>
@@ -64,6 +70,7 @@ private:
 
     Executor* executor_;
     std::vector<Decision> decisions_;
+    const Deadline* deadline_ = nullptr;
     MidEvaluationCallback midEval_;
     EvaluationCallback eval_;
 };
@@ -122,33 +129,19 @@ void DecisionPlanner<MidEvaluationResult>::iterateKumipuyoDrop(int currentDepth,
                                                                bool first,
                                                                Callback callback)
 {
-    static const Decision DECISIONS[] = {
-        Decision(2, 3), Decision(3, 3), Decision(3, 1), Decision(4, 1),
-        Decision(5, 1), Decision(1, 2), Decision(2, 2), Decision(3, 2),
-        Decision(4, 2), Decision(5, 2), Decision(6, 2),
-        Decision(1, 1), Decision(2, 1), Decision(4, 3), Decision(5, 3),
-        Decision(6, 3), Decision(1, 0), Decision(2, 0), Decision(3, 0),
-        Decision(4, 0), Decision(5, 0), Decision(6, 0),
-    };
-
     DCHECK(isNormalColor(kumipuyo.axis)) << kumipuyo.axis;
     DCHECK(isNormalColor(kumipuyo.child)) << kumipuyo.child;
 
     // Since copying CoreField is not so fast, we'd like to skip copying as many as possible.
-    int numDecisions = kumipuyo.axis == kumipuyo.child ? 11 : 22;
-    const Decision* decisionsHead = DECISIONS;
+    std::uint32_t candidateMask = kumipuyo.axis == kumipuyo.child ? (1U << 11) - 1 : (1U << 22) - 1;
 
     // When decisions are specified, we consider only such decision.
-    if (static_cast<size_t>(currentDepth) < decisions_.size()) {
-        numDecisions = 1;
-        decisionsHead = &decisions_[currentDepth];
-    }
+    if (static_cast<size_t>(currentDepth) < decisions_.size())
+        candidateMask = PuyoController::decisionBit(decisions_[currentDepth]);
 
-    for (int i = 0; i < numDecisions; ++i) {
-        const Decision& decision = decisionsHead[i];
-
-        if (!PuyoController::isReachable(currentField, decision))
-            continue;
+    std::uint32_t mask = candidateMask & PuyoController::reachableDecisionMask(currentField);
+    for (; mask; mask &= mask - 1) {
+        const Decision& decision = PuyoController::ALL_DECISIONS[countTrailingZeros32(mask)];
 
         CoreField nextField(currentField);
         if (!nextField.dropKumipuyo(decision, kumipuyo))
@@ -169,7 +162,7 @@ template<typename MidEvaluationResult>
 void DecisionPlanner<MidEvaluationResult>::iterateRest(int initialFrameId,
                                                        const CoreField& currentField,
                                                        const KumipuyoSeq& kumipuyoSeq,
-                                                       const std::vector<Decision>& currentDecisions,
+                                                       DecisionStack* decisions,
                                                        int currentNumChigiri,
                                                        int currentTotalFrames,
                                                        int currentDepth,
@@ -180,11 +173,15 @@ void DecisionPlanner<MidEvaluationResult>::iterateRest(int initialFrameId,
                                                        int ojamaCommittingFrameId,
                                                        bool hasZenkeshi,
                                                        const MidEvaluationResult& midEvaluationResult,
-                                                       WaitGroup* wg)
+                                                       TaskGroup* group)
 {
+    // |decisions| is shared among the nodes in this thread, so we need to pop the decision
+    // before returning from the callback.
     auto f = [&](CoreField&& fieldAfterDecision, const Decision& decision, bool isChigiri, int dropFrames) {
-        std::vector<Decision> decisions(currentDecisions);
-        decisions.push_back(decision);
+        if (deadlineHasPassed())
+            return;
+
+        decisions->push(decision);
 
         int newFixedOjama = fixedOjama;
         int newPendingOjama = pendingOjama;
@@ -202,9 +199,10 @@ void DecisionPlanner<MidEvaluationResult>::iterateRest(int initialFrameId,
             newHasZenkeshi = false;
             int newFallenOjama = updateOjama(frameIdToIgnite, generatedOjama, &newFixedOjama, &newPendingOjama, &newOjamaCommittingFrameId);
             int ojamaDroppingFrames = fallOjama(&fieldAfterDecision, newFallenOjama);
-            parallelEval(currentDepth, RefPlan(fieldAfterDecision, decisions, rensaResult, numChigiri, currentTotalFrames, dropFrames + ojamaDroppingFrames,
+            parallelEval(currentDepth, RefPlan(fieldAfterDecision, decisions->decisions(), rensaResult, numChigiri, currentTotalFrames, dropFrames + ojamaDroppingFrames,
                                                newFallenOjama + fallenOjama, newFixedOjama, newPendingOjama, newOjamaCommittingFrameId, newHasZenkeshi),
-                         midEvaluationResult, wg);
+                         midEvaluationResult, group);
+            decisions->pop();
             return;
         }
 
@@ -212,31 +210,35 @@ void DecisionPlanner<MidEvaluationResult>::iterateRest(int initialFrameId,
         int ojamaCount = updateOjama(frameIdToIgnite, 0, &newFixedOjama, &newPendingOjama, &newOjamaCommittingFrameId);
         int ojamaDroppingFrames = fallOjama(&fieldAfterDecision, ojamaCount);
 
-        if (fieldAfterDecision.color(3, 12) != PuyoColor::EMPTY)
+        if (fieldAfterDecision.color(3, 12) != PuyoColor::EMPTY) {
+            decisions->pop();
             return;
+        }
 
         if (currentDepth + 1 == maxDepth) {
             parallelEval(currentDepth,
-                         RefPlan(fieldAfterDecision, decisions, RensaResult(), numChigiri, currentTotalFrames, dropFrames + ojamaDroppingFrames,
+                         RefPlan(fieldAfterDecision, decisions->decisions(), RensaResult(), numChigiri, currentTotalFrames, dropFrames + ojamaDroppingFrames,
                                  ojamaCount + fallenOjama, newFixedOjama, newPendingOjama, newOjamaCommittingFrameId, newHasZenkeshi),
-                         midEvaluationResult, wg);
+                         midEvaluationResult, group);
+            decisions->pop();
             return;
         }
 
         int totalFrames = currentTotalFrames + dropFrames + ojamaDroppingFrames;
         if (executor_ && currentDepth <= 1) {
-            wg->add(1);
-            executor_->submit([=]() {
-                iterateRest(initialFrameId, fieldAfterDecision, kumipuyoSeq, decisions, numChigiri, totalFrames, currentDepth + 1, maxDepth,
+            // The task will run in another thread, so it needs its own DecisionStack.
+            std::vector<Decision> currentDecisions(decisions->decisions());
+            group->run([=]() {
+                DecisionStack taskDecisions(currentDecisions);
+                iterateRest(initialFrameId, fieldAfterDecision, kumipuyoSeq, &taskDecisions, numChigiri, totalFrames, currentDepth + 1, maxDepth,
                             fallenOjama + ojamaCount,
-                            newFixedOjama, newPendingOjama, newOjamaCommittingFrameId, newHasZenkeshi, midEvaluationResult, wg);
-
-                wg->done();
+                            newFixedOjama, newPendingOjama, newOjamaCommittingFrameId, newHasZenkeshi, midEvaluationResult, group);
             });
         } else {
             iterateRest(initialFrameId, fieldAfterDecision, kumipuyoSeq, decisions, numChigiri, totalFrames, currentDepth + 1, maxDepth,
-                        fallenOjama + ojamaCount, newFixedOjama, newPendingOjama, newOjamaCommittingFrameId, newHasZenkeshi, midEvaluationResult, wg);
+                        fallenOjama + ojamaCount, newFixedOjama, newPendingOjama, newOjamaCommittingFrameId, newHasZenkeshi, midEvaluationResult, group);
         }
+        decisions->pop();
     };
 
     iterateKumipuyoDrop(currentDepth, currentField, kumipuyoSeq.get(currentDepth), false, f);
@@ -253,9 +255,12 @@ void DecisionPlanner<MidEvaluationResult>::iterate(int initialFrameId,
     DCHECK(maxDepth >= 2);
     DCHECK(kumipuyoSeq.size() >= maxDepth);
 
-    WaitGroup wg;
+    TaskGroup group(executor_);
 
     auto f = [&](const CoreField& fieldAfterDecision, const Decision& decision, bool isChigiri, int dropFrames) {
+        if (deadlineHasPassed())
+            return;
+
         int fixedOjama = me.fixedOjama;
         int pendingOjama = me.pendingOjama;
         // TODO(mayah): Is it good to add ongoing ojama as pending ojama?
@@ -268,7 +273,8 @@ void DecisionPlanner<MidEvaluationResult>::iterate(int initialFrameId,
         int ojamaCommittingFrameId = enemy.isRensaOngoing() ? enemy.rensaFinishingFrameId() : 0;
         bool hasZenkeshi = me.hasZenkeshi;
 
-        std::vector<Decision> decisions { decision };
+        DecisionStack decisions;
+        decisions.push(decision);
 
         int numChigiri = isChigiri ? 1 : 0;
 
@@ -283,17 +289,15 @@ void DecisionPlanner<MidEvaluationResult>::iterate(int initialFrameId,
             int ojamaCount = updateOjama(currentFrameId, generatedOjama, &fixedOjama, &pendingOjama, &ojamaCommittingFrameId);
             int ojamaDroppingFrames = fallOjama(&cf, ojamaCount);
 
-            parallelEval(0, RefPlan(cf, decisions, rensaResult, numChigiri, 0, dropFrames + ojamaDroppingFrames,
+            parallelEval(0, RefPlan(cf, decisions.decisions(), rensaResult, numChigiri, 0, dropFrames + ojamaDroppingFrames,
                                     ojamaCount, fixedOjama, pendingOjama, ojamaCommittingFrameId, hasZenkeshi),
-                         MidEvaluationResult(), &wg);
+                         MidEvaluationResult(), &group);
 
             MidEvaluationResult midEvaluationResult =
-                midEval_(RefPlan(cf, decisions, rensaResult, numChigiri, 0, dropFrames + ojamaDroppingFrames,
+                midEval_(RefPlan(cf, decisions.decisions(), rensaResult, numChigiri, 0, dropFrames + ojamaDroppingFrames,
                                  ojamaCount, fixedOjama, pendingOjama, ojamaCommittingFrameId, hasZenkeshi));
-            iterateRest(initialFrameId, cf, kumipuyoSeq, decisions, numChigiri, rensaResult.frames + dropFrames + ojamaDroppingFrames,
-                        1, maxDepth, ojamaCount, fixedOjama, pendingOjama, ojamaCommittingFrameId, hasZenkeshi, midEvaluationResult, &wg);
-
-            decisions.pop_back();
+            iterateRest(initialFrameId, cf, kumipuyoSeq, &decisions, numChigiri, rensaResult.frames + dropFrames + ojamaDroppingFrames,
+                        1, maxDepth, ojamaCount, fixedOjama, pendingOjama, ojamaCommittingFrameId, hasZenkeshi, midEvaluationResult, &group);
             return;
         }
 
@@ -303,36 +307,38 @@ void DecisionPlanner<MidEvaluationResult>::iterate(int initialFrameId,
         int ojamaCount = updateOjama(currentFrameId, 0, &fixedOjama, &pendingOjama, &ojamaCommittingFrameId);
         int ojamaDroppingFrames = fallOjama(&cf, ojamaCount);
 
-        if (cf.color(3, 12) != PuyoColor::EMPTY) {
-            decisions.pop_back();
+        if (cf.color(3, 12) != PuyoColor::EMPTY)
             return;
-        }
 
         MidEvaluationResult midEvaluationResult =
-            midEval_(RefPlan(cf, decisions, RensaResult(), numChigiri, 0, dropFrames + ojamaDroppingFrames,
+            midEval_(RefPlan(cf, decisions.decisions(), RensaResult(), numChigiri, 0, dropFrames + ojamaDroppingFrames,
                              ojamaCount, fixedOjama, pendingOjama, ojamaCommittingFrameId, me.hasZenkeshi));
 
-        iterateRest(initialFrameId, cf, kumipuyoSeq, decisions, numChigiri, dropFrames + ojamaDroppingFrames, 1, maxDepth,
-                    ojamaCount, fixedOjama, pendingOjama, ojamaCommittingFrameId, hasZenkeshi, midEvaluationResult, &wg);
+        iterateRest(initialFrameId, cf, kumipuyoSeq, &decisions, numChigiri, dropFrames + ojamaDroppingFrames, 1, maxDepth,
+                    ojamaCount, fixedOjama, pendingOjama, ojamaCommittingFrameId, hasZenkeshi, midEvaluationResult, &group);
 
     };
 
     iterateKumipuyoDrop(0, originalField, kumipuyoSeq.get(0), true, f);
-    wg.waitUntilDone();
+    group.wait();
 }
 
 template<typename MidEvaluationResult>
 void DecisionPlanner<MidEvaluationResult>::parallelEval(int currentDepth, const RefPlan& refPlan,
-                                                        const MidEvaluationResult& midEvaluationResult, WaitGroup* wg)
+                                                        const MidEvaluationResult& midEvaluationResult, TaskGroup* group)
 {
+    if (deadlineHasPassed())
+        return;
+
     // We only submit a task to executor when currentDepth <= 1. (current + next).
     // If we submit a task for currentDepth == 2, the number of task is too much, and overhead is high.
     if (executor_ && currentDepth <= 1) {
-        wg->add(1);
         Plan plan(refPlan.toPlan());
-        executor_->submit([this, plan, midEvaluationResult, wg]() {
-                this->eval_(RefPlan(plan), midEvaluationResult);
-                wg->done();
+        group->run([this, plan, midEvaluationResult]() {
+            // The task might have waited in the queue until the deadline.
+            if (this->deadlineHasPassed())
+                return;
+            this->eval_(RefPlan(plan), midEvaluationResult);
         });
     } else {
         eval_(refPlan, midEvaluationResult);
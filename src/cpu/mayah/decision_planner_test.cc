@@ -101,3 +101,28 @@ TEST(DecisionPlannerTest, numChigiri)
     runTest(field, seq, 2, f);
     EXPECT_TRUE(found);
 }
+
+TEST(DecisionPlannerTest, deadline)
+{
+    CoreField field;
+    KumipuyoSeq kumipuyoSeq("RRBBYY");
+    PlayerState me;
+    PlayerState enemy;
+
+    int numEvaluated = 0;
+    auto f = [&](const RefPlan&, const Unit&) { ++numEvaluated; };
+
+    Deadline never;
+    DecisionPlanner<Unit> planner(unitMidEvaluator, f);
+    planner.setDeadline(&never);
+    planner.iterate(100, field, kumipuyoSeq, me, enemy, 2);
+    EXPECT_LT(0, numEvaluated);
+    EXPECT_FALSE(never.wasHit());
+
+    numEvaluated = 0;
+    Deadline passed = Deadline::afterMillis(0);
+    planner.setDeadline(&passed);
+    planner.iterate(100, field, kumipuyoSeq, me, enemy, 2);
+    EXPECT_EQ(0, numEvaluated);
+    EXPECT_TRUE(passed.wasHit());
+}
@@ -59,3 +59,38 @@ const EvaluationRensaSparseFeature EvaluationRensaSparseFeatures::features_[] {
 
 const EvaluationRensaSparseFeature* EvaluationRensaSparseFeatures::begin() const { return std::begin(features_); }
 const EvaluationRensaSparseFeature* EvaluationRensaSparseFeatures::end() const { return std::end(features_); }
+
+const int EvaluationMoveFeatureSet::sparseDenseOffsets_[] {
+#define DEFINE_MOVE_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_MOVE_SPARSE_PARAM(NAME, numValue, tweakability) DENSE_##NAME,
+#define DEFINE_RENSA_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_RENSA_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#include "evaluation_feature.tab"
+#undef DEFINE_MOVE_PARAM
+#undef DEFINE_MOVE_SPARSE_PARAM
+#undef DEFINE_RENSA_PARAM
+#undef DEFINE_RENSA_SPARSE_PARAM
+};
+
+const int EvaluationRensaFeatureSet::sparseDenseOffsets_[] {
+#define DEFINE_MOVE_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_MOVE_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#define DEFINE_RENSA_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_RENSA_SPARSE_PARAM(NAME, numValue, tweakability) DENSE_##NAME,
+#include "evaluation_feature.tab"
+#undef DEFINE_MOVE_PARAM
+#undef DEFINE_MOVE_SPARSE_PARAM
+#undef DEFINE_RENSA_PARAM
+#undef DEFINE_RENSA_SPARSE_PARAM
+};
+
+// The features should come first in the dense layout, so that denseIndex(key) == key.
+#define DEFINE_MOVE_PARAM(NAME, tweakability) static_assert(static_cast<int>(DENSE_##NAME) == static_cast<int>(NAME), #NAME);
+#define DEFINE_MOVE_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#define DEFINE_RENSA_PARAM(NAME, tweakability) static_assert(static_cast<int>(DENSE_##NAME) == static_cast<int>(NAME), #NAME);
+#define DEFINE_RENSA_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#include "evaluation_feature.tab"
+#undef DEFINE_MOVE_PARAM
+#undef DEFINE_MOVE_SPARSE_PARAM
+#undef DEFINE_RENSA_PARAM
+#undef DEFINE_RENSA_SPARSE_PARAM
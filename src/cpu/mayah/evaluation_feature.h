@@ -63,6 +63,55 @@ enum EvaluationRensaSparseFeatureKey {
 #undef DEFINE_RENSA_SPARSE_PARAM
 };
 
+// The dense layout of all the features, which is used by EvaluationWeightMatrix.
+// A feature takes one element, and a sparse feature takes |numValue| elements.
+// The features come first, so the index of a feature is the same as its key.
+enum EvaluationMoveDenseIndex {
+#define DEFINE_MOVE_PARAM(NAME, tweakability) DENSE_##NAME,
+#define DEFINE_MOVE_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#define DEFINE_RENSA_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_RENSA_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#include "evaluation_feature.tab"
+#undef DEFINE_MOVE_PARAM
+#undef DEFINE_MOVE_SPARSE_PARAM
+#undef DEFINE_RENSA_PARAM
+#undef DEFINE_RENSA_SPARSE_PARAM
+
+#define DEFINE_MOVE_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_MOVE_SPARSE_PARAM(NAME, numValue, tweakability) DENSE_##NAME, DENSE_##NAME##_LAST = DENSE_##NAME + (numValue) - 1,
+#define DEFINE_RENSA_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_RENSA_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#include "evaluation_feature.tab"
+#undef DEFINE_MOVE_PARAM
+#undef DEFINE_MOVE_SPARSE_PARAM
+#undef DEFINE_RENSA_PARAM
+#undef DEFINE_RENSA_SPARSE_PARAM
+    EVALUATION_MOVE_DENSE_SIZE
+};
+
+enum EvaluationRensaDenseIndex {
+#define DEFINE_MOVE_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_MOVE_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#define DEFINE_RENSA_PARAM(NAME, tweakability) DENSE_##NAME,
+#define DEFINE_RENSA_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#include "evaluation_feature.tab"
+#undef DEFINE_MOVE_PARAM
+#undef DEFINE_MOVE_SPARSE_PARAM
+#undef DEFINE_RENSA_PARAM
+#undef DEFINE_RENSA_SPARSE_PARAM
+
+#define DEFINE_MOVE_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_MOVE_SPARSE_PARAM(NAME, numValue, tweakability) /* ignored */
+#define DEFINE_RENSA_PARAM(NAME, tweakability) /* ignored */
+#define DEFINE_RENSA_SPARSE_PARAM(NAME, numValue, tweakability) DENSE_##NAME, DENSE_##NAME##_LAST = DENSE_##NAME + (numValue) - 1,
+#include "evaluation_feature.tab"
+#undef DEFINE_MOVE_PARAM
+#undef DEFINE_MOVE_SPARSE_PARAM
+#undef DEFINE_RENSA_PARAM
+#undef DEFINE_RENSA_SPARSE_PARAM
+    EVALUATION_RENSA_DENSE_SIZE
+};
+
 template<typename FeatureKey>
 class EvaluationFeature {
 public:
@@ -177,8 +226,16 @@ public:
   typedef EvaluationMoveFeatureKey FeatureKey;
   typedef EvaluationMoveSparseFeatureKey SparseFeatureKey;
 
+  static const int DENSE_SIZE = EVALUATION_MOVE_DENSE_SIZE;
+
   static EvaluationMoveFeatures features() { return EvaluationMoveFeatures(); }
   static EvaluationMoveSparseFeatures sparseFeatures() { return EvaluationMoveSparseFeatures(); }
+
+  static int denseIndex(FeatureKey key) { return key; }
+  static int denseIndex(SparseFeatureKey key, int idx) { return sparseDenseOffsets_[key] + idx; }
+
+private:
+  static const int sparseDenseOffsets_[];
 };
 
 class EvaluationRensaFeatureSet {
@@ -186,8 +243,16 @@ public:
   typedef EvaluationRensaFeatureKey FeatureKey;
   typedef EvaluationRensaSparseFeatureKey SparseFeatureKey;
 
+  static const int DENSE_SIZE = EVALUATION_RENSA_DENSE_SIZE;
+
   static EvaluationRensaFeatures features() { return EvaluationRensaFeatures(); }
   static EvaluationRensaSparseFeatures sparseFeatures() { return EvaluationRensaSparseFeatures(); }
+
+  static int denseIndex(FeatureKey key) { return key; }
+  static int denseIndex(SparseFeatureKey key, int idx) { return sparseDenseOffsets_[key] + idx; }
+
+private:
+  static const int sparseDenseOffsets_[];
 };
 
 #endif // CPU_MAYAH_EVALUATION_FEATURE_H_
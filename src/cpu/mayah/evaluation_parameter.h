@@ -13,6 +13,7 @@
 
 #include "base/base.h"
 #include "evaluation_feature.h"
+#include "evaluation_weight_matrix.h"
 #include "evaluation_mode.h"
 
 template<typename FeatureSet>
@@ -212,24 +213,32 @@ public:
         return defaultParam_.param(key, idx);
     }
 
+    // The resolved parameters of all the modes, laid out by the dense feature index.
+    // This is kept up to date by the setters.
+    const EvaluationWeightMatrix<FeatureSet>& weights() const { return weights_; }
+
     void setParam(EvaluationMode mode, FeatureKey key, double value)
     {
         params_[ordinal(mode)].setParam(key, value);
+        updateWeights(key);
     }
 
     void setParam(EvaluationMode mode, SparseFeatureKey key, int index, double value)
     {
         params_[ordinal(mode)].setParam(key, index, value);
+        updateWeights(key);
     }
 
     void setDefault(FeatureKey key, double value)
     {
         defaultParam_.setParam(key, value);
+        updateWeights(key);
     }
 
     void setDefault(SparseFeatureKey key, int index, double value)
     {
         defaultParam_.setParam(key, index, value);
+        updateWeights(key);
     }
 
     void removeNontokopuyoParameter()
@@ -238,6 +247,7 @@ public:
         for (auto& param : params_) {
             param.removeNontokopuyoParameter();
         }
+        updateAllWeights();
     }
 
     void clear()
@@ -246,6 +256,7 @@ public:
         for (auto& param : params_) {
             param.clear();
         }
+        weights_.clear();
     }
 
     toml::Value toTomlValue(const std::string& anotherKey) const
@@ -288,24 +299,55 @@ public:
             const toml::Value* v = value.find(modeKey);
             if (!v)
                 continue;
-            if (!params_[ordinal(mode)].loadValue(*v))
+            if (!params_[ordinal(mode)].loadValue(*v)) {
+                updateAllWeights();
                 return false;
+            }
         }
 
         {
             std::string defaultKey = std::string("mode.default.") + anotherKey;
             const toml::Value* v = value.find(defaultKey);
             CHECK(v != nullptr) << defaultKey << "was not found.";
-            if (!defaultParam_.loadValue(*v))
+            if (!defaultParam_.loadValue(*v)) {
+                updateAllWeights();
                 return false;
+            }
         }
 
+        updateAllWeights();
         return true;
     }
 
 private:
+    // A setter of a key can change the parameter of any mode that falls back to the default,
+    // so all the modes are resolved again.
+    void updateWeights(FeatureKey key)
+    {
+        for (const auto& mode : ALL_EVALUATION_MODES)
+            weights_.setWeight(mode, key, param(mode, key));
+    }
+
+    void updateWeights(SparseFeatureKey key)
+    {
+        const size_t size = toFeature(key).size();
+        for (const auto& mode : ALL_EVALUATION_MODES) {
+            for (size_t i = 0; i < size; ++i)
+                weights_.setWeight(mode, key, i, param(mode, key, i));
+        }
+    }
+
+    void updateAllWeights()
+    {
+        for (const auto& ef : FeatureSet::features())
+            updateWeights(ef.key());
+        for (const auto& ef : FeatureSet::sparseFeatures())
+            updateWeights(ef.key());
+    }
+
     Param defaultParam_;
     std::array<Param, NUM_EVALUATION_MODES> params_;
+    EvaluationWeightMatrix<FeatureSet> weights_;
 };
 
 typedef EvaluationParameterSet<EvaluationMoveParameter, EvaluationMoveFeatureSet> EvaluationMoveParameterSet;
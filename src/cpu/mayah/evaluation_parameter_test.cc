@@ -24,3 +24,33 @@ TEST(EvaluationParameterTest, setter)
     EXPECT_EQ(2.0, m.moveParamSet().param(EvaluationMode::EARLY, TOTAL_FRAMES));
     EXPECT_EQ(1.0, m.moveParamSet().param(EvaluationMode::MIDDLE, TOTAL_FRAMES));
 }
+
+TEST(EvaluationParameterTest, weights)
+{
+    EvaluationParameterMap m;
+    m.mutableMoveParamSet()->setParam(EvaluationMode::EARLY, TOTAL_FRAMES, 2.0);
+    m.mutableMoveParamSet()->setDefault(TOTAL_FRAMES, 1.0);
+    m.mutableMoveParamSet()->setDefault(VALLEY_DEPTH, 3, 4.0);
+
+    const EvaluationMoveWeightMatrix& weights = m.moveParamSet().weights();
+    EXPECT_EQ(2.0, weights.weight(EvaluationMode::EARLY, TOTAL_FRAMES));
+    EXPECT_EQ(1.0, weights.weight(EvaluationMode::MIDDLE, TOTAL_FRAMES));
+    EXPECT_EQ(4.0, weights.weight(EvaluationMode::LATE, VALLEY_DEPTH, 3));
+
+    // Once a mode has its own sparse parameter, the default is not used for any index.
+    m.mutableMoveParamSet()->setParam(EvaluationMode::LATE, VALLEY_DEPTH, 1, 5.0);
+    EXPECT_EQ(0.0, weights.weight(EvaluationMode::LATE, VALLEY_DEPTH, 3));
+    EXPECT_EQ(5.0, weights.weight(EvaluationMode::LATE, VALLEY_DEPTH, 1));
+    EXPECT_EQ(4.0, weights.weight(EvaluationMode::MIDDLE, VALLEY_DEPTH, 3));
+
+    EvaluationParameterMap loaded;
+    ASSERT_TRUE(loaded.loadValue(m.toTomlValue()));
+    for (const auto& mode : ALL_EVALUATION_MODES) {
+        EXPECT_EQ(weights.weight(mode, TOTAL_FRAMES), loaded.moveParamSet().weights().weight(mode, TOTAL_FRAMES));
+        for (int i = 0; i < 15; ++i)
+            EXPECT_EQ(weights.weight(mode, VALLEY_DEPTH, i), loaded.moveParamSet().weights().weight(mode, VALLEY_DEPTH, i));
+    }
+
+    m.mutableMoveParamSet()->clear();
+    EXPECT_EQ(0.0, weights.weight(EvaluationMode::EARLY, TOTAL_FRAMES));
+}
@@ -0,0 +1,70 @@
+#ifndef CPU_MAYAH_EVALUATION_WEIGHT_MATRIX_H_
+#define CPU_MAYAH_EVALUATION_WEIGHT_MATRIX_H_
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <x86intrin.h>
+#endif
+
+#include "evaluation_feature.h"
+#include "evaluation_mode.h"
+
+// The scores and the weights of all the modes are padded to EVALUATION_MODE_STRIDE,
+// so that they can be handled with 2 AVX registers.
+const int EVALUATION_MODE_STRIDE = 8;
+static_assert(NUM_EVALUATION_MODES <= EVALUATION_MODE_STRIDE, "all the modes should fit in the stride");
+
+// scores[i] += weights[i] * v for all the modes.
+inline void addWeightedScores(double* scores, const double* weights, double v)
+{
+#if defined(__AVX2__) && defined(__FMA__)
+    const __m256d x = _mm256_set1_pd(v);
+    _mm256_storeu_pd(scores, _mm256_fmadd_pd(_mm256_loadu_pd(weights), x, _mm256_loadu_pd(scores)));
+    _mm256_storeu_pd(scores + 4, _mm256_fmadd_pd(_mm256_loadu_pd(weights + 4), x, _mm256_loadu_pd(scores + 4)));
+#else
+    for (int i = 0; i < EVALUATION_MODE_STRIDE; ++i)
+        scores[i] += weights[i] * v;
+#endif
+}
+
+// EvaluationWeightMatrix has the parameters of all the modes, resolved with the default
+// parameters. The rows are laid out by FeatureSet::denseIndex(), and each row has
+// the weights of all the modes. So the score of a feature in all the modes is
+// computed with one SIMD multiply-add, instead of looking up the parameter of each mode.
+template<typename FeatureSet>
+class EvaluationWeightMatrix {
+public:
+    typedef typename FeatureSet::FeatureKey FeatureKey;
+    typedef typename FeatureSet::SparseFeatureKey SparseFeatureKey;
+
+    EvaluationWeightMatrix() : weights_(FeatureSet::DENSE_SIZE * EVALUATION_MODE_STRIDE) {}
+
+    const double* row(FeatureKey key) const { return row(FeatureSet::denseIndex(key)); }
+    const double* row(SparseFeatureKey key, int idx) const { return row(FeatureSet::denseIndex(key, idx)); }
+
+    double weight(EvaluationMode mode, FeatureKey key) const { return row(key)[ordinal(mode)]; }
+    double weight(EvaluationMode mode, SparseFeatureKey key, int idx) const { return row(key, idx)[ordinal(mode)]; }
+
+    void setWeight(EvaluationMode mode, FeatureKey key, double w)
+    {
+        weights_[FeatureSet::denseIndex(key) * EVALUATION_MODE_STRIDE + ordinal(mode)] = w;
+    }
+    void setWeight(EvaluationMode mode, SparseFeatureKey key, int idx, double w)
+    {
+        weights_[FeatureSet::denseIndex(key, idx) * EVALUATION_MODE_STRIDE + ordinal(mode)] = w;
+    }
+
+    void clear() { std::fill(weights_.begin(), weights_.end(), 0.0); }
+
+private:
+    const double* row(int index) const { return weights_.data() + index * EVALUATION_MODE_STRIDE; }
+
+    std::vector<double> weights_;
+};
+
+typedef EvaluationWeightMatrix<EvaluationMoveFeatureSet> EvaluationMoveWeightMatrix;
+typedef EvaluationWeightMatrix<EvaluationRensaFeatureSet> EvaluationRensaWeightMatrix;
+
+#endif // CPU_MAYAH_EVALUATION_WEIGHT_MATRIX_H_
@@ -290,7 +290,8 @@ void Evaluator<ScoreCollector>::eval(const RefPlan& plan,
                                      const MidEvalResult& midEvalResult,
                                      bool fast,
                                      bool usesRensaHandTree,
-                                     const GazeResult& gazeResult)
+                                     const GazeResult& gazeResult,
+                                     const Deadline* deadline)
 {
     typedef typename ScoreCollector::RensaScoreCollector RensaScoreCollector;
     typedef typename RensaScoreCollector::CollectedScore RensaCollectedScore;
@@ -329,7 +330,7 @@ void Evaluator<ScoreCollector>::eval(const RefPlan& plan,
         RensaCollectedScore collectedScore;
     } sideRensa;
 
-    RensaHandNodeMaker handTreeMaker(2, restSeq);
+    RensaHandNodeMaker handTreeMaker(2, restSeq, nullptr, deadline);
     auto evalCallback = [&](const CoreField& fieldAfterRensa,
                             const RensaResult& rensaResult,
                             const ColumnPuyoList& puyosToComplement,
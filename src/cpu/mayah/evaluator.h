@@ -11,6 +11,7 @@
 
 class ColumnPuyoList;
 class CoreField;
+class Deadline;
 class GazeResult;
 class KumipuyoSeq;
 class RefPlan;
@@ -93,9 +94,11 @@ public:
         EvaluatorBase(patternBook),
         sc_(sc) {}
 
+    // When |deadline| passes, the rensa hand tree has only the rensas found so far.
     void eval(const RefPlan&, const KumipuyoSeq&, int currentFrameId, int maxIteration,
               const PlayerState& me, const PlayerState& enemy,
-              const MidEvalResult&, bool fast, bool usesRensaHandTree, const GazeResult&);
+              const MidEvalResult&, bool fast, bool usesRensaHandTree, const GazeResult&,
+              const Deadline* deadline = nullptr);
 
     // ----------------------------------------------------------------------
 
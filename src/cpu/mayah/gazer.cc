@@ -214,7 +214,7 @@ void Gazer::gaze(int frameId, const CoreField& originalField, const KumipuyoSeq&
 
     // PossibleRensaHandTree.
     // We'd like make the depth 3, but eval() gets really slow (2~3 ms each hand.)
-    RensaHandTree tree = RensaHandTree::makeTree(2, originalField, PuyoSet(), 0, kumipuyoSeq);
+    RensaHandTree tree = RensaHandTree::makeTree(2, originalField, PuyoSet(), 0, kumipuyoSeq, executor_);
     LOG(INFO) << "Possible:" << endl << tree.toString();
 
     gazeResult_.setPossibleRensaHandTree(std::move(tree));
@@ -46,11 +46,15 @@ private:
 
 class Gazer : noncopyable {
 public:
+    // When |executor| is not nullptr, the rensas of the enemy are detected in parallel with it.
+    explicit Gazer(Executor* executor = nullptr) : executor_(executor) {}
+
     void initialize(int frameIdGameWillBegin);
     void gaze(int frameId, const CoreField&, const KumipuyoSeq&);
 
     const GazeResult& gazeResult() const { return gazeResult_; }
 private:
+    Executor* executor_;
     GazeResult gazeResult_;
 };
 
@@ -38,9 +38,16 @@ MayahAI::~MayahAI()
 
 DropDecision MayahAI::think(int frame_id, const CoreField& f, const KumipuyoSeq& kumipuyo_seq,
                             const PlayerState& me, const PlayerState& enemy, bool fast) const
+{
+    return thinkWithDeadline(frame_id, f, kumipuyo_seq, me, enemy, fast, Deadline());
+}
+
+DropDecision MayahAI::thinkWithDeadline(int frame_id, const CoreField& f, const KumipuyoSeq& kumipuyo_seq,
+                                        const PlayerState& me, const PlayerState& enemy, bool fast,
+                                        const Deadline& deadline) const
 {
     return pattern_thinker_->think(frame_id, f, kumipuyo_seq, me, enemy, gazer_.gazeResult(), fast,
-                                   usesDecisionBook_, usesRensaHandTree_);
+                                   usesDecisionBook_, usesRensaHandTree_, deadline);
 }
 
 ThoughtResult MayahAI::thinkPlan(int frameId, const CoreField& cf, const KumipuyoSeq& seq,
@@ -20,6 +20,9 @@ public:
 
     DropDecision think(int frameId, const CoreField&, const KumipuyoSeq&,
                        const PlayerState& me, const PlayerState& enemy, bool fast) const override;
+    DropDecision thinkWithDeadline(int frameId, const CoreField&, const KumipuyoSeq&,
+                                   const PlayerState& me, const PlayerState& enemy, bool fast,
+                                   const Deadline&) const override;
     ThoughtResult thinkPlan(int frameId, const CoreField&, const KumipuyoSeq&,
                             const PlayerState& me, const PlayerState& enemy,
                             int depth, int maxIteration, bool fast = false,
@@ -2,6 +2,9 @@
 
 #include "base/file/path.h"
 #include "core/frame_request.h"
+#include "core/rensa/rensa_detection_cache.h"
+
+#include "rensa_hand_tree.h"
 
 DEFINE_string(feature, SRC_DIR "/cpu/mayah/feature.toml", "the path to feature parameter");
 DEFINE_string(decision_book, SRC_DIR "/cpu/mayah/decision.toml", "the path to decision book");
@@ -13,7 +16,8 @@ using namespace std;
 
 MayahBaseAI::MayahBaseAI(int argc, char* argv[], const char* name, std::unique_ptr<Executor> executor) :
     AI(argc, argv, name),
-    executor_(std::move(executor))
+    executor_(std::move(executor)),
+    gazer_(executor_.get())
 {
     loadEvaluationParameter();
 
@@ -74,13 +78,17 @@ bool MayahBaseAI::saveEvaluationParameter() const
 }
 
 DropDecision MayahBaseAI::thinkByBeamSearch(int frame_id, const CoreField& field, const KumipuyoSeq& seq,
-                                            const PlayerState& me, const PlayerState& enemy, bool fast) const
+                                            const PlayerState& me, const PlayerState& enemy, bool fast,
+                                            const Deadline& deadline) const
 {
-    return beam_thinker_->think(frame_id, field, seq, me, enemy, fast);
+    return beam_thinker_->think(frame_id, field, seq, me, enemy, fast, deadline);
 }
 
 void MayahBaseAI::onGameWillBegin(const FrameRequest& frameRequest)
 {
+    if (const RensaDetectionCache* cache = RensaHandTree::detectionCache())
+        LOG(INFO) << "rensa detection cache: " << cache->stats().toString();
+
     gazer_.initialize(frameRequest.frameId);
 }
 
@@ -30,7 +30,8 @@ protected:
     bool saveEvaluationParameter() const;
 
     DropDecision thinkByBeamSearch(int frameId, const CoreField&, const KumipuyoSeq&,
-                                   const PlayerState& me, const PlayerState& enemy, bool fast) const;
+                                   const PlayerState& me, const PlayerState& enemy, bool fast,
+                                   const Deadline& deadline = Deadline()) const;
 
     EvaluationParameterMap evaluationParameterMap_;
     DecisionBook decisionBook_;
@@ -21,7 +21,8 @@ PatternThinker::PatternThinker(const EvaluationParameterMap& evaluationParameter
 DropDecision PatternThinker::think(int frame_id, const CoreField& field, const KumipuyoSeq& kumipuyo_seq,
                                    const PlayerState& me, const PlayerState& enemy,
                                    const GazeResult& gazeResult, bool fast,
-                                   bool usesDecisionBook, bool usesRensaHandTree) const
+                                   bool usesDecisionBook, bool usesRensaHandTree,
+                                   const Deadline& deadline) const
 {
     int depth;
     int iteration;
@@ -33,7 +34,30 @@ DropDecision PatternThinker::think(int frame_id, const CoreField& field, const K
         iteration = DEFAULT_NUM_ITERATION;
     }
 
-    ThoughtResult thoughtResult = thinkPlan(frame_id, field, kumipuyo_seq, me, enemy, depth, iteration, gazeResult, fast, usesDecisionBook, usesRensaHandTree);
+    // The base depth is always searched to the end, so we have a complete result even if
+    // the deadline is tight.
+    double beginTime = currentTime();
+    ThoughtResult thoughtResult = thinkPlan(frame_id, field, kumipuyo_seq, me, enemy, depth, iteration, gazeResult, fast,
+                                            usesDecisionBook, usesRensaHandTree);
+    double elapsedSeconds = currentTime() - beginTime;
+
+    // Iterative deepening: while we have time, search deeper with the known kumipuyos.
+    // A deeper search is started only when it's expected to finish before the deadline.
+    // A search stopped by the deadline hasn't seen all the plans, so its result is discarded.
+    // Without a deadline, the depth is fixed so that the result is reproducible.
+    if (!fast && !deadline.isInfinite()) {
+        for (int d = depth + 1; d <= MAX_DEPTH && d <= kumipuyo_seq.size(); ++d) {
+            if (deadline.remainingSeconds() < elapsedSeconds * ESTIMATED_BRANCHING_FACTOR)
+                break;
+            beginTime = currentTime();
+            ThoughtResult deeper = thinkPlan(frame_id, field, kumipuyo_seq, me, enemy, d, iteration, gazeResult, fast,
+                                             usesDecisionBook, usesRensaHandTree, nullptr, &deadline);
+            if (deadline.hasPassed())
+                break;
+            elapsedSeconds = currentTime() - beginTime;
+            thoughtResult = deeper;
+        }
+    }
 
     const Plan& plan = thoughtResult.plan;
     if (plan.decisions().empty())
@@ -47,7 +71,8 @@ ThoughtResult PatternThinker::thinkPlan(int frameId, const CoreField& field, con
                                         const GazeResult& gazeResult,
                                         bool fast,
                                         bool usesDecisionBook, bool usesRensaHandTree,
-                                        vector<Decision>* specifiedDecisions) const
+                                        vector<Decision>* specifiedDecisions,
+                                        const Deadline* deadline) const
 {
     // TODO(mayah): Do we need field and kumipuyoSeq?
     // CHECK(field, me.field);
@@ -109,7 +134,8 @@ ThoughtResult PatternThinker::thinkPlan(int frameId, const CoreField& field, con
     auto evalRefPlan = [&, this, frameId, maxIteration](const RefPlan& plan, const MidEvalResult& midEvalResult) {
         KumipuyoSeq restSeq(kumipuyoSeq.subsequence(plan.decisions().size()));
         // Here, we iterate enemy's possible rensa.
-        EvalResult evalResult = eval(plan, restSeq, frameId, maxIteration, me, enemy, midEvalResult, fast, usesRensaHandTree, gazeResult);
+        EvalResult evalResult = eval(plan, restSeq, frameId, maxIteration, me, enemy, midEvalResult, fast, usesRensaHandTree, gazeResult,
+                                     deadline);
         Plan evaledPlan = plan.toPlan();
 
         // Hmm, it looks weaker if we search this...
@@ -183,6 +209,7 @@ ThoughtResult PatternThinker::thinkPlan(int frameId, const CoreField& field, con
     DecisionPlanner<MidEvalResult> planner(executor_, evalMidEval, evalRefPlan);
     if (specifiedDecisions)
         planner.setSpecifiedDecisions(*specifiedDecisions);
+    planner.setDeadline(deadline);
     planner.iterate(frameId, field, kumipuyoSeq, me, enemy, depth);
 
     if (!ojamaFallen && bestVirtualRensaScore < bestRensaScore) {
@@ -228,11 +255,13 @@ EvalResult PatternThinker::eval(const RefPlan& plan,
                                 const PlayerState& me, const PlayerState& enemy,
                                 const MidEvalResult& midEvalResult,
                                 bool fast, bool usesRensaHandTree,
-                                const GazeResult& gazeResult) const
+                                const GazeResult& gazeResult,
+                                const Deadline* deadline) const
 {
     SimpleScoreCollector sc(evaluationParameterMap_);
     Evaluator<SimpleScoreCollector> evaluator(patternBook_, &sc);
-    evaluator.eval(plan, restSeq, currentFrameId, maxIteration, me, enemy, midEvalResult, fast, usesRensaHandTree, gazeResult);
+    evaluator.eval(plan, restSeq, currentFrameId, maxIteration, me, enemy, midEvalResult, fast, usesRensaHandTree, gazeResult,
+                   deadline);
 
     const CollectedSimpleScore& simpleScore = sc.collectedScore();
     return EvalResult(simpleScore.score(sc.collectedCoef()), sc.estimatedRensaScore());
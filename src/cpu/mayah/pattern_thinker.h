@@ -1,6 +1,7 @@
 #ifndef CPU_MAYAH_PATTERN_THINKER_H_
 #define CPU_MAYAH_PATTERN_THINKER_H_
 
+#include "base/deadline.h"
 #include "base/executor.h"
 #include "base/time.h"
 #include "core/client/ai/ai.h"
@@ -35,6 +36,11 @@ public:
     static const int DEFAULT_NUM_ITERATION = 3;
     static const int FAST_DEPTH = 2;
     static const int FAST_NUM_ITERATION = 2;
+    // When the deadline allows, the depth is deepened up to this.
+    static const int MAX_DEPTH = 3;
+    // A search one depth deeper is expected to take this times longer.
+    // One kumipuyo can be placed in 22 ways.
+    static const int ESTIMATED_BRANCHING_FACTOR = 22;
 
     PatternThinker(const EvaluationParameterMap& evaluationParameterMap,
                    const DecisionBook& decisionBook,
@@ -44,15 +50,18 @@ public:
     DropDecision think(int frameId, const CoreField& f, const KumipuyoSeq& kumipuyoSeq,
                        const PlayerState& me, const PlayerState& enemy,
                        const GazeResult& gazeResult, bool fast,
-                       bool usesDecisionBook, bool usesRensaHandTree) const;
+                       bool usesDecisionBook, bool usesRensaHandTree,
+                       const Deadline& deadline = Deadline()) const;
 
     // Use this directly in test. Otherwise, use via think.
     // When |specifiedDecisionsOnly| is specified, only that decision will be considered.
+    // When |deadline| has passed, the best plan found so far is returned.
     ThoughtResult thinkPlan(int frameId, const CoreField&, const KumipuyoSeq&,
                             const PlayerState& me, const PlayerState& enemy,
                             int depth, int maxIteration, const GazeResult&, bool fast = false,
                             bool usesDecisionBook = true, bool usesRensaHandTree = true,
-                            std::vector<Decision>* specifiedDecisions = nullptr) const;
+                            std::vector<Decision>* specifiedDecisions = nullptr,
+                            const Deadline* deadline = nullptr) const;
 
     CollectedFeatureCoefScore evalWithCollectingFeature(
         const RefPlan&, const KumipuyoSeq& restSeq, int currentFrameId, int maxIteration,
@@ -67,7 +76,8 @@ private:
                           const GazeResult&, bool usesRensaHandTree) const;
     EvalResult eval(const RefPlan&, const KumipuyoSeq& restSeq, int currentFrameId, int maxIteration,
                     const PlayerState& me, const PlayerState& enemy,
-                    const MidEvalResult&, bool fast, bool usesRensaHandTree, const GazeResult&) const;
+                    const MidEvalResult&, bool fast, bool usesRensaHandTree, const GazeResult&,
+                    const Deadline* deadline = nullptr) const;
 
     std::string makeMessageFrom(int frameId, const KumipuyoSeq&, int maxIteration,
                                 const PlayerState& me, const PlayerState& enemy,
@@ -1,9 +1,14 @@
 #include "rensa_hand_tree.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <memory>
 #include <sstream>
 
+#include <gflags/gflags.h>
+
+#include "core/rensa/rensa_detection_cache.h"
 #include "core/rensa/rensa_detector.h"
 #include "core/core_field.h"
 #include "core/frame.h"
@@ -11,6 +16,8 @@
 #include "core/probability/puyo_set_probability.h"
 #include "core/probability/puyo_set.h"
 
+DEFINE_int32(rensa_detection_cache_mb, 32, "the size of the cache of rensa detection for RensaHandTree (MB). 0 to disable.");
+
 using namespace std;
 
 namespace {
@@ -60,12 +67,26 @@ void RensaHandTree::dumpTo(int depth, ostream* os) const
     }
 }
 
+// static
+RensaDetectionCache* RensaHandTree::detectionCache()
+{
+    static unique_ptr<RensaDetectionCache> s_cache = []() {
+        unique_ptr<RensaDetectionCache> cache;
+        if (FLAGS_rensa_detection_cache_mb > 0)
+            cache.reset(new RensaDetectionCache(FLAGS_rensa_detection_cache_mb));
+        return cache;
+    }();
+    return s_cache.get();
+}
+
 // static
 RensaHandTree RensaHandTree::makeTree(int restIteration,
                                       const CoreField& currentField,
                                       const PuyoSet& usedPuyoSet,
                                       int usedPuyoMoveFrames,
-                                      const KumipuyoSeq& wholeKumipuyoSeq)
+                                      const KumipuyoSeq& wholeKumipuyoSeq,
+                                      Executor* executor,
+                                      const Deadline* deadline)
 {
     if (restIteration <= 0)
         return RensaHandTree();
@@ -75,13 +96,20 @@ RensaHandTree RensaHandTree::makeTree(int restIteration,
         CoreField field(currentField);
         const int dropFrames = field.fallOjama(ojamaLines);
 
-        RensaHandNodeMaker maker(restIteration, wholeKumipuyoSeq);
+        RensaHandNodeMaker maker(restIteration, wholeKumipuyoSeq, executor, deadline);
         auto callback = [&](CoreField&& cf, const ColumnPuyoList& puyosToComplement) -> RensaResult {
             int frames = usedPuyoMoveFrames + dropFrames;
             // frames += static_cast<int>(ColumnPuyoListProbability::instanceSlow()->necessaryKumipuyos(puyosToComplement) * NUM_FRAMES_OF_ONE_HAND / 2);
             return maker.add(std::move(cf), puyosToComplement, frames, usedPuyoSet);
         };
-        RensaDetector::detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 3, callback);
+        if (RensaDetectionCache* cache = detectionCache())
+            cache->detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 3, callback, executor, deadline);
+        else if (executor)
+            RensaDetector::detectIterativelyParallel(field, RensaDetectorStrategy::defaultDropStrategy(), 3, executor, callback,
+                                                     nullptr, deadline);
+        else
+            RensaDetector::detectIteratively(field, RensaDetectorStrategy::defaultDropStrategy(), 3, callback,
+                                             nullptr, deadline);
         nodes[ojamaLines] = maker.makeNode();
     }
 
@@ -323,9 +351,12 @@ int RensaHandTree::eval(const RensaHandTree& myTree,
     return 0;
 }
 
-RensaHandNodeMaker::RensaHandNodeMaker(int restIteration, const KumipuyoSeq& kumipuyoSeq) :
+RensaHandNodeMaker::RensaHandNodeMaker(int restIteration, const KumipuyoSeq& kumipuyoSeq,
+                                       Executor* executor, const Deadline* deadline) :
     restIteration_(restIteration),
-    kumipuyoSeq_(kumipuyoSeq)
+    kumipuyoSeq_(kumipuyoSeq),
+    executor_(executor),
+    deadline_(deadline)
 {
 }
 
@@ -358,6 +389,8 @@ RensaResult RensaHandNodeMaker::add(CoreField&& cf,
     int framesToIgnite = wholeFramesToIgnite - usedFramesToMovePuyo - NUM_FRAMES_OF_ONE_HAND;
     if (framesToIgnite < 0)
         framesToIgnite = 0;
+
+    lock_guard<mutex> lock(mu_);
     data_.emplace_back(IgnitionRensaResult(rensaResult, framesToIgnite, NUM_FRAMES_OF_ONE_HAND),
                        tracker.result(), cf, wholeUsedPuyoSet, wholeFramesToIgnite);
 
@@ -369,7 +402,7 @@ RensaHandNode RensaHandNodeMaker::makeNode()
     if (data_.empty())
         return RensaHandNode();
 
-    sort(data_.begin(), data_.end(), SortByTotalFrames());
+    stable_sort(data_.begin(), data_.end(), SortByTotalFrames());
 
     vector<RensaHandEdge> edges;
     for (const RensaHandCandidate& info : data_) {
@@ -383,7 +416,9 @@ RensaHandNode RensaHandNodeMaker::makeNode()
                                                    info.fieldAfterRensa,
                                                    info.alreadyUsedPuyoSet,
                                                    info.alreadyConsumedFramesToMovePuyo,
-                                                   kumipuyoSeq_));
+                                                   kumipuyoSeq_,
+                                                   executor_,
+                                                   deadline_));
     }
     return RensaHandNode(std::move(edges));
 }
@@ -1,6 +1,7 @@
 #ifndef CPU_MAYAH_HAND_TREE_H_
 #define CPU_MAYAH_HAND_TREE_H_
 
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -14,11 +15,14 @@
 
 class ColumnPuyoList;
 class CoreField;
+class Deadline;
+class Executor;
 class KumipuyoSeq;
 class PuyoSet;
 
 class RensaHandEdge;
 class RensaHandNode;
+class RensaDetectionCache;
 class RensaHandTree;
 
 // These values are arbitrary chosen.
@@ -53,11 +57,21 @@ public:
     explicit RensaHandTree(std::vector<RensaHandNode> nodes) :
         nodes_(std::move(nodes)) {}
 
+    // When |executor| is not nullptr, the rensas are detected in parallel with it.
+    // When |deadline| passes, the detection stops, and the tree has only the rensas
+    // found so far.
     static RensaHandTree makeTree(int restIteration,
                                   const CoreField& currentField,
                                   const PuyoSet& usedPuyoSet,
                                   int usedPuyoMoveFrames,
-                                  const KumipuyoSeq& wholeKumipuyoSeq);
+                                  const KumipuyoSeq& wholeKumipuyoSeq,
+                                  Executor* executor = nullptr,
+                                  const Deadline* deadline = nullptr);
+
+    // The cache of the rensa detection in makeTree(). Since the trees are made for both
+    // our fields (in think) and the enemy field (in gaze), the cache is shared by them.
+    // Returns nullptr if --rensa_detection_cache_mb is 0.
+    static RensaDetectionCache* detectionCache();
 
     static int eval(const RensaHandTree& myTree,
                     int myStartingFrameId,
@@ -146,11 +160,15 @@ struct RensaHandCandidate {
 
 class RensaHandNodeMaker {
 public:
-    RensaHandNodeMaker(int restIteration, const KumipuyoSeq& kumipuyoSeq);
+    // |executor| and |deadline| are used to make the child trees in makeNode().
+    // They can be nullptr.
+    RensaHandNodeMaker(int restIteration, const KumipuyoSeq& kumipuyoSeq,
+                       Executor* executor = nullptr, const Deadline* deadline = nullptr);
     ~RensaHandNodeMaker();
 
     int restIteration() const { return restIteration_; }
 
+    // add() can be called from several threads at the same time.
     RensaResult add(CoreField&& cf,
                     const ColumnPuyoList& puyosToComplement,
                     int usedPuyoMoveFrames,
@@ -162,6 +180,9 @@ public:
 private:
     const int restIteration_;
     const KumipuyoSeq kumipuyoSeq_;
+    Executor* executor_;
+    const Deadline* deadline_;
+    std::mutex mu_;
     std::vector<RensaHandCandidate> data_;
 };
 
@@ -180,7 +201,20 @@ struct SortByTotalFrames {
         if (lhs.framesToIgnite() != rhs.framesToIgnite())
             return lhs.framesToIgnite() < rhs.framesToIgnite();
 
-        return lhs.coefResult.coef(lhs.chains()) > rhs.coefResult.coef(rhs.chains());
+        if (lhs.coefResult.coef(lhs.chains()) != rhs.coefResult.coef(rhs.chains()))
+            return lhs.coefResult.coef(lhs.chains()) > rhs.coefResult.coef(rhs.chains());
+
+        // The rest is to make the order total, since the candidates can be added
+        // from several threads in any order.
+        if (lhs.alreadyConsumedFramesToMovePuyo != rhs.alreadyConsumedFramesToMovePuyo)
+            return lhs.alreadyConsumedFramesToMovePuyo < rhs.alreadyConsumedFramesToMovePuyo;
+        if (!(lhs.alreadyUsedPuyoSet == rhs.alreadyUsedPuyoSet))
+            return lhs.alreadyUsedPuyoSet < rhs.alreadyUsedPuyoSet;
+        if (lhs.fieldAfterRensa.hash() != rhs.fieldAfterRensa.hash())
+            return lhs.fieldAfterRensa.hash() < rhs.fieldAfterRensa.hash();
+        if (lhs.fieldAfterRensa == rhs.fieldAfterRensa)
+            return false;
+        return lhs.fieldAfterRensa.toDebugString() < rhs.fieldAfterRensa.toDebugString();
     }
 };
 
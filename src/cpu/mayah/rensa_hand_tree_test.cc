@@ -5,7 +5,10 @@
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include "base/deadline.h"
+#include "base/executor.h"
 #include "core/core_field.h"
+#include "core/rensa/rensa_detection_cache.h"
 #include "core/kumipuyo_seq.h"
 #include "core/probability/puyo_set_probability.h"
 
@@ -143,3 +146,81 @@ TEST(RensaHandTreeTest, eval_actual2)
 
     EXPECT_LT(0, s) << endl;
 }
+
+TEST(RensaHandTreeTest, eval_actual1WithExecutor)
+{
+    // Same as eval_actual1 with the colors swapped, so the rensas are not cached yet.
+    const CoreField cf1(
+        ".....B"
+        "....GB"
+        "G..YYY"
+        "YYYGGB"
+        "GBRGYB"
+        "GGBRRR"
+        "BBRYYY");
+
+    const CoreField cf2(
+        ".BRYG."
+        "BRYGB."
+        "BRYGBO"
+        "BRYGBO");
+
+    Executor executor(4);
+    executor.start();
+
+    RensaHandTree myTree = RensaHandTree::makeTree(2, cf1, PuyoSet(), 0, KumipuyoSeq("YYYY"), &executor);
+    RensaHandTree enemyTree = RensaHandTree::makeTree(2, cf2, PuyoSet(), 0, KumipuyoSeq("YYGG"), &executor);
+
+    executor.stop();
+
+    EXPECT_LT(0, RensaHandTree::eval(myTree, 0, 0, 0, 0, enemyTree, 0, 0, 0, 0));
+}
+
+TEST(RensaHandTreeTest, makeTreeWithPassedDeadline)
+{
+    // A field that is not used in the other tests, so the rensas are not cached yet.
+    const CoreField cf(
+        "..RRG."
+        "BRYGB."
+        "BRYGBO"
+        "BRYGBO");
+
+    Deadline passed(Deadline::afterMillis(0));
+    RensaHandTree tree = RensaHandTree::makeTree(2, cf, PuyoSet(), 0, KumipuyoSeq("YYGG"), nullptr, &passed);
+    ASSERT_EQ(6U, tree.nodes().size());
+    for (const RensaHandNode& node : tree.nodes())
+        EXPECT_TRUE(node.edges().empty());
+
+    Deadline never;
+    RensaHandTree fullTree = RensaHandTree::makeTree(2, cf, PuyoSet(), 0, KumipuyoSeq("YYGG"), nullptr, &never);
+    EXPECT_FALSE(fullTree.node(0).edges().empty());
+}
+
+TEST(RensaHandTreeTest, makeTreeWithExecutorIsDeterministic)
+{
+    const CoreField cf(
+        ".....B"
+        "....GB"
+        "G..YYY"
+        "YYYGGB"
+        "GBRGYB"
+        "GGBRRR"
+        "BBRYYY");
+    const KumipuyoSeq seq("YYYY");
+
+    auto clearCache = []() {
+        if (RensaDetectionCache* cache = RensaHandTree::detectionCache())
+            cache->clear();
+    };
+
+    clearCache();
+    string expected = RensaHandTree::makeTree(2, cf, PuyoSet(), 0, seq).toString();
+
+    Executor executor(4);
+    executor.start();
+    for (int i = 0; i < 3; ++i) {
+        clearCache();
+        EXPECT_EQ(expected, RensaHandTree::makeTree(2, cf, PuyoSet(), 0, seq, &executor).toString()) << i;
+    }
+    executor.stop();
+}
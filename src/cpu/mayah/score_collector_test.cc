@@ -16,3 +16,66 @@ TEST(ScoreCollectorTest, score)
     EXPECT_EQ(50.0, collector.collectedScore().score(EvaluationMode::EARLY));
     EXPECT_EQ(30.0, collector.collectedScore().score(EvaluationMode::MIDDLE));
 }
+
+TEST(ScoreCollectorTest, sparseScore)
+{
+    EvaluationParameterMap m;
+    m.mutableMoveParamSet()->setDefault(VALLEY_DEPTH, 2, 3.0);
+    m.mutableMoveParamSet()->setDefault(VALLEY_DEPTH, 4, 7.0);
+    m.mutableMoveParamSet()->setParam(EvaluationMode::LATE, VALLEY_DEPTH, 4, 11.0);
+
+    SimpleScoreCollector collector(m);
+    collector.addScore(VALLEY_DEPTH, 2);
+    collector.addScore(VALLEY_DEPTH, 4, 2);
+
+    EXPECT_EQ(17.0, collector.collectedScore().score(EvaluationMode::MIDDLE));
+    // LATE has its own VALLEY_DEPTH, so the default is not used for any index.
+    EXPECT_EQ(22.0, collector.collectedScore().score(EvaluationMode::LATE));
+}
+
+TEST(ScoreCollectorTest, denseScoreMatchesCollectedFeatures)
+{
+    EvaluationParameterMap m;
+    m.mutableMoveParamSet()->setDefault(TOTAL_FRAMES, 3.0);
+    m.mutableMoveParamSet()->setParam(EvaluationMode::EARLY, TOTAL_FRAMES, 5.0);
+    m.mutableMoveParamSet()->setDefault(NUM_COUNT_PUYOS, 84, 0.5);
+    m.mutableMoveParamSet()->setDefault(THIRD_COLUMN_HEIGHT, 0, -2.0);
+    m.mutableMainRensaParamSet()->setDefault(SCORE, 0.25);
+    m.mutableMainRensaParamSet()->setParam(EvaluationMode::MIDDLE, MAX_CHAINS, 19, 8.0);
+    m.mutableSideRensaParamSet()->setDefault(IGNITION_HEIGHT, 13, 4.0);
+
+    FeatureScoreCollector collector(m);
+    collector.addScore(TOTAL_FRAMES, 10.0);
+    collector.addScore(NUM_COUNT_PUYOS, 84);
+    collector.addScore(THIRD_COLUMN_HEIGHT, 0, 3);
+
+    FeatureRensaScoreCollector rensaCollector(m.mainRensaParamSet(), m.sideRensaParamSet());
+    rensaCollector.addScore(SCORE, 100.0);
+    rensaCollector.addScore(MAX_CHAINS, 19);
+    rensaCollector.addScore(IGNITION_HEIGHT, 13);
+    collector.mergeMainRensaScore(rensaCollector.mainRensaScore());
+    collector.mergeSideRensaScore(rensaCollector.sideRensaScore());
+
+    // Recomputes the score from the collected features and the parameters.
+    const CollectedFeatureScore& score = collector.collectedScore();
+    for (const auto& mode : ALL_EVALUATION_MODES) {
+        CollectedCoef coef;
+        coef.setCoef(mode, 1.0);
+
+        double expected = 0.0;
+        for (const auto& entry : score.moveScore.collectedFeatures)
+            expected += score.moveScore.scoreFor(entry.first, coef, m.moveParamSet());
+        for (const auto& entry : score.moveScore.collectedSparseFeatures)
+            expected += score.moveScore.scoreFor(entry.first, coef, m.moveParamSet());
+        for (const auto& entry : score.mainRensaScore.collectedFeatures)
+            expected += score.mainRensaScore.scoreFor(entry.first, coef, m.mainRensaParamSet());
+        for (const auto& entry : score.mainRensaScore.collectedSparseFeatures)
+            expected += score.mainRensaScore.scoreFor(entry.first, coef, m.mainRensaParamSet());
+        for (const auto& entry : score.sideRensaScore.collectedFeatures)
+            expected += score.sideRensaScore.scoreFor(entry.first, coef, m.sideRensaParamSet());
+        for (const auto& entry : score.sideRensaScore.collectedSparseFeatures)
+            expected += score.sideRensaScore.scoreFor(entry.first, coef, m.sideRensaParamSet());
+
+        EXPECT_DOUBLE_EQ(expected, score.score(coef)) << toString(mode);
+    }
+}
@@ -0,0 +1,87 @@
+#include "mayah_ai.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "duel/headless_duel.h"
+
+#include "evaluation_parameter.h"
+
+DECLARE_string(feature);
+
+DEFINE_string(enemy_feature, "", "the feature file for 2P. If empty, --feature is used.");
+DEFINE_int32(num_matches, 100, "the number of matches.");
+DEFINE_int32(offset, 0, "offset for random seed");
+DEFINE_double(think_time_scale, 1.0, "the think time is multiplied by this. 0 means no think time.");
+DEFINE_int32(max_frames, FPS * 60 * 10, "a match not finished in this frames is a draw.");
+
+using namespace std;
+
+namespace {
+
+EvaluationParameterMap loadParameterMap(const string& feature)
+{
+    EvaluationParameterMap paramMap;
+    if (!paramMap.load(feature)) {
+        std::string filename = string(SRC_DIR) + "/cpu/mayah/" + feature;
+        if (!paramMap.load(filename))
+            CHECK(false) << "parameter cannot be loaded correctly: " << feature;
+    }
+    return paramMap;
+}
+
+HeadlessDuel::AIFactory makeFactory(const EvaluationParameterMap& paramMap)
+{
+    return [paramMap]() {
+        DebuggableMayahAI* ai = new DebuggableMayahAI;
+        ai->setEvaluationParameterMap(paramMap);
+        return unique_ptr<AI>(ai);
+    };
+}
+
+} // anonymous namespace
+
+// Plays mayah AIs against each other in process, and shows the statistics.
+int main(int argc, char* argv[])
+{
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+#if !defined(_MSC_VER)
+    google::InstallFailureSignalHandler();
+#endif
+
+    unique_ptr<Executor> executor = Executor::makeDefaultExecutor();
+
+    EvaluationParameterMap p1ParamMap = loadParameterMap(FLAGS_feature);
+    EvaluationParameterMap p2ParamMap =
+        FLAGS_enemy_feature.empty() ? p1ParamMap : loadParameterMap(FLAGS_enemy_feature);
+
+    HeadlessDuelOptions options;
+    options.thinkTimeScale = FLAGS_think_time_scale;
+    options.maxFrames = FLAGS_max_frames;
+
+    vector<HeadlessDuelResult> results =
+        HeadlessDuel::runMatches(executor.get(), makeFactory(p1ParamMap), makeFactory(p2ParamMap),
+                                 FLAGS_num_matches, FLAGS_offset, options);
+
+    HeadlessDuelStats stats;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const HeadlessDuelResult& r = results[i];
+        cout << "seed=" << (FLAGS_offset + i)
+             << " result=" << toString(r.gameResult)
+             << " frames=" << r.frames
+             << " score=" << r.score[0] << "/" << r.score[1]
+             << " late=" << r.numLateResponses[0] << "/" << r.numLateResponses[1] << endl;
+        stats.add(r);
+    }
+
+    cout << stats.toString();
+
+    executor->stop();
+    return 0;
+}
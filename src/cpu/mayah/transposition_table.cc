@@ -0,0 +1,129 @@
+#include "transposition_table.h"
+
+#include <cstring>
+
+#include <glog/logging.h>
+
+using namespace std;
+
+namespace {
+
+// data layout:
+//   bits  0-31 : score (float)
+//   bits 32-39 : maxChains
+//   bits 40-47 : depth
+//   bits 48-55 : generation
+//   bit  63    : 1 if used. 0 means the slot is empty.
+const std::uint64_t USED_BIT = 1ULL << 63;
+
+}
+
+TranspositionTable::TranspositionTable(size_t megaBytes) :
+    generation_(0)
+{
+    size_t n = megaBytes * 1024 * 1024 / sizeof(Bucket);
+    CHECK(n > 0) << "transposition table is too small: " << megaBytes << "MB";
+
+    // Rounds down to the power of 2.
+    numBuckets_ = 1;
+    while (numBuckets_ * 2 <= n)
+        numBuckets_ *= 2;
+
+    buckets_.reset(new Bucket[numBuckets_]);
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < numBuckets_; ++i) {
+        for (int j = 0; j < BUCKET_SIZE; ++j) {
+            buckets_[i].slots[j].keyXorData.store(0, memory_order_relaxed);
+            buckets_[i].slots[j].data.store(0, memory_order_relaxed);
+        }
+    }
+}
+
+bool TranspositionTable::probe(std::uint64_t key, Entry* entry) const
+{
+    const Bucket& b = bucket(key);
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        std::uint64_t data = b.slots[i].data.load(memory_order_relaxed);
+        std::uint64_t keyXorData = b.slots[i].keyXorData.load(memory_order_relaxed);
+        if ((data & USED_BIT) && (keyXorData ^ data) == key) {
+            *entry = unpack(data);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, const Entry& entry)
+{
+    const int generation = generation_.load(memory_order_relaxed) & 0xFF;
+    Bucket& b = bucket(key);
+
+    // Find the same key or an empty slot. Otherwise, replace the entry that has
+    // the lowest depth. Entries in the older generations are regarded as shallower.
+    int victim = 0;
+    int victimValue = 0x7FFFFFFF;
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        std::uint64_t data = b.slots[i].data.load(memory_order_relaxed);
+        std::uint64_t keyXorData = b.slots[i].keyXorData.load(memory_order_relaxed);
+        if (!(data & USED_BIT) || (keyXorData ^ data) == key) {
+            victim = i;
+            break;
+        }
+
+        int age = (generation - generationOf(data)) & 0xFF;
+        int value = depthOf(data) - 8 * age;
+        if (value < victimValue) {
+            victim = i;
+            victimValue = value;
+        }
+    }
+
+    std::uint64_t data = pack(entry, generation);
+    b.slots[victim].data.store(data, memory_order_relaxed);
+    b.slots[victim].keyXorData.store(key ^ data, memory_order_relaxed);
+}
+
+// static
+std::uint64_t TranspositionTable::mix(std::uint64_t key)
+{
+    // The finalizer of MurmurHash3.
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb93fe53a88cdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+// static
+std::uint64_t TranspositionTable::pack(const Entry& entry, int generation)
+{
+    std::uint32_t score;
+    static_assert(sizeof(score) == sizeof(entry.score), "float should be 32bit");
+    memcpy(&score, &entry.score, sizeof(score));
+
+    DCHECK(0 <= entry.maxChains && entry.maxChains < 256) << entry.maxChains;
+    DCHECK(0 <= entry.depth && entry.depth < 256) << entry.depth;
+
+    return USED_BIT |
+        (static_cast<std::uint64_t>(generation & 0xFF) << 48) |
+        (static_cast<std::uint64_t>(entry.depth & 0xFF) << 40) |
+        (static_cast<std::uint64_t>(entry.maxChains & 0xFF) << 32) |
+        score;
+}
+
+// static
+TranspositionTable::Entry TranspositionTable::unpack(std::uint64_t data)
+{
+    Entry entry;
+    std::uint32_t score = static_cast<std::uint32_t>(data);
+    memcpy(&entry.score, &score, sizeof(score));
+    entry.maxChains = (data >> 32) & 0xFF;
+    entry.depth = depthOf(data);
+    return entry;
+}
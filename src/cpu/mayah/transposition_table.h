@@ -0,0 +1,75 @@
+#ifndef CPU_MAYAH_TRANSPOSITION_TABLE_H_
+#define CPU_MAYAH_TRANSPOSITION_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "base/noncopyable.h"
+
+// TranspositionTable caches the evaluation of a field. The key is BitField::hash().
+//
+// The table has a fixed size, and can be shared by several threads without lock.
+// Each bucket has 4 entries (64 bytes). When a bucket is full, the entry
+// that has the lowest depth in the oldest generation is replaced.
+//
+// Each entry is stored as (key ^ data, data). When two threads write the same entry
+// at the same time, the torn entry won't match any key, so probe() just misses.
+class TranspositionTable : noncopyable {
+public:
+    struct Entry {
+        float score = 0;
+        int maxChains = 0;
+        int depth = 0;
+    };
+
+    // The table will use about |megaBytes| MB.
+    explicit TranspositionTable(size_t megaBytes);
+
+    // Starts a new generation. Entries in the older generations will be replaced first.
+    // Call this once per think().
+    void newGeneration() { generation_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Returns true if |key| is found. The found entry is copied to |entry|.
+    bool probe(std::uint64_t key, Entry* entry) const;
+    void store(std::uint64_t key, const Entry& entry);
+
+    // Removes all the entries.
+    void clear();
+
+    size_t numBuckets() const { return numBuckets_; }
+    // Returns the index of the bucket that |key| goes to.
+    size_t bucketIndex(std::uint64_t key) const { return mix(key) & (numBuckets_ - 1); }
+
+private:
+    static const int BUCKET_SIZE = 4;
+
+    struct Slot {
+        std::atomic<std::uint64_t> keyXorData;
+        std::atomic<std::uint64_t> data;
+    };
+
+    // 16 bytes * 4 = 64 bytes.
+    struct Bucket {
+        Slot slots[BUCKET_SIZE];
+    };
+
+    static std::uint64_t pack(const Entry&, int generation);
+    static Entry unpack(std::uint64_t data);
+    static int depthOf(std::uint64_t data) { return (data >> 40) & 0xFF; }
+    static int generationOf(std::uint64_t data) { return (data >> 48) & 0xFF; }
+
+    // The low bits of BitField::hash() depend only on a few columns, so the key is
+    // mixed before it's used as the index.
+    static std::uint64_t mix(std::uint64_t key);
+    Bucket& bucket(std::uint64_t key) { return buckets_[bucketIndex(key)]; }
+    const Bucket& bucket(std::uint64_t key) const { return buckets_[bucketIndex(key)]; }
+
+    size_t numBuckets_;
+    std::unique_ptr<Bucket[]> buckets_;
+    // Only the low 8 bits are used.
+    std::atomic<unsigned int> generation_;
+};
+
+#endif // CPU_MAYAH_TRANSPOSITION_TABLE_H_
@@ -0,0 +1,131 @@
+#include "transposition_table.h"
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/bit_field.h"
+#include "core/puyo_color.h"
+
+namespace {
+
+TranspositionTable::Entry makeEntry(float score, int maxChains, int depth)
+{
+    TranspositionTable::Entry entry;
+    entry.score = score;
+    entry.maxChains = maxChains;
+    entry.depth = depth;
+    return entry;
+}
+
+// Returns |n| keys that go to the same bucket.
+std::vector<std::uint64_t> collidingKeys(const TranspositionTable& table, int n)
+{
+    std::vector<std::uint64_t> keys;
+    for (std::uint64_t key = 1; static_cast<int>(keys.size()) < n; ++key) {
+        if (table.bucketIndex(key) == table.bucketIndex(1))
+            keys.push_back(key);
+    }
+    return keys;
+}
+
+}
+
+TEST(TranspositionTableTest, probeAndStore)
+{
+    TranspositionTable table(1);
+
+    TranspositionTable::Entry entry;
+    EXPECT_FALSE(table.probe(12345, &entry));
+
+    table.store(12345, makeEntry(1234.5, 10, 3));
+    ASSERT_TRUE(table.probe(12345, &entry));
+    EXPECT_EQ(1234.5, entry.score);
+    EXPECT_EQ(10, entry.maxChains);
+    EXPECT_EQ(3, entry.depth);
+
+    // Overwrite.
+    table.store(12345, makeEntry(-20.0, 2, 4));
+    ASSERT_TRUE(table.probe(12345, &entry));
+    EXPECT_EQ(-20.0, entry.score);
+    EXPECT_EQ(2, entry.maxChains);
+    EXPECT_EQ(4, entry.depth);
+
+    table.clear();
+    EXPECT_FALSE(table.probe(12345, &entry));
+}
+
+TEST(TranspositionTableTest, replacement)
+{
+    TranspositionTable table(1);
+    const std::vector<std::uint64_t> keys = collidingKeys(table, 6);
+
+    // These keys go to the same bucket.
+    for (int i = 0; i < 4; ++i)
+        table.store(keys[i], makeEntry(i, i, 10 + i));
+
+    // The shallowest entry (0) should be replaced.
+    table.store(keys[4], makeEntry(4, 4, 20));
+
+    TranspositionTable::Entry entry;
+    EXPECT_FALSE(table.probe(keys[0], &entry));
+    for (int i = 1; i <= 4; ++i)
+        EXPECT_TRUE(table.probe(keys[i], &entry)) << i;
+
+    // In the new generation, older entries are replaced first even if they are deeper.
+    // (1: 11 - 8, 2: 12 - 8, 3: 13 - 8, 4: 20 - 8, 5: 1)
+    table.newGeneration();
+    table.store(keys[5], makeEntry(5, 5, 1));
+    EXPECT_FALSE(table.probe(keys[1], &entry));
+    for (int i = 2; i <= 5; ++i)
+        EXPECT_TRUE(table.probe(keys[i], &entry)) << i;
+}
+
+TEST(TranspositionTableTest, bucketDistribution)
+{
+    TranspositionTable table(1);
+
+    // The fields that differ only in the columns 2 and 3 should spread over the buckets.
+    std::set<size_t> indices;
+    const int N = 4096;
+    for (int i = 0; i < N; ++i) {
+        BitField field;
+        for (int j = 0; j < 12; ++j) {
+            if (i & (1 << j))
+                field.setColor(2 + j / 6, 1 + j % 6, PuyoColor::RED);
+            else
+                field.setColor(2 + j / 6, 1 + j % 6, PuyoColor::BLUE);
+        }
+        indices.insert(table.bucketIndex(field.hash()));
+    }
+
+    // Uniform hashing would fill about 3560 of 16384 buckets.
+    EXPECT_LT(N * 3 / 4, static_cast<int>(indices.size()));
+}
+
+TEST(TranspositionTableTest, concurrentAccess)
+{
+    TranspositionTable table(1);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&table]() {
+            for (int i = 0; i < 100000; ++i) {
+                std::uint64_t key = (i % 1000) * 0x9E3779B97F4A7C15ULL;
+                TranspositionTable::Entry entry;
+                if (table.probe(key, &entry)) {
+                    // The entry must not be torn.
+                    EXPECT_EQ(static_cast<float>(i % 1000), entry.score);
+                    EXPECT_EQ(i % 100, entry.maxChains);
+                } else {
+                    table.store(key, makeEntry(i % 1000, i % 100, 1));
+                }
+            }
+        });
+    }
+
+    for (auto& th : threads)
+        th.join();
+}
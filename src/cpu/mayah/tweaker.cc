@@ -4,7 +4,6 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <future>
 #include <sstream>
 #include <random>
 
@@ -151,10 +150,11 @@ void runOnce(const EvaluationParameterMap& paramMap)
 RunResult run(Executor* executor, const EvaluationParameterMap& paramMap)
 {
     const int N = FLAGS_size;
-    vector<promise<Result>> ps(N);
+    vector<Result> results(N);
 
+    TaskGroup group(executor);
     for (int i = 0; i < N; ++i) {
-        auto f = [i, &paramMap, &ps]() {
+        group.run([i, &paramMap, &results]() {
             auto ai = new DebuggableMayahAI;
             ai->setUsesRensaHandTree(false);
             ai->setEvaluationParameterMap(paramMap);
@@ -171,10 +171,10 @@ RunResult run(Executor* executor, const EvaluationParameterMap& paramMap)
                 ss << " / ZENKESHI";
             ss << endl;
 
-            ps[i].set_value(Result{result, ss.str()});
-        };
-        executor->submit(f);
+            results[i] = Result{result, ss.str()};
+        });
     }
+    group.wait();
 
     int numZenkeshi = 0;
     int sumScore = 0;
@@ -191,7 +191,7 @@ RunResult run(Executor* executor, const EvaluationParameterMap& paramMap)
 
     vector<pair<int, int>> scores;
     for (int i = 0; i < N; ++i) {
-        Result r = ps[i].get_future().get();
+        const Result& r = results[i];
         cout << r.msg;
         if (r.result.zenkeshi && r.result.hand < 8) {
             numZenkeshi++;
@@ -19,6 +19,13 @@ YukinaAI::YukinaAI(int argc, char* argv[]) :
 
 DropDecision YukinaAI::think(int frame_id, const CoreField& field, const KumipuyoSeq& kumipuyo_seq,
                              const PlayerState& me, const PlayerState& enemy, bool fast) const
+{
+    return thinkWithDeadline(frame_id, field, kumipuyo_seq, me, enemy, fast, Deadline());
+}
+
+DropDecision YukinaAI::thinkWithDeadline(int frame_id, const CoreField& field, const KumipuyoSeq& kumipuyo_seq,
+                                         const PlayerState& me, const PlayerState& enemy, bool fast,
+                                         const Deadline& deadline) const
 {
     const GazeResult& gazeResult = gazer_.gazeResult();
 
@@ -92,7 +99,7 @@ DropDecision YukinaAI::think(int frame_id, const CoreField& field, const Kumipuy
 #endif
 
     double beginTimeSec = currentTime();
-    DropDecision dd = thinkByThinker(frame_id, field, kumipuyo_seq, me, enemy, fast);
+    DropDecision dd = thinkByThinker(frame_id, field, kumipuyo_seq, me, enemy, fast, deadline);
     if (dd.isValid()) {
         double endTimeSec = currentTime();
         double durationSec = endTimeSec - beginTimeSec;
@@ -112,7 +119,8 @@ DropDecision YukinaAI::think(int frame_id, const CoreField& field, const Kumipuy
 }
 
 DropDecision YukinaAI::thinkByThinker(int frame_id, const CoreField& field, const KumipuyoSeq& kumipuyo_seq,
-                                      const PlayerState& me, const PlayerState& enemy, bool fast) const
+                                      const PlayerState& me, const PlayerState& enemy, bool fast,
+                                      const Deadline& deadline) const
 {
 #if 0
     return rush_thinker_->think(frame_id, field, kumipuyo_seq, me, enemy, fast);
@@ -123,7 +131,7 @@ DropDecision YukinaAI::thinkByThinker(int frame_id, const CoreField& field, cons
 
     if (fast) {
         return pattern_thinker_->think(frame_id, field, kumipuyo_seq, me, enemy, gazer_.gazeResult(), fast,
-                                       usesDecisionBook, usesRensaHandTree);
+                                       usesDecisionBook, usesRensaHandTree, deadline);
     }
 
     if (enemy.isRensaOngoing() || me.totalOjama(enemy) > 2) {
@@ -133,12 +141,12 @@ DropDecision YukinaAI::thinkByThinker(int frame_id, const CoreField& field, cons
         }
 #endif
         return pattern_thinker_->think(frame_id, field, kumipuyo_seq, me, enemy, gazer_.gazeResult(), fast,
-                                       usesDecisionBook, usesRensaHandTree);
+                                       usesDecisionBook, usesRensaHandTree, deadline);
     }
 
     if (field.countPuyos() >= 64) {
         return pattern_thinker_->think(frame_id, field, kumipuyo_seq, me, enemy, gazer_.gazeResult(), fast,
-                                       usesDecisionBook, usesRensaHandTree);
+                                       usesDecisionBook, usesRensaHandTree, deadline);
     }
 
     // Turning the table mode
@@ -159,10 +167,10 @@ DropDecision YukinaAI::thinkByThinker(int frame_id, const CoreField& field, cons
 
     if (field.countPuyos() <= 24) {
         return pattern_thinker_->think(frame_id, field, kumipuyo_seq, me, enemy, gazer_.gazeResult(), fast,
-                                       usesDecisionBook, usesRensaHandTree);
+                                       usesDecisionBook, usesRensaHandTree, deadline);
     }
 
-    return beam_thinker_->think(frame_id, field, kumipuyo_seq, me, enemy, fast);
+    return beam_thinker_->think(frame_id, field, kumipuyo_seq, me, enemy, fast, deadline);
 }
 
 std::string YukinaAI::gazeMessage(int frame_id, const PlayerState& me, const PlayerState& enemy, const GazeResult& gazeResult) const
@@ -13,9 +13,13 @@ public:
 
     DropDecision think(int frameId, const CoreField&, const KumipuyoSeq&,
                        const PlayerState& me, const PlayerState& enemy, bool fast) const override;
+    DropDecision thinkWithDeadline(int frameId, const CoreField&, const KumipuyoSeq&,
+                                   const PlayerState& me, const PlayerState& enemy, bool fast,
+                                   const Deadline&) const override;
 
     DropDecision thinkByThinker(int frameId, const CoreField&, const KumipuyoSeq&,
-                                const PlayerState& me, const PlayerState& enemy, bool fast) const;
+                                const PlayerState& me, const PlayerState& enemy, bool fast,
+                                const Deadline& deadline = Deadline()) const;
 
 private:
     std::string gazeMessage(int frame_id, const PlayerState& me, const PlayerState& enemy, const GazeResult& gazeResult) const;
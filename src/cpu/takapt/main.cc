@@ -19,7 +19,6 @@
 #include <numeric>
 #include <unordered_set>
 #include <unordered_map>
-#include <future>
 
 #include <iostream>
 
@@ -470,18 +469,16 @@ RunResult run(int seed)
 void run_loop(int num, const int start_seed, bool print_info)
 {
     unique_ptr<Executor> executor = Executor::makeDefaultExecutor();
-    vector<promise<RunResult>> promise_results(num);
+    vector<RunResult> results(num);
+    TaskGroup group(executor.get());
     for (int i = 0; i < num; ++i)
     {
-        executor->submit([i, start_seed, &promise_results]() {
-                promise_results[i].set_value(run(start_seed + i));
+        group.run([i, start_seed, &results]() {
+                results[i] = run(start_seed + i);
                 cout << "done: " << i << endl;
         });
     }
-
-    vector<RunResult> results;
-    for (auto& pr : promise_results)
-        results.push_back(pr.get_future().get());
+    group.wait();
 
     int count_score[30 * 10000]{};
     int count_chains_[30]{};
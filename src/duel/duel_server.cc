@@ -8,16 +8,13 @@
 
 #include <gflags/gflags.h>
 
-#include "core/decision.h"
 #include "core/frame_response.h"
 #include "core/kumipuyo_seq_generator.h"
-#include "core/puyo_controller.h"
 #include "core/server/connector/connector_manager.h"
 #include "core/server/connector/server_connector.h"
 #include "core/server/game_state.h"
 #include "core/server/game_state_observer.h"
-#include "duel/field_realtime.h"
-#include "duel/frame_context.h"
+#include "duel/duel_state.h"
 
 using namespace std;
 
@@ -29,81 +26,6 @@ DEFINE_bool(use_even, false, "the match gets even after 2 minutes.");
 DECLARE_bool(use_gui);
 #endif
 
-struct DuelServer::DuelState {
-    explicit DuelState(const KumipuyoSeq& seq) : field { FieldRealtime(0, seq), FieldRealtime(1, seq) } {}
-
-    GameState toGameState() const
-    {
-        GameState gs(frameId);
-        for (int pi = 0; pi < 2; ++pi) {
-            PlayerGameState* pgs = gs.mutablePlayerGameState(pi);
-            const FieldRealtime& fr = field[pi];
-            pgs->field = fr.field();
-            pgs->kumipuyoSeq = fr.visibleKumipuyoSeq();
-            pgs->kumipuyoPos = fr.kumipuyoPos();
-            pgs->event = fr.userEvent();
-            pgs->dead = fr.isDead();
-            pgs->playable = fr.playable();
-            pgs->score = fr.score();
-            pgs->pendingOjama = fr.numPendingOjama();
-            pgs->fixedOjama = fr.numFixedOjama();
-            pgs->decision = decision[pi];
-            pgs->message = message[pi];
-        }
-
-        return gs;
-    }
-
-    int frameId = 0;
-    FieldRealtime field[2];
-    Decision decision[2];
-    string message[2];
-};
-
-/**
- * Updates decision when an applicable one is found.
- * Returns:
- *   if there is an accepted decision:
- *     its index in the given data array.
- *   else:
- *     -1
- */
-static int updateDecision(int frameId, const vector<FrameResponse>& data, const FieldRealtime& field, Decision* decision)
-{
-    // updateDecision is called when grounded. Chigiri-puyo might be in the air.
-    CoreField cf(CoreField::fromPlainFieldWithDrop(field.field()));
-
-    // Try all commands from the newest one.
-    // If we find a command we can use, we'll ignore older ones.
-    for (unsigned int i = data.size(); i > 0;) {
-        i--;
-
-        // Probably we got the previous game's response. We should ignore it.
-        if (data[i].frameId > frameId) {
-            LOG(WARNING) << "Get previous game response? frameId=" << frameId << " response=" << data[i].toString();
-            continue;
-        }
-
-        // When data contains key, it should be from HumanConnector.
-        // In that case we accept it.
-        if (data[i].keySet.hasSomeKey())
-            return i;
-
-        Decision d = data[i].decision;
-
-        // We don't send ACK/NACK for invalid decision.
-        if (!d.isValid())
-            continue;
-
-        if (PuyoController::isReachableFrom(cf, field.kumipuyoMovingState(), d)) {
-            *decision = d;
-            return i;
-        }
-    }
-
-    return -1;
-}
-
 DuelServer::DuelServer(ConnectorManager* manager) :
     shouldStop_(false),
     manager_(manager)
@@ -236,7 +158,7 @@ GameResult DuelServer::runGame(ConnectorManager* manager)
         }
 
         // --- Play with input.
-        play(&duelState, data);
+        duelState.play(data);
         gameState = duelState.toGameState();
         for (GameStateObserver* observer : observers_)
             observer->onUpdate(gameState);
@@ -271,48 +193,3 @@ GameResult DuelServer::runGame(ConnectorManager* manager)
 
     return gameResult;
 }
-
-void DuelServer::play(DuelState* duelState, const vector<FrameResponse> data[2])
-{
-    for (int pi = 0; pi < 2; pi++) {
-        FieldRealtime* me = &duelState->field[pi];
-        FieldRealtime* opponent = &duelState->field[1 - pi];
-
-        int accepted_index = updateDecision(duelState->frameId, data[pi], *me, &duelState->decision[pi]);
-
-        // TODO(mayah): ReceivedData from HumanConnector does not have any decision.
-        // So, all data will be marked as NACK. Since the HumanConnector does not see ACK/NACK,
-        // it's OK for now. However, this might cause future issues. Consider better way.
-
-        if (accepted_index != -1) {
-            KeySetSeq kss = PuyoController::findKeyStrokeFrom(CoreField(me->field()), me->kumipuyoMovingState(), duelState->decision[pi]);
-            me->setKeySetSeq(kss);
-        }
-
-        string acceptedMessage;
-        if (accepted_index != -1)
-            acceptedMessage = data[pi][accepted_index].message;
-
-        LOG(INFO) << "Current KeySetSeq: " << pi << " " << me->keySetSeq().toString();
-        KeySet keySet = me->frontKeySet();
-        me->dropFrontKeySet();
-        // For human connector. The received data from HumanConnector might have some key.
-        if (accepted_index != -1 && data[pi][accepted_index].keySet.hasSomeKey()) {
-            keySet = data[pi][accepted_index].keySet;
-        }
-
-        FrameContext context;
-        me->playOneFrame(keySet, &context);
-        context.apply(me, opponent);
-
-        // Clear current key input if the move is done.
-        if (me->userEvent().grounded) {
-            duelState->decision[pi] = Decision();
-            me->setKeySetSeq(KeySetSeq());
-        }
-
-        if (!acceptedMessage.empty()) {
-            duelState->message[pi] = acceptedMessage;
-        }
-    }
-}
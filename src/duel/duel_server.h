@@ -1,6 +1,7 @@
 #ifndef DUEL_DUEL_SERVER_H_
 #define DUEL_DUEL_SERVER_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>
@@ -10,7 +11,6 @@
 
 class ConnectorManager;
 class GameStateObserver;
-struct FrameResponse;
 
 class DuelServer {
 public:
@@ -31,10 +31,7 @@ public:
     }
 
 private:
-    struct DuelState;
-
     void runDuelLoop();
-    void play(DuelState*, const std::vector<FrameResponse> data[2]);
 
     GameResult runGame(ConnectorManager* manager);
 
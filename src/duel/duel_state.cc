@@ -0,0 +1,122 @@
+#include "duel/duel_state.h"
+
+#include <glog/logging.h>
+
+#include "core/frame_response.h"
+#include "core/puyo_controller.h"
+#include "duel/frame_context.h"
+
+using namespace std;
+
+/**
+ * Updates decision when an applicable one is found.
+ * Returns:
+ *   if there is an accepted decision:
+ *     its index in the given data array.
+ *   else:
+ *     -1
+ */
+static int updateDecision(int frameId, const vector<FrameResponse>& data, const FieldRealtime& field, Decision* decision)
+{
+    // updateDecision is called when grounded. Chigiri-puyo might be in the air.
+    CoreField cf(CoreField::fromPlainFieldWithDrop(field.field()));
+
+    // Try all commands from the newest one.
+    // If we find a command we can use, we'll ignore older ones.
+    for (unsigned int i = data.size(); i > 0;) {
+        i--;
+
+        // Probably we got the previous game's response. We should ignore it.
+        if (data[i].frameId > frameId) {
+            LOG(WARNING) << "Get previous game response? frameId=" << frameId << " response=" << data[i].toString();
+            continue;
+        }
+
+        // When data contains key, it should be from HumanConnector.
+        // In that case we accept it.
+        if (data[i].keySet.hasSomeKey())
+            return i;
+
+        Decision d = data[i].decision;
+
+        // We don't send ACK/NACK for invalid decision.
+        if (!d.isValid())
+            continue;
+
+        if (PuyoController::isReachableFrom(cf, field.kumipuyoMovingState(), d)) {
+            *decision = d;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+GameState DuelState::toGameState() const
+{
+    GameState gs(frameId);
+    for (int pi = 0; pi < 2; ++pi) {
+        PlayerGameState* pgs = gs.mutablePlayerGameState(pi);
+        const FieldRealtime& fr = field[pi];
+        pgs->field = fr.field();
+        pgs->kumipuyoSeq = fr.visibleKumipuyoSeq();
+        pgs->kumipuyoPos = fr.kumipuyoPos();
+        pgs->event = fr.userEvent();
+        pgs->dead = fr.isDead();
+        pgs->playable = fr.playable();
+        pgs->score = fr.score();
+        pgs->pendingOjama = fr.numPendingOjama();
+        pgs->fixedOjama = fr.numFixedOjama();
+        pgs->decision = decision[pi];
+        pgs->message = message[pi];
+    }
+
+    return gs;
+}
+
+void DuelState::play(const vector<FrameResponse> data[2])
+{
+    for (int pi = 0; pi < 2; pi++) {
+        FieldRealtime* me = &field[pi];
+        FieldRealtime* opponent = &field[1 - pi];
+
+        int accepted_index = updateDecision(frameId, data[pi], *me, &decision[pi]);
+
+        // TODO(mayah): ReceivedData from HumanConnector does not have any decision.
+        // So, all data will be marked as NACK. Since the HumanConnector does not see ACK/NACK,
+        // it's OK for now. However, this might cause future issues. Consider better way.
+
+        if (accepted_index != -1) {
+            // The decision can arrive while puyos are still falling (e.g. ojama).
+            CoreField cf(CoreField::fromPlainFieldWithDrop(me->field()));
+            KeySetSeq kss = PuyoController::findKeyStrokeFrom(cf, me->kumipuyoMovingState(), decision[pi]);
+            me->setKeySetSeq(kss);
+        }
+
+        string acceptedMessage;
+        if (accepted_index != -1)
+            acceptedMessage = data[pi][accepted_index].message;
+
+        VLOG(1) << "Current KeySetSeq: " << pi << " " << me->keySetSeq().toString();
+        KeySet keySet = me->frontKeySet();
+        me->dropFrontKeySet();
+        // For human connector. The received data from HumanConnector might have some key.
+        if (accepted_index != -1 && data[pi][accepted_index].keySet.hasSomeKey()) {
+            keySet = data[pi][accepted_index].keySet;
+        }
+
+        FrameContext context;
+        me->playOneFrame(keySet, &context);
+        context.apply(me, opponent);
+
+        // Clear current key input if the move is done.
+        if (me->userEvent().grounded) {
+            decision[pi] = Decision();
+            me->setKeySetSeq(KeySetSeq());
+        }
+
+        if (!acceptedMessage.empty()) {
+            message[pi] = acceptedMessage;
+        }
+    }
+}
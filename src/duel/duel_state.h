@@ -0,0 +1,30 @@
+#ifndef DUEL_DUEL_STATE_H_
+#define DUEL_DUEL_STATE_H_
+
+#include <string>
+#include <vector>
+
+#include "core/decision.h"
+#include "core/kumipuyo_seq.h"
+#include "core/server/game_state.h"
+#include "duel/field_realtime.h"
+
+struct FrameResponse;
+
+// DuelState is the state of a duel between 2 players.
+// DuelServer and HeadlessDuel proceed a duel frame by frame with this.
+struct DuelState {
+    explicit DuelState(const KumipuyoSeq& seq) : field { FieldRealtime(0, seq), FieldRealtime(1, seq) } {}
+
+    GameState toGameState() const;
+
+    // Plays one frame with the responses from the players.
+    void play(const std::vector<FrameResponse> data[2]);
+
+    int frameId = 0;
+    FieldRealtime field[2];
+    Decision decision[2];
+    std::string message[2];
+};
+
+#endif // DUEL_DUEL_STATE_H_
@@ -0,0 +1,186 @@
+#include "duel/headless_duel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <sstream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "core/client/ai/ai.h"
+#include "core/frame_request.h"
+#include "core/frame_response.h"
+#include "core/kumipuyo_seq.h"
+#include "core/kumipuyo_seq_generator.h"
+#include "core/server/game_state.h"
+#include "duel/duel_state.h"
+
+using namespace std;
+
+struct HeadlessDuel::Player {
+    explicit Player(unique_ptr<AI> ai) : ai(std::move(ai)) {}
+
+    unique_ptr<AI> ai;
+    // The virtual time when the AI finishes the current work [s].
+    double clock = 0;
+    // The responses and the frameId when they become visible.
+    deque<pair<int, FrameResponse>> responses;
+    double thinkTime = 0;
+    int numLateResponses = 0;
+};
+
+void HeadlessDuelStats::add(const HeadlessDuelResult& result)
+{
+    numMatches++;
+    switch (result.gameResult) {
+    case GameResult::P1_WIN:
+    case GameResult::P1_WIN_WITH_CONNECTION_ERROR:
+        p1Win++;
+        break;
+    case GameResult::P2_WIN:
+    case GameResult::P2_WIN_WITH_CONNECTION_ERROR:
+        p2Win++;
+        break;
+    default:
+        draw++;
+        break;
+    }
+
+    totalFrames += result.frames;
+    for (int pi = 0; pi < 2; ++pi) {
+        totalScore[pi] += result.score[pi];
+        totalThinkTime[pi] += result.thinkTime[pi];
+        numLateResponses[pi] += result.numLateResponses[pi];
+    }
+}
+
+string HeadlessDuelStats::toString() const
+{
+    const int n = std::max(numMatches, 1);
+
+    stringstream ss;
+    ss << "matches = " << numMatches << endl
+       << "1P win / draw / 2P win = " << p1Win << " / " << draw << " / " << p2Win << endl
+       << "1P win rate = " << (100.0 * p1Win / n) << "%" << endl
+       << "ave frames = " << (totalFrames / n) << endl;
+    for (int pi = 0; pi < 2; ++pi) {
+        ss << (pi + 1) << "P: ave score = " << (totalScore[pi] / n)
+           << " ave think time = " << (totalThinkTime[pi] / n) << " [s]"
+           << " late responses = " << numLateResponses[pi] << endl;
+    }
+    return ss.str();
+}
+
+HeadlessDuel::HeadlessDuel(unique_ptr<AI> p1, unique_ptr<AI> p2, const HeadlessDuelOptions& options) :
+    options_(options)
+{
+    players_[0].reset(new Player(std::move(p1)));
+    players_[1].reset(new Player(std::move(p2)));
+}
+
+HeadlessDuel::~HeadlessDuel()
+{
+}
+
+HeadlessDuelResult HeadlessDuel::run(const KumipuyoSeq& kumipuyoSeq)
+{
+    DuelState duelState(kumipuyoSeq);
+
+    GameResult gameResult = GameResult::PLAYING;
+    while (gameResult == GameResult::PLAYING) {
+        duelState.frameId += 1;
+        const int frameId = duelState.frameId;
+
+        GameState gameState = duelState.toGameState();
+        for (int pi = 0; pi < 2; ++pi)
+            send(pi, frameId, gameState.toFrameRequestFor(pi));
+
+        // Collects the responses visible in this frame.
+        vector<FrameResponse> data[2];
+        for (int pi = 0; pi < 2; ++pi) {
+            auto& responses = players_[pi]->responses;
+            while (!responses.empty() && responses.front().first <= frameId) {
+                data[pi].push_back(std::move(responses.front().second));
+                responses.pop_front();
+            }
+            // A response for the previous frames might arrive late.
+            for (const auto& response : data[pi]) {
+                if (response.frameId < frameId)
+                    players_[pi]->numLateResponses++;
+            }
+        }
+
+        duelState.play(data);
+
+        gameResult = duelState.toGameState().gameResult();
+        if (gameResult == GameResult::PLAYING && frameId >= options_.maxFrames)
+            gameResult = GameResult::DRAW;
+    }
+
+    // Send the game result so that AIs can finish the game.
+    {
+        ++duelState.frameId;
+        GameState gameState = duelState.toGameState();
+        for (int pi = 0; pi < 2; ++pi) {
+            GameResult gr = pi == 0 ? gameResult : toOppositeResult(gameResult);
+            send(pi, duelState.frameId, gameState.toFrameRequestFor(pi, gr));
+        }
+    }
+
+    HeadlessDuelResult result;
+    result.gameResult = gameResult;
+    result.frames = duelState.frameId - 1;
+    for (int pi = 0; pi < 2; ++pi) {
+        result.score[pi] = duelState.field[pi].score();
+        result.thinkTime[pi] = players_[pi]->thinkTime;
+        result.numLateResponses[pi] = players_[pi]->numLateResponses;
+    }
+    return result;
+}
+
+void HeadlessDuel::send(int playerId, int frameId, const FrameRequest& request)
+{
+    Player* player = players_[playerId].get();
+
+    auto begin = chrono::steady_clock::now();
+    FrameResponse response = player->ai->playOneFrame(request);
+    auto end = chrono::steady_clock::now();
+
+    const double elapsed = chrono::duration<double>(end - begin).count();
+    player->thinkTime += elapsed;
+
+    // The request of |frameId| is sent at frameId / FPS [s]. If the AI is still working
+    // on the previous requests, this request waits for them like in a pipe.
+    // The response becomes visible in the frame when the AI finishes.
+    const double start = std::max(static_cast<double>(frameId) / FPS, player->clock);
+    player->clock = start + elapsed * options_.thinkTimeScale;
+    const int visibleFrameId = std::max(frameId, static_cast<int>(std::floor(player->clock * FPS)));
+
+    player->responses.emplace_back(visibleFrameId, std::move(response));
+}
+
+// static
+vector<HeadlessDuelResult> HeadlessDuel::runMatches(Executor* executor,
+                                                    const AIFactory& p1Factory,
+                                                    const AIFactory& p2Factory,
+                                                    int numMatches,
+                                                    int seedOffset,
+                                                    const HeadlessDuelOptions& options)
+{
+    vector<HeadlessDuelResult> results(numMatches);
+
+    TaskGroup taskGroup(executor);
+    for (int i = 0; i < numMatches; ++i) {
+        taskGroup.run([&, i]() {
+            HeadlessDuel duel(p1Factory(), p2Factory(), options);
+            KumipuyoSeq seq = KumipuyoSeqGenerator::generateACPuyo2SequenceWithSeed(seedOffset + i);
+            results[i] = duel.run(seq);
+        });
+    }
+    taskGroup.wait();
+
+    return results;
+}
@@ -0,0 +1,87 @@
+#ifndef DUEL_HEADLESS_DUEL_H_
+#define DUEL_HEADLESS_DUEL_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "core/frame.h"
+#include "core/game_result.h"
+
+class AI;
+class Executor;
+class KumipuyoSeq;
+struct FrameRequest;
+
+struct HeadlessDuelOptions {
+    // The time an AI spends for a frame is multiplied by this, and charged to the AI's
+    // virtual clock. The response becomes visible to the game when the virtual clock
+    // reaches the time, as if the AI were connected to the duel server in realtime.
+    // 0 means the AIs answer immediately.
+    double thinkTimeScale = 1.0;
+    // When a game doesn't finish in this frames, it's a draw.
+    int maxFrames = FPS * 60 * 10;
+};
+
+struct HeadlessDuelResult {
+    // The result from 1P's view.
+    GameResult gameResult = GameResult::PLAYING;
+    int frames = 0;
+    int score[2] {};
+    // The wall-clock time spent in the AIs [s].
+    double thinkTime[2] {};
+    // The number of frame responses that were visible after the frame was played.
+    int numLateResponses[2] {};
+};
+
+struct HeadlessDuelStats {
+    void add(const HeadlessDuelResult&);
+    std::string toString() const;
+
+    int numMatches = 0;
+    int p1Win = 0;
+    int p2Win = 0;
+    int draw = 0;
+    std::int64_t totalFrames = 0;
+    std::int64_t totalScore[2] {};
+    double totalThinkTime[2] {};
+    std::int64_t numLateResponses[2] {};
+};
+
+// HeadlessDuel runs a duel between 2 AIs in process. Instead of the connectors and
+// wall-clock pacing of DuelServer, the AIs are called directly and the game proceeds
+// as fast as the AIs can answer. The think time is simulated with a virtual clock
+// (see HeadlessDuelOptions::thinkTimeScale).
+class HeadlessDuel : noncopyable {
+public:
+    typedef std::function<std::unique_ptr<AI> ()> AIFactory;
+
+    HeadlessDuel(std::unique_ptr<AI> p1, std::unique_ptr<AI> p2,
+                 const HeadlessDuelOptions& = HeadlessDuelOptions());
+    ~HeadlessDuel();
+
+    HeadlessDuelResult run(const KumipuyoSeq&);
+
+    // Runs |numMatches| duels in parallel with |executor|. Each duel has its own AIs
+    // created by the factories. The i-th duel uses the sequence generated with
+    // seed (seedOffset + i). |executor| can be nullptr.
+    static std::vector<HeadlessDuelResult> runMatches(Executor* executor,
+                                                      const AIFactory& p1Factory,
+                                                      const AIFactory& p2Factory,
+                                                      int numMatches,
+                                                      int seedOffset,
+                                                      const HeadlessDuelOptions& = HeadlessDuelOptions());
+
+private:
+    struct Player;
+
+    void send(int playerId, int frameId, const FrameRequest&);
+
+    std::unique_ptr<Player> players_[2];
+    HeadlessDuelOptions options_;
+};
+
+#endif // DUEL_HEADLESS_DUEL_H_
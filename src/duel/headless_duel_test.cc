@@ -0,0 +1,117 @@
+#include "duel/headless_duel.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+#include "core/client/ai/ai.h"
+#include "core/core_field.h"
+#include "core/kumipuyo_seq_generator.h"
+
+using namespace std;
+
+namespace {
+
+// Always drops puyos on the 3rd column, so it dies soon.
+class Column3AI : public AI {
+public:
+    Column3AI() : AI("column3") {}
+
+protected:
+    DropDecision think(int, const CoreField&, const KumipuyoSeq&,
+                       const PlayerState&, const PlayerState&, bool) const override
+    {
+        return DropDecision(Decision(3, 0));
+    }
+};
+
+// Drops puyos on the lowest column.
+class FlatAI : public AI {
+public:
+    FlatAI() : AI("flat") {}
+
+protected:
+    DropDecision think(int, const CoreField& field, const KumipuyoSeq&,
+                       const PlayerState&, const PlayerState&, bool) const override
+    {
+        int x = 3;
+        for (int i = 1; i <= 6; ++i) {
+            if (field.height(i) < field.height(x))
+                x = i;
+        }
+        return DropDecision(Decision(x, 0));
+    }
+};
+
+} // namespace anonymous
+
+TEST(HeadlessDuelTest, run)
+{
+    HeadlessDuelOptions options;
+    options.thinkTimeScale = 0;
+
+    HeadlessDuel duel(unique_ptr<AI>(new Column3AI), unique_ptr<AI>(new FlatAI), options);
+    HeadlessDuelResult result = duel.run(KumipuyoSeqGenerator::generateACPuyo2SequenceWithSeed(1));
+
+    EXPECT_EQ(GameResult::P2_WIN, result.gameResult);
+    EXPECT_LT(0, result.frames);
+    EXPECT_EQ(0, result.numLateResponses[0]);
+    EXPECT_EQ(0, result.numLateResponses[1]);
+}
+
+TEST(HeadlessDuelTest, maxFrames)
+{
+    HeadlessDuelOptions options;
+    options.thinkTimeScale = 0;
+    options.maxFrames = 100;
+
+    HeadlessDuel duel(unique_ptr<AI>(new FlatAI), unique_ptr<AI>(new FlatAI), options);
+    HeadlessDuelResult result = duel.run(KumipuyoSeqGenerator::generateACPuyo2SequenceWithSeed(1));
+
+    EXPECT_EQ(GameResult::DRAW, result.gameResult);
+    EXPECT_EQ(100, result.frames);
+}
+
+TEST(HeadlessDuelTest, slowThinkIsLate)
+{
+    // Pretend that thinking takes much longer than 1 frame.
+    HeadlessDuelOptions options;
+    options.thinkTimeScale = 1e6;
+    options.maxFrames = 600;
+
+    HeadlessDuel duel(unique_ptr<AI>(new FlatAI), unique_ptr<AI>(new FlatAI), options);
+    HeadlessDuelResult result = duel.run(KumipuyoSeqGenerator::generateACPuyo2SequenceWithSeed(1));
+
+    EXPECT_LT(0, result.numLateResponses[0]);
+    EXPECT_LT(0, result.numLateResponses[1]);
+}
+
+TEST(HeadlessDuelTest, runMatches)
+{
+    HeadlessDuelOptions options;
+    options.thinkTimeScale = 0;
+
+    auto p1Factory = []() { return unique_ptr<AI>(new Column3AI); };
+    auto p2Factory = []() { return unique_ptr<AI>(new FlatAI); };
+
+    vector<HeadlessDuelResult> expected = HeadlessDuel::runMatches(nullptr, p1Factory, p2Factory, 4, 0, options);
+
+    Executor executor(2);
+    executor.start();
+    vector<HeadlessDuelResult> actual = HeadlessDuel::runMatches(&executor, p1Factory, p2Factory, 4, 0, options);
+    executor.stop();
+
+    ASSERT_EQ(expected.size(), actual.size());
+    HeadlessDuelStats stats;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].gameResult, actual[i].gameResult);
+        EXPECT_EQ(expected[i].frames, actual[i].frames);
+        EXPECT_EQ(expected[i].score[0], actual[i].score[0]);
+        EXPECT_EQ(expected[i].score[1], actual[i].score[1]);
+        stats.add(actual[i]);
+    }
+
+    EXPECT_EQ(4, stats.numMatches);
+    EXPECT_EQ(4, stats.p2Win);
+}
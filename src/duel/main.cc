@@ -25,6 +25,7 @@
 #include "duel/puyofu_recorder.h"
 
 #ifdef USE_HTTPD
+#include "net/httpd/event_stream.h"
 #include "net/httpd/http_handler.h"
 #include "net/httpd/http_server.h"
 #endif
@@ -53,6 +54,7 @@ DEFINE_bool(ignore_sigpipe, false, "true to ignore SIGPIPE");
 #ifdef USE_HTTPD
 DEFINE_bool(httpd, false, "use httpd");
 DEFINE_int32(httpd_port, 8000, "httpd port");
+DEFINE_int32(httpd_stream_buffer, 30, "the number of frames kept for the slow /stream clients");
 DECLARE_string(data_dir);
 #endif
 
@@ -68,31 +70,45 @@ DEFINE_bool(use_cui, true, "use CUI version drawer");
 DEFINE_bool(use_audio, false, "use audio commentator");
 #endif
 
+#if USE_HTTPD
+// GameStateHandler serves the game state to the browsers.
+// /data returns the latest state, and /stream pushes the changes of each frame
+// as server-sent events.
 class GameStateHandler : public GameStateObserver {
 public:
-    GameStateHandler() {}
+    GameStateHandler() : stream_(FLAGS_httpd_stream_buffer) {}
     virtual ~GameStateHandler() {}
 
-#if USE_HTTPD
     void handle(const HttpRequest& req, HttpResponse* resp) {
         UNUSED_VARIABLE(req);
 
         lock_guard<mutex> lock(mu_);
-        if (!gameState_)
-            return;
-        resp->setContent(gameState_->toJson());
+        resp->setContent(json_);
     }
-#endif
+
+    EventStream* stream() { return &stream_; }
 
     virtual void onUpdate(const GameState& gameState) override {
-        lock_guard<mutex> lock(mu_);
+        // The state is serialized once here, instead of on every request.
+        string json = gameState.toCompactJson();
+        string delta = gameState_ ? gameState.toCompactJsonDelta(*gameState_) : json;
         gameState_.reset(new GameState(gameState));
+
+        if (delta != "{}")
+            stream_.publish(delta, json);
+
+        lock_guard<mutex> lock(mu_);
+        json_ = std::move(json);
     }
 
 private:
     mutex mu_;
+    string json_;
+    // Touched only by onUpdate().
     unique_ptr<GameState> gameState_;
+    EventStream stream_;
 };
+#endif
 
 #if !defined(_MSC_VER)
 static void ignoreSIGPIPE()
@@ -147,6 +163,7 @@ int main(int argc, char* argv[])
         httpServer->installHandler("/data", [&](const HttpRequest& req, HttpResponse* res){
             gameStateHandler->handle(req, res);
         });
+        httpServer->installEventStreamHandler("/stream", gameStateHandler->stream());
         httpServer->setAssetDirectory(file::joinPath(FLAGS_data_dir, "assets"));
     }
 #endif
@@ -286,8 +303,10 @@ int main(int argc, char* argv[])
 
     duelServer.join();
 #if USE_HTTPD
-    if (httpServer.get())
+    if (httpServer.get()) {
+        gameStateHandler->stream()->close();
         httpServer->stop();
+    }
 #endif
 #if USE_AUDIO_COMMENTATOR
     if (audioServer.get())
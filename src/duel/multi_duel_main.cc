@@ -0,0 +1,78 @@
+#include <signal.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "duel/multi_duel_server.h"
+
+DECLARE_int32(num_duel);
+DECLARE_int32(num_win);
+
+DEFINE_bool(league, false, "Play all the pairs of the given programs. "
+            "Otherwise, the programs are taken as the pairs of the matches.");
+
+using namespace std;
+
+static void ignoreSIGPIPE()
+{
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+
+    act.sa_handler = SIG_IGN;
+    sigemptyset(&act.sa_mask);
+
+    CHECK(sigaction(SIGPIPE, &act, 0) == 0);
+}
+
+// Runs many matches in one process, e.g.
+//   multi_duel a.sh b.sh c.sh d.sh           (a vs b, and c vs d)
+//   multi_duel --league a.sh b.sh c.sh       (a vs b, a vs c, and b vs c)
+int main(int argc, char* argv[])
+{
+    google::InitGoogleLogging(argv[0]);
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InstallFailureSignalHandler();
+
+    // A dead AI should not kill the other matches.
+    ignoreSIGPIPE();
+
+    vector<string> programs(argv + 1, argv + argc);
+    vector<pair<string, string>> pairs;
+    if (FLAGS_league) {
+        for (size_t i = 0; i < programs.size(); ++i) {
+            for (size_t j = i + 1; j < programs.size(); ++j)
+                pairs.emplace_back(programs[i], programs[j]);
+        }
+    } else {
+        if (programs.empty() || programs.size() % 2 != 0) {
+            LOG(ERROR) << "The programs should be given in pairs.";
+            return 1;
+        }
+        for (size_t i = 0; i < programs.size(); i += 2)
+            pairs.emplace_back(programs[i], programs[i + 1]);
+    }
+
+    if (pairs.empty()) {
+        LOG(ERROR) << "No match to play.";
+        return 1;
+    }
+
+    unique_ptr<Executor> executor = Executor::makeDefaultExecutor();
+    StreamMultiDuelResultSink sink(&cout);
+    MultiDuelServer server(executor.get(), &sink);
+    for (const auto& p : pairs)
+        server.addMatch(p.first, p.second, FLAGS_num_duel, FLAGS_num_win);
+
+    server.run();
+    executor->stop();
+
+    cout << sink.summary();
+    return 0;
+}
@@ -0,0 +1,362 @@
+#include "duel/multi_duel_server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <deque>
+#include <sstream>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "core/frame.h"
+#include "core/frame_response.h"
+#include "core/kumipuyo_seq_generator.h"
+#include "core/server/connector/pipe_connector.h"
+#include "core/server/connector/server_connector.h"
+#include "core/server/game_state.h"
+#include "duel/duel_state.h"
+
+DECLARE_bool(use_even);
+
+using namespace std;
+
+struct MultiDuelServer::Match {
+    int id;
+    string name[2];
+    unique_ptr<ServerConnector> connector[2];
+    PipeConnector* pipeConnector[2];
+    int numGames;
+    int numWins;
+
+    // Touched only by the task stepping this match.
+    unique_ptr<DuelState> duelState;
+    int gamesPlayed = 0;
+    int p1Win = 0;
+    int p1Lose = 0;
+
+    // The responses received by the event loop.
+    mutex mu;
+    deque<FrameResponse> responses[2];
+    atomic<bool> closed[2];
+};
+
+void StreamMultiDuelResultSink::matchWillStart(int matchId, const string& p1, const string& p2)
+{
+    lock_guard<mutex> lock(mu_);
+    Match& match = matches_[matchId];
+    match.name[0] = p1;
+    match.name[1] = p2;
+}
+
+void StreamMultiDuelResultSink::add(const MultiDuelGameResult& result)
+{
+    lock_guard<mutex> lock(mu_);
+    Match& match = matches_[result.matchId];
+    switch (result.gameResult) {
+    case GameResult::P1_WIN:
+    case GameResult::P1_WIN_WITH_CONNECTION_ERROR:
+        match.p1Win++;
+        break;
+    case GameResult::P2_WIN:
+    case GameResult::P2_WIN_WITH_CONNECTION_ERROR:
+        match.p1Lose++;
+        break;
+    default:
+        match.draw++;
+        break;
+    }
+
+    *os_ << "match " << result.matchId << " game " << result.gameIndex << ": "
+         << toString(result.gameResult)
+         << " frames=" << result.frames
+         << " score=" << result.score[0] << "-" << result.score[1] << endl;
+}
+
+string StreamMultiDuelResultSink::summary() const
+{
+    lock_guard<mutex> lock(mu_);
+    ostringstream ss;
+    for (const auto& entry : matches_) {
+        const Match& match = entry.second;
+        ss << "match " << entry.first << ": " << match.name[0] << " vs " << match.name[1] << ": "
+           << match.p1Win << " / " << match.draw << " / " << match.p1Lose << endl;
+    }
+    return ss.str();
+}
+
+MultiDuelServer::MultiDuelServer(Executor* executor, MultiDuelResultSink* sink) :
+    executor_(executor),
+    sink_(sink),
+    frameDuration_(chrono::microseconds(1000000 / FPS)),
+    shouldStop_(false),
+    eventLoopShouldStop_(false)
+{
+    DCHECK(sink);
+}
+
+MultiDuelServer::~MultiDuelServer()
+{
+}
+
+int MultiDuelServer::addMatch(const string& p1Program, const string& p2Program, int numGames, int numWins)
+{
+    return addMatch(ServerConnector::create(0, p1Program), ServerConnector::create(1, p2Program),
+                    p1Program, p2Program, numGames, numWins);
+}
+
+int MultiDuelServer::addMatch(unique_ptr<ServerConnector> p1, unique_ptr<ServerConnector> p2,
+                              const string& p1Name, const string& p2Name, int numGames, int numWins)
+{
+    unique_ptr<Match> match(new Match);
+    match->id = static_cast<int>(matches_.size());
+    match->name[0] = p1Name;
+    match->name[1] = p2Name;
+    match->connector[0] = std::move(p1);
+    match->connector[1] = std::move(p2);
+    for (int pi = 0; pi < 2; ++pi) {
+        CHECK(!match->connector[pi]->isHuman()) << "MultiDuelServer doesn't support human players";
+        match->pipeConnector[pi] = static_cast<PipeConnector*>(match->connector[pi].get());
+        CHECK_GE(match->pipeConnector[pi]->pollableFd(), 0) << "The connector can't be polled: " << match->name[pi];
+        match->closed[pi] = false;
+    }
+    match->numGames = numGames;
+    match->numWins = numWins;
+
+    sink_->matchWillStart(match->id, p1Name, p2Name);
+    matches_.push_back(std::move(match));
+    return matches_.back()->id;
+}
+
+void MultiDuelServer::run()
+{
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    PCHECK(epollFd_ >= 0) << "failed to create epoll";
+
+    vector<Match*> activeMatches;
+    for (size_t i = 0; i < matches_.size(); ++i) {
+        Match* match = matches_[i].get();
+        for (int pi = 0; pi < 2; ++pi) {
+            // The event loop reads whatever has arrived, so that a slow client doesn't block the others.
+            // The fd can be shared with the writes (e.g. SocketConnector). Socket::writeExactly()
+            // waits with poll() when the fd isn't writable.
+            int fd = match->pipeConnector[pi]->pollableFd();
+            int flags = fcntl(fd, F_GETFL);
+            PCHECK(flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
+
+            struct epoll_event event {};
+            event.events = EPOLLIN;
+            event.data.u64 = i * 2 + pi;
+            PCHECK(epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == 0);
+        }
+        activeMatches.push_back(match);
+    }
+
+    eventLoopShouldStop_ = false;
+    eventLoopThread_ = thread([this]() {
+        runEventLoop();
+    });
+
+    auto nextTick = chrono::steady_clock::now();
+    while (!activeMatches.empty() && !shouldStop_) {
+        nextTick += frameDuration_;
+
+        // vector<bool> is not safe to be updated from multiple threads.
+        vector<char> alive(activeMatches.size());
+        {
+            TaskGroup taskGroup(executor_);
+            for (size_t i = 0; i < activeMatches.size(); ++i) {
+                taskGroup.run([this, &activeMatches, &alive, i]() {
+                    alive[i] = step(activeMatches[i]);
+                });
+            }
+            taskGroup.wait();
+        }
+
+        vector<Match*> stillActive;
+        for (size_t i = 0; i < activeMatches.size(); ++i) {
+            if (alive[i]) {
+                stillActive.push_back(activeMatches[i]);
+                continue;
+            }
+            lock_guard<mutex> lock(retireMu_);
+            matchesToRetire_.push_back(activeMatches[i]);
+        }
+        activeMatches = std::move(stillActive);
+
+        // When the matches cannot be stepped in time, don't try to catch up.
+        auto now = chrono::steady_clock::now();
+        if (now < nextTick)
+            this_thread::sleep_until(nextTick);
+        else
+            nextTick = now;
+    }
+
+    {
+        lock_guard<mutex> lock(retireMu_);
+        for (Match* match : activeMatches)
+            matchesToRetire_.push_back(match);
+    }
+
+    eventLoopShouldStop_ = true;
+    eventLoopThread_.join();
+
+    close(epollFd_);
+    epollFd_ = -1;
+}
+
+void MultiDuelServer::runEventLoop()
+{
+    const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+    char buf[4096];
+
+    while (!eventLoopShouldStop_) {
+        retireMatches();
+
+        // Wakes up periodically to retire the matches and to check the stop flag.
+        int n = epoll_wait(epollFd_, events, MAX_EVENTS, 100);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            PLOG(ERROR) << "epoll_wait";
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            Match* match = matches_[events[i].data.u64 / 2].get();
+            int pi = events[i].data.u64 % 2;
+            if (!match->connector[pi] || match->closed[pi])
+                continue;
+
+            // The fd is non-blocking. A response might arrive in pieces, so the connector
+            // keeps the partial response until the rest arrives.
+            PipeConnector* connector = match->pipeConnector[pi];
+            ssize_t size = read(connector->pollableFd(), buf, sizeof(buf));
+            if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+                continue;
+
+            vector<FrameResponse> responses;
+            if (size <= 0 || !connector->parseReceivedData(buf, size, &responses)) {
+                LOG(INFO) << "match " << match->id << ": failed to receive from " << match->name[pi];
+                epoll_ctl(epollFd_, EPOLL_CTL_DEL, connector->pollableFd(), nullptr);
+                match->closed[pi] = true;
+                continue;
+            }
+
+            lock_guard<mutex> lock(match->mu);
+            for (const FrameResponse& response : responses)
+                match->responses[pi].push_back(response);
+        }
+    }
+
+    retireMatches();
+}
+
+void MultiDuelServer::retireMatches()
+{
+    vector<Match*> matches;
+    {
+        lock_guard<mutex> lock(retireMu_);
+        matches.swap(matchesToRetire_);
+    }
+
+    for (Match* match : matches) {
+        for (int pi = 0; pi < 2; ++pi) {
+            if (!match->connector[pi])
+                continue;
+            if (!match->closed[pi])
+                epoll_ctl(epollFd_, EPOLL_CTL_DEL, match->pipeConnector[pi]->pollableFd(), nullptr);
+            match->pipeConnector[pi] = nullptr;
+            match->connector[pi].reset();
+        }
+    }
+}
+
+bool MultiDuelServer::step(Match* match)
+{
+    if (!match->duelState) {
+        match->duelState.reset(new DuelState(KumipuyoSeqGenerator::generateACPuyo2Sequence()));
+        sendFrameRequests(match);
+        return true;
+    }
+
+    if (match->closed[0] || match->closed[1]) {
+        return finishGame(match, match->closed[0] ?
+                          GameResult::P2_WIN_WITH_CONNECTION_ERROR : GameResult::P1_WIN_WITH_CONNECTION_ERROR);
+    }
+
+    DuelState* duelState = match->duelState.get();
+    int frameId = duelState->frameId;
+
+    // Takes the responses up to the current frame, as ConnectorManager does.
+    vector<FrameResponse> data[2];
+    {
+        lock_guard<mutex> lock(match->mu);
+        for (int pi = 0; pi < 2; ++pi) {
+            while (!match->responses[pi].empty()) {
+                FrameResponse response = match->responses[pi].front();
+                match->responses[pi].pop_front();
+                data[pi].push_back(response);
+                if (response.frameId == frameId)
+                    break;
+            }
+        }
+    }
+
+    duelState->play(data);
+    GameResult gameResult = duelState->toGameState().gameResult();
+    if (gameResult == GameResult::PLAYING && FLAGS_use_even && frameId >= FPS * 120)
+        gameResult = GameResult::DRAW;
+
+    if (gameResult != GameResult::PLAYING)
+        return finishGame(match, gameResult);
+
+    sendFrameRequests(match);
+    return true;
+}
+
+void MultiDuelServer::sendFrameRequests(Match* match)
+{
+    match->duelState->frameId += 1;
+    GameState gameState = match->duelState->toGameState();
+    for (int pi = 0; pi < 2; ++pi) {
+        if (!match->closed[pi])
+            match->connector[pi]->send(gameState.toFrameRequestFor(pi));
+    }
+}
+
+bool MultiDuelServer::finishGame(Match* match, GameResult gameResult)
+{
+    // Sends the request for the game result.
+    sendFrameRequests(match);
+
+    GameState gameState = match->duelState->toGameState();
+    MultiDuelGameResult result;
+    result.matchId = match->id;
+    result.gameIndex = match->gamesPlayed;
+    result.gameResult = gameResult;
+    result.frames = gameState.frameId();
+    for (int pi = 0; pi < 2; ++pi)
+        result.score[pi] = gameState.playerGameState(pi).score;
+    sink_->add(result);
+
+    match->gamesPlayed++;
+    if (gameResult == GameResult::P1_WIN)
+        match->p1Win++;
+    else if (gameResult == GameResult::P2_WIN)
+        match->p1Lose++;
+    match->duelState.reset();
+
+    if (gameResult == GameResult::P1_WIN_WITH_CONNECTION_ERROR ||
+        gameResult == GameResult::P2_WIN_WITH_CONNECTION_ERROR)
+        return false;
+    if (match->gamesPlayed == match->numGames)
+        return false;
+    if (match->p1Win == match->numWins || match->p1Lose == match->numWins)
+        return false;
+    return true;
+}
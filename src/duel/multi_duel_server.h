@@ -0,0 +1,122 @@
+#ifndef DUEL_MULTI_DUEL_SERVER_H_
+#define DUEL_MULTI_DUEL_SERVER_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "core/game_result.h"
+
+class Executor;
+class PipeConnector;
+class ServerConnector;
+
+struct MultiDuelGameResult {
+    int matchId = 0;
+    // The index of the game in the match.
+    int gameIndex = 0;
+    // The result from 1P's view.
+    GameResult gameResult = GameResult::PLAYING;
+    int frames = 0;
+    int score[2] {};
+};
+
+// MultiDuelResultSink receives the results of all the matches in a MultiDuelServer.
+// add() is called from the worker threads, so an implementation should be thread-safe.
+class MultiDuelResultSink {
+public:
+    virtual ~MultiDuelResultSink() {}
+
+    virtual void matchWillStart(int matchId, const std::string& p1, const std::string& p2) = 0;
+    virtual void add(const MultiDuelGameResult&) = 0;
+};
+
+// Writes a line for each game, and the win/draw/lose of each match on summary().
+class StreamMultiDuelResultSink : public MultiDuelResultSink {
+public:
+    explicit StreamMultiDuelResultSink(std::ostream* os) : os_(os) {}
+    ~StreamMultiDuelResultSink() override {}
+
+    void matchWillStart(int matchId, const std::string& p1, const std::string& p2) override;
+    void add(const MultiDuelGameResult&) override;
+
+    // e.g. "match 0: p1.sh vs p2.sh: 3 / 0 / 2"
+    std::string summary() const;
+
+private:
+    struct Match {
+        std::string name[2];
+        int p1Win = 0;
+        int draw = 0;
+        int p1Lose = 0;
+    };
+
+    mutable std::mutex mu_;
+    std::ostream* os_;
+    std::map<int, Match> matches_;
+};
+
+// MultiDuelServer hosts many independent matches in one process.
+// Instead of the threads of DuelServer and ConnectorManager for each match, one
+// thread receives the responses from all the AIs with epoll, and every frame tick
+// the matches are stepped in parallel on |executor|.
+// Only the connectors with a pollable fd are supported (e.g. stdio, but not shm).
+// The fds are made non-blocking, so a client sending a response slowly doesn't
+// block the other matches.
+class MultiDuelServer : noncopyable {
+public:
+    // Doesn't take ownership. |executor| can be nullptr.
+    MultiDuelServer(Executor* executor, MultiDuelResultSink* sink);
+    ~MultiDuelServer();
+
+    // Adds a match between 2 programs. The match finishes after |numGames| games, or when
+    // either player wins |numWins| games. Negative means infinity.
+    // Returns the match id.
+    int addMatch(const std::string& p1Program, const std::string& p2Program, int numGames, int numWins = -1);
+    int addMatch(std::unique_ptr<ServerConnector> p1, std::unique_ptr<ServerConnector> p2,
+                 const std::string& p1Name, const std::string& p2Name, int numGames, int numWins = -1);
+
+    // Sets the interval of the frame ticks. The default is 1/FPS.
+    void setFrameDuration(std::chrono::steady_clock::duration d) { frameDuration_ = d; }
+
+    // Runs all the matches until they finish or stop() is called.
+    void run();
+    // Can be called from any thread.
+    void stop() { shouldStop_ = true; }
+
+private:
+    struct Match;
+
+    void runEventLoop();
+    // Removes the connectors of the finished matches from epoll, and closes them.
+    void retireMatches();
+
+    // Steps |match| by a frame. Returns false when the match has finished.
+    bool step(Match*);
+    void sendFrameRequests(Match*);
+    // Returns false when the match has finished.
+    bool finishGame(Match*, GameResult);
+
+    Executor* executor_;
+    MultiDuelResultSink* sink_;
+    std::chrono::steady_clock::duration frameDuration_;
+
+    std::vector<std::unique_ptr<Match>> matches_;
+
+    int epollFd_ = -1;
+    std::thread eventLoopThread_;
+    std::atomic<bool> shouldStop_;
+    std::atomic<bool> eventLoopShouldStop_;
+
+    std::mutex retireMu_;
+    std::vector<Match*> matchesToRetire_;
+};
+
+#endif // DUEL_MULTI_DUEL_SERVER_H_
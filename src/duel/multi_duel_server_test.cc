@@ -0,0 +1,214 @@
+#include "duel/multi_duel_server.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+#include "core/client/client_connector.h"
+#include "core/connector/connector_impl.h"
+#include "core/frame_request.h"
+#include "core/frame_response.h"
+#include "core/server/connector/pipe_connector.h"
+
+using namespace std;
+
+namespace {
+
+class TestServerConnector : public PipeConnector {
+public:
+    TestServerConnector(int playerId, int fd) : PipeConnector(playerId), fd_(fd) {}
+    ~TestServerConnector() override { close(fd_); }
+
+    int pollableFd() const override { return fd_; }
+
+protected:
+    bool writeData(const void* data, size_t size) override
+    {
+        return ::send(fd_, data, size, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+    }
+
+    bool readData(void* data, size_t size) override
+    {
+        return recv(fd_, data, size, MSG_WAITALL) == static_cast<ssize_t>(size);
+    }
+
+private:
+    int fd_;
+};
+
+class TestClientConnectorImpl : public ConnectorImpl {
+public:
+    explicit TestClientConnectorImpl(int fd) : fd_(fd) {}
+    ~TestClientConnectorImpl() override { close(fd_); }
+
+    bool readExactly(void* buf, size_t size) override
+    {
+        return recv(fd_, buf, size, MSG_WAITALL) == static_cast<ssize_t>(size);
+    }
+
+    bool writeExactly(const void* buf, size_t size) override
+    {
+        return ::send(fd_, buf, size, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+    }
+
+    void flush() override {}
+
+private:
+    int fd_;
+};
+
+// Same as TestClientConnectorImpl, but sends the data in 2 pieces with an interval,
+// so the server receives partial responses.
+class SlowTestClientConnectorImpl : public TestClientConnectorImpl {
+public:
+    explicit SlowTestClientConnectorImpl(int fd) : TestClientConnectorImpl(fd) {}
+
+    bool writeExactly(const void* buf, size_t size) override
+    {
+        if (size <= 1)
+            return TestClientConnectorImpl::writeExactly(buf, size);
+        if (!TestClientConnectorImpl::writeExactly(buf, 1))
+            return false;
+        this_thread::sleep_for(chrono::milliseconds(1));
+        return TestClientConnectorImpl::writeExactly(static_cast<const char*>(buf) + 1, size - 1);
+    }
+};
+
+// A client that answers every frame without any decision.
+// It stops when the server closes the connection.
+void runClient(int fd, bool slow = false)
+{
+    unique_ptr<ConnectorImpl> impl(slow ? new SlowTestClientConnectorImpl(fd) : new TestClientConnectorImpl(fd));
+    ClientConnector connector(std::move(impl));
+    FrameRequest request;
+    while (connector.receive(&request)) {
+        FrameResponse response;
+        response.frameId = request.frameId;
+        connector.send(response);
+    }
+}
+
+} // anonymous namespace
+
+TEST(MultiDuelServerTest, run)
+{
+    const int NUM_MATCHES = 3;
+    const int NUM_GAMES = 2;
+
+    ostringstream output;
+    StreamMultiDuelResultSink sink(&output);
+    Executor executor(2);
+    executor.start();
+    MultiDuelServer server(&executor, &sink);
+    server.setFrameDuration(chrono::milliseconds(0));
+
+    vector<thread> clients;
+    for (int i = 0; i < NUM_MATCHES; ++i) {
+        unique_ptr<ServerConnector> connectors[2];
+        for (int pi = 0; pi < 2; ++pi) {
+            int sv[2];
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+            connectors[pi].reset(new TestServerConnector(pi, sv[0]));
+            clients.emplace_back(runClient, sv[1], false);
+        }
+        EXPECT_EQ(i, server.addMatch(std::move(connectors[0]), std::move(connectors[1]),
+                                     "p1", "p2", NUM_GAMES));
+    }
+
+    server.run();
+    for (auto& th : clients)
+        th.join();
+    executor.stop();
+
+    // Nobody moves the puyos, so both players die at the same time.
+    string summary = sink.summary();
+    for (int i = 0; i < NUM_MATCHES; ++i) {
+        string expected = "match " + to_string(i) + ": p1 vs p2: 0 / 2 / 0";
+        EXPECT_NE(string::npos, summary.find(expected)) << summary;
+    }
+}
+
+TEST(MultiDuelServerTest, connectionError)
+{
+    ostringstream output;
+    StreamMultiDuelResultSink sink(&output);
+    MultiDuelServer server(nullptr, &sink);
+    server.setFrameDuration(chrono::milliseconds(1));
+
+    int sv1[2], sv2[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv1));
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv2));
+    thread client(runClient, sv1[1], false);
+    // 2P has disconnected.
+    close(sv2[1]);
+
+    server.addMatch(unique_ptr<ServerConnector>(new TestServerConnector(0, sv1[0])),
+                    unique_ptr<ServerConnector>(new TestServerConnector(1, sv2[0])),
+                    "p1", "p2", 10);
+    server.run();
+    client.join();
+
+    EXPECT_NE(string::npos, output.str().find("p1 win (p2 connection error)")) << output.str();
+    EXPECT_NE(string::npos, sink.summary().find("1 / 0 / 0")) << sink.summary();
+}
+
+TEST(MultiDuelServerTest, slowClient)
+{
+    ostringstream output;
+    StreamMultiDuelResultSink sink(&output);
+    MultiDuelServer server(nullptr, &sink);
+    server.setFrameDuration(chrono::milliseconds(0));
+
+    vector<thread> clients;
+    for (int i = 0; i < 2; ++i) {
+        unique_ptr<ServerConnector> connectors[2];
+        for (int pi = 0; pi < 2; ++pi) {
+            int sv[2];
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+            connectors[pi].reset(new TestServerConnector(pi, sv[0]));
+            // Only 2P of the match 0 is slow.
+            clients.emplace_back(runClient, sv[1], i == 0 && pi == 1);
+        }
+        server.addMatch(std::move(connectors[0]), std::move(connectors[1]), "p1", "p2", 1);
+    }
+
+    server.run();
+    for (auto& th : clients)
+        th.join();
+
+    // The partial responses are not taken as connection errors.
+    EXPECT_NE(string::npos, sink.summary().find("match 0: p1 vs p2: 0 / 1 / 0")) << sink.summary();
+    EXPECT_NE(string::npos, sink.summary().find("match 1: p1 vs p2: 0 / 1 / 0")) << sink.summary();
+}
+
+TEST(MultiDuelServerTest, parseReceivedData)
+{
+    int sv[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+    close(sv[1]);
+    TestServerConnector connector(0, sv[0]);
+
+    string data;
+    for (int frameId = 1; frameId <= 2; ++frameId) {
+        string payload = FrameResponse(frameId).toString();
+        FrameResponseHeader header(payload.size());
+        data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        data.append(payload);
+    }
+
+    // Gives the data byte by byte. Each response is parsed when it's completed.
+    vector<FrameResponse> responses;
+    for (size_t i = 0; i < data.size(); ++i) {
+        ASSERT_TRUE(connector.parseReceivedData(&data[i], 1, &responses));
+        if (i + 1 < data.size() / 2)
+            EXPECT_TRUE(responses.empty());
+    }
+    ASSERT_EQ(2U, responses.size());
+    EXPECT_EQ(1, responses[0].frameId);
+    EXPECT_EQ(2, responses[1].frameId);
+}
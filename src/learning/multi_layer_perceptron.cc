@@ -11,10 +11,24 @@
 #include <sstream>
 #include <string>
 
+#if OS_WIN
+#include <malloc.h>
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <x86intrin.h>
+#endif
+
+#include <glog/logging.h>
+
+#include "base/executor.h"
 #include "base/file/file.h"
 
 namespace {
 
+// A shard smaller than this is not worth running in another thread.
+const int MIN_SAMPLES_PER_SHARD = 16;
+
 inline float activator(float x)
 {
     return std::tanh(x);
@@ -25,27 +39,136 @@ inline float d_activator(float x)
     return 1 / std::cosh(x) / std::cosh(x);
 }
 
+inline int padToAVX(int n)
+{
+    return (n + 7) & ~7;
+}
+
+learning::MultiLayerPerceptron::AlignedFloats makeAlignedFloats(size_t n)
+{
+    const size_t bytes = std::max<size_t>(n, 1) * sizeof(float);
+#if OS_WIN
+    void* p = _aligned_malloc(bytes, 32);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, 32, bytes) != 0)
+        p = nullptr;
+#endif
+    CHECK(p) << "failed to allocate " << bytes << " bytes";
+
+    float* fs = static_cast<float*>(p);
+    std::fill(fs, fs + n, 0.0f);
+    return learning::MultiLayerPerceptron::AlignedFloats(fs);
+}
+
+// C = A * B, where A is m x k, B is k x n, and C is m x n.
+// When |transposeA| is true, A is given as k x m instead, i.e. C = A^T * B.
+// |n|, |ldb| and |ldc| should be multiples of 8.
+template<bool transposeA>
+void multiply(const float* a, int lda, const float* b, int ldb, float* c, int ldc, int m, int n, int k)
+{
+    auto at = [a, lda](int row, int j) { return transposeA ? a[j * lda + row] : a[row * lda + j]; };
+
+#if defined(__AVX2__) && defined(__FMA__)
+    // Computes 4 rows x 8 columns of C at once in the registers.
+    int row = 0;
+    for (; row + 4 <= m; row += 4) {
+        for (int col = 0; col < n; col += 8) {
+            __m256 c0 = _mm256_setzero_ps();
+            __m256 c1 = _mm256_setzero_ps();
+            __m256 c2 = _mm256_setzero_ps();
+            __m256 c3 = _mm256_setzero_ps();
+            for (int j = 0; j < k; ++j) {
+                const __m256 bv = _mm256_loadu_ps(b + j * ldb + col);
+                c0 = _mm256_fmadd_ps(_mm256_set1_ps(at(row + 0, j)), bv, c0);
+                c1 = _mm256_fmadd_ps(_mm256_set1_ps(at(row + 1, j)), bv, c1);
+                c2 = _mm256_fmadd_ps(_mm256_set1_ps(at(row + 2, j)), bv, c2);
+                c3 = _mm256_fmadd_ps(_mm256_set1_ps(at(row + 3, j)), bv, c3);
+            }
+            _mm256_storeu_ps(c + (row + 0) * ldc + col, c0);
+            _mm256_storeu_ps(c + (row + 1) * ldc + col, c1);
+            _mm256_storeu_ps(c + (row + 2) * ldc + col, c2);
+            _mm256_storeu_ps(c + (row + 3) * ldc + col, c3);
+        }
+    }
+    for (; row < m; ++row) {
+        for (int col = 0; col < n; col += 8) {
+            __m256 c0 = _mm256_setzero_ps();
+            for (int j = 0; j < k; ++j)
+                c0 = _mm256_fmadd_ps(_mm256_set1_ps(at(row, j)), _mm256_loadu_ps(b + j * ldb + col), c0);
+            _mm256_storeu_ps(c + row * ldc + col, c0);
+        }
+    }
+#else
+    for (int row = 0; row < m; ++row) {
+        float* cr = c + row * ldc;
+        std::fill(cr, cr + n, 0.0f);
+        for (int j = 0; j < k; ++j) {
+            const float v = at(row, j);
+            const float* br = b + j * ldb;
+            for (int col = 0; col < n; ++col)
+                cr[col] += v * br[col];
+        }
+    }
+#endif
+}
+
+// y += alpha * x. |n| should be a multiple of 8.
+void axpy(int n, float alpha, const float* x, float* y)
+{
+#if defined(__AVX2__) && defined(__FMA__)
+    const __m256 av = _mm256_set1_ps(alpha);
+    for (int i = 0; i < n; i += 8)
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(av, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+#else
+    for (int i = 0; i < n; ++i)
+        y[i] += alpha * x[i];
+#endif
+}
+
+// x *= alpha.
+void scale(int n, float alpha, float* x)
+{
+    for (int i = 0; i < n; ++i)
+        x[i] *= alpha;
+}
+
 } // namespace
 
 namespace learning {
 
+void MultiLayerPerceptron::AlignedDeleter::operator()(float* p) const
+{
+#if OS_WIN
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
 MultiLayerPerceptron::MultiLayerPerceptron(int in, int hid, int out) :
     num_input_(in),
     num_hidden_(hid),
-    num_output_(out)
+    num_output_(out),
+    hidden_stride_(padToAVX(hid)),
+    output_stride_(padToAVX(out))
 {
-    w2_.reset(new float[(in + 1) * hid]);
-    w3_.reset(new float[(hid + 1) * out]);
+    w2_ = makeAlignedFloats((in + 1) * hidden_stride_);
+    w3_ = makeAlignedFloats((hid + 1) * output_stride_);
+    w3t_ = makeAlignedFloats(output_stride_ * hidden_stride_);
 
     std::random_device rd;
     std::mt19937 mt(rd());
     std::uniform_real_distribution<float> distribution(-1.0, 1.0);
 
-    for (int i = 0; i < (in + 1) * hid; ++i) {
-        w2_[i] = distribution(mt);
+    // The padding columns are kept 0.
+    for (int i = 0; i < in + 1; ++i) {
+        for (int j = 0; j < hid; ++j)
+            w2_[i * hidden_stride_ + j] = distribution(mt);
     }
-    for (int i = 0; i < (hid + 1) * out; ++i) {
-        w3_[i] = distribution(mt);
+    for (int i = 0; i < hid + 1; ++i) {
+        for (int j = 0; j < out; ++j)
+            w3_[i * output_stride_ + j] = distribution(mt);
     }
 }
 
@@ -57,20 +180,35 @@ MultiLayerPerceptron::ForwardingIntermediateStorage MultiLayerPerceptron::makeFo
 {
     ForwardingIntermediateStorage data;
     data.o1.reset(new float[num_input_ + 1]);
-    data.i2.reset(new float[num_hidden_]);
+    data.i2.reset(new float[hidden_stride_]);
     data.o2.reset(new float[num_hidden_ + 1]);
-    data.i3.reset(new float[num_output_]);
+    data.i3.reset(new float[output_stride_]);
     return data;
 }
 
 MultiLayerPerceptron::BackPropagationIntermediateStorage MultiLayerPerceptron::makeBackpropagationStorage() const
 {
     BackPropagationIntermediateStorage error_data;
-    error_data.e2.reset(new float[num_hidden_]);
-    error_data.e3.reset(new float[num_output_]);
+    error_data.e2.reset(new float[hidden_stride_]());
+    error_data.e3.reset(new float[output_stride_]());
     return error_data;
 }
 
+MultiLayerPerceptron::BatchStorage MultiLayerPerceptron::makeBatchStorage(int capacity) const
+{
+    BatchStorage storage;
+    storage.capacity = capacity;
+    storage.o1 = makeAlignedFloats(capacity * (num_input_ + 1));
+    storage.i2 = makeAlignedFloats(capacity * hidden_stride_);
+    storage.o2 = makeAlignedFloats(capacity * (num_hidden_ + 1));
+    storage.i3 = makeAlignedFloats(capacity * output_stride_);
+    storage.e2 = makeAlignedFloats(capacity * hidden_stride_);
+    storage.e3 = makeAlignedFloats(capacity * output_stride_);
+    storage.g2 = makeAlignedFloats((num_input_ + 1) * hidden_stride_);
+    storage.g3 = makeAlignedFloats((num_hidden_ + 1) * output_stride_);
+    return storage;
+}
+
 int MultiLayerPerceptron::hidden_layer_weight_size() const
 {
     return ((num_input_ + 1) * num_hidden_);
@@ -81,10 +219,39 @@ int MultiLayerPerceptron::output_layer_weight_size() const
     return ((num_hidden_ + 1) * num_output_);
 }
 
+int MultiLayerPerceptron::argmax(const float* i3) const
+{
+    return std::max_element(i3, i3 + num_output_) - i3;
+}
+
 int MultiLayerPerceptron::predict(const float x[], ForwardingIntermediateStorage* data) const
 {
     forward(x, data);
-    return std::max_element(data->i3.get(), data->i3.get() + num_output_) - data->i3.get();
+    return argmax(data->i3.get());
+}
+
+int MultiLayerPerceptron::predict(const float x[]) const
+{
+    thread_local std::vector<float> buffer;
+    const size_t size = (num_input_ + 1) + hidden_stride_ + (num_hidden_ + 1) + output_stride_;
+    if (buffer.size() < size)
+        buffer.resize(size);
+
+    float* o1 = buffer.data();
+    float* i2 = o1 + num_input_ + 1;
+    float* o2 = i2 + hidden_stride_;
+    float* i3 = o2 + num_hidden_ + 1;
+    forwardBatch(x, 1, o1, i2, o2, i3);
+    return argmax(i3);
+}
+
+void MultiLayerPerceptron::predictBatch(const float xs[], int n, int labels[], BatchStorage* storage) const
+{
+    CHECK_LE(n, storage->capacity);
+
+    forwardBatch(xs, n, storage->o1.get(), storage->i2.get(), storage->o2.get(), storage->i3.get());
+    for (int r = 0; r < n; ++r)
+        labels[r] = argmax(storage->i3.get() + r * output_stride_);
 }
 
 bool MultiLayerPerceptron::train(int correct_label,
@@ -108,72 +275,180 @@ bool MultiLayerPerceptron::train(int correct_label,
     for (int i = 0; i < num_hidden_; ++i) {
         float t = 0;
         for (int j = 0; j < num_output_; ++j) {
-            t += w3_[i * num_output_ + j] * error_data->e3[j];
+            t += w3_[i * output_stride_ + j] * error_data->e3[j];
         }
         error_data->e2[i] = t * d_activator(data->i2[i]);
     }
 
     // back propagation
     for (int i = 0; i < num_hidden_ + 1; ++i) {
-        for (int j = 0; j < num_output_; ++j) {
-            w3_[i * num_output_ + j] -= learning_rate * error_data->e3[j] * data->o2[i];
-        }
+        axpy(output_stride_, -learning_rate * data->o2[i], error_data->e3.get(), w3_.get() + i * output_stride_);
     }
 
     for (int i = 0; i < num_input_ + 1; ++i) {
-        for (int j = 0; j < num_hidden_; ++j) {
-            w2_[i * num_hidden_ + j] -= learning_rate * data->o1[i] * error_data->e2[j];
-        }
+        axpy(hidden_stride_, -learning_rate * data->o1[i], error_data->e2.get(), w2_.get() + i * hidden_stride_);
     }
 
     // normalization
     if (l2_normalization != 0.0) {
-        for (int i = 0; i < hidden_layer_weight_size(); ++i) {
-            w2_[i] -= learning_rate * l2_normalization * w2_[i];
-        }
-        for (int i = 0; i < output_layer_weight_size(); ++i) {
-            w3_[i] -= learning_rate * l2_normalization * w3_[i];
-        }
+        scale((num_input_ + 1) * hidden_stride_, 1 - learning_rate * l2_normalization, w2_.get());
+        scale((num_hidden_ + 1) * output_stride_, 1 - learning_rate * l2_normalization, w3_.get());
     }
 
     return correct_label == predicted_label;
 }
 
+int MultiLayerPerceptron::trainBatch(const int correct_labels[],
+                                     const float xs[],
+                                     int n,
+                                     float learning_rate,
+                                     float l2_normalization,
+                                     Executor* executor)
+{
+    if (n <= 0)
+        return 0;
+
+    int num_shards = executor ? executor->numThreads() : 1;
+    num_shards = std::max(1, std::min(num_shards, n / MIN_SAMPLES_PER_SHARD));
+    const int shard_size = (n + num_shards - 1) / num_shards;
+    num_shards = (n + shard_size - 1) / shard_size;
+
+    if (static_cast<int>(train_storages_.size()) < num_shards)
+        train_storages_.resize(num_shards);
+    for (int s = 0; s < num_shards; ++s) {
+        if (train_storages_[s].capacity < shard_size)
+            train_storages_[s] = makeBatchStorage(shard_size);
+    }
+
+    // The error is propagated back with the transposed weight. The bias row is not needed.
+    for (int j = 0; j < num_output_; ++j) {
+        for (int i = 0; i < num_hidden_; ++i)
+            w3t_[j * hidden_stride_ + i] = w3_[i * output_stride_ + j];
+    }
+
+    std::vector<int> num_corrects(num_shards);
+    {
+        TaskGroup group(executor);
+        for (int s = 0; s < num_shards; ++s) {
+            group.run([this, s, n, shard_size, correct_labels, xs, &num_corrects]() {
+                int begin = s * shard_size;
+                int end = std::min(n, begin + shard_size);
+                num_corrects[s] = backwardBatch(correct_labels, xs, begin, end, w3t_.get(), &train_storages_[s]);
+            });
+        }
+        group.wait();
+    }
+
+    // Reduces the gradients into the first storage.
+    const int w2_size = (num_input_ + 1) * hidden_stride_;
+    const int w3_size = (num_hidden_ + 1) * output_stride_;
+    BatchStorage* total = &train_storages_[0];
+    for (int s = 1; s < num_shards; ++s) {
+        axpy(w2_size, 1, train_storages_[s].g2.get(), total->g2.get());
+        axpy(w3_size, 1, train_storages_[s].g3.get(), total->g3.get());
+    }
+
+    axpy(w2_size, -learning_rate / n, total->g2.get(), w2_.get());
+    axpy(w3_size, -learning_rate / n, total->g3.get(), w3_.get());
+
+    // normalization
+    if (l2_normalization != 0.0) {
+        scale(w2_size, 1 - learning_rate * l2_normalization, w2_.get());
+        scale(w3_size, 1 - learning_rate * l2_normalization, w3_.get());
+    }
+
+    int num_correct = 0;
+    for (int c : num_corrects)
+        num_correct += c;
+    return num_correct;
+}
+
 void MultiLayerPerceptron::forward(const float x[], ForwardingIntermediateStorage* data) const
 {
-    for (int i = 0; i < num_input_; ++i) {
-        data->o1[i] = x[i];
+    forwardBatch(x, 1, data->o1.get(), data->i2.get(), data->o2.get(), data->i3.get());
+}
+
+void MultiLayerPerceptron::forwardBatch(const float xs[], int n, float* o1, float* i2, float* o2, float* i3) const
+{
+    const int o1_stride = num_input_ + 1;
+    const int o2_stride = num_hidden_ + 1;
+
+    for (int r = 0; r < n; ++r) {
+        std::copy(xs + r * num_input_, xs + (r + 1) * num_input_, o1 + r * o1_stride);
+        o1[r * o1_stride + num_input_] = 1.0;
     }
-    data->o1[num_input_] = 1.0;
 
-    std::fill(data->i2.get(), data->i2.get() + num_hidden_, 0.0);
-    for (int j = 0; j < num_input_ + 1; ++j) {
+    multiply<false>(o1, o1_stride, w2_.get(), hidden_stride_, i2, hidden_stride_, n, hidden_stride_, num_input_ + 1);
+
+    for (int r = 0; r < n; ++r) {
         for (int i = 0; i < num_hidden_; ++i) {
-            data->i2[i] += w2_[j * num_hidden_ + i] * data->o1[j];
+            o2[r * o2_stride + i] = activator(i2[r * hidden_stride_ + i]);
         }
+        o2[r * o2_stride + num_hidden_] = 1;
     }
 
-    for (int i = 0; i < num_hidden_; ++i) {
-        data->o2[i] = activator(data->i2[i]);
+    multiply<false>(o2, o2_stride, w3_.get(), output_stride_, i3, output_stride_, n, output_stride_, num_hidden_ + 1);
+}
+
+int MultiLayerPerceptron::backwardBatch(const int correct_labels[], const float xs[], int begin, int end,
+                                        const float* w3t, BatchStorage* storage) const
+{
+    const int n = end - begin;
+    const int o1_stride = num_input_ + 1;
+    const int o2_stride = num_hidden_ + 1;
+    DCHECK_LE(n, storage->capacity);
+
+    float* o1 = storage->o1.get();
+    float* i2 = storage->i2.get();
+    float* o2 = storage->o2.get();
+    float* i3 = storage->i3.get();
+    float* e2 = storage->e2.get();
+    float* e3 = storage->e3.get();
+
+    forwardBatch(xs + begin * num_input_, n, o1, i2, o2, i3);
+
+    // calculate error.
+    int num_correct = 0;
+    for (int r = 0; r < n; ++r) {
+        const int correct_label = correct_labels[begin + r];
+        if (argmax(i3 + r * output_stride_) == correct_label)
+            ++num_correct;
+        for (int j = 0; j < output_stride_; ++j) {
+            float e = 0;
+            if (j < num_output_)
+                e = i3[r * output_stride_ + j] - (j == correct_label ? 1 : 0);
+            e3[r * output_stride_ + j] = e;
+        }
     }
-    data->o2[num_hidden_] = 1;
 
-    std::fill(data->i3.get(), data->i3.get() + num_output_, 0.0);
-    for (int j = 0; j < num_hidden_ + 1; ++j) {
-        for (int i = 0; i < num_output_; ++i) {
-            data->i3[i] += w3_[j * num_output_ + i] * data->o2[j];
+    multiply<false>(e3, output_stride_, w3t, hidden_stride_, e2, hidden_stride_, n, hidden_stride_, num_output_);
+    for (int r = 0; r < n; ++r) {
+        for (int i = 0; i < num_hidden_; ++i) {
+            // d tanh(x) = 1 - tanh(x)^2
+            const float o = o2[r * o2_stride + i];
+            e2[r * hidden_stride_ + i] *= 1 - o * o;
         }
     }
+
+    // gradients summed over the samples.
+    multiply<true>(o2, o2_stride, e3, output_stride_, storage->g3.get(), output_stride_,
+                   num_hidden_ + 1, output_stride_, n);
+    multiply<true>(o1, o1_stride, e2, hidden_stride_, storage->g2.get(), hidden_stride_,
+                   num_input_ + 1, hidden_stride_, n);
+
+    return num_correct;
 }
 
 void MultiLayerPerceptron::setHiddenLayerParameter(const float values[])
 {
-    memcpy(w2_.get(), values, hidden_layer_weight_size());
+    for (int i = 0; i < num_input_ + 1; ++i)
+        std::copy(values + i * num_hidden_, values + (i + 1) * num_hidden_, w2_.get() + i * hidden_stride_);
 }
 
 void MultiLayerPerceptron::setOutputLayerParameter(const float values[])
 {
-    memcpy(w3_.get(), values, output_layer_weight_size());
+    for (int i = 0; i < num_hidden_ + 1; ++i)
+        std::copy(values + i * num_output_, values + (i + 1) * num_output_, w3_.get() + i * output_stride_);
 }
 
 bool MultiLayerPerceptron::saveParameterAsCSource(const char* path, const char* prefix) const
@@ -189,6 +464,7 @@ bool MultiLayerPerceptron::saveParameterAsCSource(const char* path, const char*
          << output_layer_weight_size() << ";" << std::endl;
     body << std::endl;
 
+    // The padding columns are not emitted.
     body << "const float " << prefix << "_HIDDEN_LAYER_WEIGHT[] = {";
     for (int i = 0; i < hidden_layer_weight_size(); ++i) {
         if (i % 4 == 0) {
@@ -196,7 +472,8 @@ bool MultiLayerPerceptron::saveParameterAsCSource(const char* path, const char*
         } else {
             body << " ";
         }
-        body << std::scientific << std::showpos << std::setprecision(10) << w2_[i] << ",";
+        float w = w2_[i / num_hidden_ * hidden_stride_ + i % num_hidden_];
+        body << std::scientific << std::showpos << std::setprecision(10) << w << ",";
     }
     body << std::endl << "};" << std::endl;
     body << std::endl;
@@ -208,7 +485,8 @@ bool MultiLayerPerceptron::saveParameterAsCSource(const char* path, const char*
         } else {
             body << " ";
         }
-        body << std::scientific << std::showpos << std::setprecision(10) << w3_[i] << ",";
+        float w = w3_[i / num_output_ * output_stride_ + i % num_output_];
+        body << std::scientific << std::showpos << std::setprecision(10) << w << ",";
     }
     body << std::endl << "};" << std::endl;
     body << std::endl;
@@ -1,14 +1,27 @@
 #ifndef LEARNING_MULTILAYER_PERCEPTRON_H_
 #define LEARNING_MULTILAYER_PERCEPTRON_H_
 
+#include <cstddef>
 #include <memory>
+#include <vector>
+
+class Executor;
 
 namespace learning {
 
 // Defines a 3-layer perceptron.
-// This is not thread-safe.
+//
+// The const methods (e.g. predict() and predictBatch()) can be called from several
+// threads at the same time, as long as each thread uses its own storage.
+// train() and trainBatch() should not be called concurrently with any other method.
 class MultiLayerPerceptron {
 public:
+    struct AlignedDeleter {
+        void operator()(float* p) const;
+    };
+    // A float array aligned for AVX.
+    typedef std::unique_ptr<float[], AlignedDeleter> AlignedFloats;
+
     struct ForwardingIntermediateStorage {
         std::unique_ptr<float[]> o1; // input layer output (= input layer input)
         std::unique_ptr<float[]> i2; // hidden layer input
@@ -19,16 +32,36 @@ public:
         std::unique_ptr<float[]> e2; // hidden layer error
         std::unique_ptr<float[]> e3; // output layer error
     };
+    // The storage for a mini-batch of up to |capacity| samples.
+    // Each matrix has a sample per row.
+    struct BatchStorage {
+        int capacity = 0;
+        AlignedFloats o1; // input layer output
+        AlignedFloats i2; // hidden layer input
+        AlignedFloats o2; // hidden layer output
+        AlignedFloats i3; // output layer input
+        AlignedFloats e2; // hidden layer error
+        AlignedFloats e3; // output layer error
+        AlignedFloats g2; // hidden layer weight gradient
+        AlignedFloats g3; // output layer weight gradient
+    };
 
     MultiLayerPerceptron(int in, int hid, int out);
     ~MultiLayerPerceptron();
 
     ForwardingIntermediateStorage makeForwadingStorage() const;
     BackPropagationIntermediateStorage makeBackpropagationStorage() const;
+    BatchStorage makeBatchStorage(int capacity) const;
 
     // Returns the label.
     // |x| should have |num_input_| size.
     int predict(const float x[], ForwardingIntermediateStorage* data) const;
+    // Same as above, but uses a storage owned by the calling thread.
+    int predict(const float x[]) const;
+
+    // Predicts |n| samples at once. |xs| should have |n| * |num_input_| size, and
+    // |labels| should have |n| size. |n| should not exceed the storage capacity.
+    void predictBatch(const float xs[], int n, int labels[], BatchStorage*) const;
 
     // Train single data.
     // |x| should have |num_input_| size.
@@ -39,6 +72,18 @@ public:
                float learning_rate = 0.1,
                float l2_normalization = 0.001);
 
+    // Trains a mini-batch of |n| samples with the averaged gradient. The L2
+    // normalization is applied once per mini-batch.
+    // When |executor| is not nullptr, the samples are split among its threads, and
+    // their gradients are summed up.
+    // Returns the number of the samples that were predicted correctly before the update.
+    int trainBatch(const int correct_labels[],
+                   const float xs[],
+                   int n,
+                   float learning_rate = 0.1,
+                   float l2_normalization = 0.001,
+                   Executor* executor = nullptr);
+
     void setHiddenLayerParameter(const float values[]);
     void setOutputLayerParameter(const float values[]);
 
@@ -49,13 +94,29 @@ private:
     int output_layer_weight_size() const;
 
     void forward(const float x[], ForwardingIntermediateStorage* data) const;
+    // Runs the forwarding of |n| samples. |o1| and |o2| have the bias columns.
+    void forwardBatch(const float xs[], int n, float* o1, float* i2, float* o2, float* i3) const;
+    // Computes the gradients of the rows [begin, end) into |storage|.
+    // |w3t| is the transposed output layer weight. Returns the number of the correct predictions.
+    int backwardBatch(const int correct_labels[], const float xs[], int begin, int end,
+                      const float* w3t, BatchStorage* storage) const;
+    int argmax(const float* i3) const;
 
     const int num_input_;  // the number of input layer neuron.
     const int num_hidden_; // the number of hidden layer nueron.
     const int num_output_; // the number of output layer nueron.
 
-    std::unique_ptr<float[]> w2_; // hidden layer weight
-    std::unique_ptr<float[]> w3_; // output layer weight
+    // The weights have a row per input neuron (+ bias). Each row is padded to
+    // a multiple of 8 floats, so the rows are aligned for AVX.
+    const int hidden_stride_;
+    const int output_stride_;
+
+    AlignedFloats w2_; // hidden layer weight
+    AlignedFloats w3_; // output layer weight
+
+    // The storages for trainBatch(). One per thread.
+    std::vector<BatchStorage> train_storages_;
+    AlignedFloats w3t_;
 };
 
 } // namespace learning
@@ -0,0 +1,114 @@
+#include "learning/multi_layer_perceptron.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+
+using namespace std;
+using namespace learning;
+
+namespace {
+
+// The size of the perceptron in tool/arow.cc.
+const int NUM_INPUT = 16 * 16 * 3;
+const int NUM_HIDDEN = 20;
+const int NUM_OUTPUT = 8;
+
+const int N = 4096;
+
+vector<float> randomFloats(size_t n)
+{
+    mt19937 mt(1);
+    uniform_real_distribution<float> distribution(-1.0, 1.0);
+    vector<float> vs(n);
+    for (float& v : vs)
+        v = distribution(mt);
+    return vs;
+}
+
+vector<int> randomLabels(size_t n)
+{
+    mt19937 mt(2);
+    uniform_int_distribution<int> distribution(0, NUM_OUTPUT - 1);
+    vector<int> labels(n);
+    for (int& label : labels)
+        label = distribution(mt);
+    return labels;
+}
+
+// Runs |f| |times| times, and shows the samples per second. |f| should process |N| samples.
+template<typename F>
+void showSamplesPerSecond(const char* name, int times, F f)
+{
+    // Warm up.
+    f();
+
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < times; ++i)
+        f();
+    auto end = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(end - begin).count();
+    cout << name << ": " << static_cast<long long>(static_cast<double>(N) * times / seconds) << " samples/sec" << endl;
+}
+
+}
+
+TEST(MultiLayerPerceptronPerformanceTest, predict)
+{
+    MultiLayerPerceptron mlp(NUM_INPUT, NUM_HIDDEN, NUM_OUTPUT);
+    const vector<float> xs = randomFloats(N * NUM_INPUT);
+
+    auto data = mlp.makeForwadingStorage();
+    showSamplesPerSecond("predict", 10, [&]() {
+        for (int r = 0; r < N; ++r)
+            mlp.predict(xs.data() + r * NUM_INPUT, &data);
+    });
+
+    for (int batchSize : { 16, 64, 256 }) {
+        MultiLayerPerceptron::BatchStorage storage = mlp.makeBatchStorage(batchSize);
+        vector<int> labels(batchSize);
+        string name = "predictBatch(" + to_string(batchSize) + ")";
+        showSamplesPerSecond(name.c_str(), 10, [&]() {
+            for (int r = 0; r < N; r += batchSize)
+                mlp.predictBatch(xs.data() + r * NUM_INPUT, batchSize, labels.data(), &storage);
+        });
+    }
+}
+
+TEST(MultiLayerPerceptronPerformanceTest, train)
+{
+    MultiLayerPerceptron mlp(NUM_INPUT, NUM_HIDDEN, NUM_OUTPUT);
+    const vector<float> xs = randomFloats(N * NUM_INPUT);
+    const vector<int> labels = randomLabels(N);
+
+    auto data = mlp.makeForwadingStorage();
+    auto errorData = mlp.makeBackpropagationStorage();
+    showSamplesPerSecond("train", 5, [&]() {
+        for (int r = 0; r < N; ++r)
+            mlp.train(labels[r], xs.data() + r * NUM_INPUT, &data, &errorData, 0.01);
+    });
+
+    for (int batchSize : { 16, 64, 256 }) {
+        string name = "trainBatch(" + to_string(batchSize) + ")";
+        showSamplesPerSecond(name.c_str(), 5, [&]() {
+            for (int r = 0; r < N; r += batchSize)
+                mlp.trainBatch(labels.data() + r, xs.data() + r * NUM_INPUT, batchSize, 0.01);
+        });
+    }
+
+    unique_ptr<Executor> executor = Executor::makeDefaultExecutor();
+    string name = "trainBatch(256) with " + to_string(executor->numThreads()) + " threads";
+    showSamplesPerSecond(name.c_str(), 5, [&]() {
+        for (int r = 0; r < N; r += 256)
+            mlp.trainBatch(labels.data() + r, xs.data() + r * NUM_INPUT, 256, 0.01, 0.001, executor.get());
+    });
+    executor->stop();
+}
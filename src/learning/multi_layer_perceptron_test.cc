@@ -0,0 +1,177 @@
+#include "learning/multi_layer_perceptron.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+
+using namespace std;
+using namespace learning;
+
+namespace {
+
+const int NUM_INPUT = 13;
+const int NUM_HIDDEN = 11;
+const int NUM_OUTPUT = 3;
+
+vector<float> randomFloats(mt19937* mt, size_t n)
+{
+    uniform_real_distribution<float> distribution(-1.0, 1.0);
+    vector<float> vs(n);
+    for (float& v : vs)
+        v = distribution(*mt);
+    return vs;
+}
+
+// Makes a perceptron with the parameters given by |seed|.
+unique_ptr<MultiLayerPerceptron> makePerceptron(int seed)
+{
+    mt19937 mt(seed);
+    unique_ptr<MultiLayerPerceptron> mlp(new MultiLayerPerceptron(NUM_INPUT, NUM_HIDDEN, NUM_OUTPUT));
+    mlp->setHiddenLayerParameter(randomFloats(&mt, (NUM_INPUT + 1) * NUM_HIDDEN).data());
+    mlp->setOutputLayerParameter(randomFloats(&mt, (NUM_HIDDEN + 1) * NUM_OUTPUT).data());
+    return mlp;
+}
+
+// The label is the largest of the sums of the thirds of the input.
+vector<int> makeLabels(const vector<float>& xs)
+{
+    vector<int> labels;
+    for (size_t r = 0; r < xs.size() / NUM_INPUT; ++r) {
+        float sums[NUM_OUTPUT] {};
+        for (int i = 0; i < NUM_INPUT; ++i)
+            sums[i % NUM_OUTPUT] += xs[r * NUM_INPUT + i];
+        labels.push_back(max_element(sums, sums + NUM_OUTPUT) - sums);
+    }
+    return labels;
+}
+
+void expectSameOutput(const MultiLayerPerceptron& expected, const MultiLayerPerceptron& actual, const vector<float>& xs)
+{
+    auto expectedData = expected.makeForwadingStorage();
+    auto actualData = actual.makeForwadingStorage();
+    for (size_t r = 0; r < xs.size() / NUM_INPUT; ++r) {
+        expected.predict(xs.data() + r * NUM_INPUT, &expectedData);
+        actual.predict(xs.data() + r * NUM_INPUT, &actualData);
+        for (int i = 0; i < NUM_OUTPUT; ++i)
+            EXPECT_NEAR(expectedData.i3[i], actualData.i3[i], 1e-4) << r << ' ' << i;
+    }
+}
+
+}
+
+TEST(MultiLayerPerceptronTest, predictBatch)
+{
+    const int N = 37;
+    mt19937 mt(1);
+    unique_ptr<MultiLayerPerceptron> mlp = makePerceptron(2);
+    vector<float> xs = randomFloats(&mt, N * NUM_INPUT);
+
+    MultiLayerPerceptron::BatchStorage storage = mlp->makeBatchStorage(N);
+    vector<int> labels(N);
+    mlp->predictBatch(xs.data(), N, labels.data(), &storage);
+
+    auto data = mlp->makeForwadingStorage();
+    for (int r = 0; r < N; ++r) {
+        EXPECT_EQ(labels[r], mlp->predict(xs.data() + r * NUM_INPUT, &data));
+        EXPECT_EQ(labels[r], mlp->predict(xs.data() + r * NUM_INPUT));
+    }
+}
+
+TEST(MultiLayerPerceptronTest, predictConcurrently)
+{
+    const int N = 100;
+    mt19937 mt(1);
+    unique_ptr<MultiLayerPerceptron> mlp = makePerceptron(2);
+    vector<float> xs = randomFloats(&mt, N * NUM_INPUT);
+
+    vector<int> expected(N);
+    for (int r = 0; r < N; ++r)
+        expected[r] = mlp->predict(xs.data() + r * NUM_INPUT);
+
+    vector<thread> threads;
+    vector<int> mismatches(4);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int times = 0; times < 100; ++times) {
+                for (int r = 0; r < N; ++r) {
+                    if (mlp->predict(xs.data() + r * NUM_INPUT) != expected[r])
+                        ++mismatches[t];
+                }
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    for (int t = 0; t < 4; ++t)
+        EXPECT_EQ(0, mismatches[t]);
+}
+
+TEST(MultiLayerPerceptronTest, trainBatchOfOne)
+{
+    const int N = 50;
+    mt19937 mt(1);
+    vector<float> xs = randomFloats(&mt, N * NUM_INPUT);
+    vector<int> labels = makeLabels(xs);
+
+    unique_ptr<MultiLayerPerceptron> single = makePerceptron(3);
+    unique_ptr<MultiLayerPerceptron> batch = makePerceptron(3);
+
+    auto data = single->makeForwadingStorage();
+    auto errorData = single->makeBackpropagationStorage();
+    for (int r = 0; r < N; ++r) {
+        bool correct = single->train(labels[r], xs.data() + r * NUM_INPUT, &data, &errorData);
+        EXPECT_EQ(correct ? 1 : 0, batch->trainBatch(&labels[r], xs.data() + r * NUM_INPUT, 1));
+    }
+
+    expectSameOutput(*single, *batch, xs);
+}
+
+TEST(MultiLayerPerceptronTest, trainBatchWithExecutor)
+{
+    const int N = 200;
+    mt19937 mt(1);
+    vector<float> xs = randomFloats(&mt, N * NUM_INPUT);
+    vector<int> labels = makeLabels(xs);
+
+    unique_ptr<MultiLayerPerceptron> serial = makePerceptron(4);
+    unique_ptr<MultiLayerPerceptron> parallel = makePerceptron(4);
+
+    Executor executor(4);
+    executor.start();
+    for (int times = 0; times < 10; ++times) {
+        EXPECT_EQ(serial->trainBatch(labels.data(), xs.data(), N, 0.1),
+                  parallel->trainBatch(labels.data(), xs.data(), N, 0.1, 0.001, &executor));
+    }
+    executor.stop();
+
+    expectSameOutput(*serial, *parallel, xs);
+}
+
+TEST(MultiLayerPerceptronTest, learn)
+{
+    const int N = 1000;
+    const int BATCH_SIZE = 20;
+    mt19937 mt(1);
+    vector<float> xs = randomFloats(&mt, N * NUM_INPUT);
+    vector<int> labels = makeLabels(xs);
+
+    unique_ptr<MultiLayerPerceptron> mlp = makePerceptron(5);
+    for (int times = 0; times < 100; ++times) {
+        for (int r = 0; r < N; r += BATCH_SIZE)
+            mlp->trainBatch(labels.data() + r, xs.data() + r * NUM_INPUT, BATCH_SIZE, 0.1, 0.0001);
+    }
+
+    int numCorrect = 0;
+    for (int r = 0; r < N; ++r) {
+        if (mlp->predict(xs.data() + r * NUM_INPUT) == labels[r])
+            ++numCorrect;
+    }
+    EXPECT_LT(N * 0.9, numCorrect);
+}
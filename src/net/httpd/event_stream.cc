@@ -0,0 +1,120 @@
+#include "net/httpd/event_stream.h"
+
+#include <glog/logging.h>
+
+#include <sstream>
+
+using namespace std;
+
+EventStream::EventStream(size_t capacity) :
+    events_(capacity),
+    numSubscribers_(0)
+{
+    CHECK_GT(capacity, 0U);
+}
+
+EventStream::~EventStream()
+{
+    DCHECK_EQ(0, numSubscribers_.load()) << "all the subscribers should be destructed before the stream";
+}
+
+// static
+string EventStream::encode(int64_t seq, const char* event, const string& data)
+{
+    DCHECK_EQ(string::npos, data.find('\n')) << data;
+
+    ostringstream ss;
+    ss << "id: " << seq << "\n"
+       << "event: " << event << "\n"
+       << "data: " << data << "\n\n";
+    return ss.str();
+}
+
+void EventStream::publish(const string& delta, const string& snapshot)
+{
+    // Encodes out of the lock. Only the publisher updates |headSeq_|.
+    int64_t seq;
+    {
+        lock_guard<mutex> lock(mu_);
+        seq = headSeq_;
+    }
+
+    shared_ptr<const string> encodedDelta = make_shared<string>(encode(seq, "delta", delta));
+    shared_ptr<const string> encodedSnapshot = make_shared<string>(encode(seq, "snapshot", snapshot));
+
+    {
+        lock_guard<mutex> lock(mu_);
+        DCHECK_EQ(seq, headSeq_) << "publish() should be called from one thread";
+        events_[seq % events_.size()] = std::move(encodedDelta);
+        snapshot_ = std::move(encodedSnapshot);
+        headSeq_ = seq + 1;
+    }
+    cond_.notify_all();
+}
+
+void EventStream::close()
+{
+    {
+        lock_guard<mutex> lock(mu_);
+        closed_ = true;
+    }
+    cond_.notify_all();
+}
+
+unique_ptr<EventStream::Subscriber> EventStream::subscribe()
+{
+    ++numSubscribers_;
+    return unique_ptr<Subscriber>(new Subscriber(this));
+}
+
+int64_t EventStream::numPublishedEvents() const
+{
+    lock_guard<mutex> lock(mu_);
+    return headSeq_;
+}
+
+EventStream::Subscriber::~Subscriber()
+{
+    --stream_->numSubscribers_;
+}
+
+EventStream::Status EventStream::Subscriber::next(chrono::steady_clock::duration timeout,
+                                                  size_t maxBytes, string* out)
+{
+    EventStream* s = stream_;
+    const int64_t capacity = s->events_.size();
+
+    vector<shared_ptr<const string>> events;
+    {
+        unique_lock<mutex> lock(s->mu_);
+        bool ready = s->cond_.wait_for(lock, timeout, [this, s]() {
+            return s->closed_ || (nextSeq_ < 0 ? s->headSeq_ > 0 : nextSeq_ < s->headSeq_);
+        });
+        if (s->closed_)
+            return Status::CLOSED;
+        if (!ready)
+            return Status::TIMEOUT;
+
+        if (nextSeq_ < 0 || nextSeq_ < s->headSeq_ - capacity) {
+            // A new subscriber, or the deltas have been overwritten.
+            if (nextSeq_ >= 0)
+                numSkippedEvents_ += s->headSeq_ - nextSeq_;
+            events.push_back(s->snapshot_);
+            nextSeq_ = s->headSeq_;
+        } else {
+            size_t bytes = 0;
+            while (nextSeq_ < s->headSeq_) {
+                const shared_ptr<const string>& event = s->events_[nextSeq_ % capacity];
+                if (!events.empty() && bytes + event->size() > maxBytes)
+                    break;
+                bytes += event->size();
+                events.push_back(event);
+                ++nextSeq_;
+            }
+        }
+    }
+
+    for (const auto& event : events)
+        out->append(*event);
+    return Status::OK;
+}
@@ -0,0 +1,86 @@
+#ifndef NET_HTTPD_EVENT_STREAM_H_
+#define NET_HTTPD_EVENT_STREAM_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/noncopyable.h"
+
+// EventStream fans out a stream of server-sent events to many subscribers.
+//
+// The publisher gives a delta (the change from the previous event) and a snapshot
+// (the whole state after the delta) for each event. Each event is encoded once, and
+// the recent events are kept in a ring buffer shared by all the subscribers.
+// A subscriber pulls the events at its own pace, so a slow client doesn't block
+// the publisher or the other clients. When a subscriber falls behind the ring buffer,
+// it skips the missed deltas, and restarts from the latest snapshot.
+class EventStream : noncopyable {
+public:
+    enum class Status {
+        OK, TIMEOUT, CLOSED,
+    };
+
+    class Subscriber : noncopyable {
+    public:
+        ~Subscriber();
+
+        // Waits for the next events up to |timeout|, and appends them to |out| in the
+        // text/event-stream format. At most about |maxBytes| are appended, unless the
+        // first event is larger than that.
+        Status next(std::chrono::steady_clock::duration timeout, size_t maxBytes, std::string* out);
+
+        // The number of the events that were skipped because this subscriber was slow.
+        int64_t numSkippedEvents() const { return numSkippedEvents_; }
+
+    private:
+        friend class EventStream;
+        explicit Subscriber(EventStream* stream) : stream_(stream) {}
+
+        EventStream* stream_;
+        // The sequence number of the next event to send. -1 means a snapshot is needed.
+        int64_t nextSeq_ = -1;
+        int64_t numSkippedEvents_ = 0;
+    };
+
+    // Keeps the last |capacity| events.
+    explicit EventStream(size_t capacity);
+    ~EventStream();
+
+    // Publishes an event. |delta| and |snapshot| should not contain a newline.
+    // The snapshot is sent to a new or slow subscriber instead of the deltas.
+    void publish(const std::string& delta, const std::string& snapshot);
+
+    // Wakes up all the subscribers, and makes them return CLOSED.
+    void close();
+
+    // The returned subscriber should be destructed before the stream.
+    std::unique_ptr<Subscriber> subscribe();
+
+    int numSubscribers() const { return numSubscribers_; }
+    int64_t numPublishedEvents() const;
+
+    // "id: <seq>\nevent: <event>\ndata: <data>\n\n"
+    static std::string encode(int64_t seq, const char* event, const std::string& data);
+
+private:
+    mutable std::mutex mu_;
+    std::condition_variable cond_;
+    bool closed_ = false;
+
+    // |events_[seq % capacity]| is the encoded delta of |seq|.
+    std::vector<std::shared_ptr<const std::string>> events_;
+    // The sequence number of the next event.
+    int64_t headSeq_ = 0;
+    // The encoded snapshot of |headSeq_ - 1|.
+    std::shared_ptr<const std::string> snapshot_;
+
+    std::atomic<int> numSubscribers_;
+};
+
+#endif // NET_HTTPD_EVENT_STREAM_H_
@@ -0,0 +1,112 @@
+#include "net/httpd/event_stream.h"
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+const chrono::milliseconds TIMEOUT(10);
+const size_t MAX_BYTES = 1 << 20;
+}
+
+TEST(EventStreamTest, encode)
+{
+    EXPECT_EQ("id: 3\nevent: delta\ndata: {\"a\":1}\n\n", EventStream::encode(3, "delta", "{\"a\":1}"));
+}
+
+TEST(EventStreamTest, newSubscriberStartsFromSnapshot)
+{
+    EventStream stream(4);
+    unique_ptr<EventStream::Subscriber> subscriber = stream.subscribe();
+    EXPECT_EQ(1, stream.numSubscribers());
+
+    string out;
+    EXPECT_EQ(EventStream::Status::TIMEOUT, subscriber->next(TIMEOUT, MAX_BYTES, &out));
+    EXPECT_EQ("", out);
+
+    stream.publish("d0", "s0");
+    stream.publish("d1", "s1");
+
+    EXPECT_EQ(EventStream::Status::OK, subscriber->next(TIMEOUT, MAX_BYTES, &out));
+    EXPECT_EQ(EventStream::encode(1, "snapshot", "s1"), out);
+
+    out.clear();
+    stream.publish("d2", "s2");
+    stream.publish("d3", "s3");
+    EXPECT_EQ(EventStream::Status::OK, subscriber->next(TIMEOUT, MAX_BYTES, &out));
+    EXPECT_EQ(EventStream::encode(2, "delta", "d2") + EventStream::encode(3, "delta", "d3"), out);
+
+    subscriber.reset();
+    EXPECT_EQ(0, stream.numSubscribers());
+}
+
+TEST(EventStreamTest, maxBytes)
+{
+    EventStream stream(4);
+    unique_ptr<EventStream::Subscriber> subscriber = stream.subscribe();
+    stream.publish("d0", "s0");
+
+    string out;
+    EXPECT_EQ(EventStream::Status::OK, subscriber->next(TIMEOUT, MAX_BYTES, &out));
+
+    stream.publish("d1", "s1");
+    stream.publish("d2", "s2");
+
+    // The first event is always taken, even if it's larger than |maxBytes|.
+    out.clear();
+    EXPECT_EQ(EventStream::Status::OK, subscriber->next(TIMEOUT, 1, &out));
+    EXPECT_EQ(EventStream::encode(1, "delta", "d1"), out);
+
+    out.clear();
+    EXPECT_EQ(EventStream::Status::OK, subscriber->next(TIMEOUT, 1, &out));
+    EXPECT_EQ(EventStream::encode(2, "delta", "d2"), out);
+}
+
+TEST(EventStreamTest, slowSubscriberSkipsToSnapshot)
+{
+    EventStream stream(2);
+    unique_ptr<EventStream::Subscriber> fast = stream.subscribe();
+    unique_ptr<EventStream::Subscriber> slow = stream.subscribe();
+
+    stream.publish("d0", "s0");
+    string out;
+    EXPECT_EQ(EventStream::Status::OK, fast->next(TIMEOUT, MAX_BYTES, &out));
+    EXPECT_EQ(EventStream::Status::OK, slow->next(TIMEOUT, MAX_BYTES, &out));
+
+    for (int i = 1; i <= 4; ++i) {
+        stream.publish("d" + to_string(i), "s" + to_string(i));
+        out.clear();
+        EXPECT_EQ(EventStream::Status::OK, fast->next(TIMEOUT, MAX_BYTES, &out));
+        EXPECT_EQ(EventStream::encode(i, "delta", "d" + to_string(i)), out);
+    }
+
+    // d1 and d2 have been overwritten, so |slow| gets the latest snapshot.
+    out.clear();
+    EXPECT_EQ(EventStream::Status::OK, slow->next(TIMEOUT, MAX_BYTES, &out));
+    EXPECT_EQ(EventStream::encode(4, "snapshot", "s4"), out);
+    EXPECT_EQ(4, slow->numSkippedEvents());
+    EXPECT_EQ(0, fast->numSkippedEvents());
+
+    stream.publish("d5", "s5");
+    out.clear();
+    EXPECT_EQ(EventStream::Status::OK, slow->next(TIMEOUT, MAX_BYTES, &out));
+    EXPECT_EQ(EventStream::encode(5, "delta", "d5"), out);
+}
+
+TEST(EventStreamTest, close)
+{
+    EventStream stream(4);
+    unique_ptr<EventStream::Subscriber> subscriber = stream.subscribe();
+
+    EventStream::Status status = EventStream::Status::OK;
+    thread th([&]() {
+        string out;
+        status = subscriber->next(chrono::seconds(10), MAX_BYTES, &out);
+    });
+
+    stream.close();
+    th.join();
+    EXPECT_EQ(EventStream::Status::CLOSED, status);
+}
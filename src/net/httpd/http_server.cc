@@ -1,7 +1,11 @@
 #include "net/httpd/http_server.h"
 
 #include <cstdlib>
+#include <cstring>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <fstream>
 
@@ -12,10 +16,15 @@
 #include "base/file/file.h"
 #include "base/file/path.h"
 #include "base/strings.h"
+#include "net/httpd/event_stream.h"
 
 using namespace std;
 
 const int POST_BUFFER_SIZE = 4096;
+const int EVENT_STREAM_BLOCK_SIZE = 4096;
+
+// Sends a comment when nothing is published for a while, to find the closed connections.
+const chrono::seconds EVENT_STREAM_KEEPALIVE(15);
 
 class HttpExchange {
 public:
@@ -83,6 +92,70 @@ static int handleHandler(MHD_Connection* connection, const HttpHandler& handler,
     return ret;
 }
 
+// EventStreamReader feeds an EventStream::Subscriber to a connection.
+// Since the daemon runs a thread per connection, read() can block. When the client is slow,
+// MHD calls read() less often, and the subscriber skips the events it cannot catch up with.
+class EventStreamReader {
+public:
+    explicit EventStreamReader(unique_ptr<EventStream::Subscriber> subscriber) :
+        subscriber_(std::move(subscriber)) {}
+
+    static ssize_t read(void* cls, uint64_t /*pos*/, char* buf, size_t max)
+    {
+        return reinterpret_cast<EventStreamReader*>(cls)->readInternal(buf, max);
+    }
+
+    static void destroy(void* cls)
+    {
+        delete reinterpret_cast<EventStreamReader*>(cls);
+    }
+
+private:
+    ssize_t readInternal(char* buf, size_t max)
+    {
+        if (offset_ == pending_.size()) {
+            pending_.clear();
+            offset_ = 0;
+            switch (subscriber_->next(EVENT_STREAM_KEEPALIVE, max, &pending_)) {
+            case EventStream::Status::OK:
+                break;
+            case EventStream::Status::TIMEOUT:
+                pending_ = ": keepalive\n\n";
+                break;
+            case EventStream::Status::CLOSED:
+                return MHD_CONTENT_READER_END_OF_STREAM;
+            }
+        }
+
+        size_t size = min(max, pending_.size() - offset_);
+        memcpy(buf, pending_.data() + offset_, size);
+        offset_ += size;
+        return size;
+    }
+
+    unique_ptr<EventStream::Subscriber> subscriber_;
+    // The events taken from |subscriber_|, but not sent yet.
+    string pending_;
+    size_t offset_ = 0;
+};
+
+static int eventStreamHandler(MHD_Connection* connection, EventStream* stream)
+{
+    EventStreamReader* reader = new EventStreamReader(stream->subscribe());
+    struct MHD_Response* response = MHD_create_response_from_callback(
+        MHD_SIZE_UNKNOWN, EVENT_STREAM_BLOCK_SIZE, &EventStreamReader::read, reader, &EventStreamReader::destroy);
+    if (response == nullptr) {
+        delete reader;
+        return MHD_NO;
+    }
+
+    MHD_add_response_header(response, "Content-Type", "text/event-stream");
+    MHD_add_response_header(response, "Cache-Control", "no-cache");
+    int ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
 static int iterate_post(void* con_cls, enum MHD_ValueKind /*kind*/, const char* key,
                         const char* /*filename*/, const char* /*content_type*/, const char* /*transfer_encoding*/,
                         const char* data, uint64_t /*off*/, size_t size)
@@ -128,6 +201,10 @@ int HttpServer::accessHandler(void* cls, struct MHD_Connection* connection,
             return handleHandler(connection, it->second, exchange);
         }
 
+        auto streamIt = server->eventStreams_.find(url);
+        if (streamIt != server->eventStreams_.end())
+            return eventStreamHandler(connection, streamIt->second);
+
         // Check assets handlers.
         string path = file::joinPath(server->assetDirPath_, url);
         // Check path has the prefix |server->assetDirPath_| not to allow directory listing attack.
@@ -186,7 +263,8 @@ bool HttpServer::start()
 {
     DCHECK(!httpd_);
 
-    httpd_ = MHD_start_daemon(MHD_USE_SELECT_INTERNALLY, port_, nullptr, nullptr,
+    // A thread per connection, since an event stream blocks its connection.
+    httpd_ = MHD_start_daemon(MHD_USE_SELECT_INTERNALLY | MHD_USE_THREAD_PER_CONNECTION, port_, nullptr, nullptr,
                               &HttpServer::accessHandler, reinterpret_cast<void*>(this),
                               MHD_OPTION_NOTIFY_COMPLETED, &HttpServer::requestCompleted, nullptr,
                               MHD_OPTION_END);
@@ -220,6 +298,14 @@ void HttpServer::installHandler(const string& path, HttpHandler handler)
     handlers_[path] = std::move(handler);
 }
 
+void HttpServer::installEventStreamHandler(const string& path, EventStream* stream)
+{
+    DCHECK(stream);
+    DCHECK(!eventStreams_.count(path));
+
+    eventStreams_[path] = stream;
+}
+
 void HttpServer::installStaticFileHandler(const std::string& path,
                                           const std::string& filepath,
                                           const std::string& mime)
@@ -9,6 +9,8 @@
 
 #include "net/httpd/http_handler.h"
 
+class EventStream;
+
 class HttpServer {
 public:
     explicit HttpServer(int port);
@@ -21,6 +23,9 @@ public:
     void installStaticFileHandler(const std::string& path,
                                   const std::string& filepath,
                                   const std::string& mime);
+    // Serves |stream| as server-sent events (text/event-stream). Doesn't take ownership.
+    // |stream| should be closed before stop(), so that the connections finish.
+    void installEventStreamHandler(const std::string& path, EventStream* stream);
 
     // When no handler is matched, we get the content of this path.
     void setAssetDirectory(const std::string& path);
@@ -35,6 +40,7 @@ private:
     int port_;
     struct MHD_Daemon* httpd_;
     std::unordered_map<std::string, HttpHandler> handlers_;
+    std::unordered_map<std::string, EventStream*> eventStreams_;
     std::string assetDirPath_;
 };
 
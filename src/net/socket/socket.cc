@@ -4,6 +4,7 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
@@ -11,6 +12,27 @@
 
 namespace net {
 
+namespace {
+
+// Waits until |sd| gets ready for |events|. The socket can be non-blocking when
+// it's also watched by an event loop (e.g. MultiDuelServer), so EAGAIN must not be
+// retried in a busy loop.
+bool waitUntilReady(int sd, short events)
+{
+    struct pollfd pfd {};
+    pfd.fd = sd;
+    pfd.events = events;
+    while (poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            PLOG(ERROR) << "failed to poll";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
 Socket::Socket(Socket&& socket) noexcept :
     sd_(socket.sd_)
 {
@@ -49,8 +71,13 @@ bool Socket::readExactly(void* buf, size_t size)
                 PLOG(ERROR) << "unexpected EOF";
                 return false;
             }
-            if (errno == EAGAIN)
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!waitUntilReady(sd_, POLLIN))
+                    return false;
                 continue;
+            }
 
             PLOG(ERROR) << "failed to read";
             return false;
@@ -77,8 +104,13 @@ bool Socket::writeExactly(const void* buf, size_t size)
                 PLOG(ERROR) << "connection closed";
                 return false;
             }
-            if (errno == EAGAIN)
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!waitUntilReady(sd_, POLLOUT))
+                    return false;
                 continue;
+            }
 
             PLOG(ERROR) << "faied to write";
             return false;
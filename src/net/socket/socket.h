@@ -28,6 +28,8 @@ public:
     bool readExactly(void* buf, size_t size);
 
     ssize_t write(const void* buf, size_t size);
+    // Writes exactly |size| byte from |buf|. When the socket is non-blocking,
+    // this waits until the socket gets writable instead of failing with EAGAIN.
     bool writeExactly(const void* buf, size_t size);
     void flush();
 
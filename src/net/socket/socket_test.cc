@@ -0,0 +1,81 @@
+#include "net/socket/socket.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+class TestSocket : public net::Socket {
+public:
+    explicit TestSocket(int sd) : Socket(sd) {}
+};
+
+double threadCpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void setNonBlocking(int sd)
+{
+    int flags = fcntl(sd, F_GETFL);
+    ASSERT_LE(0, flags);
+    ASSERT_EQ(0, fcntl(sd, F_SETFL, flags | O_NONBLOCK));
+}
+
+} // anonymous namespace
+
+TEST(SocketTest, writeExactlyWaitsOnNonBlockingSocket)
+{
+    int sv[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+    setNonBlocking(sv[0]);
+    TestSocket writer(sv[0]);
+    TestSocket reader(sv[1]);
+
+    const string data(1 << 20, 'x');
+    string received(data.size(), '\0');
+    thread th([&]() {
+        // The writer fills the buffer and has to wait for this.
+        this_thread::sleep_for(chrono::milliseconds(100));
+        EXPECT_TRUE(reader.readExactly(&received[0], received.size()));
+    });
+
+    double start = threadCpuSeconds();
+    EXPECT_TRUE(writer.writeExactly(data.data(), data.size()));
+    double cpuSeconds = threadCpuSeconds() - start;
+    th.join();
+
+    EXPECT_EQ(data, received);
+    // The writer should sleep instead of retrying EAGAIN while the reader sleeps.
+    EXPECT_GT(0.05, cpuSeconds);
+}
+
+TEST(SocketTest, readExactlyWaitsOnNonBlockingSocket)
+{
+    int sv[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+    setNonBlocking(sv[1]);
+    TestSocket writer(sv[0]);
+    TestSocket reader(sv[1]);
+
+    thread th([&]() {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        EXPECT_TRUE(writer.writeExactly("abc", 3));
+    });
+
+    char buf[4] {};
+    EXPECT_TRUE(reader.readExactly(buf, 3));
+    EXPECT_STREQ("abc", buf);
+    th.join();
+}
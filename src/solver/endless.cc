@@ -32,6 +32,7 @@ EndlessResult Endless::run(const KumipuyoSeq& originalSeq)
     ai_->enemy_.seq = req.playerFrameRequest[1].kumipuyoSeq;
 
     vector<Decision> decisions;
+    vector<double> thinkTimes;
 
     int maxRensaScore = 0;
     int maxRensa = 0;
@@ -61,6 +62,7 @@ EndlessResult Endless::run(const KumipuyoSeq& originalSeq)
                                                false);
 
         double endTime = currentTime();
+        thinkTimes.push_back(endTime - beginTime);
 
         CoreField f(req.myPlayerFrameRequest().field);
         if (!f.dropKumipuyo(dropDecision.decision(), req.myPlayerFrameRequest().kumipuyoSeq.front())) {
@@ -84,6 +86,7 @@ EndlessResult Endless::run(const KumipuyoSeq& originalSeq)
                 -1,                        // .maxRensa
                 false,                     // .zenkeshi
                 decisions,                 // .decisions
+                thinkTimes,                // .thinkTimes
                 EndlessResult::Type::DEAD, // .type
             };
         }
@@ -95,6 +98,7 @@ EndlessResult Endless::run(const KumipuyoSeq& originalSeq)
                 rensaResult.chains,              // .maxRensa
                 f.isZenkeshi(),                  // .zenkeshi
                 decisions,                       // .decisions
+                thinkTimes,                      // .thinkTimes
                 EndlessResult::Type::MAIN_CHAIN, // .type
             };
         }
@@ -105,6 +109,7 @@ EndlessResult Endless::run(const KumipuyoSeq& originalSeq)
                 rensaResult.chains,            // .maxRensa
                 true,                          // .zenkeshi
                 decisions,                     // .decisions
+                thinkTimes,                    // .thinkTimes
                 EndlessResult::Type::ZENKESHI, // .type
 
             };
@@ -124,6 +129,7 @@ EndlessResult Endless::run(const KumipuyoSeq& originalSeq)
         maxRensa,                            // .maxRensa
         false,                               // .zenkeshi
         decisions,                           // .decisions
+        thinkTimes,                          // .thinkTimes
         EndlessResult::Type::PUYOSEQ_RUNOUT, // .type
     };
 }
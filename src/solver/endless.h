@@ -22,6 +22,8 @@ struct EndlessResult {
     int maxRensa;
     bool zenkeshi;
     std::vector<Decision> decisions;
+    // The time to think each hand [s].
+    std::vector<double> thinkTimes;
     Type type;
 };
 
@@ -0,0 +1,283 @@
+#include "solver/endless_benchmark.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include <glog/logging.h>
+#include <json/json.h>
+
+#include "base/executor.h"
+#include "core/client/ai/ai.h"
+#include "core/kumipuyo_seq.h"
+#include "core/kumipuyo_seq_generator.h"
+
+using namespace std;
+
+namespace {
+
+const char* toString(EndlessResult::Type type)
+{
+    switch (type) {
+    case EndlessResult::Type::DEAD: return "dead";
+    case EndlessResult::Type::MAIN_CHAIN: return "main_chain";
+    case EndlessResult::Type::ZENKESHI: return "zenkeshi";
+    case EndlessResult::Type::PUYOSEQ_RUNOUT: return "runout";
+    }
+
+    CHECK(false) << "Unknown type: " << static_cast<int>(type);
+    return "";
+}
+
+// Returns the |p|-th percentile of sorted |values| (nearest rank).
+template<typename T>
+T percentile(const vector<T>& values, int p)
+{
+    if (values.empty())
+        return T();
+    size_t rank = (values.size() * p + 99) / 100;
+    return values[std::max<size_t>(rank, 1) - 1];
+}
+
+double averageOf(const vector<double>& values)
+{
+    if (values.empty())
+        return 0;
+    double sum = 0;
+    for (double v : values)
+        sum += v;
+    return sum / values.size();
+}
+
+} // anonymous namespace
+
+// static
+EndlessBenchmarkSummary EndlessBenchmarkSummary::summarize(const vector<EndlessBenchmarkCase>& cases)
+{
+    EndlessBenchmarkSummary summary;
+
+    vector<int> mainChainScores;
+    int sumMainChainRensa = 0;
+    vector<double> thinkTimes;
+    for (const auto& c : cases) {
+        const EndlessResult& result = c.result;
+        summary.numCases++;
+        thinkTimes.insert(thinkTimes.end(), result.thinkTimes.begin(), result.thinkTimes.end());
+
+        switch (result.type) {
+        case EndlessResult::Type::DEAD:
+            summary.numDead++;
+            break;
+        case EndlessResult::Type::MAIN_CHAIN:
+            summary.numMainChain++;
+            mainChainScores.push_back(result.score);
+            sumMainChainRensa += result.maxRensa;
+            if (result.score >= 60000) { summary.over60000Count++; }
+            if (result.score >= 80000) { summary.over80000Count++; }
+            if (result.score >= 100000) { summary.over100000Count++; }
+            break;
+        case EndlessResult::Type::ZENKESHI:
+            summary.numZenkeshi++;
+            break;
+        case EndlessResult::Type::PUYOSEQ_RUNOUT:
+            summary.numRunout++;
+            break;
+        }
+    }
+
+    sort(mainChainScores.begin(), mainChainScores.end());
+    if (!mainChainScores.empty()) {
+        double sum = 0;
+        for (int score : mainChainScores)
+            sum += score;
+        summary.averageMainChainScore = sum / mainChainScores.size();
+        summary.averageMainChainRensa = static_cast<double>(sumMainChainRensa) / mainChainScores.size();
+    }
+    summary.mainChainScoreP10 = percentile(mainChainScores, 10);
+    summary.mainChainScoreP50 = percentile(mainChainScores, 50);
+    summary.mainChainScoreP90 = percentile(mainChainScores, 90);
+
+    sort(thinkTimes.begin(), thinkTimes.end());
+    summary.thinkTimeP50 = percentile(thinkTimes, 50);
+    summary.thinkTimeP90 = percentile(thinkTimes, 90);
+    summary.thinkTimeP99 = percentile(thinkTimes, 99);
+    summary.thinkTimeMax = thinkTimes.empty() ? 0 : thinkTimes.back();
+
+    return summary;
+}
+
+// static
+bool EndlessBenchmarkSummary::parseJson(const string& json, EndlessBenchmarkSummary* summary)
+{
+    Json::Value root;
+    Json::Reader reader;
+    if (!reader.parse(json, root)) {
+        LOG(ERROR) << "failed to parse json: " << reader.getFormattedErrorMessages();
+        return false;
+    }
+
+    const Json::Value& s = root["summary"];
+    if (!s.isObject()) {
+        LOG(ERROR) << "json doesn't have summary";
+        return false;
+    }
+
+    summary->numCases = s["numCases"].asInt();
+    summary->numDead = s["numDead"].asInt();
+    summary->numMainChain = s["numMainChain"].asInt();
+    summary->numZenkeshi = s["numZenkeshi"].asInt();
+    summary->numRunout = s["numRunout"].asInt();
+    summary->averageMainChainScore = s["averageMainChainScore"].asDouble();
+    summary->mainChainScoreP10 = s["mainChainScoreP10"].asInt();
+    summary->mainChainScoreP50 = s["mainChainScoreP50"].asInt();
+    summary->mainChainScoreP90 = s["mainChainScoreP90"].asInt();
+    summary->over60000Count = s["over60000Count"].asInt();
+    summary->over80000Count = s["over80000Count"].asInt();
+    summary->over100000Count = s["over100000Count"].asInt();
+    summary->averageMainChainRensa = s["averageMainChainRensa"].asDouble();
+    summary->thinkTimeP50 = s["thinkTimeP50"].asDouble();
+    summary->thinkTimeP90 = s["thinkTimeP90"].asDouble();
+    summary->thinkTimeP99 = s["thinkTimeP99"].asDouble();
+    summary->thinkTimeMax = s["thinkTimeMax"].asDouble();
+    return true;
+}
+
+string EndlessBenchmarkSummary::toString() const
+{
+    stringstream ss;
+    ss << "cases = " << numCases << endl
+       << "main chain / dead / zenkeshi / runout = "
+       << numMainChain << " / " << numDead << " / " << numZenkeshi << " / " << numRunout << endl
+       << "main chain score: ave = " << averageMainChainScore
+       << " p10 = " << mainChainScoreP10
+       << " p50 = " << mainChainScoreP50
+       << " p90 = " << mainChainScoreP90 << endl
+       << "main chain score >= 60000 / 80000 / 100000 = "
+       << over60000Count << " / " << over80000Count << " / " << over100000Count << endl
+       << "main chain rensa: ave = " << averageMainChainRensa << endl
+       << "think time [ms]: p50 = " << (thinkTimeP50 * 1000)
+       << " p90 = " << (thinkTimeP90 * 1000)
+       << " p99 = " << (thinkTimeP99 * 1000)
+       << " max = " << (thinkTimeMax * 1000) << endl;
+    return ss.str();
+}
+
+vector<string> findEndlessRegressions(const EndlessBenchmarkSummary& baseline,
+                                      const EndlessBenchmarkSummary& current,
+                                      const EndlessBenchmarkTolerance& tolerance)
+{
+    vector<string> regressions;
+
+    if (current.mainChainRate() < baseline.mainChainRate() - tolerance.rate) {
+        stringstream ss;
+        ss << "main chain rate: " << baseline.mainChainRate() << " -> " << current.mainChainRate();
+        regressions.push_back(ss.str());
+    }
+
+    if (current.deadRate() > baseline.deadRate() + tolerance.rate) {
+        stringstream ss;
+        ss << "dead rate: " << baseline.deadRate() << " -> " << current.deadRate();
+        regressions.push_back(ss.str());
+    }
+
+    if (current.averageMainChainScore < baseline.averageMainChainScore * (1 - tolerance.score)) {
+        stringstream ss;
+        ss << "average main chain score: " << baseline.averageMainChainScore << " -> " << current.averageMainChainScore;
+        regressions.push_back(ss.str());
+    }
+
+    if (current.thinkTimeP90 > baseline.thinkTimeP90 * (1 + tolerance.thinkTime)) {
+        stringstream ss;
+        ss << "think time p90 [ms]: " << (baseline.thinkTimeP90 * 1000) << " -> " << (current.thinkTimeP90 * 1000);
+        regressions.push_back(ss.str());
+    }
+
+    return regressions;
+}
+
+vector<EndlessBenchmarkCase> EndlessBenchmark::run(Executor* executor, int seedOffset, int numSeeds) const
+{
+    vector<EndlessBenchmarkCase> cases(numSeeds);
+
+    const int numWorkers = executor ? std::max(executor->numThreads(), 1) : 1;
+    TaskGroup taskGroup(executor);
+    for (int w = 0; w < std::min(numWorkers, numSeeds); ++w) {
+        taskGroup.run([this, &cases, w, numWorkers, seedOffset, numSeeds]() {
+            Endless endless(factory_());
+            for (int i = w; i < numSeeds; i += numWorkers) {
+                KumipuyoSeq seq = KumipuyoSeqGenerator::generateACPuyo2SequenceWithSeed(seedOffset + i);
+                cases[i].seed = seedOffset + i;
+                cases[i].result = endless.run(seq);
+            }
+        });
+    }
+    taskGroup.wait();
+
+    return cases;
+}
+
+// static
+string EndlessBenchmark::toCSV(const vector<EndlessBenchmarkCase>& cases)
+{
+    stringstream ss;
+    ss << "seed,type,hand,score,rensa,zenkeshi,think_time_ave_ms,think_time_max_ms" << endl;
+    for (const auto& c : cases) {
+        const EndlessResult& r = c.result;
+        double maxThinkTime = r.thinkTimes.empty() ? 0 : *max_element(r.thinkTimes.begin(), r.thinkTimes.end());
+        ss << c.seed << ','
+           << toString(r.type) << ','
+           << r.hand << ','
+           << r.score << ','
+           << r.maxRensa << ','
+           << (r.zenkeshi ? 1 : 0) << ','
+           << fixed << setprecision(3) << (averageOf(r.thinkTimes) * 1000) << ','
+           << (maxThinkTime * 1000) << endl;
+        ss.unsetf(ios::floatfield);
+    }
+    return ss.str();
+}
+
+// static
+string EndlessBenchmark::toJson(const vector<EndlessBenchmarkCase>& cases, const EndlessBenchmarkSummary& summary)
+{
+    Json::Value root;
+
+    Json::Value& cs = root["cases"];
+    cs = Json::Value(Json::arrayValue);
+    for (const auto& c : cases) {
+        Json::Value v;
+        v["seed"] = c.seed;
+        v["type"] = toString(c.result.type);
+        v["hand"] = c.result.hand;
+        v["score"] = c.result.score;
+        v["rensa"] = c.result.maxRensa;
+        v["zenkeshi"] = c.result.zenkeshi;
+        Json::Value& thinkTimes = v["thinkTimes"];
+        thinkTimes = Json::Value(Json::arrayValue);
+        for (double t : c.result.thinkTimes)
+            thinkTimes.append(t);
+        cs.append(v);
+    }
+
+    Json::Value& s = root["summary"];
+    s["numCases"] = summary.numCases;
+    s["numDead"] = summary.numDead;
+    s["numMainChain"] = summary.numMainChain;
+    s["numZenkeshi"] = summary.numZenkeshi;
+    s["numRunout"] = summary.numRunout;
+    s["averageMainChainScore"] = summary.averageMainChainScore;
+    s["mainChainScoreP10"] = summary.mainChainScoreP10;
+    s["mainChainScoreP50"] = summary.mainChainScoreP50;
+    s["mainChainScoreP90"] = summary.mainChainScoreP90;
+    s["over60000Count"] = summary.over60000Count;
+    s["over80000Count"] = summary.over80000Count;
+    s["over100000Count"] = summary.over100000Count;
+    s["averageMainChainRensa"] = summary.averageMainChainRensa;
+    s["thinkTimeP50"] = summary.thinkTimeP50;
+    s["thinkTimeP90"] = summary.thinkTimeP90;
+    s["thinkTimeP99"] = summary.thinkTimeP99;
+    s["thinkTimeMax"] = summary.thinkTimeMax;
+
+    Json::StyledWriter writer;
+    return writer.write(root);
+}
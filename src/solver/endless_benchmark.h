@@ -0,0 +1,90 @@
+#ifndef SOLVER_ENDLESS_BENCHMARK_H_
+#define SOLVER_ENDLESS_BENCHMARK_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "solver/endless.h"
+
+class AI;
+class Executor;
+
+struct EndlessBenchmarkCase {
+    int seed;
+    EndlessResult result;
+};
+
+struct EndlessBenchmarkSummary {
+    static EndlessBenchmarkSummary summarize(const std::vector<EndlessBenchmarkCase>&);
+
+    // Parses the "summary" of the JSON made by EndlessBenchmark::toJson().
+    static bool parseJson(const std::string& json, EndlessBenchmarkSummary*);
+
+    std::string toString() const;
+
+    double mainChainRate() const { return numCases > 0 ? static_cast<double>(numMainChain) / numCases : 0.0; }
+    double deadRate() const { return numCases > 0 ? static_cast<double>(numDead) / numCases : 0.0; }
+
+    // Counted by EndlessResult::Type, so they sum up to |numCases|.
+    int numCases = 0;
+    int numDead = 0;
+    int numMainChain = 0;
+    int numZenkeshi = 0;
+    int numRunout = 0;
+
+    // The distribution of the main chain scores.
+    double averageMainChainScore = 0;
+    int mainChainScoreP10 = 0;
+    int mainChainScoreP50 = 0;
+    int mainChainScoreP90 = 0;
+    int over60000Count = 0;
+    int over80000Count = 0;
+    int over100000Count = 0;
+    double averageMainChainRensa = 0;
+
+    // The distribution of the think time per hand [s].
+    double thinkTimeP50 = 0;
+    double thinkTimeP90 = 0;
+    double thinkTimeP99 = 0;
+    double thinkTimeMax = 0;
+};
+
+struct EndlessBenchmarkTolerance {
+    // The allowed decrease of the main chain rate, and increase of the dead rate.
+    double rate = 0.05;
+    // The allowed relative decrease of the average main chain score.
+    double score = 0.05;
+    // The allowed relative increase of the 90 percentile think time.
+    double thinkTime = 0.2;
+};
+
+// Compares |current| with |baseline|, and returns the descriptions of the regressions.
+// Returns an empty vector if nothing regressed.
+std::vector<std::string> findEndlessRegressions(const EndlessBenchmarkSummary& baseline,
+                                                const EndlessBenchmarkSummary& current,
+                                                const EndlessBenchmarkTolerance& = EndlessBenchmarkTolerance());
+
+// EndlessBenchmark runs Endless for many seeds in parallel.
+// Each worker of the executor has its own AI, and the i-th seed is always run by the
+// (i % #workers)-th AI, so the result is reproducible for the same number of threads.
+class EndlessBenchmark : noncopyable {
+public:
+    typedef std::function<std::unique_ptr<AI> ()> AIFactory;
+
+    explicit EndlessBenchmark(AIFactory factory) : factory_(std::move(factory)) {}
+
+    // Runs the sequences generated with seed [seedOffset, seedOffset + numSeeds).
+    // |executor| can be nullptr.
+    std::vector<EndlessBenchmarkCase> run(Executor* executor, int seedOffset, int numSeeds) const;
+
+    static std::string toCSV(const std::vector<EndlessBenchmarkCase>&);
+    static std::string toJson(const std::vector<EndlessBenchmarkCase>&, const EndlessBenchmarkSummary&);
+
+private:
+    AIFactory factory_;
+};
+
+#endif // SOLVER_ENDLESS_BENCHMARK_H_
@@ -0,0 +1,146 @@
+#include "solver/endless_benchmark.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+#include "core/client/ai/ai.h"
+#include "core/core_field.h"
+
+using namespace std;
+
+namespace {
+
+// Drops puyos on the columns from left to right in turn.
+class RoundRobinAI : public AI {
+public:
+    RoundRobinAI() : AI("round_robin") {}
+
+protected:
+    DropDecision think(int, const CoreField& field, const KumipuyoSeq&,
+                       const PlayerState&, const PlayerState&, bool) const override
+    {
+        return DropDecision(Decision(field.countPuyos() / 2 % 6 + 1, 0));
+    }
+};
+
+EndlessBenchmarkCase makeCase(int seed, EndlessResult::Type type, int score, vector<double> thinkTimes,
+                              bool zenkeshi = false)
+{
+    EndlessResult result {
+        10,                                                // .hand
+        score,                                             // .score
+        score > 0 ? 10 : -1,                               // .maxRensa
+        zenkeshi || type == EndlessResult::Type::ZENKESHI, // .zenkeshi
+        vector<Decision>(),                                // .decisions
+        thinkTimes,                                        // .thinkTimes
+        type,                                              // .type
+    };
+    return EndlessBenchmarkCase { seed, result };
+}
+
+} // anonymous namespace
+
+TEST(EndlessBenchmarkTest, summarize)
+{
+    vector<EndlessBenchmarkCase> cases {
+        makeCase(0, EndlessResult::Type::MAIN_CHAIN, 50000, { 0.001, 0.002 }),
+        makeCase(1, EndlessResult::Type::MAIN_CHAIN, 70000, { 0.003 }),
+        // A main chain after a zenkeshi is counted only as a main chain.
+        makeCase(2, EndlessResult::Type::MAIN_CHAIN, 90000, { 0.004 }, true),
+        makeCase(3, EndlessResult::Type::DEAD, -1, { 0.005 }),
+        makeCase(4, EndlessResult::Type::ZENKESHI, 2100, {}),
+    };
+
+    EndlessBenchmarkSummary summary = EndlessBenchmarkSummary::summarize(cases);
+    EXPECT_EQ(5, summary.numCases);
+    EXPECT_EQ(3, summary.numMainChain);
+    EXPECT_EQ(1, summary.numDead);
+    EXPECT_EQ(1, summary.numZenkeshi);
+    EXPECT_EQ(0, summary.numRunout);
+    EXPECT_DOUBLE_EQ(70000, summary.averageMainChainScore);
+    EXPECT_EQ(50000, summary.mainChainScoreP10);
+    EXPECT_EQ(70000, summary.mainChainScoreP50);
+    EXPECT_EQ(90000, summary.mainChainScoreP90);
+    EXPECT_EQ(2, summary.over60000Count);
+    EXPECT_EQ(1, summary.over80000Count);
+    EXPECT_EQ(0, summary.over100000Count);
+    EXPECT_DOUBLE_EQ(0.003, summary.thinkTimeP50);
+    EXPECT_DOUBLE_EQ(0.005, summary.thinkTimeMax);
+}
+
+TEST(EndlessBenchmarkTest, jsonRoundTrip)
+{
+    vector<EndlessBenchmarkCase> cases {
+        makeCase(0, EndlessResult::Type::MAIN_CHAIN, 50000, { 0.001, 0.002 }),
+        makeCase(1, EndlessResult::Type::DEAD, -1, { 0.005 }),
+    };
+    EndlessBenchmarkSummary summary = EndlessBenchmarkSummary::summarize(cases);
+
+    EndlessBenchmarkSummary parsed;
+    ASSERT_TRUE(EndlessBenchmarkSummary::parseJson(EndlessBenchmark::toJson(cases, summary), &parsed));
+    EXPECT_EQ(summary.numCases, parsed.numCases);
+    EXPECT_EQ(summary.numMainChain, parsed.numMainChain);
+    EXPECT_EQ(summary.numDead, parsed.numDead);
+    EXPECT_DOUBLE_EQ(summary.averageMainChainScore, parsed.averageMainChainScore);
+    EXPECT_DOUBLE_EQ(summary.thinkTimeP90, parsed.thinkTimeP90);
+
+    EXPECT_FALSE(EndlessBenchmarkSummary::parseJson("{}", &parsed));
+    EXPECT_FALSE(EndlessBenchmarkSummary::parseJson("{", &parsed));
+}
+
+TEST(EndlessBenchmarkTest, findEndlessRegressions)
+{
+    EndlessBenchmarkSummary baseline;
+    baseline.numCases = 100;
+    baseline.numMainChain = 80;
+    baseline.numDead = 5;
+    baseline.averageMainChainScore = 60000;
+    baseline.thinkTimeP90 = 0.1;
+
+    EXPECT_TRUE(findEndlessRegressions(baseline, baseline).empty());
+
+    EndlessBenchmarkSummary current = baseline;
+    current.numMainChain = 70;
+    current.numDead = 15;
+    current.averageMainChainScore = 50000;
+    current.thinkTimeP90 = 0.2;
+    EXPECT_EQ(4U, findEndlessRegressions(baseline, current).size());
+
+    // Within the tolerance.
+    current = baseline;
+    current.numMainChain = 78;
+    current.averageMainChainScore = 59000;
+    current.thinkTimeP90 = 0.11;
+    EXPECT_TRUE(findEndlessRegressions(baseline, current).empty());
+}
+
+TEST(EndlessBenchmarkTest, run)
+{
+    EndlessBenchmark benchmark([]() { return unique_ptr<AI>(new RoundRobinAI); });
+
+    vector<EndlessBenchmarkCase> expected = benchmark.run(nullptr, 10, 5);
+    ASSERT_EQ(5U, expected.size());
+
+    Executor executor(2);
+    executor.start();
+    vector<EndlessBenchmarkCase> actual = benchmark.run(&executor, 10, 5);
+    executor.stop();
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(static_cast<int>(10 + i), actual[i].seed);
+        EXPECT_EQ(expected[i].result.type, actual[i].result.type);
+        EXPECT_EQ(expected[i].result.hand, actual[i].result.hand);
+        EXPECT_EQ(expected[i].result.score, actual[i].result.score);
+        EXPECT_EQ(expected[i].result.decisions, actual[i].result.decisions);
+        EXPECT_LE(actual[i].result.decisions.size(), actual[i].result.thinkTimes.size());
+    }
+
+    // A header and 5 rows.
+    string csv = EndlessBenchmark::toCSV(actual);
+    EXPECT_EQ(6, count(csv.begin(), csv.end(), '\n'));
+}
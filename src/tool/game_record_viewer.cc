@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include "core/frame.h"
+#include "core/server/game_record.h"
+#include "core/server/game_state.h"
+#include "gui/box.h"
+#include "gui/drawer.h"
+#include "gui/field_drawer.h"
+#include "gui/main_window.h"
+#include "gui/screen.h"
+#include "gui/unique_sdl_surface.h"
+
+DEFINE_int32(frame, 0, "the frame id to show first");
+
+using namespace std;
+
+// ReplayController moves the shown GameState by the keys.
+//   RIGHT / LEFT         the next / previous GameState
+//   DOWN / UP            1 second forward / backward
+//   PAGEDOWN / PAGEUP    1 minute forward / backward
+//   HOME / END           the first / last GameState
+//   SPACE                play / pause
+class ReplayController : public MainWindow::EventListener, public Drawer {
+public:
+    ReplayController(GameRecordReader* reader, GameStateObserver* observer) :
+        reader_(reader),
+        observer_(observer)
+    {
+    }
+
+    void seek(size_t i)
+    {
+        if (reader_->size() == 0)
+            return;
+
+        index_ = min(i, reader_->size() - 1);
+        if (!reader_->read(index_, &gameState_)) {
+            LOG(ERROR) << "failed to read the GameState " << index_;
+            return;
+        }
+        observer_->onUpdate(gameState_);
+    }
+
+    void seekFrame(int frameId)
+    {
+        seek(reader_->findFrame(frameId));
+    }
+
+    void handleEvent(const SDL_Event& event) override
+    {
+        if (event.type != SDL_KEYDOWN)
+            return;
+
+        const int frameId = gameState_.frameId();
+        switch (event.key.keysym.sym) {
+        case SDLK_RIGHT:
+            seek(index_ + 1);
+            break;
+        case SDLK_LEFT:
+            seek(index_ > 0 ? index_ - 1 : 0);
+            break;
+        case SDLK_DOWN:
+            seekFrame(frameId + FPS);
+            break;
+        case SDLK_UP:
+            seekFrame(frameId - FPS);
+            break;
+        case SDLK_PAGEDOWN:
+            seekFrame(frameId + 60 * FPS);
+            break;
+        case SDLK_PAGEUP:
+            seekFrame(frameId - 60 * FPS);
+            break;
+        case SDLK_HOME:
+            seek(0);
+            break;
+        case SDLK_END:
+            seek(reader_->size());
+            break;
+        case SDLK_SPACE:
+            playing_ = !playing_;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void handleAfterPollEvent() override
+    {
+        if (playing_ && index_ + 1 < reader_->size())
+            seek(index_ + 1);
+    }
+
+    void draw(Screen* screen) override
+    {
+        stringstream ss;
+        ss << "Frame " << gameState_.frameId() << " (" << (index_ + 1) << "/" << reader_->size() << ")";
+
+        SDL_Color c;
+        c.r = c.g = c.b = 255;
+        c.a = 255;
+
+        UniqueSDLSurface surf(makeUniqueSDLSurface(TTF_RenderUTF8_Blended(screen->font(), ss.str().c_str(), c)));
+        if (!surf.get())
+            return;
+
+        SDL_Rect dr = {
+            static_cast<Sint16>(screen->surface()->w / 2 - surf->w / 2),
+            static_cast<Sint16>(screen->surface()->h - surf->h - 8),
+            0,
+            0
+        };
+        SDL_BlitSurface(surf.get(), NULL, screen->surface(), &dr);
+    }
+
+private:
+    GameRecordReader* reader_;
+    GameStateObserver* observer_;
+
+    size_t index_ = 0;
+    GameState gameState_ { 0 };
+    bool playing_ = false;
+};
+
+// Shows a game record made by GameStateRecorder. Any frame is shown without
+// decoding the whole record, so a long record can be scrubbed quickly.
+int main(int argc, char* argv[])
+{
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " [--frame=<frame id>] <record>" << endl;
+        return EXIT_FAILURE;
+    }
+
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(argv[1]);
+    if (!reader) {
+        cerr << "failed to open " << argv[1] << endl;
+        return EXIT_FAILURE;
+    }
+    if (reader->size() == 0) {
+        cerr << argv[1] << " has no GameState" << endl;
+        return EXIT_FAILURE;
+    }
+
+    SDL_Init(SDL_INIT_VIDEO);
+    atexit(SDL_Quit);
+
+    MainWindow mainWindow(640, 448, Box(0, 0, 640, 448));
+    FieldDrawer fieldDrawer;
+    mainWindow.addDrawer(&fieldDrawer);
+
+    ReplayController controller(reader.get(), &fieldDrawer);
+    mainWindow.addDrawer(&controller);
+    mainWindow.addEventListener(&controller);
+
+    controller.seekFrame(FLAGS_frame);
+    mainWindow.runMainLoop();
+
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <unordered_set>
 
@@ -10,6 +11,7 @@
 #include "core/core_field.h"
 #include "core/pattern/pattern_book.h"
 #include "core/rensa_tracker/rensa_chain_tracker.h"
+#include "core/server/game_record.h"
 
 using namespace std;
 
@@ -83,10 +85,41 @@ void add(PatternBook* patternBook, const CoreField& original, std::unordered_set
     }
 }
 
+void addField(const PlainField& pf, PatternBook* patternBook,
+              std::unordered_set<std::string>* patterns,
+              std::unordered_set<CoreField>* visited)
+{
+    CoreField cf(CoreField::fromPlainFieldWithDrop(pf));
+    if (!visited->insert(cf).second || !cf.rensaWillOccur())
+        return;
+
+    add(patternBook, cf, patterns);
+}
+
+// Reads a game record made by GameStateRecorder. The GameStates are decoded one by one,
+// so a long record is not loaded into memory.
+bool parseRecordAndAdd(const char* filename, PatternBook* patternBook,
+                       std::unordered_set<std::string>* patterns,
+                       std::unordered_set<CoreField>* visited)
+{
+    unique_ptr<GameRecordReader> reader = GameRecordReader::open(filename);
+    if (!reader)
+        return false;
+
+    GameRecordReader::Iterator it = reader->iterate();
+    for (; it.valid(); it.next())
+        addField(it.gameState().playerGameState(0).field, patternBook, patterns, visited);
+    return it.index() == reader->size();
+}
+
 bool parseAndAdd(const char* filename, PatternBook* patternBook,
                  std::unordered_set<std::string>* patterns,
                  std::unordered_set<CoreField>* visited)
 {
+    // GameStateRecorder writes game records. The older ones wrote JSON.
+    if (GameRecordReader::isGameRecord(filename))
+        return parseRecordAndAdd(filename, patternBook, patterns, visited);
+
     ifstream ifs(filename);
     if (!ifs) {
         PLOG(ERROR) << "failed to open " << filename;
@@ -96,14 +129,8 @@ bool parseAndAdd(const char* filename, PatternBook* patternBook,
     Json::Value root;
     ifs >> root;
 
-    for (unsigned int i = 0; i < root.size(); ++i) {
-        PlainField pf(root[i]["p1"].asString());
-        CoreField cf(CoreField::fromPlainFieldWithDrop(pf));
-        if (!visited->insert(cf).second || !cf.rensaWillOccur())
-            continue;
-
-        add(patternBook, cf, patterns);
-    }
+    for (unsigned int i = 0; i < root.size(); ++i)
+        addField(PlainField(root[i]["p1"].asString()), patternBook, patterns, visited);
     return true;
 }
 
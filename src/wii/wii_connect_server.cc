@@ -1,11 +1,15 @@
 #include "wii/wii_connect_server.h"
 
 #include <iostream>
+#include <sstream>
 #include <vector>
 
+#include <gflags/gflags.h>
+
 #include "base/time.h"
 #include "capture/analyzer.h"
 #include "capture/source.h"
+#include "capture/source_reader.h"
 #include "core/core_field.h"
 #include "core/game_result.h"
 #include "core/frame_response.h"
@@ -22,10 +26,26 @@
 
 using namespace std;
 
+DEFINE_int32(stale_frame_ms, 33, "a captured frame older than this is dropped if a newer frame is available. 0 means never.");
+
+namespace {
+// The capacity of the queues between the stages.
+const size_t QUEUE_CAPACITY = 4;
+// The latency stats are logged once in this frames.
+const int LATENCY_LOG_INTERVAL = 600;
+// The loops wait for a frame this long at most, and check whether they should stop.
+const chrono::milliseconds TAKE_TIMEOUT(10);
+// The producers wake up in this interval to check whether they should stop.
+const chrono::milliseconds PUSH_TIMEOUT(10);
+}
+
 WiiConnectServer::WiiConnectServer(Source* source, Analyzer* analyzer,
                                    KeySender* p1KeySender, KeySender* p2KeySender,
                                    const string& p1Program, const string& p2Program) :
+    reader_(new SourceReader(source, QUEUE_CAPACITY, chrono::milliseconds(FLAGS_stale_frame_ms))),
     shouldStop_(false),
+    analyzerFinished_(false),
+    analyzedFrames_(QUEUE_CAPACITY),
     surface_(emptyUniqueSDLSurface()),
     source_(source),
     analyzer_(analyzer),
@@ -43,8 +63,7 @@ WiiConnectServer::WiiConnectServer(Source* source, Analyzer* analyzer,
 WiiConnectServer::~WiiConnectServer()
 {
     connector_->stop();
-    if (th_.joinable())
-        th_.join();
+    stop();
 }
 
 void WiiConnectServer::addObserver(GameStateObserver* observer)
@@ -55,8 +74,14 @@ void WiiConnectServer::addObserver(GameStateObserver* observer)
 
 bool WiiConnectServer::start()
 {
-    th_ = thread([this]() {
-        this->runLoop();
+    reset();
+
+    reader_->start();
+    analyzerThread_ = thread([this]() {
+        this->runAnalyzerLoop();
+    });
+    outputThread_ = thread([this]() {
+        this->runOutputLoop();
     });
     return true;
 }
@@ -64,8 +89,13 @@ bool WiiConnectServer::start()
 void WiiConnectServer::stop()
 {
     shouldStop_ = true;
-    if (th_.joinable())
-        th_.join();
+    if (analyzerThread_.joinable())
+        analyzerThread_.join();
+    if (outputThread_.joinable()) {
+        outputThread_.join();
+        cout << latencyStatsString();
+    }
+    reader_->stop();
 }
 
 void WiiConnectServer::reset()
@@ -81,60 +111,38 @@ void WiiConnectServer::reset()
     colorsUsed_.fill(false);
 }
 
-void WiiConnectServer::runLoop()
+void WiiConnectServer::runAnalyzerLoop()
 {
-    reset();
-
     bool gameStarted = false;
-    int noSurfaceCount = 0;
     int frameId = 0;
     UniqueSDLSurface prevSurface(emptyUniqueSDLSurface());
     UniqueSDLSurface prev2Surface(emptyUniqueSDLSurface());
     UniqueSDLSurface prev3Surface(emptyUniqueSDLSurface());
 
-    auto start_time = std::chrono::steady_clock::now();
-    auto prev_time = start_time;
-
     while (!shouldStop_) {
-        UniqueSDLSurface surface(source_->nextFrame());
-
-        auto curr_time = std::chrono::steady_clock::now();
-        auto timeout_time = curr_time + std::chrono::milliseconds(16);
-
-        LOG(INFO) << "TIME"
-                  << " id=" << frameId
-                  << " elapsed=" << std::chrono::duration_cast<std::chrono::milliseconds>(curr_time - start_time).count()
-                  << " from_prev=" << std::chrono::duration_cast<std::chrono::milliseconds>(curr_time - prev_time).count();
-
-        prev_time = curr_time;
-
-        if (!surface.get()) {
-            ++noSurfaceCount;
-            LOG(INFO) << "No surface?: count=" << noSurfaceCount << endl;
-            cout << "No surface? count=" << noSurfaceCount
-                 << " done=" << source_->done() << endl;
-
-            if (source_->done()) {
+        CapturedFrame captured;
+        if (!reader_->take(&captured, TAKE_TIMEOUT)) {
+            if (reader_->done())
                 break;
-            }
-
-            // TODO(mayah): Why not sleep?
-            if (noSurfaceCount > 100000) {
+            if (reader_->numNoSurfaces() > 100000) {
+                cout << "No surface? count=" << reader_->numNoSurfaces() << endl;
                 shouldStop_ = true;
                 break;
             }
             continue;
         }
 
+        auto beginTime = chrono::steady_clock::now();
+
+        UniqueSDLSurface surface(std::move(captured.surface));
         unique_ptr<AnalyzerResult> r =
             analyzer_->analyze(surface.get(), prevSurface.get(), prev2Surface.get(), prev3Surface.get(), analyzerResults_);
         LOG(INFO) << r->toString();
 
+        AnalyzedFrame frame;
+        frame.capturedTime = captured.capturedTime;
+
         switch (r->state()) {
-        case CaptureGameState::UNKNOWN:
-            if (!playForUnknown(frameId))
-                shouldStop_ = true;
-            break;
         case CaptureGameState::LEVEL_SELECT:
             // TODO(mayah): For workaround, we make frameId = 1.
             // Server should send some event to initialize a game state.
@@ -148,54 +156,40 @@ void WiiConnectServer::runLoop()
                 if (analyzerResults_.empty() || analyzerResults_.front()->state() != CaptureGameState::LEVEL_SELECT) {
                     cout << "New game started" << endl;
                     frameId = 1;
-                    reset();
                     // The result might contain the previous game's result. We don't want to stabilize the result
                     // with using the previous game's results.
                     // So, remove all the results.
                     analyzerResults_.clear();
                     r->clear();
 
-                    for (auto observer : observers_) {
-                        observer->newGameWillStart();
-                    }
+                    frame.newGameStarted = true;
                     gameStarted = true;
                 }
             }
-            if (!playForLevelSelect(frameId, *r, timeout_time))
-                shouldStop_ = true;
-            break;
-        case CaptureGameState::PLAYING: {
-            if (!playForPlaying(frameId, *r, timeout_time))
-                shouldStop_ = true;
-            GameState gameState = toGameState(frameId, *r);
-            for (auto observer : observers_)
-                observer->onUpdate(gameState);
             break;
-        }
         case CaptureGameState::MATCH_FINISHED_WITH_DRAW:
         case CaptureGameState::MATCH_FINISHED_WITH_1P_WIN:
         case CaptureGameState::MATCH_FINISHED_WITH_2P_WIN:
         case CaptureGameState::GAME_FINISHED_WITH_DRAW:
         case CaptureGameState::GAME_FINISHED_WITH_1P_WIN:
         case CaptureGameState::GAME_FINISHED_WITH_2P_WIN:
-            cout << "game finished detected: started?=" << gameStarted << endl;
-            if (!playForFinished(frameId, gameStarted, *r, timeout_time))
-                shouldStop_ = true;
-            if (gameStarted) {
-                GameResult gameResult = GameResult::DRAW;
-                if (r->state() == CaptureGameState::GAME_FINISHED_WITH_1P_WIN || r->state() == CaptureGameState::MATCH_FINISHED_WITH_1P_WIN)
-                    gameResult = GameResult::P1_WIN;
-                if (r->state() == CaptureGameState::GAME_FINISHED_WITH_2P_WIN || r->state() == CaptureGameState::MATCH_FINISHED_WITH_2P_WIN)
-                    gameResult = GameResult::P2_WIN;
-                for (auto observer : observers_) {
-                    // TODO(mayah): This is not DRAW, of course.
-                    observer->gameHasDone(gameResult);
-                }
-                gameStarted = false;
-            }
+            frame.gameStarted = gameStarted;
+            gameStarted = false;
+            break;
+        default:
             break;
         }
 
+        frame.frameId = frameId;
+        frame.result = r->copy();
+
+        analyzeLatency_.add(chrono::duration<double>(chrono::steady_clock::now() - beginTime).count());
+
+        while (!analyzedFrames_.pushWithTimeout(PUSH_TIMEOUT, std::move(frame))) {
+            if (shouldStop_)
+                break;
+        }
+
         // We set frameId to surface's userdata. This will be useful for saving screen shot.
         surface->userdata = reinterpret_cast<void*>(static_cast<uintptr_t>(frameId));
 
@@ -212,6 +206,117 @@ void WiiConnectServer::runLoop()
 
         frameId++;
     }
+
+    analyzerFinished_ = true;
+    reader_->stop();
+}
+
+void WiiConnectServer::runOutputLoop()
+{
+    while (!shouldStop_) {
+        AnalyzedFrame frame;
+        if (!analyzedFrames_.takeWithTimeout(TAKE_TIMEOUT, &frame)) {
+            if (analyzerFinished_ && analyzedFrames_.empty())
+                break;
+            continue;
+        }
+
+        if (isStale(frame)) {
+            ++numDroppedFrames_;
+            continue;
+        }
+
+        auto beginTime = chrono::steady_clock::now();
+        if (!play(frame)) {
+            shouldStop_ = true;
+            break;
+        }
+        auto endTime = chrono::steady_clock::now();
+
+        outputLatency_.add(chrono::duration<double>(endTime - beginTime).count());
+        endToEndLatency_.add(chrono::duration<double>(endTime - frame.capturedTime).count());
+        if (endToEndLatency_.count() % LATENCY_LOG_INTERVAL == 0)
+            LOG(INFO) << "output: " << outputLatency_.toString() << " end-to-end: " << endToEndLatency_.toString();
+    }
+}
+
+bool WiiConnectServer::isStale(const AnalyzedFrame& frame) const
+{
+    // Only the playing frames without any event can be dropped. The others change the state.
+    if (analyzedFrames_.empty() || frame.result->state() != CaptureGameState::PLAYING)
+        return false;
+
+    for (int pi = 0; pi < 2; ++pi) {
+        const PlayerAnalyzerResult* pr = frame.result->playerResult(pi);
+        if (pr && pr->userEvent.hasEventState())
+            return false;
+    }
+
+    return true;
+}
+
+bool WiiConnectServer::play(const AnalyzedFrame& frame)
+{
+    const int frameId = frame.frameId;
+    const AnalyzerResult& r = *frame.result;
+    // The AIs have 16 ms from when the frame is captured.
+    auto timeout_time = frame.capturedTime + chrono::milliseconds(16);
+
+    switch (r.state()) {
+    case CaptureGameState::UNKNOWN:
+        return playForUnknown(frameId);
+    case CaptureGameState::LEVEL_SELECT:
+        if (frame.newGameStarted) {
+            reset();
+            for (auto observer : observers_) {
+                observer->newGameWillStart();
+            }
+        }
+        return playForLevelSelect(frameId, r, timeout_time);
+    case CaptureGameState::PLAYING: {
+        bool ok = playForPlaying(frameId, r, timeout_time);
+        GameState gameState = toGameState(frameId, r);
+        for (auto observer : observers_)
+            observer->onUpdate(gameState);
+        return ok;
+    }
+    case CaptureGameState::MATCH_FINISHED_WITH_DRAW:
+    case CaptureGameState::MATCH_FINISHED_WITH_1P_WIN:
+    case CaptureGameState::MATCH_FINISHED_WITH_2P_WIN:
+    case CaptureGameState::GAME_FINISHED_WITH_DRAW:
+    case CaptureGameState::GAME_FINISHED_WITH_1P_WIN:
+    case CaptureGameState::GAME_FINISHED_WITH_2P_WIN: {
+        cout << "game finished detected: started?=" << frame.gameStarted << endl;
+        bool ok = playForFinished(frameId, frame.gameStarted, r, timeout_time);
+        if (frame.gameStarted) {
+            GameResult gameResult = GameResult::DRAW;
+            if (r.state() == CaptureGameState::GAME_FINISHED_WITH_1P_WIN || r.state() == CaptureGameState::MATCH_FINISHED_WITH_1P_WIN)
+                gameResult = GameResult::P1_WIN;
+            if (r.state() == CaptureGameState::GAME_FINISHED_WITH_2P_WIN || r.state() == CaptureGameState::MATCH_FINISHED_WITH_2P_WIN)
+                gameResult = GameResult::P2_WIN;
+            for (auto observer : observers_) {
+                // TODO(mayah): This is not DRAW, of course.
+                observer->gameHasDone(gameResult);
+            }
+        }
+        return ok;
+    }
+    }
+
+    return true;
+}
+
+string WiiConnectServer::latencyStatsString() const
+{
+    stringstream ss;
+    ss << "capture: " << reader_->captureLatency().toString() << endl
+       << "capture queue: " << reader_->queueLatency().toString()
+       << " dropped=" << reader_->numDroppedFrames() << endl
+       << "analyze: " << analyzeLatency_.toString() << endl
+       << "output: " << outputLatency_.toString()
+       << " dropped=" << numDroppedFrames_ << endl
+       << "end-to-end: " << endToEndLatency_.toString() << endl;
+    return ss.str();
 }
 
 bool WiiConnectServer::playForUnknown(int frameId)
@@ -2,6 +2,7 @@
 #define WII_WII_CONNECTOR_SERVER_H_
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <deque>
 #include <map>
@@ -11,6 +12,8 @@
 #include <thread>
 
 #include "base/base.h"
+#include "base/latency_histogram.h"
+#include "base/spsc_queue.h"
 #include "capture/analyzer_result_drawer.h"
 #include "core/decision.h"
 #include "core/frame_request.h"
@@ -27,7 +30,15 @@ class GameState;
 class GameStateObserver;
 class KeySender;
 class Source;
-
+class SourceReader;
+
+// WiiConnectServer runs a pipeline of 3 stages, each of which has its own thread.
+//  1. SourceReader takes frames from Source.
+//  2. The analyzer stage analyzes the frames.
+//  3. The output stage sends the analyzed frames to the AIs, and outputs their keys.
+// The stages are connected with bounded lock-free queues, so that e.g. the next frame
+// can be analyzed while the output stage is waiting for the AIs.
+// Frames are processed in order. Stale frames can be dropped between the stages.
 class WiiConnectServer : public Drawer, public AnalyzerResultRetriever {
 public:
     WiiConnectServer(Source*, Analyzer*, KeySender* p1KeySender, KeySender* p2KeySender,
@@ -46,8 +57,25 @@ public:
     static KumipuyoPos calculateDropPosition(const PlainField&, const Decision&);
 
 private:
+    struct AnalyzedFrame {
+        int frameId = 0;
+        std::unique_ptr<AnalyzerResult> result;
+        // True if a new game is detected in this frame.
+        bool newGameStarted = false;
+        // True if a game was started when this frame is analyzed.
+        bool gameStarted = false;
+        std::chrono::steady_clock::time_point capturedTime;
+    };
+
     void reset();
-    void runLoop();
+    void runAnalyzerLoop();
+    void runOutputLoop();
+
+    // Returns false if the server should stop.
+    bool play(const AnalyzedFrame&);
+    // Returns true if |frame| can be dropped because the newer frame is already available.
+    bool isStale(const AnalyzedFrame&) const;
+    std::string latencyStatsString() const;
 
     bool playForUnknown(int frameId);
     bool playForLevelSelect(int frameId, const AnalyzerResult&, const std::chrono::steady_clock::time_point& timeout_time);
@@ -61,13 +89,25 @@ private:
 
     GameState toGameState(int frameId, const AnalyzerResult&);
 
-    std::thread th_;
-    volatile bool shouldStop_;
+    std::unique_ptr<SourceReader> reader_;
+    std::thread analyzerThread_;
+    std::thread outputThread_;
+    std::atomic<bool> shouldStop_;
+    std::atomic<bool> analyzerFinished_;
+    base::SPSCQueue<AnalyzedFrame> analyzedFrames_;
     std::unique_ptr<ConnectorManager> connector_;
 
+    // Updated by the analyzer thread.
+    LatencyHistogram analyzeLatency_;
+    // Updated by the output thread.
+    LatencyHistogram outputLatency_;
+    LatencyHistogram endToEndLatency_;
+    int numDroppedFrames_ = 0;
+
     std::vector<GameStateObserver*> observers_;
 
     // These 3 field should be used for only drawing.
+    // surface_ and analyzerResults_ are updated by the analyzer thread.
     mutable std::mutex mu_;
     UniqueSDLSurface surface_;
     std::deque<std::unique_ptr<AnalyzerResult>> analyzerResults_;
@@ -76,6 +116,7 @@ private:
     Analyzer* analyzer_;
     KeySender* keySenders_[2];
 
+    // The followings are used by the output thread.
     std::map<RealColor, PuyoColor> colorMap_;
     std::array<bool, 4> colorsUsed_;
 